@@ -87,6 +87,7 @@
 #include <math.h>
 #include "builtin_functions.h"
 #include "util/hash_table.h"
+#include "util/set.h"
 
 #ifndef M_PIf
 #define M_PIf   ((float) M_PI)
@@ -1155,7 +1156,7 @@ namespace {
  */
 class builtin_builder {
 public:
-   builtin_builder();
+   builtin_builder(bool lazy = true);
    builtin_builder(const builtin_builder &) = delete;
    ~builtin_builder();
    builtin_builder & operator=(const builtin_builder &) = delete;
@@ -1166,12 +1167,21 @@ public:
                                const char *name, ir_exec_list *actual_parameters);
 
    /**
-    * A symbol table to hold all the built-in signatures; created by this
+    * Looks up a built-in function, building its signatures on first use.
+    */
+   ir_function *get_function(const char *name);
+
+   /** Calls \p cb for every function in the symbol table */
+   void foreach_function(void (*cb)(ir_function *f, void *data), void *data);
+
+   /**
+    * A symbol table to hold the built-in signatures; created by this
     * module.
     *
-    * This includes signatures for every built-in, regardless of version or
-    * enabled extensions.  The availability predicate associated with each
-    * signature allows matching_signature() to filter out the irrelevant ones.
+    * Functions are only added once get_function() asked for them, but then
+    * with signatures for every version and extension.  The availability
+    * predicate associated with each signature allows matching_signature()
+    * to filter out the irrelevant ones.
     */
    struct glsl_symbol_table *symbols;
 
@@ -1179,9 +1189,36 @@ private:
    void *mem_ctx;
    linear_ctx *linalloc;
 
+   /**
+    * Whether signatures are built on first lookup rather than all at once
+    * by initialize().  Eager construction is kept for comparison in tests
+    * and benchmarks.
+    */
+   bool lazy;
+
+   /**
+    * Names get_function() was called with, built-in or not.  When built
+    * eagerly, the name of every built-in instead.
+    */
+   struct set *materialized;
+
+   /**
+    * The function create_intrinsics() and create_builtins() are building.
+    * Every other add_function() is skipped without evaluating its
+    * signatures.
+    */
+   const char *materialize_name;
+
    void create_shader();
    void create_intrinsics();
    void create_builtins();
+   void materialize(const char *name);
+   void add_to_symbols(ir_function *f);
+
+   bool wants_function(const char *name)
+   {
+      return materialize_name == NULL || strcmp(name, materialize_name) == 0;
+   }
 
    /**
     * IR builder helpers:
@@ -1630,11 +1667,13 @@ enum image_function_flags {
  * Core builtin_builder functionality:
  *  @{
  */
-builtin_builder::builtin_builder()
-   : symbols(NULL)
+builtin_builder::builtin_builder(bool lazy)
+   : symbols(NULL), lazy(lazy)
 {
    mem_ctx = NULL;
    linalloc = NULL;
+   materialized = NULL;
+   materialize_name = NULL;
 }
 
 builtin_builder::~builtin_builder()
@@ -1645,6 +1684,7 @@ builtin_builder::~builtin_builder()
    mem_ctx = NULL;
    linalloc = NULL;
    symbols = NULL;
+   materialized = NULL;
 
    simple_mtx_unlock(&builtins_lock);
 }
@@ -1662,7 +1702,7 @@ builtin_builder::find(_mesa_glsl_parse_state *state,
     */
    state->uses_builtin_functions = true;
 
-   ir_function *f = symbols->get_function(name);
+   ir_function *f = get_function(name);
    if (f == NULL)
       return NULL;
 
@@ -1688,9 +1728,14 @@ builtin_builder::initialize()
 
    mem_ctx = ralloc_context(NULL);
    linalloc = linear_context(mem_ctx);
+   materialized = _mesa_set_create(mem_ctx, _mesa_hash_string,
+                                   _mesa_key_string_equal);
    create_shader();
-   create_intrinsics();
-   create_builtins();
+
+   if (!lazy) {
+      create_intrinsics();
+      create_builtins();
+   }
 }
 
 void
@@ -1700,6 +1745,7 @@ builtin_builder::release()
    mem_ctx = NULL;
    linalloc = NULL;
    symbols = NULL;
+   materialized = NULL;
 
    glsl_type_singleton_decref();
 }
@@ -1710,6 +1756,60 @@ builtin_builder::create_shader()
    symbols = new(mem_ctx) glsl_symbol_table;
 }
 
+/**
+ * Builds the signatures of one built-in function or intrinsic.
+ *
+ * Building IR for every built-in up front is a large fixed cost for each
+ * process compiling GLSL, while a shader only calls a handful of them.
+ * Instead, create_intrinsics() and create_builtins() are walked with only
+ * the requested name enabled; every other add_function() is skipped before
+ * its signatures are constructed.  Built-in bodies get the intrinsics they
+ * call through get_function(), which materializes them in turn.
+ */
+void
+builtin_builder::materialize(const char *name)
+{
+   if (_mesa_set_search(materialized, name))
+      return;
+
+   /* Marked first: a name that isn't a built-in is only looked for once */
+   const char *key = ralloc_strdup(mem_ctx, name);
+   _mesa_set_add(materialized, key);
+
+   const char *outer_name = materialize_name;
+   materialize_name = key;
+   create_intrinsics();
+   create_builtins();
+   materialize_name = outer_name;
+}
+
+ir_function *
+builtin_builder::get_function(const char *name)
+{
+   if (lazy)
+      materialize(name);
+   return symbols->get_function(name);
+}
+
+void
+builtin_builder::foreach_function(void (*cb)(ir_function *f, void *data),
+                                  void *data)
+{
+   set_foreach(materialized, entry) {
+      ir_function *f = symbols->get_function((const char *)entry->key);
+      if (f != NULL)
+         cb(f, data);
+   }
+}
+
+void
+builtin_builder::add_to_symbols(ir_function *f)
+{
+   symbols->add_function(f);
+   if (!lazy)
+      _mesa_set_add(materialized, f->name);
+}
+
 /** @} */
 
 #define FIU(func, ...) \
@@ -1768,6 +1868,13 @@ builtin_builder::create_shader()
    func(&glsl_type_builtin_bvec3, ##__VA_ARGS__), \
    func(&glsl_type_builtin_bvec4, ##__VA_ARGS__)
 
+/* Skips the signatures of every function but the one being materialized */
+#define add_function(name, ...)                 \
+   do {                                         \
+      if (wants_function(name))                 \
+         add_function(name, __VA_ARGS__);       \
+   } while (0)
+
 /**
  * Create ir_function and ir_function_signature objects for each
  * intrinsic.
@@ -6051,6 +6158,8 @@ builtin_builder::create_builtins()
 #undef FIU2_MIXED
 }
 
+#undef add_function
+
 void
 builtin_builder::add_function(const char *name, ...)
 {
@@ -6074,7 +6183,7 @@ builtin_builder::add_function(const char *name, ...)
    }
    va_end(ap);
 
-   symbols->add_function(f);
+   add_to_symbols(f);
 }
 
 void
@@ -6085,6 +6194,9 @@ builtin_builder::add_image_function(const char *name,
                                     unsigned flags,
                                     enum ir_intrinsic_id intrinsic_id)
 {
+   if (!wants_function(name))
+      return;
+
    static const glsl_type *const types[] = {
       &glsl_type_builtin_image1D,
       &glsl_type_builtin_image2D,
@@ -6145,7 +6257,7 @@ builtin_builder::add_image_function(const char *name,
       f->add_signature(_image(prototype, types[i], intrinsic_name,
                               num_arguments, flags, intrinsic_id));
    }
-   symbols->add_function(f);
+   add_to_symbols(f);
 }
 
 void
@@ -7838,7 +7950,7 @@ builtin_builder::_is_sparse_texels_resident(void)
 
    ir_variable *retval = body.make_temp(&glsl_type_builtin_bool, "retval");
    ir_function *f =
-      symbols->get_function("__intrinsic_is_sparse_texels_resident");
+      get_function("__intrinsic_is_sparse_texels_resident");
 
    body.emit(call(f, retval, sig->parameters));
    body.emit(ret(retval));
@@ -8689,7 +8801,7 @@ builtin_builder::_atomic_counter_op(const char *intrinsic,
    MAKE_SIG(&glsl_type_builtin_uint, avail, 1, counter);
 
    ir_variable *retval = body.make_temp(&glsl_type_builtin_uint, "atomic_retval");
-   body.emit(call(symbols->get_function(intrinsic), retval,
+   body.emit(call(get_function(intrinsic), retval,
                   sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -8720,7 +8832,7 @@ builtin_builder::_atomic_counter_op1(const char *intrinsic,
       parameters.push_tail(new(linalloc) ir_dereference_variable(neg_data));
 
       ir_function *const func =
-         symbols->get_function("__intrinsic_atomic_add");
+         get_function("__intrinsic_atomic_add");
       ir_instruction *const c = call(func, retval, parameters);
 
       assert(c != NULL);
@@ -8728,7 +8840,7 @@ builtin_builder::_atomic_counter_op1(const char *intrinsic,
 
       body.emit(c);
    } else {
-      body.emit(call(symbols->get_function(intrinsic), retval,
+      body.emit(call(get_function(intrinsic), retval,
                      sig->parameters));
    }
 
@@ -8746,7 +8858,7 @@ builtin_builder::_atomic_counter_op2(const char *intrinsic,
    MAKE_SIG(&glsl_type_builtin_uint, avail, 3, counter, compare, data);
 
    ir_variable *retval = body.make_temp(&glsl_type_builtin_uint, "atomic_retval");
-   body.emit(call(symbols->get_function(intrinsic), retval,
+   body.emit(call(get_function(intrinsic), retval,
                   sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -8764,7 +8876,7 @@ builtin_builder::_atomic_op2(const char *intrinsic,
    atomic->data.implicit_conversion_prohibited = true;
 
    ir_variable *retval = body.make_temp(type, "atomic_retval");
-   body.emit(call(symbols->get_function(intrinsic), retval,
+   body.emit(call(get_function(intrinsic), retval,
                   sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -8783,7 +8895,7 @@ builtin_builder::_atomic_op3(const char *intrinsic,
    atomic->data.implicit_conversion_prohibited = true;
 
    ir_variable *retval = body.make_temp(type, "atomic_retval");
-   body.emit(call(symbols->get_function(intrinsic), retval,
+   body.emit(call(get_function(intrinsic), retval,
                   sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -9001,7 +9113,7 @@ builtin_builder::_image(image_prototype_ctr prototype,
 
    if (flags & IMAGE_FUNCTION_EMIT_STUB) {
       ir_factory body(&sig->body, linalloc);
-      ir_function *f = symbols->get_function(intrinsic_name);
+      ir_function *f = get_function(intrinsic_name);
 
       if (flags & IMAGE_FUNCTION_RETURNS_VOID) {
          body.emit(call(f, NULL, sig->parameters));
@@ -9058,7 +9170,7 @@ builtin_builder::_memory_barrier(const char *intrinsic_name,
                                  builtin_available_predicate avail)
 {
    MAKE_SIG(&glsl_type_builtin_void, avail, 0);
-   body.emit(call(symbols->get_function(intrinsic_name),
+   body.emit(call(get_function(intrinsic_name),
                   NULL, sig->parameters));
    return sig;
 }
@@ -9080,11 +9192,11 @@ builtin_builder::_ballot(const glsl_type *type, builtin_available_predicate avai
    ir_variable *retval = body.make_temp(type, "retval");
 
    if (type == &glsl_type_builtin_uint64_t) {
-      body.emit(call(symbols->get_function("__intrinsic_ballot_uint64"),
+      body.emit(call(get_function("__intrinsic_ballot_uint64"),
                      retval, sig->parameters));
    } else {
       assert(type == &glsl_type_builtin_uvec4);
-      body.emit(call(symbols->get_function("__intrinsic_ballot_uvec4"),
+      body.emit(call(get_function("__intrinsic_ballot_uvec4"),
                      retval, sig->parameters));
    }
    body.emit(ret(retval));
@@ -9107,7 +9219,7 @@ builtin_builder::_inverse_ballot()
    MAKE_SIG(&glsl_type_builtin_bool, ballot_khr, 1, value);
    ir_variable *retval = body.make_temp(&glsl_type_builtin_bool, "retval");
 
-   body.emit(call(symbols->get_function("__intrinsic_inverse_ballot"),
+   body.emit(call(get_function("__intrinsic_inverse_ballot"),
                   retval, sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -9133,7 +9245,7 @@ builtin_builder::_ballot_bit_extract()
    MAKE_SIG(&glsl_type_builtin_bool, ballot_khr, 2, value, index);
    ir_variable *retval = body.make_temp(&glsl_type_builtin_bool, "retval");
 
-   body.emit(call(symbols->get_function("__intrinsic_ballot_bit_extract"),
+   body.emit(call(get_function("__intrinsic_ballot_bit_extract"),
                   retval, sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -9155,7 +9267,7 @@ builtin_builder::_ballot_bit(const char *intrinsic_name)
    MAKE_SIG(&glsl_type_builtin_uint, ballot_khr, 1, value);
    ir_variable *retval = body.make_temp(&glsl_type_builtin_uint, "retval");
 
-   body.emit(call(symbols->get_function(intrinsic_name), retval, sig->parameters));
+   body.emit(call(get_function(intrinsic_name), retval, sig->parameters));
    body.emit(ret(retval));
    return sig;
 }
@@ -9178,7 +9290,7 @@ builtin_builder::_read_first_invocation(const glsl_type *type, builtin_available
    MAKE_SIG(type, avail, 1, value);
    ir_variable *retval = body.make_temp(type, "retval");
 
-   body.emit(call(symbols->get_function("__intrinsic_read_first_invocation"),
+   body.emit(call(get_function("__intrinsic_read_first_invocation"),
                   retval, sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -9204,7 +9316,7 @@ builtin_builder::_read_invocation(const glsl_type *type, builtin_available_predi
    MAKE_SIG(type, avail, 2, value, invocation);
    ir_variable *retval = body.make_temp(type, "retval");
 
-   body.emit(call(symbols->get_function("__intrinsic_read_invocation"),
+   body.emit(call(get_function("__intrinsic_read_invocation"),
                   retval, sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -9223,7 +9335,7 @@ builtin_builder::_invocation_interlock(const char *intrinsic_name,
                                        builtin_available_predicate avail)
 {
    MAKE_SIG(&glsl_type_builtin_void, avail, 0);
-   body.emit(call(symbols->get_function(intrinsic_name),
+   body.emit(call(get_function(intrinsic_name),
                   NULL, sig->parameters));
    return sig;
 }
@@ -9244,7 +9356,7 @@ builtin_builder::_shader_clock(builtin_available_predicate avail,
 
    ir_variable *retval = body.make_temp(&glsl_type_builtin_uvec2, "clock_retval");
 
-   body.emit(call(symbols->get_function("__intrinsic_shader_clock"),
+   body.emit(call(get_function("__intrinsic_shader_clock"),
                   retval, sig->parameters));
 
    if (type == &glsl_type_builtin_uint64_t) {
@@ -9272,7 +9384,7 @@ builtin_builder::_shader_clock_realtime(builtin_available_predicate avail,
 
    ir_variable *retval = body.make_temp(&glsl_type_builtin_uvec2, "clock_retval");
 
-   body.emit(call(symbols->get_function("__intrinsic_shader_clock_realtime"),
+   body.emit(call(get_function("__intrinsic_shader_clock_realtime"),
                   retval, sig->parameters));
 
    if (type == &glsl_type_builtin_uint64_t) {
@@ -9305,7 +9417,7 @@ builtin_builder::_vote(const glsl_type *type,
 
    ir_variable *retval = body.make_temp(&glsl_type_builtin_bool, "retval");
 
-   body.emit(call(symbols->get_function(intrinsic_name),
+   body.emit(call(get_function(intrinsic_name),
                   retval, sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -9326,7 +9438,7 @@ builtin_builder::_helper_invocation()
 
    ir_variable *retval = body.make_temp(&glsl_type_builtin_bool, "retval");
 
-   body.emit(call(symbols->get_function("__intrinsic_helper_invocation"),
+   body.emit(call(get_function("__intrinsic_helper_invocation"),
                   retval, sig->parameters));
    body.emit(ret(retval));
 
@@ -9346,7 +9458,7 @@ builtin_builder::_subgroup_barrier(const char *intrinsic_name,
                                    builtin_available_predicate avail)
 {
    MAKE_SIG(&glsl_type_builtin_void, avail, 0);
-   body.emit(call(symbols->get_function(intrinsic_name), NULL, sig->parameters));
+   body.emit(call(get_function(intrinsic_name), NULL, sig->parameters));
    return sig;
 }
 
@@ -9364,7 +9476,7 @@ builtin_builder::_elect()
 
    ir_variable *retval = body.make_temp(&glsl_type_builtin_bool, "retval");
 
-   body.emit(call(symbols->get_function("__intrinsic_elect"), retval, sig->parameters));
+   body.emit(call(get_function("__intrinsic_elect"), retval, sig->parameters));
    body.emit(ret(retval));
 
    return sig;
@@ -9392,7 +9504,7 @@ builtin_builder::_shuffle(const glsl_type *type)
 
    ir_variable *retval = body.make_temp(type, "retval");
 
-   body.emit(call(symbols->get_function("__intrinsic_shuffle"), retval, sig->parameters));
+   body.emit(call(get_function("__intrinsic_shuffle"), retval, sig->parameters));
    body.emit(ret(retval));
    return sig;
 }
@@ -9419,7 +9531,7 @@ builtin_builder::_shuffle_xor(const glsl_type *type)
 
    ir_variable *retval = body.make_temp(type, "retval");
 
-   body.emit(call(symbols->get_function("__intrinsic_shuffle_xor"),
+   body.emit(call(get_function("__intrinsic_shuffle_xor"),
                   retval, sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -9446,7 +9558,7 @@ builtin_builder::_shuffle_up(const glsl_type *type)
             2, value, delta);
    ir_variable *retval = body.make_temp(type, "retval");
 
-   body.emit(call(symbols->get_function("__intrinsic_shuffle_up"),
+   body.emit(call(get_function("__intrinsic_shuffle_up"),
                   retval, sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -9473,7 +9585,7 @@ builtin_builder::_shuffle_down(const glsl_type *type)
             2, value, delta);
    ir_variable *retval = body.make_temp(type, "retval");
 
-   body.emit(call(symbols->get_function("__intrinsic_shuffle_down"),
+   body.emit(call(get_function("__intrinsic_shuffle_down"),
                   retval, sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -9497,7 +9609,7 @@ builtin_builder::_subgroup_arithmetic(const glsl_type *type, const char *intrins
             1, value);
 
    ir_variable *retval = body.make_temp(type, "retval");
-   body.emit(call(symbols->get_function(intrinsic_name), retval, sig->parameters));
+   body.emit(call(get_function(intrinsic_name), retval, sig->parameters));
    body.emit(ret(retval));
    return sig;
 }
@@ -9526,7 +9638,7 @@ builtin_builder::_subgroup_clustered(const glsl_type *type, const char *intrinsi
             2, value, size);
 
    ir_variable *retval = body.make_temp(type, "retval");
-   body.emit(call(symbols->get_function(intrinsic_name), retval, sig->parameters));
+   body.emit(call(get_function(intrinsic_name), retval, sig->parameters));
    body.emit(ret(retval));
    return sig;
 }
@@ -9552,7 +9664,7 @@ builtin_builder::_quad_broadcast(const glsl_type *type)
             2, value, id);
    ir_variable *retval = body.make_temp(type, "retval");
 
-   body.emit(call(symbols->get_function("__intrinsic_quad_broadcast"),
+   body.emit(call(get_function("__intrinsic_quad_broadcast"),
                   retval, sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -9576,7 +9688,7 @@ builtin_builder::_quad_swap(const glsl_type *type, const char *intrinsic_name)
             1, value);
 
    ir_variable *retval = body.make_temp(type, "retval");
-   body.emit(call(symbols->get_function(intrinsic_name), retval, sig->parameters));
+   body.emit(call(get_function(intrinsic_name), retval, sig->parameters));
    body.emit(ret(retval));
    return sig;
 }
@@ -9598,7 +9710,7 @@ ir_function_signature *builtin_builder::_emit_mesh_tasks()
    ir_variable *z = in_var(&glsl_type_builtin_uint, "num_group_z");
    MAKE_SIG(&glsl_type_builtin_void, mesh_shader, 3, x, y, z);
 
-   body.emit(call(symbols->get_function("__intrinsic_emit_mesh_tasks"),
+   body.emit(call(get_function("__intrinsic_emit_mesh_tasks"),
                   NULL, sig->parameters));
    return sig;
 }
@@ -9618,7 +9730,7 @@ ir_function_signature *builtin_builder::_set_mesh_outputs()
    ir_variable *pc = in_var(&glsl_type_builtin_uint, "primitive_count");
    MAKE_SIG(&glsl_type_builtin_void, mesh_shader, 2, vc, pc);
 
-   body.emit(call(symbols->get_function("__intrinsic_set_mesh_outputs"),
+   body.emit(call(get_function("__intrinsic_set_mesh_outputs"),
                   NULL, sig->parameters));
    return sig;
 }
@@ -9672,7 +9784,7 @@ _mesa_glsl_has_builtin_function(_mesa_glsl_parse_state *state, const char *name)
    ir_function *f;
    bool ret = false;
    simple_mtx_lock(&builtins_lock);
-   f = builtins.symbols->get_function(name);
+   f = builtins.get_function(name);
    if (f != NULL) {
       ir_foreach_in_list(ir_function_signature, sig, &f->signatures) {
          if (sig->is_builtin_available(state)) {
@@ -9686,10 +9798,62 @@ _mesa_glsl_has_builtin_function(_mesa_glsl_parse_state *state, const char *name)
    return ret;
 }
 
-struct glsl_symbol_table *
-_mesa_glsl_get_builtin_function_symbols()
+/**
+ * Look up a built-in function and all of its signatures, available or not.
+ *
+ * The ir_function is only ever added to, and then with all of its
+ * signatures at once, so it can be used after the lock is dropped.
+ */
+ir_function *
+_mesa_glsl_get_builtin_function(const char *name)
+{
+   ir_function *f;
+   simple_mtx_lock(&builtins_lock);
+   f = builtins.get_function(name);
+   simple_mtx_unlock(&builtins_lock);
+
+   return f;
+}
+
+/**
+ * A private built-in function table, independent of the shared one and of
+ * builtins_lock.  Tests and benchmarks use these to compare lazy
+ * construction against building every signature up front.
+ */
+struct builtin_function_table {
+   builtin_function_table(bool lazy) : builder(lazy) {}
+
+   builtin_builder builder;
+};
+
+builtin_function_table *
+_mesa_glsl_builtin_function_table_create(bool lazy)
+{
+   builtin_function_table *table = new builtin_function_table(lazy);
+   table->builder.initialize();
+   return table;
+}
+
+void
+_mesa_glsl_builtin_function_table_destroy(builtin_function_table *table)
+{
+   table->builder.release();
+   delete table;
+}
+
+ir_function *
+_mesa_glsl_builtin_function_table_get(builtin_function_table *table,
+                                      const char *name)
+{
+   return table->builder.get_function(name);
+}
+
+void
+_mesa_glsl_builtin_function_table_foreach(builtin_function_table *table,
+                                          void (*cb)(ir_function *f, void *data),
+                                          void *data)
 {
-   return builtins.symbols;
+   table->builder.foreach_function(cb, data);
 }
 
 
@@ -48,12 +48,29 @@ extern bool
 _mesa_glsl_has_builtin_function(_mesa_glsl_parse_state *state,
                                 const char *name);
 
-extern glsl_symbol_table *
-_mesa_glsl_get_builtin_function_symbols(void);
+extern ir_function *
+_mesa_glsl_get_builtin_function(const char *name);
 
 extern ir_function_signature *
 _mesa_get_main_function_signature(glsl_symbol_table *symbols);
 
+struct builtin_function_table;
+
+extern builtin_function_table *
+_mesa_glsl_builtin_function_table_create(bool lazy);
+
+extern void
+_mesa_glsl_builtin_function_table_destroy(builtin_function_table *table);
+
+extern ir_function *
+_mesa_glsl_builtin_function_table_get(builtin_function_table *table,
+                                      const char *name);
+
+extern void
+_mesa_glsl_builtin_function_table_foreach(builtin_function_table *table,
+                                          void (*cb)(ir_function *f, void *data),
+                                          void *data);
+
 namespace generate_ir {
 
 ir_function_signature *
@@ -0,0 +1,86 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Compares the startup cost of the built-in function module with lazy and
+ * eager construction.  Eager construction builds every signature the way
+ * initialization used to; lazy construction only builds the functions a
+ * typical shader looks up.  Reported are the time to create the table and
+ * do the lookups, and the number of functions and signatures that ended up
+ * allocated, which is what the built-in module's memory scales with.
+ *
+ * Average of 10 runs in an -O2 release build on one x86_64 core, three runs:
+ *
+ *    eager   3.9 - 5.0 ms   544 functions   5015 signatures
+ *    lazy    0.2 - 0.3 ms    11 functions    338 signatures
+ */
+
+#include <stdio.h>
+#include "util/macros.h"
+#include "util/os_time.h"
+#include "compiler/glsl_types.h"
+#include "ir.h"
+#include "builtin_functions.h"
+
+#define NUM_RUNS 10
+
+/* Built-ins called by a simple lit and textured fragment shader */
+static const char *const typical_names[] = {
+   "texture", "normalize", "dot", "max", "min", "clamp", "mix", "pow",
+   "reflect", "length", "smoothstep", "not_a_builtin",
+};
+
+struct table_size {
+   unsigned functions;
+   unsigned signatures;
+};
+
+static void
+count_function(ir_function *f, void *data)
+{
+   struct table_size *size = (struct table_size *)data;
+
+   size->functions++;
+   ir_foreach_in_list(ir_function_signature, sig, &f->signatures)
+      size->signatures++;
+}
+
+static void
+run(bool lazy)
+{
+   int64_t total = 0;
+   struct table_size size = { 0, 0 };
+
+   for (unsigned i = 0; i < NUM_RUNS; i++) {
+      int64_t start = os_time_get_nano();
+      builtin_function_table *table =
+         _mesa_glsl_builtin_function_table_create(lazy);
+      for (unsigned n = 0; n < ARRAY_SIZE(typical_names); n++)
+         _mesa_glsl_builtin_function_table_get(table, typical_names[n]);
+      total += os_time_get_nano() - start;
+
+      if (i == 0)
+         _mesa_glsl_builtin_function_table_foreach(table, count_function, &size);
+      _mesa_glsl_builtin_function_table_destroy(table);
+   }
+
+   printf("%-5s %10.3f ms  %5u functions  %6u signatures\n",
+          lazy ? "lazy" : "eager", total * 1e-6 / NUM_RUNS,
+          size.functions, size.signatures);
+}
+
+int
+main(int argc, char **argv)
+{
+   /* Keep the type singleton alive so it isn't part of the measurement */
+   glsl_type_singleton_init_or_ref();
+
+   run(false);
+   run(true);
+
+   glsl_type_singleton_decref();
+
+   return 0;
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "standalone_scaffolding.h"
+#include "main/mtypes.h"
+#include "ir.h"
+#include "glsl_parser_extras.h"
+#include "builtin_functions.h"
+
+/**
+ * Built-in signatures are built on first lookup.  These tests build a
+ * private table lazily and another one eagerly, the way every signature
+ * used to be built at startup, and check that each built-in resolves to
+ * the same overloads either way.
+ */
+class builtin_functions : public ::testing::Test {
+public:
+   virtual void SetUp();
+   virtual void TearDown();
+
+   std::string print(ir_function_signature *sig);
+
+   void *mem_ctx;
+   gl_context ctx;
+   std::vector<_mesa_glsl_parse_state *> states;
+   builtin_function_table *eager;
+   builtin_function_table *lazy;
+};
+
+void
+builtin_functions::SetUp()
+{
+   glsl_type_singleton_init_or_ref();
+
+   mem_ctx = ralloc_context(NULL);
+   initialize_context_to_defaults(&ctx, API_OPENGL_COMPAT);
+
+   /* Availability depends on the stage and the language version */
+   static const GLenum stages[] = {
+      GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_COMPUTE_SHADER,
+   };
+   static const struct {
+      unsigned version;
+      bool es;
+   } versions[] = {
+      { 110, false }, { 130, false }, { 150, false }, { 330, false },
+      { 400, false }, { 430, false }, { 460, false },
+      { 100, true }, { 300, true }, { 310, true }, { 320, true },
+   };
+
+   for (unsigned i = 0; i < ARRAY_SIZE(stages); i++) {
+      for (unsigned j = 0; j < ARRAY_SIZE(versions); j++) {
+         gl_shader *shader = rzalloc(mem_ctx, gl_shader);
+         shader->Type = stages[i];
+         shader->Stage = _mesa_shader_enum_to_shader_stage(stages[i]);
+
+         _mesa_glsl_parse_state *state =
+            new(mem_ctx) _mesa_glsl_parse_state(&ctx, shader->Stage, shader);
+         state->language_version = versions[j].version;
+         state->es_shader = versions[j].es;
+         states.push_back(state);
+      }
+   }
+
+   eager = _mesa_glsl_builtin_function_table_create(false);
+   lazy = _mesa_glsl_builtin_function_table_create(true);
+}
+
+void
+builtin_functions::TearDown()
+{
+   _mesa_glsl_builtin_function_table_destroy(lazy);
+   _mesa_glsl_builtin_function_table_destroy(eager);
+
+   free(ctx.screen);
+   ralloc_free(mem_ctx);
+   mem_ctx = NULL;
+
+   glsl_type_singleton_decref();
+}
+
+/**
+ * Prints a signature with its body.  The "@N" suffixes the printer uses to
+ * tell apart variables of the same name come from a process-wide counter,
+ * so they are dropped.
+ */
+std::string
+builtin_functions::print(ir_function_signature *sig)
+{
+   FILE *f = tmpfile();
+   if (f == NULL)
+      return std::string();
+
+   fprint_ir(f, sig);
+   rewind(f);
+
+   std::string text;
+   int c;
+   while ((c = fgetc(f)) != EOF) {
+      if (c == '@') {
+         while ((c = fgetc(f)) != EOF && c >= '0' && c <= '9')
+            ;
+         if (c == EOF)
+            break;
+      }
+      text += (char)c;
+   }
+   fclose(f);
+
+   return text;
+}
+
+static void
+collect_function(ir_function *f, void *data)
+{
+   ((std::vector<ir_function *> *)data)->push_back(f);
+}
+
+TEST_F(builtin_functions, lazy_matches_eager)
+{
+   std::vector<ir_function *> functions;
+   _mesa_glsl_builtin_function_table_foreach(eager, collect_function,
+                                             &functions);
+   ASSERT_FALSE(functions.empty());
+
+   for (ir_function *eager_f : functions) {
+      SCOPED_TRACE(eager_f->name);
+
+      ir_function *lazy_f =
+         _mesa_glsl_builtin_function_table_get(lazy, eager_f->name);
+      ASSERT_NE(lazy_f, nullptr);
+
+      ir_exec_node *lazy_node = lazy_f->signatures.get_head_raw();
+      ir_foreach_in_list(ir_function_signature, eager_sig,
+                         &eager_f->signatures) {
+         ASSERT_FALSE(lazy_node->is_tail_sentinel());
+         ir_function_signature *lazy_sig = (ir_function_signature *)lazy_node;
+         lazy_node = lazy_node->next;
+
+         EXPECT_EQ(eager_sig->return_type, lazy_sig->return_type);
+         EXPECT_EQ(eager_sig->intrinsic_id, lazy_sig->intrinsic_id);
+         EXPECT_EQ(eager_sig->is_defined, lazy_sig->is_defined);
+         EXPECT_EQ(print(eager_sig), print(lazy_sig));
+
+         for (_mesa_glsl_parse_state *state : states) {
+            EXPECT_EQ(eager_sig->is_builtin_available(state),
+                      lazy_sig->is_builtin_available(state));
+         }
+      }
+      EXPECT_TRUE(lazy_node->is_tail_sentinel());
+   }
+
+   /* Looking everything up lazily must not have created anything else */
+   std::vector<ir_function *> lazy_functions;
+   _mesa_glsl_builtin_function_table_foreach(lazy, collect_function,
+                                             &lazy_functions);
+   EXPECT_EQ(functions.size(), lazy_functions.size());
+}
+
+TEST_F(builtin_functions, lazy_only_builds_what_is_asked_for)
+{
+   ASSERT_NE(_mesa_glsl_builtin_function_table_get(lazy, "atomicAdd"),
+             nullptr);
+   EXPECT_EQ(_mesa_glsl_builtin_function_table_get(lazy, "not_a_builtin"),
+             nullptr);
+
+   /* atomicAdd() plus the intrinsics its bodies call */
+   std::vector<ir_function *> lazy_functions;
+   _mesa_glsl_builtin_function_table_foreach(lazy, collect_function,
+                                             &lazy_functions);
+   EXPECT_GT(lazy_functions.size(), 1u);
+   for (ir_function *f : lazy_functions) {
+      EXPECT_TRUE(strcmp(f->name, "atomicAdd") == 0 ||
+                  strncmp(f->name, "__intrinsic_", 12) == 0) << f->name;
+   }
+}
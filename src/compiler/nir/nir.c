@@ -53,6 +53,8 @@ static const struct debug_named_value nir_debug_control[] = {
      "Validate even if a pass does not make progress and test that it properly preserves most types of metadata. This can be very slow" },
    { "progress_validation", NIR_DEBUG_PROGRESS_VALIDATION,
      "Validate that a shader is unmodified if a pass does not report progress" },
+   { "pass_stats", NIR_DEBUG_PASS_STATS,
+     "Record time, progress and instruction/block count changes of every pass per call site and write them as JSON at exit, to NIR_PASS_STATS_FILE or stderr" },
    { "invalidate_metadata", NIR_DEBUG_INVALIDATE_METADATA,
      "Invalidate metadata before passes to try to find passes which don't require metadata that they use. This overrides NIR_DEBUG=extended_validation somewhat" },
    { "tgsi", NIR_DEBUG_TGSI,
@@ -95,6 +95,7 @@ extern bool nir_debug_print_shader[MESA_SHADER_KERNEL + 1];
 #define NIR_DEBUG_INVALIDATE_METADATA    (1u << 23)
 #define NIR_DEBUG_PRINT_STRUCT_DECLS     (1u << 24)
 #define NIR_DEBUG_PROGRESS_VALIDATION    (1u << 25)
+#define NIR_DEBUG_PASS_STATS             (1u << 26)
 
 #define NIR_DEBUG_PRINT (NIR_DEBUG_PRINT_VS |  \
                          NIR_DEBUG_PRINT_TCS | \
@@ -3952,6 +3953,9 @@ typedef struct nir_shader {
    u_printf_info *printf_info;
 
    bool has_debug_info;
+
+   /** Function bodies nir_deserialize_lazy() hasn't read yet, if any */
+   struct nir_lazy_impls *lazy_impls;
 } nir_shader;
 
 #define nir_foreach_function(func, shader) \
@@ -4015,6 +4019,9 @@ nir_foreach_function_with_impl_next(nir_function **it)
 #define nir_foreach_function_impl(it, shader) \
    nir_foreach_function_with_impl(_func_##it, it, shader)
 
+nir_function_impl *nir_function_materialize(nir_function *func);
+void nir_shader_materialize(nir_shader *shader);
+
 static inline nir_function_impl *
 nir_shader_get_entrypoint(const nir_shader *shader)
 {
@@ -4034,6 +4041,10 @@ nir_shader_get_entrypoint(const nir_shader *shader)
       return NULL;
 
    assert(func->num_params == 0);
+
+   if (unlikely(shader->lazy_impls))
+      nir_function_materialize(func);
+
    assert(func->impl);
    return func->impl;
 }
@@ -4812,6 +4823,18 @@ void nir_metadata_require_most(nir_shader *shader);
 struct blob nir_validate_progress_setup(nir_shader *shader);
 void nir_validate_progress_finish(nir_shader *shader, struct blob *setup_blob, bool progress, const char *when);
 
+/** State taken before a pass runs with NIR_DEBUG=pass_stats */
+typedef struct nir_pass_stats_start {
+   int64_t time_ns;
+   unsigned num_instrs;
+   unsigned num_blocks;
+} nir_pass_stats_start;
+
+void nir_pass_stats_begin(nir_shader *shader, nir_pass_stats_start *start);
+void nir_pass_stats_end(nir_shader *shader, const nir_pass_stats_start *start,
+                        const char *pass, const char *when, bool progress);
+void nir_pass_stats_write_json(FILE *fp);
+
 static inline bool
 should_skip_nir(const char *name)
 {
@@ -4881,6 +4904,26 @@ nir_validate_progress_finish(nir_shader *shader, struct blob *setup_blob, bool p
    (void)progress;
    (void)when;
 }
+typedef struct nir_pass_stats_start {
+   int64_t time_ns;
+} nir_pass_stats_start;
+
+static inline void
+nir_pass_stats_begin(nir_shader *shader, nir_pass_stats_start *start)
+{
+   (void)shader;
+   (void)start;
+}
+static inline void
+nir_pass_stats_end(nir_shader *shader, const nir_pass_stats_start *start,
+                   const char *pass, const char *when, bool progress)
+{
+   (void)shader;
+   (void)start;
+   (void)pass;
+   (void)when;
+   (void)progress;
+}
 static inline bool
 should_skip_nir(UNUSED const char *pass_name)
 {
@@ -4922,7 +4965,13 @@ should_print_nir(UNUSED nir_shader *shader)
       printf("%s\n", #pass);                                                             \
    static const char *when = "after " #pass " in " __FILE__ ":" NIR_STRINGIZE(__LINE__); \
    struct blob blob_before = nir_validate_progress_setup(nir);                           \
-   if (pass(nir, ##__VA_ARGS__)) {                                                       \
+   nir_pass_stats_start _stats_start;                                                    \
+   if (NIR_DEBUG(PASS_STATS))                                                            \
+      nir_pass_stats_begin(nir, &_stats_start);                                          \
+   bool _pass_progress = pass(nir, ##__VA_ARGS__);                                       \
+   if (NIR_DEBUG(PASS_STATS))                                                            \
+      nir_pass_stats_end(nir, &_stats_start, #pass, when, _pass_progress);               \
+   if (_pass_progress) {                                                                 \
       nir_validate_shader(nir, when);                                                    \
       UNUSED bool _;                                                                     \
       progress = true;                                                                   \
@@ -820,6 +820,9 @@ clone_printf_info(void *mem_ctx, const nir_shader *s)
 nir_shader *
 nir_shader_clone(void *mem_ctx, const nir_shader *s)
 {
+   /* Bodies nir_deserialize_lazy() hasn't read yet would be lost */
+   assert(s->lazy_impls == NULL);
+
    clone_state state;
    init_clone_state(&state, NULL, true, false);
 
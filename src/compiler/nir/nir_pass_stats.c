@@ -0,0 +1,232 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * NIR_DEBUG=pass_stats: records the wall time, progress and change in
+ * instruction and block count of every NIR_PASS invocation, aggregated per
+ * call site for the whole process, and writes them as JSON at exit.  The
+ * report goes to the file named by NIR_PASS_STATS_FILE, or to stderr.
+ *
+ * Both a per-pass and a per-call-site list are written, sorted by total
+ * time, so that fixed-point loops running passes which hardly ever make
+ * progress stand out.
+ */
+
+#include "nir.h"
+
+#include <stdlib.h>
+
+#include "util/hash_table.h"
+#include "util/os_misc.h"
+#include "util/os_time.h"
+#include "util/ralloc.h"
+#include "util/simple_mtx.h"
+
+#ifndef NDEBUG
+
+struct pass_stats {
+   const char *pass;
+   /* "file:line" of the NIR_PASS, NULL for per-pass totals */
+   const char *site;
+
+   uint64_t calls;
+   uint64_t progress;
+   uint64_t time_ns;
+   int64_t instr_delta;
+   int64_t block_delta;
+};
+
+static simple_mtx_t pass_stats_mtx = SIMPLE_MTX_INITIALIZER;
+
+/* NIR_PASS "when" string -> struct pass_stats */
+static struct hash_table *pass_stats_sites;
+
+static void
+count_shader(nir_shader *shader, unsigned *num_instrs, unsigned *num_blocks)
+{
+   *num_instrs = 0;
+   *num_blocks = 0;
+
+   nir_foreach_function_impl(impl, shader) {
+      nir_foreach_block(block, impl) {
+         (*num_blocks)++;
+         nir_foreach_instr(instr, block)
+            (*num_instrs)++;
+      }
+   }
+}
+
+void
+nir_pass_stats_begin(nir_shader *shader, nir_pass_stats_start *start)
+{
+   /* Counted before the clock starts so it isn't charged to the pass */
+   count_shader(shader, &start->num_instrs, &start->num_blocks);
+   start->time_ns = os_time_get_nano();
+}
+
+static void
+write_json_string(FILE *fp, const char *str)
+{
+   fputc('"', fp);
+   for (const char *c = str; *c; c++) {
+      if (*c == '"' || *c == '\\')
+         fputc('\\', fp);
+      fputc(*c, fp);
+   }
+   fputc('"', fp);
+}
+
+static void
+write_json_stats(FILE *fp, const struct pass_stats *stats)
+{
+   fprintf(fp, "    {\"pass\": ");
+   write_json_string(fp, stats->pass);
+   if (stats->site) {
+      fprintf(fp, ", \"site\": ");
+      write_json_string(fp, stats->site);
+   }
+   fprintf(fp, ", \"calls\": %" PRIu64 ", \"progress\": %" PRIu64
+           ", \"time_ns\": %" PRIu64 ", \"instr_delta\": %" PRId64
+           ", \"block_delta\": %" PRId64 "}",
+           stats->calls, stats->progress, stats->time_ns,
+           stats->instr_delta, stats->block_delta);
+}
+
+static int
+compare_time(const void *_a, const void *_b)
+{
+   const struct pass_stats *a = _a, *b = _b;
+
+   if (a->time_ns != b->time_ns)
+      return a->time_ns < b->time_ns ? 1 : -1;
+   return strcmp(a->pass, b->pass);
+}
+
+static void
+write_json_list(FILE *fp, const char *name, struct pass_stats *list,
+                unsigned count, bool last)
+{
+   qsort(list, count, sizeof(*list), compare_time);
+
+   fprintf(fp, "  \"%s\": [", name);
+   for (unsigned i = 0; i < count; i++) {
+      fprintf(fp, i ? ",\n" : "\n");
+      write_json_stats(fp, &list[i]);
+   }
+   fprintf(fp, "\n  ]%s\n", last ? "" : ",");
+}
+
+void
+nir_pass_stats_write_json(FILE *fp)
+{
+   simple_mtx_lock(&pass_stats_mtx);
+
+   unsigned num_sites =
+      pass_stats_sites ? _mesa_hash_table_num_entries(pass_stats_sites) : 0;
+   struct pass_stats *sites = calloc(MAX2(num_sites, 1), sizeof(*sites));
+   struct pass_stats *passes = calloc(MAX2(num_sites, 1), sizeof(*passes));
+   struct hash_table *pass_index = _mesa_hash_table_create(NULL,
+                                                           _mesa_hash_string,
+                                                           _mesa_key_string_equal);
+   unsigned num_passes = 0;
+
+   if (!sites || !passes || !pass_index) {
+      simple_mtx_unlock(&pass_stats_mtx);
+      free(sites);
+      free(passes);
+      _mesa_hash_table_destroy(pass_index, NULL);
+      return;
+   }
+
+   unsigned i = 0;
+   if (pass_stats_sites) {
+      hash_table_foreach(pass_stats_sites, entry) {
+         const struct pass_stats *site = entry->data;
+         sites[i++] = *site;
+
+         struct hash_entry *pass_entry =
+            _mesa_hash_table_search(pass_index, site->pass);
+         struct pass_stats *pass;
+         if (pass_entry) {
+            pass = &passes[(uintptr_t)pass_entry->data];
+         } else {
+            _mesa_hash_table_insert(pass_index, site->pass,
+                                    (void *)(uintptr_t)num_passes);
+            pass = &passes[num_passes++];
+            pass->pass = site->pass;
+         }
+
+         pass->calls += site->calls;
+         pass->progress += site->progress;
+         pass->time_ns += site->time_ns;
+         pass->instr_delta += site->instr_delta;
+         pass->block_delta += site->block_delta;
+      }
+   }
+
+   simple_mtx_unlock(&pass_stats_mtx);
+
+   fprintf(fp, "{\n");
+   write_json_list(fp, "passes", passes, num_passes, false);
+   write_json_list(fp, "sites", sites, num_sites, true);
+   fprintf(fp, "}\n");
+   fflush(fp);
+
+   _mesa_hash_table_destroy(pass_index, NULL);
+   free(passes);
+   free(sites);
+}
+
+static void
+pass_stats_atexit(void)
+{
+   const char *filename = os_get_option("NIR_PASS_STATS_FILE");
+   FILE *fp = filename ? fopen(filename, "w") : NULL;
+
+   nir_pass_stats_write_json(fp ? fp : stderr);
+
+   if (fp)
+      fclose(fp);
+}
+
+void
+nir_pass_stats_end(nir_shader *shader, const nir_pass_stats_start *start,
+                   const char *pass, const char *when, bool progress)
+{
+   int64_t time_ns = os_time_get_nano() - start->time_ns;
+
+   unsigned num_instrs, num_blocks;
+   count_shader(shader, &num_instrs, &num_blocks);
+
+   simple_mtx_lock(&pass_stats_mtx);
+
+   if (!pass_stats_sites) {
+      pass_stats_sites = _mesa_pointer_hash_table_create(NULL);
+      atexit(pass_stats_atexit);
+   }
+
+   struct hash_entry *entry =
+      _mesa_hash_table_search(pass_stats_sites, when);
+   struct pass_stats *stats;
+   if (entry) {
+      stats = entry->data;
+   } else {
+      stats = rzalloc(pass_stats_sites, struct pass_stats);
+      stats->pass = pass;
+      /* when is "after <pass> in <file>:<line>" */
+      stats->site = when + strlen("after ") + strlen(pass) + strlen(" in ");
+      _mesa_hash_table_insert(pass_stats_sites, when, stats);
+   }
+
+   stats->calls++;
+   stats->progress += progress;
+   stats->time_ns += time_ns;
+   stats->instr_delta += (int64_t)num_instrs - start->num_instrs;
+   stats->block_delta += (int64_t)num_blocks - start->num_blocks;
+
+   simple_mtx_unlock(&pass_stats_mtx);
+}
+
+#endif /* NDEBUG */
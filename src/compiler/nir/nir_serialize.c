@@ -1970,6 +1970,13 @@ read_cf_list(read_ctx *ctx, struct exec_list *cf_list)
 static void
 write_function_impl(write_ctx *ctx, const nir_function_impl *fi)
 {
+   /* Every impl is encoded on its own, so that nir_deserialize_lazy() can
+    * read them in any order.
+    */
+   ctx->last_type = NULL;
+   ctx->last_interface_type = NULL;
+   memset(&ctx->last_var_data, 0, sizeof(ctx->last_var_data));
+
    blob_write_uint8(ctx->blob, fi->structured);
    blob_write_uint8(ctx->blob, !!fi->preamble);
 
@@ -1987,6 +1994,10 @@ read_function_impl(read_ctx *ctx)
 {
    nir_function_impl *fi = nir_function_impl_create_bare(ctx->nir);
 
+   ctx->last_type = NULL;
+   ctx->last_interface_type = NULL;
+   memset(&ctx->last_var_data, 0, sizeof(ctx->last_var_data));
+
    fi->structured = blob_read_uint8(ctx->blob);
    bool preamble = blob_read_uint8(ctx->blob);
 
@@ -2189,6 +2200,9 @@ nir_serialize_function(struct blob *blob, const nir_function *fxn)
 static void
 serialize_internal(struct blob *blob, const nir_shader *nir, bool strip, bool serialize_info)
 {
+   /* See nir_shader_materialize() */
+   assert(nir->lazy_impls == NULL);
+
    write_ctx ctx = { 0 };
    _mesa_pointer_hash_table_init(&ctx.remap_table, NULL);
    ctx.blob = blob;
@@ -2232,7 +2246,17 @@ serialize_internal(struct blob *blob, const nir_shader *nir, bool strip, bool se
    }
 
    nir_foreach_function_impl(impl, nir) {
+      /* Lets nir_deserialize_lazy() skip the impl */
+      size_t num_objects_offset = blob_reserve_uint32(blob);
+      size_t size_offset = blob_reserve_uint32(blob);
+      const uint32_t first_idx = ctx.next_idx;
+      const size_t start = blob->size;
+
       write_function_impl(&ctx, impl);
+
+      blob_overwrite_uint32(blob, num_objects_offset,
+                            ctx.next_idx - first_idx);
+      blob_overwrite_uint32(blob, size_offset, blob->size - start);
    }
 
    blob_write_uint32(blob, nir->constant_data_size);
@@ -2263,16 +2287,32 @@ nir_serialize(struct blob *blob, const nir_shader *nir, bool strip)
    serialize_internal(blob, nir, strip, true);
 }
 
-nir_shader *
-nir_deserialize(void *mem_ctx,
-                const struct nir_shader_compiler_options *options,
-                struct blob_reader *blob)
+struct nir_lazy_impl {
+   /* Where the impl is in the blob */
+   size_t offset;
+   uint32_t size;
+
+   /* Index of the first object the impl defines */
+   uint32_t first_idx;
+};
+
+struct nir_lazy_impls {
+   /* Start of the blob the shader was deserialized from */
+   const uint8_t *data;
+
+   /* Index -> object table and string table, shared by all impls */
+   read_ctx ctx;
+
+   /* nir_function -> struct nir_lazy_impl */
+   struct hash_table *pending;
+};
+
+static nir_shader *
+deserialize_internal(void *mem_ctx,
+                     const struct nir_shader_compiler_options *options,
+                     struct blob_reader *blob, bool lazy)
 {
-   read_ctx ctx = { 0 };
-   ctx.blob = blob;
-   list_inithead(&ctx.phi_srcs);
-   ctx.idx_table_len = blob_read_uint32(blob);
-   ctx.idx_table = calloc(ctx.idx_table_len, sizeof(uintptr_t));
+   uint32_t idx_table_len = blob_read_uint32(blob);
 
    enum nir_serialize_shader_flags flags = blob_read_uint32(blob);
    char *name = (flags & NIR_SERIALIZE_SHADER_NAME) ? blob_read_string(blob) : NULL;
@@ -2281,55 +2321,194 @@ nir_deserialize(void *mem_ctx,
    struct shader_info info;
    blob_copy_bytes(blob, (uint8_t *)&info, sizeof(info));
 
-   ctx.nir = nir_shader_create(mem_ctx, info.stage, options);
+   nir_shader *nir = nir_shader_create(mem_ctx, info.stage, options);
 
-   ctx.nir->has_debug_info = !!(flags & NIR_SERIALIZE_DEBUG_INFO);
-   if (ctx.nir->has_debug_info)
-      _mesa_hash_table_init(&ctx.strings, NULL, _mesa_hash_string, _mesa_key_string_equal);
+   /* The pending impls keep using the context, including the string table
+    * whose storage is inline, so in that case it lives in lazy_impls from
+    * the start.  lazy_impls is only attached to the shader if some impls are
+    * left.
+    */
+   read_ctx eager_ctx = { 0 };
+   read_ctx *ctx = &eager_ctx;
+   struct nir_lazy_impls *lazy_impls = NULL;
+   if (lazy) {
+      lazy_impls = rzalloc(nir, struct nir_lazy_impls);
+      lazy_impls->data = blob->data;
+      lazy_impls->pending = _mesa_pointer_hash_table_create(lazy_impls);
+      ctx = &lazy_impls->ctx;
+      ctx->idx_table = rzalloc_array(lazy_impls, void *, idx_table_len);
+   } else {
+      ctx->idx_table = calloc(idx_table_len, sizeof(uintptr_t));
+   }
+
+   ctx->nir = nir;
+   ctx->blob = blob;
+   ctx->idx_table_len = idx_table_len;
+   list_inithead(&ctx->phi_srcs);
 
-   info.name = name ? ralloc_strdup(ctx.nir, name) : NULL;
-   info.label = label ? ralloc_strdup(ctx.nir, label) : NULL;
+   nir->has_debug_info = !!(flags & NIR_SERIALIZE_DEBUG_INFO);
+   if (nir->has_debug_info)
+      _mesa_hash_table_init(&ctx->strings, lazy_impls, _mesa_hash_string, _mesa_key_string_equal);
 
-   ctx.nir->info = info;
+   info.name = name ? ralloc_strdup(nir, name) : NULL;
+   info.label = label ? ralloc_strdup(nir, label) : NULL;
 
-   read_var_list(&ctx, &ctx.nir->variables);
+   nir->info = info;
 
-   ctx.nir->num_inputs = blob_read_uint32(blob);
-   ctx.nir->num_uniforms = blob_read_uint32(blob);
-   ctx.nir->num_outputs = blob_read_uint32(blob);
-   ctx.nir->scratch_size = blob_read_uint32(blob);
+   read_var_list(ctx, &nir->variables);
+
+   nir->num_inputs = blob_read_uint32(blob);
+   nir->num_uniforms = blob_read_uint32(blob);
+   nir->num_outputs = blob_read_uint32(blob);
+   nir->scratch_size = blob_read_uint32(blob);
 
    unsigned num_functions = blob_read_uint32(blob);
    for (unsigned i = 0; i < num_functions; i++)
-      read_function(&ctx);
+      read_function(ctx);
+
+   nir_foreach_function(fxn, nir) {
+      if (fxn->impl != NIR_SERIALIZE_FUNC_HAS_IMPL)
+         continue;
+
+      uint32_t num_objects = blob_read_uint32(blob);
+      uint32_t size = blob_read_uint32(blob);
+
+      if (lazy) {
+         struct nir_lazy_impl *pending =
+            ralloc(lazy_impls, struct nir_lazy_impl);
+         pending->offset = blob->current - blob->data;
+         pending->size = size;
+         pending->first_idx = ctx->next_idx;
+         _mesa_hash_table_insert(lazy_impls->pending, fxn, pending);
+
+         fxn->impl = NULL;
+         ctx->next_idx += num_objects;
+         blob_skip_bytes(blob, size);
+      } else {
+         ASSERTED const uint8_t *start = blob->current;
+         nir_function_set_impl(fxn, read_function_impl(ctx));
+         assert(blob->overrun || blob->current == start + size);
+      }
+   }
 
-   nir_foreach_function(fxn, ctx.nir) {
-      if (fxn->impl == NIR_SERIALIZE_FUNC_HAS_IMPL)
-         nir_function_set_impl(fxn, read_function_impl(&ctx));
+   nir->constant_data_size = blob_read_uint32(blob);
+   if (nir->constant_data_size > 0) {
+      nir->constant_data = ralloc_size(nir, nir->constant_data_size);
+      blob_copy_bytes(blob, nir->constant_data, nir->constant_data_size);
    }
 
-   ctx.nir->constant_data_size = blob_read_uint32(blob);
-   if (ctx.nir->constant_data_size > 0) {
-      ctx.nir->constant_data =
-         ralloc_size(ctx.nir, ctx.nir->constant_data_size);
-      blob_copy_bytes(blob, ctx.nir->constant_data,
-                      ctx.nir->constant_data_size);
+   nir->xfb_info = read_xfb_info(ctx);
+
+   if (nir->info.uses_printf) {
+      nir->printf_info =
+         u_printf_deserialize_info(nir, blob, &nir->printf_info_count);
    }
 
-   ctx.nir->xfb_info = read_xfb_info(&ctx);
+   ctx->blob = NULL;
 
-   if (ctx.nir->info.uses_printf) {
-      ctx.nir->printf_info =
-         u_printf_deserialize_info(ctx.nir, blob,
-                                   &ctx.nir->printf_info_count);
+   if (lazy_impls && _mesa_hash_table_num_entries(lazy_impls->pending) > 0) {
+      nir->lazy_impls = lazy_impls;
+      return nir;
    }
 
-   free(ctx.idx_table);
-   _mesa_hash_table_fini(&ctx.strings, NULL);
+   _mesa_hash_table_fini(&ctx->strings, NULL);
+   if (lazy_impls)
+      ralloc_free(lazy_impls);
+   else
+      free(ctx->idx_table);
 
-   nir_validate_shader(ctx.nir, "after deserialize");
+   nir_validate_shader(nir, "after deserialize");
+
+   return nir;
+}
+
+nir_shader *
+nir_deserialize(void *mem_ctx,
+                const struct nir_shader_compiler_options *options,
+                struct blob_reader *blob)
+{
+   return deserialize_internal(mem_ctx, options, blob, false);
+}
+
+/**
+ * Deserializes everything but the function bodies, which are read from the
+ * blob when nir_function_materialize() or nir_shader_get_entrypoint() first
+ * asks for them.  Until then, their nir_function::impl is NULL.
+ *
+ * This is meant for cache hits which only need shader_info, the variables
+ * or some of the functions.  The blob's data is not copied and must outlive
+ * the shader, or at least the call to nir_shader_materialize().  The shader
+ * can't be validated, cloned, serialized or run through passes before it is
+ * fully materialized.
+ */
+nir_shader *
+nir_deserialize_lazy(void *mem_ctx,
+                     const struct nir_shader_compiler_options *options,
+                     struct blob_reader *blob)
+{
+   return deserialize_internal(mem_ctx, options, blob, true);
+}
+
+/**
+ * Reads the body of a function of a shader from nir_deserialize_lazy(), if
+ * it hasn't been read yet.  Returns the function's impl.
+ */
+nir_function_impl *
+nir_function_materialize(nir_function *fxn)
+{
+   nir_shader *shader = fxn->shader;
+   struct nir_lazy_impls *lazy_impls = shader->lazy_impls;
+   if (!lazy_impls)
+      return fxn->impl;
 
-   return ctx.nir;
+   struct hash_entry *entry =
+      _mesa_hash_table_search(lazy_impls->pending, fxn);
+   if (!entry)
+      return fxn->impl;
+
+   struct nir_lazy_impl *pending = entry->data;
+   _mesa_hash_table_remove(lazy_impls->pending, entry);
+
+   /* Starting at the blob's data keeps the reads aligned as when writing */
+   struct blob_reader blob;
+   blob_reader_init(&blob, lazy_impls->data, pending->offset + pending->size);
+   blob.current += pending->offset;
+
+   read_ctx *ctx = &lazy_impls->ctx;
+   ctx->nir = shader;
+   ctx->blob = &blob;
+   ctx->next_idx = pending->first_idx;
+   list_inithead(&ctx->phi_srcs);
+
+   nir_function_set_impl(fxn, read_function_impl(ctx));
+   assert(blob.overrun || blob.current == blob.end);
+
+   ctx->blob = NULL;
+   ralloc_free(pending);
+
+   if (_mesa_hash_table_num_entries(lazy_impls->pending) == 0) {
+      _mesa_hash_table_fini(&ctx->strings, NULL);
+      shader->lazy_impls = NULL;
+      ralloc_free(lazy_impls);
+
+      nir_validate_shader(shader, "after deserialize");
+   }
+
+   return fxn->impl;
+}
+
+/**
+ * Reads every function body nir_deserialize_lazy() left out.
+ */
+void
+nir_shader_materialize(nir_shader *shader)
+{
+   nir_foreach_function(fxn, shader) {
+      if (!shader->lazy_impls)
+         break;
+
+      nir_function_materialize(fxn);
+   }
 }
 
 nir_function *
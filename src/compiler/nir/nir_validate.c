@@ -2325,6 +2325,9 @@ nir_validate_shader(nir_shader *shader, const char *when)
       validate_assert(&state, shader->xfb_info->output_count > 0);
    }
 
+   /* Passes would skip the bodies nir_deserialize_lazy() hasn't read yet */
+   validate_assert(&state, shader->lazy_impls == NULL);
+
    validate_assert(&state,
                    util_is_power_of_two_or_zero(shader->info.api_subgroup_size));
    validate_assert(&state,
@@ -117,4 +117,41 @@ TEST_F(nir_core_test, nir_instr_free_and_dce_multiple_src_test)
    nir_validate_shader(b->shader, "after remove_and_dce");
 }
 
+#ifndef NDEBUG
+TEST_F(nir_core_test, nir_pass_stats_test)
+{
+   nir_def *one = nir_imm_int(b, 1);
+   nir_iadd(b, one, one);
+   nir_iadd(b, one, one);
+
+   const uint32_t saved_debug = nir_debug;
+   nir_debug |= NIR_DEBUG_PASS_STATS;
+
+   bool progress = false;
+   NIR_PASS(progress, b->shader, nir_opt_dce);
+   ASSERT_TRUE(progress);
+   NIR_PASS(progress, b->shader, nir_opt_dce);
+
+   nir_debug = saved_debug;
+
+   FILE *fp = tmpfile();
+   ASSERT_NE(fp, nullptr);
+   nir_pass_stats_write_json(fp);
+
+   char json[4096];
+   rewind(fp);
+   size_t size = fread(json, 1, sizeof(json) - 1, fp);
+   json[size] = '\0';
+   fclose(fp);
+
+   /* Both calls are aggregated under the pass; only the first made progress
+    * and it removed all three instructions.
+    */
+   EXPECT_NE(strstr(json, "{\"pass\": \"nir_opt_dce\", \"calls\": 2, "
+                          "\"progress\": 1, "), nullptr);
+   EXPECT_NE(strstr(json, "\"instr_delta\": -3, \"block_delta\": 0}"), nullptr);
+   EXPECT_NE(strstr(json, "\"site\": \""), nullptr);
+}
+#endif
+
 }
@@ -195,3 +195,189 @@ TEST_P(nir_serialize_all_but_one_test, single_channel)
 
    ASSERT_SWIZZLE_EQ(vec_alu, vec_alu_dup, 1, 0);
 }
+
+namespace {
+
+class nir_serialize_lazy_test : public ::testing::Test {
+protected:
+   nir_serialize_lazy_test();
+   ~nir_serialize_lazy_test();
+
+   void build(bool debug_info);
+   void serialize();
+   void expect_same_as_eager(nir_shader *lazy);
+
+   nir_builder *b, _b;
+   nir_function *helper;
+   struct blob blob;
+   const nir_shader_compiler_options options;
+};
+
+nir_serialize_lazy_test::nir_serialize_lazy_test()
+:  options()
+{
+   glsl_type_singleton_init_or_ref();
+
+   _b = nir_builder_init_simple_shader(MESA_SHADER_COMPUTE, &options, "serialize lazy test");
+   b = &_b;
+
+   blob_init(&blob);
+}
+
+void
+nir_serialize_lazy_test::build(bool debug_info)
+{
+   /* Instructions only get debug info if it is set when they are created */
+   b->shader->has_debug_info = debug_info;
+
+   /* Both impls have locals, so they only decode right on their own if
+    * nothing carries over from one impl to the next.
+    */
+   helper = nir_function_create(b->shader, "helper");
+   nir_function_impl *impl = nir_function_impl_create(helper);
+   nir_builder hb = nir_builder_at(nir_after_impl(impl));
+   nir_variable *tmp = nir_local_variable_create(impl, glsl_uint_type(), "tmp");
+   nir_store_var(&hb, tmp, nir_imm_int(&hb, 1), 0x1);
+
+   nir_variable *v = nir_local_variable_create(b->impl, glsl_uint_type(), "v");
+   nir_store_var(b, v, nir_imm_int(b, 2), 0x1);
+   nir_build_call(b, helper, 0, NULL);
+
+   if (!debug_info)
+      return;
+
+   /* The same file name in both impls, which the reader deduplicates with
+    * a string table shared by the impls.
+    */
+   static char filename[] = "serialize_tests.cpp";
+   nir_foreach_function_impl(fi, b->shader) {
+      nir_foreach_block(block, fi) {
+         nir_foreach_instr(instr, block) {
+            nir_instr_debug_info *info = nir_instr_get_debug_info(instr);
+            info->filename = filename;
+            info->line = 1;
+         }
+      }
+   }
+}
+
+nir_serialize_lazy_test::~nir_serialize_lazy_test()
+{
+   blob_finish(&blob);
+   ralloc_free(b->shader);
+
+   glsl_type_singleton_decref();
+}
+
+void
+nir_serialize_lazy_test::serialize()
+{
+   nir_serialize(&blob, b->shader, false);
+}
+
+void
+nir_serialize_lazy_test::expect_same_as_eager(nir_shader *lazy)
+{
+   struct blob_reader reader;
+   blob_reader_init(&reader, blob.data, blob.size);
+   nir_shader *eager = nir_deserialize(b->shader, &options, &reader);
+
+   struct blob a, c;
+   blob_init(&a);
+   blob_init(&c);
+   nir_serialize(&a, eager, false);
+   nir_serialize(&c, lazy, false);
+
+   ASSERT_EQ(a.size, c.size);
+   EXPECT_EQ(memcmp(a.data, c.data, a.size), 0);
+
+   blob_finish(&a);
+   blob_finish(&c);
+}
+
+} // namespace
+
+TEST_F(nir_serialize_lazy_test, entrypoint_on_demand)
+{
+   build(false);
+   serialize();
+
+   struct blob_reader reader;
+   blob_reader_init(&reader, blob.data, blob.size);
+   nir_shader *dup = nir_deserialize_lazy(b->shader, &options, &reader);
+   ASSERT_FALSE(reader.overrun);
+   ASSERT_EQ(reader.current, reader.end);
+
+   EXPECT_EQ(dup->info.stage, MESA_SHADER_COMPUTE);
+   ASSERT_NE(dup->lazy_impls, nullptr);
+
+   nir_function *dup_helper = nir_shader_get_function_for_name(dup, "helper");
+   ASSERT_NE(dup_helper, nullptr);
+   EXPECT_EQ(dup_helper->impl, nullptr);
+
+   ASSERT_NE(nir_shader_get_entrypoint(dup), nullptr);
+   EXPECT_EQ(dup_helper->impl, nullptr);
+   EXPECT_NE(dup->lazy_impls, nullptr);
+
+   nir_shader_materialize(dup);
+   EXPECT_EQ(dup->lazy_impls, nullptr);
+   EXPECT_NE(dup_helper->impl, nullptr);
+
+   expect_same_as_eager(dup);
+}
+
+TEST_F(nir_serialize_lazy_test, out_of_order)
+{
+   build(false);
+   serialize();
+
+   struct blob_reader reader;
+   blob_reader_init(&reader, blob.data, blob.size);
+   nir_shader *dup = nir_deserialize_lazy(b->shader, &options, &reader);
+
+   nir_function *dup_helper = nir_shader_get_function_for_name(dup, "helper");
+   ASSERT_NE(nir_function_materialize(dup_helper), nullptr);
+   EXPECT_NE(dup->lazy_impls, nullptr);
+
+   ASSERT_NE(nir_shader_get_entrypoint(dup), nullptr);
+   EXPECT_EQ(dup->lazy_impls, nullptr);
+
+   expect_same_as_eager(dup);
+}
+
+TEST_F(nir_serialize_lazy_test, sweep_keeps_pending_bodies)
+{
+   build(false);
+   serialize();
+
+   struct blob_reader reader;
+   blob_reader_init(&reader, blob.data, blob.size);
+   nir_shader *dup = nir_deserialize_lazy(b->shader, &options, &reader);
+
+   nir_sweep(dup);
+   nir_shader_materialize(dup);
+
+   expect_same_as_eager(dup);
+}
+
+TEST_F(nir_serialize_lazy_test, debug_info)
+{
+   build(true);
+   serialize();
+
+   struct blob_reader reader;
+   blob_reader_init(&reader, blob.data, blob.size);
+   nir_shader *dup = nir_deserialize_lazy(b->shader, &options, &reader);
+   ASSERT_TRUE(dup->has_debug_info);
+
+   nir_function *dup_helper = nir_shader_get_function_for_name(dup, "helper");
+   nir_function_materialize(dup_helper);
+   nir_function_impl *entrypoint = nir_shader_get_entrypoint(dup);
+   EXPECT_EQ(dup->lazy_impls, nullptr);
+
+   nir_instr *first = nir_block_first_instr(nir_start_block(entrypoint));
+   EXPECT_STREQ(nir_instr_get_debug_info(first)->filename,
+                "serialize_tests.cpp");
+
+   expect_same_as_eager(dup);
+}
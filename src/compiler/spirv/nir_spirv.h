@@ -147,6 +147,13 @@ struct spirv_to_nir_options {
 
    /* If GroupNonUniform capability is used, set this api subgroup size. */
    uint8_t group_non_uniform_subgroup_size;
+
+   /* Number of threads function bodies may be emitted on.  When more than
+    * one function needs emitting, they are split between the threads and
+    * linked back into one shader afterwards.  0 and 1 emit everything on
+    * the calling thread.
+    */
+   unsigned num_threads;
 };
 
 enum spirv_verify_result {
@@ -30,6 +30,7 @@
 #include "nir.h"
 #include "nir_spirv.h"
 #include "spirv.h"
+#include "util/os_time.h"
 #include "util/u_dynarray.h"
 #include "vtn_private.h"
 
@@ -43,6 +44,7 @@
 #include <getopt.h>
 
 #define WORD_SIZE 4
+#define BENCH_RUNS 5
 
 struct {
    const char *name;
@@ -102,6 +104,10 @@ print_usage(char *exec_name, FILE *f)
            "  -g, --opengl            Use OpenGL environment instead of Vulkan for\n"
            "                          graphics stages.\n"
            "  --optimize              Run basic NIR optimizations in the result.\n"
+           "  -j, --threads <n>       Emit function bodies on up to n threads.\n"
+           "  --bench                 Instead of printing the result, time the\n"
+           "                          conversion on 1, 2, 4, ... up to --threads\n"
+           "                          threads and report the throughput.\n"
            "\n"
            "Passing the stage and the entry-point name is optional unless there's\n"
            "ambiguity, in which case the program will print the entry-points\n"
@@ -196,6 +202,8 @@ int main(int argc, char **argv)
    };
    int ch;
    bool optimize = false;
+   bool bench = false;
+   unsigned num_threads = 1;
    enum nir_spirv_execution_environment env = NIR_SPIRV_VULKAN;
 
    static struct option long_options[] =
@@ -205,10 +213,12 @@ int main(int argc, char **argv)
          {"entry",    required_argument, 0, 'e'},
          {"opengl",   no_argument,       0, 'g'},
          {"optimize", no_argument,       0, 'O'},
+         {"threads",  required_argument, 0, 'j'},
+         {"bench",    no_argument,       0, 'B'},
          {0, 0,                          0, 0}
       };
 
-   while ((ch = getopt_long(argc, argv, "hs:e:g", long_options, NULL)) != -1) {
+   while ((ch = getopt_long(argc, argv, "hs:e:gj:", long_options, NULL)) != -1) {
       switch (ch) {
       case 'h':
          print_usage(argv[0], stdout);
@@ -232,6 +242,12 @@ int main(int argc, char **argv)
       case 'O':
          optimize = true;
          break;
+      case 'j':
+         num_threads = MAX2(atoi(optarg), 1);
+         break;
+      case 'B':
+         bench = true;
+         break;
       default:
          fprintf(stderr, "Unrecognized option \"%s\".\n", optarg);
          print_usage(argv[0], stderr);
@@ -288,6 +304,48 @@ int main(int argc, char **argv)
    if (entry_point.stage == MESA_SHADER_KERNEL)
       spirv_opts.environment = NIR_SPIRV_OPENCL;
 
+   if (bench) {
+      int ret = 0;
+
+      /* 1, 2, 4, ... threads, always finishing with num_threads */
+      for (unsigned n = 1;; n = MIN2(n * 2, num_threads)) {
+         spirv_opts.num_threads = n;
+
+         int64_t best = INT64_MAX;
+         for (unsigned i = 0; i < BENCH_RUNS; i++) {
+            int64_t start = os_time_get_nano();
+            nir_shader *nir = spirv_to_nir(map, word_count, NULL, 0,
+                                           entry_point.stage, entry_point.name,
+                                           &spirv_opts, &nir_opts);
+            int64_t end = os_time_get_nano();
+
+            if (!nir) {
+               fprintf(stderr, "SPIRV to NIR compilation failed\n");
+               ret = 1;
+               break;
+            }
+
+            ralloc_free(nir);
+            best = MIN2(best, end - start);
+         }
+
+         if (ret)
+            break;
+
+         printf("%2u threads: %9.3f ms  %8.2f MB/s\n", n, best / 1e6,
+                len * 1e3 / MAX2(best, 1));
+
+         if (n == num_threads)
+            break;
+      }
+
+      glsl_type_singleton_decref();
+      ralloc_free(mem_ctx);
+      return ret;
+   }
+
+   spirv_opts.num_threads = num_threads;
+
    nir_shader *nir = spirv_to_nir(map, word_count, NULL, 0,
                                   entry_point.stage, entry_point.name,
                                   &spirv_opts, &nir_opts);
@@ -6277,7 +6277,7 @@ vtn_handle_write_packed_primitive_indices(struct vtn_builder *b, SpvOp opcode,
                "must be an OpTypeInt with 32-bit Width and 0 Signedness.");
 
    nir_deref_instr *indices = NULL;
-   nir_foreach_variable_with_modes(var, b->nb.shader, nir_var_shader_out) {
+   nir_foreach_variable_with_modes(var, b->globals, nir_var_shader_out) {
       if (var->data.location == VARYING_SLOT_PRIMITIVE_INDICES) {
          indices = nir_build_deref_var(&b->nb, var);
          break;
@@ -7304,6 +7304,7 @@ spirv_to_nir(const uint32_t *words, size_t word_count,
    }
 
    b->shader = nir_shader_create(b, stage, nir_options);
+   b->globals = b->shader;
    b->shader->info.float_controls_execution_mode = options->float_controls_execution_mode;
    if (mesa_shader_stage_uses_workgroup(stage))
       b->shader->info.workgroup_size_variable = true;
@@ -7465,6 +7466,12 @@ spirv_to_nir(const uint32_t *words, size_t word_count,
       b->entry_point->func->referenced = true;
    }
 
+   /* The values of bodies emitted on other threads wouldn't show up in
+    * vtn_dump_values().  Whatever isn't emitted here is by the loop below.
+    */
+   if (options->num_threads > 1 && !MESA_SPIRV_DEBUG(VALUES))
+      vtn_emit_functions_parallel(b, vtn_handle_body_instruction);
+
    bool progress;
    do {
       progress = false;
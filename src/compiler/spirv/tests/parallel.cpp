@@ -0,0 +1,114 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+#include "helpers.h"
+
+class Parallel : public spirv_test {
+protected:
+   Parallel()
+   {
+      spirv_caps.GroupNonUniform = true;
+      spirv_caps.GroupNonUniformQuad = true;
+   }
+
+   char *get_nir_str(size_t num_words, const uint32_t *words, unsigned num_threads)
+   {
+      spirv_options.num_threads = num_threads;
+
+      ralloc_free(shader);
+      get_nir(num_words, words, MESA_SHADER_FRAGMENT);
+      if (!shader)
+         return NULL;
+
+      /* Workers clone their impls in, so only the numbering may differ */
+      nir_foreach_function_impl(impl, shader) {
+         nir_index_blocks(impl);
+         nir_index_ssa_defs(impl);
+      }
+
+      return nir_shader_as_str(shader, shader);
+   }
+};
+
+TEST_F(Parallel, matches_serial)
+{
+   /*
+               OpCapability Shader
+               OpCapability GroupNonUniform
+               OpCapability GroupNonUniformQuad
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %main "main" %out
+               OpExecutionMode %main OriginUpperLeft
+               OpName %quad "quad"
+               OpName %add "add"
+               OpName %main "main"
+               OpDecorate %out Location 0
+       %void = OpTypeVoid
+          %2 = OpTypeFunction %void
+       %uint = OpTypeInt 32 0
+          %4 = OpTypeFunction %uint %uint
+%_ptr_Output_uint = OpTypePointer Output %uint
+        %out = OpVariable %_ptr_Output_uint Output
+     %uint_0 = OpConstant %uint 0
+     %uint_1 = OpConstant %uint 1
+     %uint_3 = OpConstant %uint 3
+       %quad = OpFunction %uint None %4
+         %11 = OpFunctionParameter %uint
+         %12 = OpLabel
+         %13 = OpGroupNonUniformQuadSwap %uint %uint_3 %11 %uint_0
+               OpReturnValue %13
+               OpFunctionEnd
+        %add = OpFunction %uint None %4
+         %15 = OpFunctionParameter %uint
+         %16 = OpLabel
+         %17 = OpIAdd %uint %15 %uint_3
+               OpReturnValue %17
+               OpFunctionEnd
+       %main = OpFunction %void None %2
+         %19 = OpLabel
+         %20 = OpFunctionCall %uint %add %uint_1
+         %21 = OpFunctionCall %uint %quad %20
+               OpStore %out %21
+               OpReturn
+               OpFunctionEnd
+   */
+   static const uint32_t words[] = {
+      0x07230203, 0x00010300, 0x00000000, 0x00000016, 0x00000000, 0x00020011,
+      0x00000001, 0x00020011, 0x0000003d, 0x00020011, 0x00000044, 0x0003000e,
+      0x00000000, 0x00000001, 0x0006000f, 0x00000004, 0x00000012, 0x6e69616d,
+      0x00000000, 0x00000006, 0x00030010, 0x00000012, 0x00000007, 0x00040005,
+      0x0000000a, 0x64617571, 0x00000000, 0x00030005, 0x0000000e, 0x00646461,
+      0x00040005, 0x00000012, 0x6e69616d, 0x00000000, 0x00040047, 0x00000006,
+      0x0000001e, 0x00000000, 0x00020013, 0x00000001, 0x00030021, 0x00000002,
+      0x00000001, 0x00040015, 0x00000003, 0x00000020, 0x00000000, 0x00040021,
+      0x00000004, 0x00000003, 0x00000003, 0x00040020, 0x00000005, 0x00000003,
+      0x00000003, 0x0004003b, 0x00000005, 0x00000006, 0x00000003, 0x0004002b,
+      0x00000003, 0x00000007, 0x00000000, 0x0004002b, 0x00000003, 0x00000008,
+      0x00000001, 0x0004002b, 0x00000003, 0x00000009, 0x00000003, 0x00050036,
+      0x00000003, 0x0000000a, 0x00000000, 0x00000004, 0x00030037, 0x00000003,
+      0x0000000b, 0x000200f8, 0x0000000c, 0x0006016e, 0x00000003, 0x0000000d,
+      0x00000009, 0x0000000b, 0x00000007, 0x000200fe, 0x0000000d, 0x00010038,
+      0x00050036, 0x00000003, 0x0000000e, 0x00000000, 0x00000004, 0x00030037,
+      0x00000003, 0x0000000f, 0x000200f8, 0x00000010, 0x00050080, 0x00000003,
+      0x00000011, 0x0000000f, 0x00000009, 0x000200fe, 0x00000011, 0x00010038,
+      0x00050036, 0x00000001, 0x00000012, 0x00000000, 0x00000002, 0x000200f8,
+      0x00000013, 0x00050039, 0x00000003, 0x00000014, 0x0000000e, 0x00000008,
+      0x00050039, 0x00000003, 0x00000015, 0x0000000a, 0x00000014, 0x0003003e,
+      0x00000006, 0x00000015, 0x000100fd, 0x00010038,
+   };
+
+   char *serial = get_nir_str(sizeof(words) / sizeof(words[0]), words, 1);
+   ASSERT_NE(serial, nullptr);
+   serial = ralloc_strdup(NULL, serial);
+   EXPECT_TRUE(shader->info.fs.require_full_quads);
+
+   char *parallel = get_nir_str(sizeof(words) / sizeof(words[0]), words, 4);
+   ASSERT_NE(parallel, nullptr);
+
+   /* Set by the quad swap, which a worker emits */
+   EXPECT_TRUE(shader->info.fs.require_full_quads);
+   EXPECT_STREQ(serial, parallel);
+
+   ralloc_free(serial);
+}
@@ -0,0 +1,567 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Emitting function bodies on several threads.
+ *
+ * Everything up to vtn_build_cfg() runs on the calling thread as usual: the
+ * types, decorations, constants, global variables and the nir_function of
+ * every function exist before any body is emitted, and body handlers only
+ * read them.  The functions to emit are then split between workers, each
+ * with a copy of the vtn_builder that has its own vtn_value array, linear
+ * allocator and scratch nir_shader.  A worker emits a function into an impl
+ * of its scratch shader, attached to a stand-in nir_function carrying the
+ * parameters, so nothing a worker allocates or frees belongs to the real
+ * shader while workers run.  Workers also structurize their impls.
+ *
+ * Once every worker is done, the results are linked into the real shader,
+ * worker by worker so that the output doesn't depend on scheduling:
+ *
+ *  - printf infos are appended, and nir_printf's fmt_idx rebased;
+ *  - variables a worker created are matched by location against the
+ *    shader's, or cloned into it;
+ *  - functions a worker created, such as declarations of OpenCL library
+ *    functions, are matched by name against the shader's, or cloned into it;
+ *  - impls are moved into the shader with all of the above remapped, along
+ *    with the rest of the worker's allocations;
+ *  - the shader_info flags body handlers set are merged, and in debug
+ *    builds the rest is checked to be unchanged.
+ *
+ * The worker threads come from a pool shared by all translations, created
+ * the first time one runs in parallel.
+ */
+
+#include "vtn_private.h"
+
+#include "util/hash_table.h"
+#include "util/set.h"
+#include "util/u_dynarray.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_printf.h"
+#include "util/u_queue.h"
+
+struct vtn_worker {
+   struct vtn_builder *b;
+   vtn_instruction_handler handler;
+
+   /* The shader_info the worker started from */
+   shader_info info;
+
+   /* struct vtn_function * */
+   struct util_dynarray funcs;
+   size_t num_words;
+
+   struct util_queue_fence fence;
+   bool failed;
+};
+
+static size_t
+vtn_function_num_words(struct vtn_function *func)
+{
+   return func->end - func->start_block->label;
+}
+
+/* Marks everything the referenced functions call as referenced, as emitting
+ * them would.  This also means the handlers of these instructions don't
+ * change anything while workers emit the callers.
+ */
+static void
+mark_referenced_functions(struct vtn_builder *b)
+{
+   bool progress;
+   do {
+      progress = false;
+      vtn_foreach_function(func, &b->functions) {
+         if (!func->referenced)
+            continue;
+
+         const uint32_t *w = func->start_block->label;
+         while (w < func->end) {
+            SpvOp opcode = w[0] & SpvOpCodeMask;
+            unsigned count = w[0] >> SpvWordCountShift;
+            vtn_assert(count >= 1 && w + count <= func->end);
+
+            uint32_t callee_id;
+            switch (opcode) {
+            case SpvOpFunctionCall:
+               callee_id = w[3];
+               break;
+            case SpvOpCooperativeMatrixReduceNV:
+               callee_id = w[5];
+               break;
+            case SpvOpCooperativeMatrixPerElementOpNV:
+               callee_id = w[4];
+               break;
+            default:
+               callee_id = 0;
+               break;
+            }
+
+            if (callee_id) {
+               struct vtn_function *callee =
+                  vtn_value(b, callee_id, vtn_value_type_function)->func;
+               if (opcode != SpvOpFunctionCall)
+                  callee->nir_func->cmat_call = true;
+               if (!callee->referenced) {
+                  callee->referenced = true;
+                  progress = true;
+               }
+            }
+
+            w += count;
+         }
+      }
+   } while (progress);
+}
+
+/* The copy shares everything the builder points to.  Body handlers only
+ * read the types, constants and global variables, with one exception:
+ * remap_parameter_values() rewrites the parameters' vtn_ssa_values and
+ * vtn_pointers in place, which the calling thread does before any worker
+ * starts.  Each parameter belongs to a single function, so a single worker
+ * ever uses the rewritten values.
+ */
+static struct vtn_builder *
+create_worker_builder(struct vtn_builder *b)
+{
+   struct vtn_builder *wb = ralloc(b, struct vtn_builder);
+   *wb = *b;
+
+   /* Sized like vtn_create_builder() does, for the function values only */
+   const linear_opts lin_opts = {
+      .min_buffer_size = b->value_id_bound * sizeof(struct vtn_ssa_value),
+   };
+   wb->lin_ctx = linear_context_with_opts(wb, &lin_opts);
+
+   wb->values = ralloc_array(wb, struct vtn_value, b->value_id_bound);
+   memcpy(wb->values, b->values, b->value_id_bound * sizeof(*b->values));
+
+   wb->shader = nir_shader_create(wb, b->shader->info.stage,
+                                  b->shader->options);
+   wb->shader->info = b->shader->info;
+   wb->shader->has_debug_info = b->shader->has_debug_info;
+
+   if (b->vars_used_indirectly)
+      wb->vars_used_indirectly = _mesa_pointer_set_create(wb);
+   if (b->strings)
+      wb->strings = _mesa_pointer_hash_table_create(wb);
+
+   wb->func = NULL;
+   wb->block = NULL;
+
+   return wb;
+}
+
+static void *
+remap_pointer(struct hash_table *remap, void *ptr)
+{
+   if (ptr == NULL)
+      return NULL;
+
+   struct hash_entry *entry = _mesa_hash_table_search(remap, ptr);
+   return entry ? entry->data : ptr;
+}
+
+static void
+remap_ssa_value(struct hash_table *remap, struct vtn_ssa_value *value)
+{
+   if (value->is_variable) {
+      value->var = remap_pointer(remap, value->var);
+   } else if (glsl_type_is_vector_or_scalar(value->type)) {
+      value->def = remap_pointer(remap, value->def);
+   } else {
+      unsigned elems = glsl_get_length(value->type);
+      for (unsigned i = 0; i < elems; i++)
+         remap_ssa_value(remap, value->elems[i]);
+   }
+}
+
+/* Gives func a stand-in function in the worker's shader, with a copy of the
+ * impl which so far only loads the parameters.  The nir_function points to
+ * the copy until link_worker() replaces it, which is where
+ * vtn_function_emit() picks it up.  What was copied is recorded in remap.
+ *
+ * The instructions are copied rather than moved, as passes run by the worker
+ * would otherwise free them from the shader's gc context while other workers
+ * allocate from it.
+ */
+static void
+assign_function_to_worker(struct vtn_builder *wb, struct vtn_function *func,
+                          struct hash_table *remap)
+{
+   nir_function *nir_func = func->nir_func;
+   nir_function_impl *impl = nir_func->impl;
+
+   nir_function *stand_in = nir_function_clone(wb->shader, nir_func);
+   nir_function_impl *wimpl = nir_function_impl_create(stand_in);
+
+   nir_foreach_function_temp_variable(var, impl) {
+      nir_variable *wvar = nir_variable_clone(var, wb->shader);
+      nir_function_impl_add_variable(wimpl, wvar);
+      _mesa_hash_table_insert(remap, var, wvar);
+   }
+
+   nir_foreach_instr(instr, nir_start_block(impl)) {
+      nir_instr *winstr = nir_instr_clone_deep(wb->shader, instr, remap);
+      nir_instr_insert(nir_after_impl(wimpl), winstr);
+   }
+
+   nir_func->impl = wimpl;
+}
+
+/* Points the parameter values at the copies made by
+ * assign_function_to_worker().  This changes values every worker builder
+ * shares, see create_worker_builder().
+ */
+static void
+remap_parameter_values(struct vtn_builder *b, struct hash_table *remap)
+{
+   for (unsigned i = 0; i < b->value_id_bound; i++) {
+      struct vtn_value *val = &b->values[i];
+      if (val->value_type == vtn_value_type_ssa) {
+         remap_ssa_value(remap, val->ssa);
+      } else if (val->value_type == vtn_value_type_pointer) {
+         val->pointer->desc_index =
+            remap_pointer(remap, val->pointer->desc_index);
+         val->pointer->deref = remap_pointer(remap, val->pointer->deref);
+      }
+   }
+}
+
+static void
+emit_worker_functions(void *data, void *gdata, int thread_index)
+{
+   struct vtn_worker *worker = data;
+   struct vtn_builder *b = worker->b;
+
+   /* See also _vtn_fail() */
+   if (vtn_setjmp(b->fail_jump)) {
+      worker->failed = true;
+      return;
+   }
+
+   util_dynarray_foreach(&worker->funcs, struct vtn_function *, func) {
+      if (b->strings)
+         _mesa_hash_table_clear(b->strings, NULL);
+      vtn_function_emit(b, *func, worker->handler);
+   }
+
+   /* Done here, spirv_to_nir() would do it on the calling thread */
+   nir_lower_goto_ifs(b->shader);
+}
+
+/* Points the global variables and functions a worker's impl uses at the
+ * shader's, which is all nir_function_impl_clone_remap_globals() would
+ * change, and rebases the printf indices.
+ */
+static void
+remap_impl(nir_function_impl *impl, struct hash_table *remap,
+           unsigned printf_base)
+{
+   impl->preamble = remap_pointer(remap, impl->preamble);
+
+   nir_foreach_block(block, impl) {
+      nir_foreach_instr(instr, block) {
+         switch (instr->type) {
+         case nir_instr_type_deref: {
+            nir_deref_instr *deref = nir_instr_as_deref(instr);
+            if (deref->deref_type == nir_deref_type_var)
+               deref->var = remap_pointer(remap, deref->var);
+            break;
+         }
+
+         case nir_instr_type_call: {
+            nir_call_instr *call = nir_instr_as_call(instr);
+            call->callee = remap_pointer(remap, call->callee);
+            break;
+         }
+
+         case nir_instr_type_cmat_call: {
+            nir_cmat_call_instr *call = nir_instr_as_cmat_call(instr);
+            call->callee = remap_pointer(remap, call->callee);
+            break;
+         }
+
+         case nir_instr_type_intrinsic: {
+            nir_intrinsic_instr *intrin = nir_instr_as_intrinsic(instr);
+            if (intrin->intrinsic == nir_intrinsic_printf && printf_base) {
+               nir_intrinsic_set_fmt_idx(intrin,
+                                         nir_intrinsic_fmt_idx(intrin) +
+                                         printf_base);
+            }
+            break;
+         }
+
+         default:
+            break;
+         }
+      }
+   }
+}
+
+static nir_variable *
+find_matching_variable(nir_shader *shader, const nir_variable *var)
+{
+   if (var->data.location < 0)
+      return NULL;
+
+   nir_foreach_variable_with_modes(other, shader, var->data.mode) {
+      if (other->data.location == var->data.location)
+         return other;
+   }
+
+   return NULL;
+}
+
+/* Body handlers only ever set the flags merged below, everything else in
+ * shader_info is set by the execution modes and the like on the calling
+ * thread.  Debug builds check that the worker changed nothing else, so a
+ * flag set by a new handler can't get lost without notice.
+ */
+static void
+merge_worker_info(shader_info *info, const shader_info *winfo,
+                  const shader_info *orig)
+{
+   info->uses_printf |= winfo->uses_printf;
+   if (info->stage == MESA_SHADER_FRAGMENT)
+      info->fs.require_full_quads |= winfo->fs.require_full_quads;
+
+#ifndef NDEBUG
+   shader_info rest = *winfo;
+   rest.uses_printf = orig->uses_printf;
+   if (info->stage == MESA_SHADER_FRAGMENT)
+      rest.fs.require_full_quads = orig->fs.require_full_quads;
+   assert(memcmp(&rest, orig, sizeof(rest)) == 0 &&
+          "shader_info changed by a body handler needs to be merged");
+#endif
+}
+
+static void
+link_worker(struct vtn_builder *b, struct vtn_worker *worker,
+            struct hash_table *remap)
+{
+   struct vtn_builder *wb = worker->b;
+   nir_shader *shader = b->shader;
+   nir_shader *ws = wb->shader;
+
+   const unsigned printf_base = shader->printf_info_count;
+   if (ws->printf_info_count) {
+      shader->printf_info = reralloc(shader, shader->printf_info,
+                                     u_printf_info,
+                                     printf_base + ws->printf_info_count);
+      for (unsigned i = 0; i < ws->printf_info_count; i++) {
+         const u_printf_info *src = &ws->printf_info[i];
+         u_printf_info *dst = &shader->printf_info[printf_base + i];
+
+         dst->num_args = src->num_args;
+         dst->arg_sizes = ralloc_memdup(shader, src->arg_sizes,
+                                        src->num_args * sizeof(unsigned));
+         dst->string_size = src->string_size;
+         dst->strings = ralloc_memdup(shader, src->strings, src->string_size);
+      }
+      shader->printf_info_count += ws->printf_info_count;
+   }
+
+   nir_foreach_variable_in_shader(var, ws) {
+      nir_variable *nvar = find_matching_variable(shader, var);
+      if (!nvar) {
+         nvar = nir_variable_clone(var, shader);
+         nir_shader_add_variable(shader, nvar);
+      }
+      _mesa_hash_table_insert(remap, var, nvar);
+   }
+
+   util_dynarray_foreach(&worker->funcs, struct vtn_function *, func) {
+      nir_function *stand_in = (*func)->nir_func->impl->function;
+      _mesa_hash_table_insert(remap, stand_in, (*func)->nir_func);
+   }
+
+   struct util_dynarray cloned_funcs;
+   util_dynarray_init(&cloned_funcs, wb);
+
+   nir_foreach_function(wfunc, ws) {
+      if (_mesa_hash_table_search(remap, wfunc))
+         continue;
+
+      nir_function *nfunc =
+         nir_shader_get_function_for_name(shader, wfunc->name);
+      if (!nfunc) {
+         nfunc = nir_function_clone(shader, wfunc);
+         if (wfunc->impl)
+            util_dynarray_append(&cloned_funcs, wfunc);
+      }
+      _mesa_hash_table_insert(remap, wfunc, nfunc);
+   }
+
+   /* The impls move to the shader as they are, cloning them would cost
+    * about as much as emitting them did.
+    */
+   util_dynarray_foreach(&cloned_funcs, nir_function *, wfunc) {
+      nir_function *nfunc = _mesa_hash_table_search(remap, *wfunc)->data;
+      remap_impl((*wfunc)->impl, remap, printf_base);
+      nir_function_set_impl(nfunc, (*wfunc)->impl);
+   }
+
+   util_dynarray_foreach(&worker->funcs, struct vtn_function *, func) {
+      nir_function *nir_func = (*func)->nir_func;
+      remap_impl(nir_func->impl, remap, printf_base);
+      nir_function_set_impl(nir_func, nir_func->impl);
+   }
+
+   /* Along with everything else the worker allocated in its shader, which
+    * the shader's next nir_sweep() frees if unused, as it does for what the
+    * calling thread leaves behind.
+    */
+   gc_adopt(shader->gctx, ws->gctx);
+   ralloc_adopt(shader, ws);
+
+   merge_worker_info(&shader->info, &ws->info, &worker->info);
+
+   if (wb->vars_used_indirectly) {
+      set_foreach(wb->vars_used_indirectly, entry) {
+         struct hash_entry *var = _mesa_hash_table_search(remap, entry->key);
+         _mesa_set_add(b->vars_used_indirectly,
+                       var ? var->data : entry->key);
+      }
+   }
+}
+
+static int
+compare_function_size(const void *_a, const void *_b)
+{
+   struct vtn_function *a = *(struct vtn_function *const *)_a;
+   struct vtn_function *b = *(struct vtn_function *const *)_b;
+
+   size_t a_words = vtn_function_num_words(a);
+   size_t b_words = vtn_function_num_words(b);
+   if (a_words != b_words)
+      return a_words < b_words ? 1 : -1;
+
+   /* Ties go by position in the module, keeping the split deterministic */
+   if (a->start_block->label != b->start_block->label)
+      return a->start_block->label < b->start_block->label ? -1 : 1;
+   return 0;
+}
+
+static struct util_queue vtn_queue;
+static bool vtn_have_queue;
+
+static void
+init_vtn_queue(void)
+{
+   /* The calling thread always works too */
+   const unsigned num_threads = MAX2(util_get_cpu_caps()->nr_cpus, 2) - 1;
+
+   vtn_have_queue = util_queue_init(&vtn_queue, "spirv", 64, num_threads,
+                                    UTIL_QUEUE_INIT_RESIZE_IF_FULL, NULL);
+}
+
+static struct util_queue *
+get_vtn_queue(void)
+{
+   static once_flag once = ONCE_FLAG_INIT;
+   call_once(&once, init_vtn_queue);
+   return vtn_have_queue ? &vtn_queue : NULL;
+}
+
+/**
+ * Emits the bodies of all functions spirv_to_nir() would, on up to
+ * options->num_threads threads.  Does nothing when there are less than two
+ * functions, leaving them to the regular loop.
+ */
+void
+vtn_emit_functions_parallel(struct vtn_builder *b,
+                            vtn_instruction_handler instruction_handler)
+{
+   if (!b->options->create_library)
+      mark_referenced_functions(b);
+
+   unsigned num_funcs = 0;
+   vtn_foreach_function(func, &b->functions) {
+      if ((b->options->create_library || func->referenced) && !func->emitted)
+         num_funcs++;
+   }
+
+   const unsigned num_workers = MIN2(b->options->num_threads, num_funcs);
+   if (num_workers < 2)
+      return;
+
+   struct vtn_function **funcs =
+      ralloc_array(b, struct vtn_function *, num_funcs);
+   unsigned i = 0;
+   vtn_foreach_function(func, &b->functions) {
+      if ((b->options->create_library || func->referenced) && !func->emitted)
+         funcs[i++] = func;
+   }
+
+   /* Largest first, each to the least loaded worker */
+   qsort(funcs, num_funcs, sizeof(*funcs), compare_function_size);
+
+   struct vtn_worker *workers = rzalloc_array(b, struct vtn_worker, num_workers);
+   for (unsigned w = 0; w < num_workers; w++) {
+      workers[w].b = create_worker_builder(b);
+      workers[w].handler = instruction_handler;
+      workers[w].info = b->shader->info;
+      util_dynarray_init(&workers[w].funcs, workers[w].b);
+      util_queue_fence_init(&workers[w].fence);
+   }
+
+   struct hash_table *prologue_remap = _mesa_pointer_hash_table_create(NULL);
+   for (i = 0; i < num_funcs; i++) {
+      struct vtn_worker *worker = &workers[0];
+      for (unsigned w = 1; w < num_workers; w++) {
+         if (workers[w].num_words < worker->num_words)
+            worker = &workers[w];
+      }
+
+      assign_function_to_worker(worker->b, funcs[i], prologue_remap);
+      util_dynarray_append(&worker->funcs, funcs[i]);
+      worker->num_words += vtn_function_num_words(funcs[i]);
+   }
+
+   /* The workers' value arrays share the vtn_ssa_values and vtn_pointers */
+   remap_parameter_values(b, prologue_remap);
+   _mesa_hash_table_destroy(prologue_remap, NULL);
+
+   /* The calling thread takes the first worker */
+   struct util_queue *queue = get_vtn_queue();
+
+   for (unsigned w = 1; w < num_workers; w++) {
+      if (queue) {
+         util_queue_add_job(queue, &workers[w], &workers[w].fence,
+                            emit_worker_functions, NULL, 0);
+      } else {
+         emit_worker_functions(&workers[w], NULL, 0);
+      }
+   }
+   emit_worker_functions(&workers[0], NULL, 0);
+
+   bool failed = false;
+   for (unsigned w = 0; w < num_workers; w++) {
+      util_queue_fence_wait(&workers[w].fence);
+      util_queue_fence_destroy(&workers[w].fence);
+      failed |= workers[w].failed;
+   }
+
+   /* The worker already reported the failure */
+   if (failed)
+      vtn_longjmp(b->fail_jump, 1);
+
+   /* Globals of the shader map to themselves */
+   struct hash_table *remap = _mesa_pointer_hash_table_create(NULL);
+   nir_foreach_variable_in_shader(var, b->shader)
+      _mesa_hash_table_insert(remap, var, var);
+   nir_foreach_function(func, b->shader)
+      _mesa_hash_table_insert(remap, func, func);
+
+   for (unsigned w = 0; w < num_workers; w++) {
+      link_worker(b, &workers[w], remap);
+      ralloc_free(workers[w].b);
+   }
+
+   _mesa_hash_table_destroy(remap, NULL);
+   ralloc_free(workers);
+   ralloc_free(funcs);
+}
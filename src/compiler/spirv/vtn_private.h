@@ -244,6 +244,8 @@ void vtn_build_cfg(struct vtn_builder *b, const uint32_t *words,
                    const uint32_t *end);
 void vtn_function_emit(struct vtn_builder *b, struct vtn_function *func,
                        vtn_instruction_handler instruction_handler);
+void vtn_emit_functions_parallel(struct vtn_builder *b,
+                                 vtn_instruction_handler instruction_handler);
 void vtn_handle_function_call(struct vtn_builder *b, SpvOp opcode,
                               const uint32_t *w, unsigned count);
 
@@ -645,6 +647,12 @@ struct vtn_builder {
    struct spirv_to_nir_options *options;
    struct vtn_block *block;
 
+   /* Shader holding the module's global variables.  This is shader, except
+    * in the copies of the builder vtn_emit_functions_parallel() emits
+    * function bodies with, where shader is a per-thread scratch shader.
+    */
+   nir_shader *globals;
+
    /* Current offset, file, line, and column.  Useful for debugging.  Set
     * automatically by vtn_foreach_instruction.
     */
@@ -2109,7 +2109,7 @@ nir_deref_instr *
 vtn_get_call_payload_for_location(struct vtn_builder *b, uint32_t location_id)
 {
    uint32_t location = vtn_constant_uint(b, location_id);
-   nir_foreach_variable_with_modes(var, b->nb.shader, nir_var_shader_temp) {
+   nir_foreach_variable_with_modes(var, b->globals, nir_var_shader_temp) {
       if (var->data.explicit_location &&
           var->data.location == location)
          return nir_build_deref_var(&b->nb, var);
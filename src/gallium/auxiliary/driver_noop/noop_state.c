@@ -385,6 +385,10 @@ static void noop_set_patch_vertices(struct pipe_context *ctx,
 {
 }
 
+static void noop_set_dynamic_state(struct pipe_context *ctx, unsigned flags)
+{
+}
+
 void noop_init_state_functions(struct pipe_context *ctx);
 
 void noop_init_state_functions(struct pipe_context *ctx)
@@ -474,4 +478,5 @@ void noop_init_state_functions(struct pipe_context *ctx)
    ctx->delete_image_handle = noop_delete_image_handle;
    ctx->make_image_handle_resident = noop_make_image_handle_resident;
    ctx->set_patch_vertices = noop_set_patch_vertices;
+   ctx->set_dynamic_state = noop_set_dynamic_state;
 }
@@ -2182,6 +2182,21 @@ trace_context_set_patch_vertices(struct pipe_context *_context,
    context->set_patch_vertices(context, patch_vertices);
 }
 
+static void
+trace_context_set_dynamic_state(struct pipe_context *_context,
+                                unsigned flags)
+{
+   struct trace_context *tr_context = trace_context(_context);
+   struct pipe_context *context = tr_context->pipe;
+
+   trace_dump_call_begin("pipe_context", "set_dynamic_state");
+   trace_dump_arg(ptr, context);
+   trace_dump_arg(uint, flags);
+   trace_dump_call_end();
+
+   context->set_dynamic_state(context, flags);
+}
+
 static void trace_context_set_shader_buffers(struct pipe_context *_context,
                                              mesa_shader_stage shader,
                                              unsigned start, unsigned nr,
@@ -2602,6 +2617,7 @@ trace_context_create(struct trace_screen *tr_scr,
    TR_CTX_INIT(create_video_buffer);
    TR_CTX_INIT(set_tess_state);
    TR_CTX_INIT(set_patch_vertices);
+   TR_CTX_INIT(set_dynamic_state);
    TR_CTX_INIT(set_shader_buffers);
    TR_CTX_INIT(launch_grid);
    TR_CTX_INIT(get_compute_state_info);
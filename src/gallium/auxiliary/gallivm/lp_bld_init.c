@@ -153,7 +153,7 @@ init_gallivm_engine(struct gallivm_state *gallivm)
       char *error = NULL;
       int ret;
 
-      if (gallivm_perf & GALLIVM_PERF_NO_OPT) {
+      if (lp_passmgr_no_opt(gallivm->module)) {
          optlevel = None;
       }
       else {
@@ -109,6 +109,9 @@ gallivm_destroy(struct gallivm_state *gallivm);
 void
 gallivm_free_ir(struct gallivm_state *gallivm);
 
+void
+gallivm_set_no_opt(struct gallivm_state *gallivm);
+
 void
 gallivm_verify_function(struct gallivm_state *gallivm,
                         LLVMValueRef func);
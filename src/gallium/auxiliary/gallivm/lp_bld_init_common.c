@@ -29,6 +29,7 @@
 #include "util/u_cpu_detect.h"
 #include "lp_bld_debug.h"
 #include "lp_bld_init.h"
+#include "lp_bld_passmgr.h"
 #include "lp_bld_type.h"
 
 #include <llvm-c/Core.h>
@@ -105,6 +106,21 @@ lp_init_clock_hook(struct gallivm_state *gallivm)
    gallivm->get_time_hook = LLVMAddFunction(gallivm->module, "get_time_hook", get_time_type);
 }
 
+/**
+ * Compile the module with only the passes needed for correctness and the
+ * cheapest code generation level, trading code quality for compile time.
+ * Must be called before gallivm_compile_module().
+ */
+void
+gallivm_set_no_opt(struct gallivm_state *gallivm)
+{
+   LLVMAddModuleFlag(gallivm->module, LLVMModuleFlagBehaviorOverride,
+                     LP_MODULE_FLAG_NO_OPT, strlen(LP_MODULE_FLAG_NO_OPT),
+                     LLVMValueAsMetadata(
+                        LLVMConstInt(LLVMInt32TypeInContext(gallivm->context),
+                                     1, 0)));
+}
+
 /**
  * Validate a function.
  * Verification is only done with debug builds.
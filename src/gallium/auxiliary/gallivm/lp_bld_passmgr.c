@@ -82,7 +82,7 @@ lp_passmgr_create(LLVMModuleRef module, struct lp_passmgr **mgr_p)
    LLVMAddCoroSplitPass(mgr->cgpassmgr);
    LLVMAddCoroElidePass(mgr->cgpassmgr);
 
-   if ((gallivm_perf & GALLIVM_PERF_NO_OPT) == 0) {
+   if (!lp_passmgr_no_opt(module)) {
       /*
        * TODO: Evaluate passes some more - keeping in mind
        * both quality of generated code and compile times.
@@ -149,7 +149,7 @@ lp_passmgr_run(struct lp_passmgr *mgr,
    LLVMPassBuilderOptionsRef opts = LLVMCreatePassBuilderOptions();
    LLVMRunPasses(module, passes, tm, opts);
 
-   if (!(gallivm_perf & GALLIVM_PERF_NO_OPT))
+   if (!lp_passmgr_no_opt(module))
 #if LLVM_VERSION_MAJOR >= 18
       strcpy(passes, "sroa,early-cse,simplifycfg,reassociate,mem2reg,instsimplify,instcombine<no-verify-fixpoint>");
 #else
@@ -209,3 +209,18 @@ lp_passmgr_dispose(struct lp_passmgr *mgr)
    FREE(mgr);
 #endif
 }
+
+/**
+ * Whether only the passes needed for correctness should be run on the
+ * module, either globally (GALLIVM_PERF=nopt) or because the module was
+ * marked with gallivm_set_no_opt().
+ */
+bool
+lp_passmgr_no_opt(LLVMModuleRef module)
+{
+   if (gallivm_perf & GALLIVM_PERF_NO_OPT)
+      return true;
+
+   return LLVMGetModuleFlag(module, LP_MODULE_FLAG_NO_OPT,
+                            strlen(LP_MODULE_FLAG_NO_OPT)) != NULL;
+}
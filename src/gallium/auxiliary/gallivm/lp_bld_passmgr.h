@@ -38,6 +38,12 @@ extern "C" {
 
 struct lp_passmgr;
 
+/*
+ * Module flag set by gallivm_set_no_opt() on modules which should be
+ * compiled quickly rather than well.
+ */
+#define LP_MODULE_FLAG_NO_OPT "lp.no_opt"
+
 /*
  * mgr can be returned as NULL for modern pass mgr handling
  * so use a bool to denote success/fail.
@@ -48,6 +54,7 @@ void lp_passmgr_run(struct lp_passmgr *mgr,
                     LLVMTargetMachineRef tm,
                     const char *module_name);
 void lp_passmgr_dispose(struct lp_passmgr *mgr);
+bool lp_passmgr_no_opt(LLVMModuleRef module);
 
 #ifdef __cplusplus
 }
@@ -191,6 +191,22 @@ util_fill_box(uint8_t * dst,
 }
 
 
+static void
+util_copy_box_cpu(struct pipe_context *pipe,
+                  uint8_t *dst, enum pipe_format format,
+                  unsigned dst_stride, uint64_t dst_slice_stride,
+                  unsigned dst_x, unsigned dst_y, unsigned dst_z,
+                  unsigned width, unsigned height, unsigned depth,
+                  const uint8_t *src,
+                  int src_stride, uint64_t src_slice_stride,
+                  unsigned src_x, unsigned src_y, unsigned src_z)
+{
+   util_copy_box(dst, format, dst_stride, dst_slice_stride,
+                 dst_x, dst_y, dst_z, width, height, depth,
+                 src, src_stride, src_slice_stride, src_x, src_y, src_z);
+}
+
+
 /**
  * Fallback function for pipe->resource_copy_region().
  * We support copying between different formats (including compressed/
@@ -207,7 +223,29 @@ util_resource_copy_region(struct pipe_context *pipe,
                           unsigned dst_x, unsigned dst_y, unsigned dst_z,
                           struct pipe_resource *src,
                           unsigned src_level,
-                          const struct pipe_box *src_box_in)
+                          const struct pipe_box *src_box)
+{
+   util_resource_copy_region_with_copy_box(pipe, dst, dst_level,
+                                           dst_x, dst_y, dst_z,
+                                           src, src_level, src_box,
+                                           util_copy_box_cpu);
+}
+
+
+/**
+ * Same as util_resource_copy_region(), but the mapped data is copied with
+ * copy_box, a buffer range as a single row of R8_UNORM.
+ */
+void
+util_resource_copy_region_with_copy_box(struct pipe_context *pipe,
+                                        struct pipe_resource *dst,
+                                        unsigned dst_level,
+                                        unsigned dst_x, unsigned dst_y,
+                                        unsigned dst_z,
+                                        struct pipe_resource *src,
+                                        unsigned src_level,
+                                        const struct pipe_box *src_box_in,
+                                        util_copy_box_func copy_box)
 {
    struct pipe_transfer *src_trans, *dst_trans;
    uint8_t *dst_map;
@@ -314,7 +352,8 @@ util_resource_copy_region(struct pipe_context *pipe,
 
       assert(src_box.height == 1);
       assert(src_box.depth == 1);
-      memcpy(dst_map, src_map, src_box.width);
+      copy_box(pipe, dst_map, PIPE_FORMAT_R8_UNORM, 0, 0, 0, 0, 0,
+               src_box.width, 1, 1, src_map, 0, 0, 0, 0, 0);
 
       pipe->buffer_unmap(pipe, dst_trans);
    no_dst_map_buf:
@@ -343,14 +382,14 @@ util_resource_copy_region(struct pipe_context *pipe,
          goto no_dst_map;
       }
 
-      util_copy_box(dst_map,
-                    src_format,
-                    dst_trans->stride, dst_trans->layer_stride,
-                    0, 0, 0,
-                    src_box.width, src_box.height, src_box.depth,
-                    src_map,
-                    src_trans->stride, src_trans->layer_stride,
-                    0, 0, 0);
+      copy_box(pipe, dst_map,
+               src_format,
+               dst_trans->stride, dst_trans->layer_stride,
+               0, 0, 0,
+               src_box.width, src_box.height, src_box.depth,
+               src_map,
+               src_trans->stride, src_trans->layer_stride,
+               0, 0, 0);
 
       pipe->texture_unmap(pipe, dst_trans);
    no_dst_map:
@@ -82,6 +82,33 @@ util_resource_copy_region(struct pipe_context *pipe,
                           unsigned src_level,
                           const struct pipe_box *src_box);
 
+/**
+ * Copies a box between mapped resources, like util_copy_box().
+ */
+typedef void (*util_copy_box_func)(struct pipe_context *pipe,
+                                   uint8_t *dst, enum pipe_format format,
+                                   unsigned dst_stride,
+                                   uint64_t dst_slice_stride,
+                                   unsigned dst_x, unsigned dst_y,
+                                   unsigned dst_z,
+                                   unsigned width, unsigned height,
+                                   unsigned depth,
+                                   const uint8_t *src,
+                                   int src_stride, uint64_t src_slice_stride,
+                                   unsigned src_x, unsigned src_y,
+                                   unsigned src_z);
+
+extern void
+util_resource_copy_region_with_copy_box(struct pipe_context *pipe,
+                                        struct pipe_resource *dst,
+                                        unsigned dst_level,
+                                        unsigned dst_x, unsigned dst_y,
+                                        unsigned dst_z,
+                                        struct pipe_resource *src,
+                                        unsigned src_level,
+                                        const struct pipe_box *src_box,
+                                        util_copy_box_func copy_box);
+
 extern void
 u_default_clear_texture(struct pipe_context *pipe,
                         struct pipe_resource *tex,
@@ -0,0 +1,203 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "util/u_atomic.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+#include "util/reallocarray.h"
+#include "lp_bin_sched.h"
+#include "lp_scene.h"
+
+
+static inline uint64_t
+range_pack(uint32_t begin, uint32_t end)
+{
+   return ((uint64_t)end << 32) | begin;
+}
+
+
+static inline uint32_t
+range_begin(uint64_t range)
+{
+   return (uint32_t)range;
+}
+
+
+static inline uint32_t
+range_end(uint64_t range)
+{
+   return (uint32_t)(range >> 32);
+}
+
+
+/**
+ * Per-tile overhead (mapping, clearing the task state, ...) plus the
+ * number of commands binned into it.
+ */
+static inline uint64_t
+bin_weight(const struct cmd_bin *bin)
+{
+   return 1 + bin->cost;
+}
+
+
+static inline unsigned
+sched_bin(const struct lp_bin_sched *sched, unsigned i)
+{
+   return sched->raster_order ? i : sched->order[i];
+}
+
+
+bool
+lp_bin_sched_init(struct lp_bin_sched *sched, unsigned max_queues)
+{
+   memset(sched, 0, sizeof *sched);
+
+   max_queues = MAX2(1, max_queues);
+   sched->queues = align_calloc(max_queues * sizeof *sched->queues,
+                                CACHE_LINE_SIZE);
+   if (!sched->queues)
+      return false;
+
+   sched->max_queues = max_queues;
+   return true;
+}
+
+
+void
+lp_bin_sched_destroy(struct lp_bin_sched *sched)
+{
+   align_free(sched->queues);
+   free(sched->order);
+   memset(sched, 0, sizeof *sched);
+}
+
+
+/**
+ * Make sure the order array can hold num_bins entries.
+ */
+bool
+lp_bin_sched_reserve(struct lp_bin_sched *sched, unsigned num_bins)
+{
+   if (sched->max_bins >= num_bins)
+      return true;
+
+   uint32_t *order = reallocarray(sched->order, num_bins, sizeof *order);
+   if (!order)
+      return false;
+
+   sched->order = order;
+   sched->max_bins = num_bins;
+   return true;
+}
+
+
+/**
+ * Build the scheduling order of the non-empty bins and split it into
+ * num_queues cost-balanced contiguous ranges.
+ * Called once per scene by one thread, before the others start pulling.
+ */
+void
+lp_bin_sched_begin(struct lp_bin_sched *sched,
+                   const struct cmd_bin *bins,
+                   unsigned tiles_x, unsigned tiles_y,
+                   unsigned num_queues)
+{
+   unsigned n = 0;
+   uint64_t total = 0;
+
+   sched->raster_order = sched->max_bins < tiles_x * tiles_y;
+   if (sched->raster_order) {
+      n = tiles_x * tiles_y;
+      for (unsigned i = 0; i < n; i++)
+         total += bin_weight(&bins[i]);
+   } else {
+      for (unsigned gy = 0; gy < tiles_y; gy += LP_BIN_SCHED_GROUP_SIZE) {
+         unsigned y_end = MIN2(gy + LP_BIN_SCHED_GROUP_SIZE, tiles_y);
+         for (unsigned gx = 0; gx < tiles_x; gx += LP_BIN_SCHED_GROUP_SIZE) {
+            unsigned x_end = MIN2(gx + LP_BIN_SCHED_GROUP_SIZE, tiles_x);
+            for (unsigned y = gy; y < y_end; y++) {
+               for (unsigned x = gx; x < x_end; x++) {
+                  unsigned idx = y * tiles_x + x;
+                  if (bins[idx].head) {
+                     sched->order[n++] = idx;
+                     total += bin_weight(&bins[idx]);
+                  }
+               }
+            }
+         }
+      }
+   }
+
+   sched->num_bins = n;
+   sched->num_queues = CLAMP(num_queues, 1, sched->max_queues);
+
+   /* Cut the list where the running cost crosses each 1/num_queues mark. */
+   unsigned q = 0, start = 0;
+   uint64_t acc = 0;
+   for (unsigned i = 0; i < n && q + 1 < sched->num_queues; i++) {
+      acc += bin_weight(&bins[sched_bin(sched, i)]);
+      while (q + 1 < sched->num_queues &&
+             acc * sched->num_queues >= total * (q + 1)) {
+         sched->queues[q++].range = range_pack(start, i + 1);
+         start = i + 1;
+      }
+   }
+   sched->queues[q++].range = range_pack(start, n);
+   for (; q < sched->num_queues; q++)
+      sched->queues[q].range = range_pack(n, n);
+}
+
+
+/**
+ * Fetch the next bin for the given queue (rasterizer thread).
+ * Returns false once there is no work left that this thread can take.
+ */
+bool
+lp_bin_sched_next(struct lp_bin_sched *sched, unsigned queue,
+                  unsigned *bin)
+{
+   struct lp_bin_sched_queue *own = &sched->queues[queue];
+   uint64_t range = p_atomic_read(&own->range);
+
+   assert(queue < sched->num_queues);
+
+   /* Pop from the front of our own range. */
+   while (range_begin(range) < range_end(range)) {
+      uint64_t old = p_atomic_cmpxchg(&own->range, range, range + 1);
+      if (old == range) {
+         *bin = sched_bin(sched, range_begin(range));
+         return true;
+      }
+      range = old;
+   }
+
+   /* Steal the back half of another queue.  We only ever refill our own
+    * queue while it is empty, and indices are never handed out twice, so
+    * a stale range value can never compare equal (no ABA).
+    */
+   for (unsigned i = 1; i < sched->num_queues; i++) {
+      struct lp_bin_sched_queue *victim =
+         &sched->queues[(queue + i) % sched->num_queues];
+
+      range = p_atomic_read(&victim->range);
+      while (range_begin(range) < range_end(range)) {
+         uint32_t begin = range_begin(range);
+         uint32_t end = range_end(range);
+         uint32_t mid = begin + (end - begin) / 2;
+         uint64_t old = p_atomic_cmpxchg(&victim->range, range,
+                                         range_pack(begin, mid));
+         if (old == range) {
+            if (mid + 1 < end)
+               p_atomic_set(&own->range, range_pack(mid + 1, end));
+            *bin = sched_bin(sched, mid);
+            return true;
+         }
+         range = old;
+      }
+   }
+
+   return false;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * Lock-free, work-stealing bin scheduler.
+ *
+ * At the start of rasterization the non-empty bins of a scene are laid out
+ * in a spatially coherent order (groups of LP_BIN_SCHED_GROUP_SIZE^2 tiles,
+ * raster order inside each group) and the resulting list is cut into one
+ * contiguous range per rasterizer thread, balanced by the per-bin cost
+ * estimate recorded during binning.
+ *
+ * Each thread pops bins from the front of its own range.  When it runs dry
+ * it steals the back half of another thread's range, so neighbouring tiles
+ * tend to stay on the same thread.  Every range is a single 64-bit word
+ * updated with compare-and-swap, so no mutex is taken on the hot path.
+ */
+
+#ifndef LP_BIN_SCHED_H
+#define LP_BIN_SCHED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "util/u_memory.h"
+
+struct cmd_bin;
+
+
+/** Tiles per side of a scheduling group (4x4 tiles = 256x256 pixels) */
+#define LP_BIN_SCHED_GROUP_SIZE 4
+
+
+/**
+ * One thread's range of work.  The range is packed as
+ * (end << 32) | begin and indexes lp_bin_sched::order.
+ */
+struct lp_bin_sched_queue {
+   EXCLUSIVE_CACHELINE(uint64_t range);
+};
+
+
+struct lp_bin_sched {
+   struct lp_bin_sched_queue *queues;
+   unsigned max_queues;
+   unsigned num_queues;
+
+   /** Bin indices (y * tiles_x + x) in scheduling order */
+   uint32_t *order;
+   unsigned max_bins;
+   unsigned num_bins;
+
+   /** The order array couldn't be allocated, schedule in raster order */
+   bool raster_order;
+};
+
+
+bool
+lp_bin_sched_init(struct lp_bin_sched *sched, unsigned max_queues);
+
+void
+lp_bin_sched_destroy(struct lp_bin_sched *sched);
+
+bool
+lp_bin_sched_reserve(struct lp_bin_sched *sched, unsigned num_bins);
+
+void
+lp_bin_sched_begin(struct lp_bin_sched *sched,
+                   const struct cmd_bin *bins,
+                   unsigned tiles_x, unsigned tiles_y,
+                   unsigned num_queues);
+
+bool
+lp_bin_sched_next(struct lp_bin_sched *sched, unsigned queue,
+                  unsigned *bin);
+
+
+#endif /* LP_BIN_SCHED_H */
@@ -83,6 +83,8 @@ enum stencil_op {
  * This will be used twice when generating two-sided stencil code.
  * \param stencil  the front/back stencil state
  * \param stencilRef  the stencil reference value, replicated as a vector
+ * \param valuemask  the runtime compare mask as a vector, or NULL to use
+ *                   the one in the stencil state
  * \param stencilVals  vector of stencil values from framebuffer
  * \return vector mask of pass/fail values (~0 or 0)
  */
@@ -90,6 +92,7 @@ static LLVMValueRef
 lp_build_stencil_test_single(struct lp_build_context *bld,
                              const struct pipe_stencil_state *stencil,
                              LLVMValueRef stencilRef,
+                             LLVMValueRef valuemask,
                              LLVMValueRef stencilVals)
 {
    LLVMBuilderRef builder = bld->gallivm->builder;
@@ -109,9 +112,10 @@ lp_build_stencil_test_single(struct lp_build_context *bld,
 
    assert(stencil->enabled);
 
-   if (stencil->valuemask != stencilMax) {
+   if (valuemask || stencil->valuemask != stencilMax) {
       /* compute stencilRef = stencilRef & valuemask */
-      LLVMValueRef valuemask = lp_build_const_int_vec(bld->gallivm, type, stencil->valuemask);
+      if (!valuemask)
+         valuemask = lp_build_const_int_vec(bld->gallivm, type, stencil->valuemask);
       stencilRef = LLVMBuildAnd(builder, stencilRef, valuemask, "");
       /* compute stencilVals = stencilVals & valuemask */
       stencilVals = LLVMBuildAnd(builder, stencilVals, valuemask, "");
@@ -126,6 +130,7 @@ lp_build_stencil_test_single(struct lp_build_context *bld,
 /**
  * Do the one or two-sided stencil test comparison.
  * \sa lp_build_stencil_test_single
+ * \param valuemasks  the front/back runtime compare masks, or NULL
  * \param front_facing  an integer vector mask, indicating front (~0) or back
  *                      (0) facing polygon. If NULL, assume front-facing.
  */
@@ -133,6 +138,7 @@ static LLVMValueRef
 lp_build_stencil_test(struct lp_build_context *bld,
                       const struct pipe_stencil_state stencil[2],
                       LLVMValueRef stencilRefs[2],
+                      LLVMValueRef valuemasks[2],
                       LLVMValueRef stencilVals,
                       LLVMValueRef front_facing)
 {
@@ -141,15 +147,17 @@ lp_build_stencil_test(struct lp_build_context *bld,
    assert(stencil[0].enabled);
 
    /* do front face test */
-   res = lp_build_stencil_test_single(bld, &stencil[0],
-                                      stencilRefs[0], stencilVals);
+   res = lp_build_stencil_test_single(bld, &stencil[0], stencilRefs[0],
+                                      valuemasks ? valuemasks[0] : NULL,
+                                      stencilVals);
 
    if (stencil[1].enabled && front_facing != NULL) {
       /* do back face test */
       LLVMValueRef back_res;
 
-      back_res = lp_build_stencil_test_single(bld, &stencil[1],
-                                              stencilRefs[1], stencilVals);
+      back_res = lp_build_stencil_test_single(bld, &stencil[1], stencilRefs[1],
+                                              valuemasks ? valuemasks[1] : NULL,
+                                              stencilVals);
 
       res = lp_build_select(bld, front_facing, res, back_res);
    }
@@ -236,12 +244,15 @@ lp_build_stencil_op_single(struct lp_build_context *bld,
 
 /**
  * Do the one or two-sided stencil test op/update.
+ * \param writemasks  the front/back runtime write masks, or NULL to use the
+ *                    ones in the stencil state
  */
 static LLVMValueRef
 lp_build_stencil_op(struct lp_build_context *bld,
                     const struct pipe_stencil_state stencil[2],
                     enum stencil_op op,
                     LLVMValueRef stencilRefs[2],
+                    LLVMValueRef writemasks[2],
                     LLVMValueRef stencilVals,
                     LLVMValueRef mask,
                     LLVMValueRef front_facing)
@@ -266,9 +277,18 @@ lp_build_stencil_op(struct lp_build_context *bld,
       res = lp_build_select(bld, front_facing, res, back_res);
    }
 
-   if (stencil[0].writemask != 0xff ||
-       (stencil[1].enabled && front_facing != NULL &&
-        stencil[1].writemask != 0xff)) {
+   if (writemasks) {
+      /* mask &= front_facing ? writemasks[0] : writemasks[1] */
+      LLVMValueRef writemask = writemasks[0];
+      if (stencil[1].enabled && front_facing != NULL)
+         writemask = lp_build_select(bld, front_facing,
+                                     writemask, writemasks[1]);
+
+      mask = LLVMBuildAnd(builder, mask, writemask, "");
+      res = lp_build_select_bitwise(bld, mask, res, stencilVals);
+   } else if (stencil[0].writemask != 0xff ||
+              (stencil[1].enabled && front_facing != NULL &&
+               stencil[1].writemask != 0xff)) {
       /* mask &= stencil[0].writemask */
       LLVMValueRef writemask = lp_build_const_int_vec(bld->gallivm, bld->type,
                                                       stencil[0].writemask);
@@ -810,6 +830,10 @@ lp_build_depth_stencil_write_swizzled(struct gallivm_state *gallivm,
  * \param mask  the alive/dead pixel mask for the quad (vector)
  * \param cov_mask coverage mask
  * \param stencil_refs  the front/back stencil ref values (scalar)
+ * \param stencil_valuemasks  the front/back runtime stencil compare masks,
+ *                            or NULL to use the ones in the stencil state
+ * \param stencil_writemasks  the front/back runtime stencil write masks,
+ *                            or NULL to use the ones in the stencil state
  * \param z_src  the incoming depth/stencil values (n 2x2 quad values, float32)
  * \param zs_dst  the depth/stencil values in framebuffer
  * \param face  contains boolean value indicating front/back facing polygon
@@ -823,6 +847,8 @@ lp_build_depth_stencil_test(struct gallivm_state *gallivm,
                             struct lp_build_mask_context *mask,
                             LLVMValueRef *cov_mask,
                             LLVMValueRef stencil_refs[2],
+                            LLVMValueRef stencil_valuemasks[2],
+                            LLVMValueRef stencil_writemasks[2],
                             LLVMValueRef z_src,
                             LLVMValueRef z_fb,
                             LLVMValueRef s_fb,
@@ -1016,14 +1042,15 @@ lp_build_depth_stencil_test(struct gallivm_state *gallivm,
       }
 
       s_pass_mask = lp_build_stencil_test(&s_bld, stencil,
-                                          stencil_refs, stencil_vals,
-                                          front_facing);
+                                          stencil_refs, stencil_valuemasks,
+                                          stencil_vals, front_facing);
 
       /* apply stencil-fail operator */
       {
          LLVMValueRef s_fail_mask = lp_build_andnot(&s_bld, current_mask, s_pass_mask);
          stencil_vals = lp_build_stencil_op(&s_bld, stencil, S_FAIL_OP,
-                                            stencil_refs, stencil_vals,
+                                            stencil_refs, stencil_writemasks,
+                                            stencil_vals,
                                             s_fail_mask, front_facing);
       }
    }
@@ -1139,13 +1166,15 @@ lp_build_depth_stencil_test(struct gallivm_state *gallivm,
          /* apply Z-fail operator */
          z_fail_mask = lp_build_andnot(&s_bld, current_mask, z_pass);
          stencil_vals = lp_build_stencil_op(&s_bld, stencil, Z_FAIL_OP,
-                                            stencil_refs, stencil_vals,
+                                            stencil_refs, stencil_writemasks,
+                                            stencil_vals,
                                             z_fail_mask, front_facing);
 
          /* apply Z-pass operator */
          z_pass_mask = LLVMBuildAnd(builder, current_mask, z_pass, "");
          stencil_vals = lp_build_stencil_op(&s_bld, stencil, Z_PASS_OP,
-                                            stencil_refs, stencil_vals,
+                                            stencil_refs, stencil_writemasks,
+                                            stencil_vals,
                                             z_pass_mask, front_facing);
       }
    } else if (stencil[0].enabled) {
@@ -1154,7 +1183,8 @@ lp_build_depth_stencil_test(struct gallivm_state *gallivm,
        */
       s_pass_mask = LLVMBuildAnd(builder, current_mask, s_pass_mask, "");
       stencil_vals = lp_build_stencil_op(&s_bld, stencil, Z_PASS_OP,
-                                         stencil_refs, stencil_vals,
+                                         stencil_refs, stencil_writemasks,
+                                         stencil_vals,
                                          s_pass_mask, front_facing);
    }
 
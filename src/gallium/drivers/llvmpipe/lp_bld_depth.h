@@ -62,6 +62,8 @@ lp_build_depth_stencil_test(struct gallivm_state *gallivm,
                             struct lp_build_mask_context *mask,
                             LLVMValueRef *cov_mask,
                             LLVMValueRef stencil_refs[2],
+                            LLVMValueRef stencil_valuemasks[2],
+                            LLVMValueRef stencil_writemasks[2],
                             LLVMValueRef z_src,
                             LLVMValueRef z_fb,
                             LLVMValueRef s_fb,
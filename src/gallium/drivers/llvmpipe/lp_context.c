@@ -48,6 +48,7 @@
 #include "lp_setup.h"
 #include "lp_screen.h"
 #include "lp_fence.h"
+#include "lp_rast.h"
 
 static void
 llvmpipe_destroy(struct pipe_context *pipe)
@@ -105,6 +106,8 @@ llvmpipe_destroy(struct pipe_context *pipe)
 
    lp_delete_setup_variants(llvmpipe);
 
+   llvmpipe_destroy_fs_compile_queue(llvmpipe);
+
    llvmpipe_sampler_matrix_destroy(llvmpipe);
 
    lp_context_destroy(&llvmpipe->context);
@@ -177,7 +180,7 @@ lp_draw_disk_cache_find_shader(void *cookie,
                                unsigned char ir_sha1_cache_key[20])
 {
    struct llvmpipe_screen *screen = cookie;
-   lp_disk_cache_find_shader(screen, cache, ir_sha1_cache_key);
+   lp_disk_cache_find_shader(screen, LP_JIT_DRAW, cache, ir_sha1_cache_key);
 }
 
 
@@ -274,6 +277,8 @@ llvmpipe_create_context(struct pipe_screen *screen, void *priv,
    if (!llvmpipe->context.ref)
       goto fail;
 
+   llvmpipe_init_fs_compile_queue(llvmpipe);
+
    /*
     * Create drawing context and plug our rendering stage into it.
     */
@@ -292,7 +297,14 @@ llvmpipe_create_context(struct pipe_screen *screen, void *priv,
 
    /* FIXME: devise alternative to draw_texture_samplers */
 
-   llvmpipe->setup = lp_setup_create(&llvmpipe->pipe, llvmpipe->draw);
+   unsigned priority = LP_RAST_PRIORITY_MEDIUM;
+   if (flags & (PIPE_CONTEXT_HIGH_PRIORITY | PIPE_CONTEXT_REALTIME_PRIORITY))
+      priority = LP_RAST_PRIORITY_HIGH;
+   else if (flags & PIPE_CONTEXT_LOW_PRIORITY)
+      priority = LP_RAST_PRIORITY_LOW;
+
+   llvmpipe->setup = lp_setup_create(&llvmpipe->pipe, llvmpipe->draw,
+                                     priority);
    if (!llvmpipe->setup)
       goto fail;
 
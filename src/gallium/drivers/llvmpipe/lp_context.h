@@ -35,9 +35,11 @@
 
 #include "draw/draw_vertex.h"
 #include "util/u_blitter.h"
+#include "util/u_queue.h"
 
 #include "lp_tex_sample.h"
 #include "lp_jit.h"
+#include "lp_limits.h"
 #include "lp_texture_handle.h"
 #include "lp_setup.h"
 #include "lp_state_fs.h"
@@ -87,6 +89,7 @@ struct llvmpipe_context {
    bool sample_locations_enabled;
    struct pipe_blend_color blend_color;
    struct pipe_stencil_ref stencil_ref;
+   unsigned dynamic_state;  /**< LP_DYNAMIC_x flags */
    struct pipe_clip_state clip;
    struct pipe_constant_buffer constants[MESA_SHADER_MESH_STAGES][LP_MAX_TGSI_CONST_BUFFERS];
    struct pipe_framebuffer_state framebuffer;
@@ -166,6 +169,15 @@ struct llvmpipe_context {
    struct lp_fs_variant_list_item fs_variants_list;
    unsigned nr_fs_variants;
    unsigned nr_fs_instrs;
+   double fs_cache_clock;
+
+   /** Background compilation of optimized fragment shader variants */
+   struct util_queue fs_compile_queue;
+   lp_context_ref fs_compile_contexts[LP_MAX_FS_COMPILE_THREADS];
+   unsigned num_fs_compile_threads;
+
+   /** Bound unoptimized variant whose optimized version is compiling */
+   struct lp_fragment_shader_variant *fs_stand_in;
 
    bool permit_linear_rasterizer;
    bool single_vp;
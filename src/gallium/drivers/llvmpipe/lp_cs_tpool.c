@@ -28,9 +28,11 @@
  * based on threadpool.c but modified heavily to be compute shader tuned.
  */
 
+#include "util/u_atomic.h"
 #include "util/u_thread.h"
 #include "util/u_memory.h"
 #include "lp_cs_tpool.h"
+#include "lp_thread.h"
 
 static int
 lp_cs_tpool_worker(void *data)
@@ -38,6 +40,11 @@ lp_cs_tpool_worker(void *data)
    struct lp_cs_tpool *pool = data;
    struct lp_cs_local_mem lmem;
 
+   if (pool->pin_threads) {
+      unsigned index = p_atomic_inc_return(&pool->next_thread_index) - 1;
+      lp_thread_bind_l3(index, pool->pin_num_threads);
+   }
+
    memset(&lmem, 0, sizeof(lmem));
    mtx_lock(&pool->m);
 
@@ -84,18 +91,26 @@ lp_cs_tpool_worker(void *data)
 }
 
 struct lp_cs_tpool *
-lp_cs_tpool_create(unsigned num_threads)
+lp_cs_tpool_create(unsigned num_threads, bool pin_threads)
 {
    struct lp_cs_tpool *pool = CALLOC_STRUCT(lp_cs_tpool);
 
    if (!pool)
       return NULL;
 
+   pool->threads = CALLOC(MAX2(1, num_threads), sizeof *pool->threads);
+   if (!pool->threads) {
+      FREE(pool);
+      return NULL;
+   }
+
    (void) mtx_init(&pool->m, mtx_plain);
    cnd_init(&pool->new_work);
 
    list_inithead(&pool->workqueue);
    assert (num_threads <= LP_MAX_THREADS);
+   pool->pin_threads = pin_threads;
+   pool->pin_num_threads = num_threads;
    for (unsigned i = 0; i < num_threads; i++) {
       if (thrd_success != u_thread_create(pool->threads + i, lp_cs_tpool_worker, pool)) {
          num_threads = i;  /* previous thread is max */
@@ -123,6 +138,7 @@ lp_cs_tpool_destroy(struct lp_cs_tpool *pool)
 
    cnd_destroy(&pool->new_work);
    mtx_destroy(&pool->m);
+   FREE(pool->threads);
    FREE(pool);
 }
 
@@ -45,10 +45,15 @@ struct lp_cs_tpool {
    mtx_t m;
    cnd_t new_work;
 
-   thrd_t threads[LP_MAX_THREADS];
+   thrd_t *threads;
    unsigned num_threads;
    struct list_head workqueue;
    bool shutdown;
+
+   /* L3 domain assignment, see lp_thread_bind_l3() */
+   bool pin_threads;
+   unsigned pin_num_threads;
+   unsigned next_thread_index;
 };
 
 struct lp_cs_local_mem {
@@ -70,7 +75,7 @@ struct lp_cs_tpool_task {
    unsigned iter_remainder;
 };
 
-struct lp_cs_tpool *lp_cs_tpool_create(unsigned num_threads);
+struct lp_cs_tpool *lp_cs_tpool_create(unsigned num_threads, bool pin_threads);
 void lp_cs_tpool_destroy(struct lp_cs_tpool *);
 
 struct lp_cs_tpool_task *lp_cs_tpool_queue_task(struct lp_cs_tpool *,
@@ -33,6 +33,7 @@
 #include "pipe/p_defines.h"
 #include "pipe/p_screen.h"
 #include "util/u_debug_image.h"
+#include "util/u_dynarray.h"
 #include "util/u_string.h"
 #include "draw/draw_context.h"
 #include "lp_flush.h"
@@ -52,16 +53,13 @@ llvmpipe_flush(struct pipe_context *pipe,
                const char *reason)
 {
    struct llvmpipe_context *llvmpipe = llvmpipe_context(pipe);
-   struct llvmpipe_screen *screen = llvmpipe_screen(pipe->screen);
 
    draw_flush(llvmpipe->draw);
 
    /* ask the setup module to flush */
    lp_setup_flush(llvmpipe->setup, reason);
 
-   mtx_lock(&screen->rast_mutex);
-   lp_rast_fence(screen->rast, (struct lp_fence **)fence);
-   mtx_unlock(&screen->rast_mutex);
+   lp_setup_fence(llvmpipe->setup, (struct lp_fence **)fence);
 
    if (fence && (!*fence))
       *fence = (struct pipe_fence_handle *)lp_fence_create(0);
@@ -122,28 +120,54 @@ llvmpipe_flush_resource(struct pipe_context *pipe,
 {
    unsigned referenced = 0;
    struct llvmpipe_screen *lp_screen = llvmpipe_screen(pipe->screen);
+   struct util_dynarray fences;
 
+   util_dynarray_init(&fences, NULL);
+
+   /* Other contexts can't be flushed from here, but the scenes they have
+    * queued with the rasterizer can be waited for.
+    */
    mtx_lock(&lp_screen->ctx_mutex);
    list_for_each_entry(struct llvmpipe_context, ctx, &lp_screen->ctx_list, list) {
-      referenced |=
+      unsigned ctx_referenced =
          llvmpipe_is_resource_referenced((struct pipe_context *)ctx,
                                          resource, level);
+      if (!ctx_referenced)
+         continue;
+
+      referenced |= ctx_referenced;
+      if (&ctx->pipe != pipe) {
+         struct lp_fence *fence = NULL;
+         lp_setup_fence(ctx->setup, &fence);
+         if (fence)
+            util_dynarray_append(&fences, fence);
+      }
    }
    mtx_unlock(&lp_screen->ctx_mutex);
 
    if ((referenced & LP_REFERENCED_FOR_WRITE) ||
        ((referenced & LP_REFERENCED_FOR_READ) && !read_only)) {
 
-      if (cpu_access)
-         if (do_not_block)
-            return false;
+      if (cpu_access && do_not_block) {
+         util_dynarray_foreach(&fences, struct lp_fence *, fence)
+            lp_fence_reference(fence, NULL);
+         util_dynarray_fini(&fences);
+         return false;
+      }
 
       /*
        * Flush and wait.
        * Finish so VS can use FS results.
        */
       llvmpipe_finish(pipe, reason);
+
+      util_dynarray_foreach(&fences, struct lp_fence *, fence)
+         lp_fence_wait(*fence);
    }
 
+   util_dynarray_foreach(&fences, struct lp_fence *, fence)
+      lp_fence_reference(fence, NULL);
+   util_dynarray_fini(&fences);
+
    return true;
 }
@@ -82,6 +82,10 @@ lp_jit_create_types(struct lp_fragment_shader_variant *lp)
       elem_types[LP_JIT_CTX_MAX_DEPTH_BOUNDS] =
       elem_types[LP_JIT_CTX_ALPHA_REF] = LLVMFloatTypeInContext(lc);
       elem_types[LP_JIT_CTX_SAMPLE_MASK] =
+      elem_types[LP_JIT_CTX_STENCIL_VALUEMASK_FRONT] =
+      elem_types[LP_JIT_CTX_STENCIL_VALUEMASK_BACK] =
+      elem_types[LP_JIT_CTX_STENCIL_WRITEMASK_FRONT] =
+      elem_types[LP_JIT_CTX_STENCIL_WRITEMASK_BACK] =
       elem_types[LP_JIT_CTX_STENCIL_REF_FRONT] =
       elem_types[LP_JIT_CTX_STENCIL_REF_BACK] = LLVMInt32TypeInContext(lc);
       elem_types[LP_JIT_CTX_U8_BLEND_COLOR] = LLVMPointerType(LLVMInt8TypeInContext(lc), 0);
@@ -118,6 +122,18 @@ lp_jit_create_types(struct lp_fragment_shader_variant *lp)
       LP_CHECK_MEMBER_OFFSET(struct lp_jit_context, sample_mask,
                              gallivm->target, context_type,
                              LP_JIT_CTX_SAMPLE_MASK);
+      LP_CHECK_MEMBER_OFFSET(struct lp_jit_context, stencil_valuemask_front,
+                             gallivm->target, context_type,
+                             LP_JIT_CTX_STENCIL_VALUEMASK_FRONT);
+      LP_CHECK_MEMBER_OFFSET(struct lp_jit_context, stencil_valuemask_back,
+                             gallivm->target, context_type,
+                             LP_JIT_CTX_STENCIL_VALUEMASK_BACK);
+      LP_CHECK_MEMBER_OFFSET(struct lp_jit_context, stencil_writemask_front,
+                             gallivm->target, context_type,
+                             LP_JIT_CTX_STENCIL_WRITEMASK_FRONT);
+      LP_CHECK_MEMBER_OFFSET(struct lp_jit_context, stencil_writemask_back,
+                             gallivm->target, context_type,
+                             LP_JIT_CTX_STENCIL_WRITEMASK_BACK);
       LP_CHECK_STRUCT_SIZE(struct lp_jit_context,
                            gallivm->target, context_type);
 
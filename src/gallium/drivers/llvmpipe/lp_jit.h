@@ -88,6 +88,10 @@ struct lp_jit_context
    float min_depth_bounds, max_depth_bounds;
 
    uint32_t sample_mask;
+
+   /* Only read by variants built with LP_DYNAMIC_STENCIL_MASKS */
+   uint32_t stencil_valuemask_front, stencil_valuemask_back;
+   uint32_t stencil_writemask_front, stencil_writemask_back;
 };
 
 
@@ -105,6 +109,10 @@ enum {
    LP_JIT_CTX_MIN_DEPTH_BOUNDS,
    LP_JIT_CTX_MAX_DEPTH_BOUNDS,
    LP_JIT_CTX_SAMPLE_MASK,
+   LP_JIT_CTX_STENCIL_VALUEMASK_FRONT,
+   LP_JIT_CTX_STENCIL_VALUEMASK_BACK,
+   LP_JIT_CTX_STENCIL_WRITEMASK_FRONT,
+   LP_JIT_CTX_STENCIL_WRITEMASK_BACK,
    LP_JIT_CTX_COUNT
 };
 
@@ -135,6 +143,18 @@ enum {
 #define lp_jit_context_sample_mask(_gallivm, _type, _ptr)                \
    lp_build_struct_get_ptr2(_gallivm, _type, _ptr, LP_JIT_CTX_SAMPLE_MASK, "sample_mask")
 
+#define lp_jit_context_stencil_valuemask_front(_gallivm, _type, _ptr) \
+   lp_build_struct_get2(_gallivm, _type, _ptr, LP_JIT_CTX_STENCIL_VALUEMASK_FRONT, "stencil_valuemask_front")
+
+#define lp_jit_context_stencil_valuemask_back(_gallivm, _type, _ptr) \
+   lp_build_struct_get2(_gallivm, _type, _ptr, LP_JIT_CTX_STENCIL_VALUEMASK_BACK, "stencil_valuemask_back")
+
+#define lp_jit_context_stencil_writemask_front(_gallivm, _type, _ptr) \
+   lp_build_struct_get2(_gallivm, _type, _ptr, LP_JIT_CTX_STENCIL_WRITEMASK_FRONT, "stencil_writemask_front")
+
+#define lp_jit_context_stencil_writemask_back(_gallivm, _type, _ptr) \
+   lp_build_struct_get2(_gallivm, _type, _ptr, LP_JIT_CTX_STENCIL_WRITEMASK_BACK, "stencil_writemask_back")
+
 
 struct lp_jit_thread_data
 {
@@ -34,11 +34,20 @@
 
 
 /**
- * Tile size (width and height). This needs to be a power of two.
+ * Default tile size (width and height). This needs to be a power of two.
+ * Resources are padded to this size.
  */
 #define TILE_ORDER 6
 #define TILE_SIZE (1 << TILE_ORDER)
 
+/**
+ * Range of tile sizes a scene may pick instead (32x32 .. 128x128).
+ * The rasterizer works on 16x16 blocks within 64x64 quadrants, so the
+ * orders must stay within one of TILE_ORDER.
+ */
+#define LP_MIN_TILE_ORDER (TILE_ORDER - 1)
+#define LP_MAX_TILE_ORDER (TILE_ORDER + 1)
+
 
 /**
  * Max texture sizes
@@ -66,20 +75,38 @@
 
 #define LP_MAX_SAMPLES 8
 
-#define LP_MAX_THREADS 32
+/**
+ * Upper bound for LP_NUM_THREADS (matches UTIL_MAX_CPUS).  Per-thread
+ * storage is sized from the actual thread count at runtime.
+ */
+#define LP_MAX_THREADS 1024
+
+/** Upper bound for LP_BIN_THREADS */
+#define LP_MAX_BIN_THREADS 16
+
+/** Upper bound for LP_FS_COMPILE_THREADS */
+#define LP_MAX_FS_COMPILE_THREADS 8
+
+/**
+ * Copies and fills are split into chunks of at least this many bytes for
+ * the cs thread pool; smaller ones run on the calling thread.
+ */
+#define LP_TRANSFER_CHUNK_SIZE (256 * 1024)
 
 
 /**
  * Max number of shader variants (for all shaders combined,
  * per context) that will be kept around.
  */
-#define LP_MAX_SHADER_VARIANTS 1024
+#define LP_MAX_SHADER_VARIANTS 4096
 
 /**
  * Max number of instructions (for all fragment shaders combined per context)
- * that will be kept around (counted in terms of llvm ir).
+ * that will be kept around (counted in terms of llvm ir).  This is what
+ * bounds the memory used by variants, so it doesn't scale with
+ * LP_MAX_SHADER_VARIANTS.
  */
-#define LP_MAX_SHADER_INSTRUCTIONS (2048 * LP_MAX_SHADER_VARIANTS)
+#define LP_MAX_SHADER_INSTRUCTIONS (2048 * 1024)
 
 /**
  * Max number of setup variants that will be kept around.
@@ -25,6 +25,8 @@
  *
  **************************************************************************/
 
+#include <inttypes.h>
+
 #include "util/u_debug.h"
 #include "lp_debug.h"
 #include "lp_perf.h"
@@ -32,12 +34,14 @@
 
 
 struct lp_counters lp_count;
+struct lp_jit_counters lp_jit_count[LP_JIT_KIND_COUNT];
 
 
 void
 lp_reset_counters(void)
 {
    memset(&lp_count, 0, sizeof(lp_count));
+   memset(lp_jit_count, 0, sizeof(lp_jit_count));
 }
 
 
@@ -114,6 +118,10 @@ lp_print_counters(void)
       debug_printf("llvmpipe:   nr_rect_part_4x4:           %9u (%3.0f%% of %u)\n", lp_count.nr_rect_partially_covered_4, p2, total_4);
 
 
+      debug_printf("llvmpipe: nr_hiz_culled_64x64:          %9u\n", lp_count.nr_hiz_culled_64);
+      debug_printf("llvmpipe: nr_hiz_culled_16x16:          %9u\n", lp_count.nr_hiz_culled_16);
+      debug_printf("llvmpipe: nr_hiz_culled_4x4:            %9u\n", lp_count.nr_hiz_culled_4);
+
       debug_printf("llvmpipe: nr_color_tile_clear:          %9u\n", lp_count.nr_color_tile_clear);
       debug_printf("llvmpipe: nr_color_tile_load:           %9u\n", lp_count.nr_color_tile_load);
       debug_printf("llvmpipe: nr_color_tile_store:          %9u\n", lp_count.nr_color_tile_store);
@@ -122,5 +130,31 @@ lp_print_counters(void)
       debug_printf("llvmpipe: total LLVM compile time:      %.2f sec\n", lp_count.llvm_compile_time / 1000000.0);
       debug_printf("llvmpipe: average LLVM compile time:    %.2f sec\n", lp_count.llvm_compile_time / 1000000.0 / lp_count.nr_llvm_compiles);
 
+      debug_printf("llvmpipe: nr_fs_async_compiles:         %u\n", lp_count.nr_fs_async_compiles);
+      debug_printf("llvmpipe: background FS compile time:   %.2f sec\n", lp_count.fs_async_compile_time / 1000000.0);
+      debug_printf("llvmpipe: FS compile stalls avoided:    %.2f sec\n", lp_count.fs_async_stall_avoided / 1000000.0);
+
+      static const char *jit_kind_names[LP_JIT_KIND_COUNT] = {
+         [LP_JIT_FS] = "fs",
+         [LP_JIT_SETUP] = "setup",
+         [LP_JIT_CS] = "cs",
+         [LP_JIT_DRAW] = "draw",
+         [LP_JIT_TEXTURE] = "texture",
+      };
+
+      debug_printf("llvmpipe: JIT code     cache hits     load time  cache misses      compiles  compile time     evictions    recompiles       avoided\n");
+      for (unsigned i = 0; i < LP_JIT_KIND_COUNT; i++) {
+         debug_printf("llvmpipe:   %-8s %12" PRIu64 "  %8.2f sec  %12" PRIu64 "  %12" PRIu64 "  %8.2f sec  %12" PRIu64 "  %12" PRIu64 "  %12" PRIu64 "\n",
+                      jit_kind_names[i],
+                      lp_jit_count[i].cache_hits,
+                      lp_jit_count[i].cache_load_time / 1000000.0,
+                      lp_jit_count[i].cache_misses,
+                      lp_jit_count[i].compiles,
+                      lp_jit_count[i].compile_time / 1000000.0,
+                      lp_jit_count[i].evictions,
+                      lp_jit_count[i].recompiles,
+                      lp_jit_count[i].avoided);
+      }
+
    }
 }
@@ -34,6 +34,7 @@
 #define LP_PERF_H
 
 #include "util/compiler.h"
+#include "util/u_atomic.h"
 
 /**
  * Various counters
@@ -62,8 +63,14 @@ struct lp_counters
    unsigned nr_rect_fully_covered_4;
    unsigned nr_rect_partially_covered_4;
    unsigned nr_non_empty_4;
+   unsigned nr_hiz_culled_64;
+   unsigned nr_hiz_culled_16;
+   unsigned nr_hiz_culled_4;
    unsigned nr_llvm_compiles;
    int64_t llvm_compile_time;  /**< total, in microseconds */
+   unsigned nr_fs_async_compiles;
+   int64_t fs_async_compile_time;  /**< total, in microseconds */
+   int64_t fs_async_stall_avoided;  /**< total, in microseconds */
 
    unsigned nr_color_tile_clear;
    unsigned nr_color_tile_load;
@@ -86,6 +93,56 @@ extern struct lp_counters lp_count;
 #endif
 
 
+/**
+ * Kinds of JIT code, for lp_jit_count.
+ */
+enum lp_jit_kind {
+   LP_JIT_FS,
+   LP_JIT_SETUP,
+   LP_JIT_CS,
+   LP_JIT_DRAW,
+   LP_JIT_TEXTURE,
+   LP_JIT_KIND_COUNT,
+};
+
+
+/**
+ * Shader disk cache and compile counters, per kind of JIT code.  Unlike
+ * lp_count these are kept in release builds too, and are updated
+ * atomically since code gets compiled on several threads.
+ */
+struct lp_jit_counters
+{
+   uint64_t cache_hits;
+   uint64_t cache_misses;
+   uint64_t compiles;  /**< LLVM compiles, not counting cache hits */
+   uint64_t compile_time;  /**< total, in microseconds */
+   uint64_t cache_load_time;  /**< building cache hits, in microseconds */
+   uint64_t evictions;
+   uint64_t recompiles;  /**< compiles of previously evicted variants */
+   uint64_t avoided;  /**< variants not built thanks to runtime state */
+};
+
+
+extern struct lp_jit_counters lp_jit_count[LP_JIT_KIND_COUNT];
+
+
+/**
+ * Count building JIT code, which is only compiled by LLVM when it wasn't
+ * found in the disk cache.
+ */
+static inline void
+lp_jit_count_compile(enum lp_jit_kind kind, int64_t usecs, bool cache_hit)
+{
+   if (cache_hit) {
+      p_atomic_add(&lp_jit_count[kind].cache_load_time, usecs);
+   } else {
+      p_atomic_inc(&lp_jit_count[kind].compiles);
+      p_atomic_add(&lp_jit_count[kind].compile_time, usecs);
+   }
+}
+
+
 extern void
 lp_reset_counters(void);
 
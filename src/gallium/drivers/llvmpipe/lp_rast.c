@@ -36,7 +36,6 @@
 #include "util/u_memset.h"
 #include "util/os_time.h"
 
-#include "lp_scene_queue.h"
 #include "lp_context.h"
 #include "lp_debug.h"
 #include "lp_fence.h"
@@ -49,6 +48,7 @@
 #include "lp_scene.h"
 #include "lp_screen.h"
 #include "lp_tex_sample.h"
+#include "lp_thread.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -74,30 +74,6 @@ const float lp_sample_pos_8x[8][2] = { { 0.5625, 0.3125 },
                                        { 0.6875, 0.9375 },
                                        { 0.9375, 0.0625 } };
 
-/**
- * Begin rasterizing a scene.
- * Called once per scene by one thread.
- */
-static void
-lp_rast_begin(struct lp_rasterizer *rast,
-              struct lp_scene *scene)
-{
-   rast->curr_scene = scene;
-
-   LP_DBG(DEBUG_RAST, "%s\n", __func__);
-
-   lp_scene_begin_rasterization(scene);
-   lp_scene_bin_iter_begin(scene);
-}
-
-
-static void
-lp_rast_end(struct lp_rasterizer *rast)
-{
-   rast->curr_scene = NULL;
-}
-
-
 /**
  * Beginning rasterization of a tile.
  * \param x  window X position of the tile, in pixels
@@ -113,16 +89,18 @@ lp_rast_tile_begin(struct lp_rasterizer_task *task,
    LP_DBG(DEBUG_RAST, "%s %d,%d\n", __func__, x, y);
 
    task->bin = bin;
-   task->x = x * TILE_SIZE;
-   task->y = y * TILE_SIZE;
-   task->width = TILE_SIZE + x * TILE_SIZE > scene->fb.width ?
-                    scene->fb.width - x * TILE_SIZE : TILE_SIZE;
-   task->height = TILE_SIZE + y * TILE_SIZE > scene->fb.height ?
-                    scene->fb.height - y * TILE_SIZE : TILE_SIZE;
+   task->x = x << scene->tile_order;
+   task->y = y << scene->tile_order;
+   task->width = MIN2(scene->tile_size, scene->fb.width - task->x);
+   task->height = MIN2(scene->tile_size, scene->fb.height - task->y);
 
    task->thread_data.vis_counter = 0;
    task->thread_data.ps_invocations = 0;
 
+   /* Nothing is known about the depth buffer contents yet. */
+   if (scene->hiz)
+      lp_rast_hiz_reset(task, INFINITY);
+
    for (unsigned i = 0; i < scene->fb.nr_cbufs; i++) {
       if (scene->fb.cbufs[i].texture) {
          task->color_tiles[i] = scene->cbufs[i].map +
@@ -294,6 +272,32 @@ lp_rast_clear_zstencil(struct lp_rasterizer_task *task,
             dst_layer += scene->zsbuf.layer_stride;
          }
       }
+
+      if (scene->hiz) {
+         const enum pipe_format format = scene->fb.zsbuf.format;
+         const uint64_t zmask = util_pack64_mask_z(format, ~0u);
+
+         if ((clear_mask64 & zmask) == zmask) {
+            const uint16_t value16 = (uint16_t) clear_value64;
+            const uint32_t value32 = (uint32_t) clear_value64;
+            float z;
+
+            switch (util_format_get_blocksize(format)) {
+            case 2:
+               util_format_unpack_z_float(format, &z, &value16, 1);
+               break;
+            case 4:
+               util_format_unpack_z_float(format, &z, &value32, 1);
+               break;
+            default:
+               util_format_unpack_z_float(format, &z, &clear_value64, 1);
+               break;
+            }
+            lp_rast_hiz_reset(task, z + scene->hiz_eps);
+         } else if (clear_mask64 & zmask) {
+            lp_rast_hiz_reset(task, INFINITY);
+         }
+      }
    }
 }
 
@@ -326,8 +330,15 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
 
    const struct lp_fragment_shader_variant *variant = state->variant;
 
+   if (lp_rast_hiz_cull(task, inputs, tile_x, tile_y,
+                        task->width, task->height)) {
+      LP_COUNT(nr_hiz_culled_64);
+      return;
+   }
+   lp_rast_hiz_invalidate(task, tile_x, tile_y, task->width, task->height);
+
    unsigned view_index = inputs->view_index;
-   /* render the whole 64x64 tile in 4x4 chunks */
+   /* render the whole tile in 4x4 chunks */
    for (unsigned y = 0; y < task->height; y += 4){
       for (unsigned x = 0; x < task->width; x += 4) {
          /* color buffer */
@@ -389,6 +400,10 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
          END_JIT_CALL();
       }
    }
+
+   for (unsigned y = 0; y < task->height; y += 1 << LP_HIZ_ORDER)
+      for (unsigned x = 0; x < task->width; x += 1 << LP_HIZ_ORDER)
+         lp_rast_hiz_update(task, inputs, tile_x + x, tile_y + y);
 }
 
 
@@ -431,8 +446,8 @@ lp_rast_shade_quads_mask_sample(struct lp_rasterizer_task *task,
    assert(state);
 
    /* Sanity checks */
-   assert(x < scene->tiles_x * TILE_SIZE);
-   assert(y < scene->tiles_y * TILE_SIZE);
+   assert(x < scene->tiles_x * scene->tile_size);
+   assert(y < scene->tiles_y * scene->tile_size);
    assert(x % TILE_VECTOR_WIDTH == 0);
    assert(y % TILE_VECTOR_HEIGHT == 0);
 
@@ -473,7 +488,13 @@ lp_rast_shade_quads_mask_sample(struct lp_rasterizer_task *task,
     * The rasterizer may produce fragments outside our
     * allocated 4x4 blocks hence need to filter them out here.
     */
-   if ((x % TILE_SIZE) < task->width && (y % TILE_SIZE) < task->height) {
+   if (x - task->x < task->width && y - task->y < task->height) {
+      if (lp_rast_hiz_cull(task, inputs, x, y, 4, 4)) {
+         LP_COUNT(nr_hiz_culled_4);
+         return;
+      }
+      lp_rast_hiz_invalidate(task, x, y, 4, 4);
+
       /* Propagate non-interpolated raster state. */
       task->thread_data.raster_state.viewport_index = inputs->viewport_index;
       task->thread_data.raster_state.view_index = inputs->view_index;
@@ -1047,14 +1068,39 @@ is_empty_bin(const struct cmd_bin *bin)
 }
 
 
+/** Bins rasterized before checking whether other tenants are waiting */
+#define LP_RAST_QUANTUM 8
+
+
 /**
- * Rasterize/execute all bins within a scene.
- * Called per thread.
+ * Begin rasterizing a scene.
+ * Called once per scene by one thread.
  */
 static void
+lp_rast_begin(struct lp_rasterizer *rast,
+              struct lp_scene *scene)
+{
+   LP_DBG(DEBUG_RAST, "%s\n", __func__);
+
+   lp_scene_begin_rasterization(scene);
+   lp_scene_bin_iter_begin(scene, rast->num_threads);
+}
+
+
+/**
+ * Rasterize/execute bins of a scene.
+ * Called per thread.  Returns true once the scene has no bins left to hand
+ * out, false if the thread stopped early to let other tenants in.  The
+ * work done is added to *cost.
+ */
+static bool
 rasterize_scene(struct lp_rasterizer_task *task,
-                struct lp_scene *scene)
+                struct lp_scene *scene,
+                uint64_t *cost)
 {
+   struct lp_rasterizer *rast = task->rast;
+   bool drained = true;
+
    task->scene = scene;
 
    /* Clear the cache tags. This should not always be necessary but
@@ -1069,15 +1115,25 @@ rasterize_scene(struct lp_rasterizer_task *task,
 #endif
 #endif
 
-   if (!task->rast->no_rast) {
+   if (!rast->no_rast) {
       /* loop over scene bins, rasterize each */
       struct cmd_bin *bin;
+      unsigned n = 0;
       int i, j;
 
       assert(scene);
-      while ((bin = lp_scene_bin_iter_next(scene, &i, &j))) {
+      while ((bin = lp_scene_bin_iter_next(scene, task->thread_index,
+                                           &i, &j))) {
          if (!is_empty_bin(bin))
             rasterize_bin(task, bin, i, j);
+
+         *cost += 1 + bin->cost;
+
+         if (++n % LP_RAST_QUANTUM == 0 &&
+             p_atomic_read(&rast->num_runnable) > 1) {
+            drained = false;
+            break;
+         }
       }
    }
 
@@ -1095,11 +1151,120 @@ rasterize_scene(struct lp_rasterizer_task *task,
    }
 #endif
 
+   task->scene = NULL;
+
+   return drained;
+}
+
+
+/**
+ * Can the first pending scene of a tenant start?  Scenes touching the
+ * same resources as a scene submitted earlier by another context wait
+ * for it, as they would have in a single submission queue.
+ */
+static bool
+scene_is_ready(const struct lp_rasterizer *rast,
+               const struct lp_scene *scene)
+{
+   list_for_each_entry(struct lp_rast_tenant, other, &rast->tenants, link) {
+      if (other == scene->tenant)
+         continue;
+
+      if (other->active && other->active->rast_seqno < scene->rast_seqno &&
+          lp_scene_depends_on(scene, other->active))
+         return false;
+
+      for (const struct lp_scene *prev = other->pending_head;
+           prev && prev->rast_seqno < scene->rast_seqno;
+           prev = prev->rast_next) {
+         if (lp_scene_depends_on(scene, prev))
+            return false;
+      }
+   }
+
+   return true;
+}
+
+
+/**
+ * Pick the scene to work on next, activating it if necessary.
+ * Among the tenants with work available, the one with the smallest
+ * virtual time wins.  Called with rast->mutex held.
+ */
+static struct lp_scene *
+pick_scene(struct lp_rasterizer *rast)
+{
+   struct lp_rast_tenant *best = NULL;
+   unsigned num_runnable = 0;
+
+   list_for_each_entry(struct lp_rast_tenant, tenant, &rast->tenants, link) {
+      if (tenant->active) {
+         if (tenant->active->rast_drained)
+            continue;
+      } else if (!tenant->pending_head ||
+                 !scene_is_ready(rast, tenant->pending_head)) {
+         continue;
+      }
+
+      num_runnable++;
+      if (!best || tenant->vtime < best->vtime)
+         best = tenant;
+   }
+
+   p_atomic_set(&rast->num_runnable, num_runnable);
+
+   if (!best)
+      return NULL;
+
+   if (!best->active) {
+      struct lp_scene *scene = best->pending_head;
+
+      best->pending_head = scene->rast_next;
+      if (!best->pending_head)
+         best->pending_tail = NULL;
+      scene->rast_next = NULL;
+
+      lp_rast_begin(rast, scene);
+      best->active = scene;
+   }
+
+   rast->vtime = MAX2(rast->vtime, best->vtime);
+
+   return best->active;
+}
+
+
+/**
+ * Called with rast->mutex held by the last thread leaving a drained scene.
+ */
+static void
+finish_scene(struct lp_rasterizer *rast, struct lp_scene *scene)
+{
+   struct lp_rast_tenant *tenant = scene->tenant;
+
+   assert(tenant->active == scene);
+   tenant->active = NULL;
+   scene->tenant = NULL;
+
    if (scene->fence) {
       lp_fence_signal(scene->fence);
    }
 
-   task->scene = NULL;
+   /* The tenant's next scene and scenes waiting on this one may start */
+   cnd_broadcast(&rast->work);
+}
+
+
+/**
+ * Other contexts read the fence when a resource is flushed, so this is
+ * done under lp_rasterizer::mutex.
+ */
+static void
+set_last_fence(struct lp_rast_tenant *tenant, struct lp_scene *scene)
+{
+   lp_fence_reference(&tenant->last_fence, scene->fence);
+   if (tenant->last_fence)
+      tenant->last_fence->issued = true;
 }
 
 
@@ -1107,67 +1272,78 @@ rasterize_scene(struct lp_rasterizer_task *task,
  * Called by setup module when it has something for us to render.
  */
 void
-lp_rast_queue_scene(struct lp_rasterizer *rast,
+lp_rast_queue_scene(struct lp_rast_tenant *tenant,
                     struct lp_scene *scene)
 {
-   LP_DBG(DEBUG_SETUP, "%s\n", __func__);
+   struct lp_rasterizer *rast = tenant->rast;
 
-   lp_fence_reference(&rast->last_fence, scene->fence);
-   if (rast->last_fence)
-      rast->last_fence->issued = true;
+   LP_DBG(DEBUG_SETUP, "%s\n", __func__);
 
    if (rast->num_threads == 0) {
       /* no threading */
       unsigned fpstate = util_fpstate_get();
+      uint64_t cost = 0;
 
       /* Make sure that denorms are treated like zeros. This is
        * the behavior required by D3D10. OpenGL doesn't care.
        */
       util_fpstate_set_denorms_to_zero(fpstate);
 
+      /* The single task is shared by all contexts */
+      mtx_lock(&rast->mutex);
+
+      set_last_fence(tenant, scene);
       lp_rast_begin(rast, scene);
 
-      rasterize_scene(&rast->tasks[0], scene);
+      rasterize_scene(&rast->tasks[0], scene, &cost);
+
+      if (scene->fence) {
+         lp_fence_signal(scene->fence);
+      }
 
-      lp_rast_end(rast);
+      mtx_unlock(&rast->mutex);
 
       util_fpstate_set(fpstate);
-
-      rast->curr_scene = NULL;
    } else {
       /* threaded rendering! */
-      lp_scene_enqueue(rast->full_scenes, scene);
+      mtx_lock(&rast->mutex);
 
-      /* signal the threads that there's work to do */
-      for (unsigned i = 0; i < rast->num_threads; i++) {
-         util_semaphore_signal(&rast->tasks[i].work_ready);
-      }
-   }
+      set_last_fence(tenant, scene);
 
-   LP_DBG(DEBUG_SETUP, "%s done \n", __func__);
-}
+      /* Don't let a tenant bank credit while it was idle */
+      if (!tenant->active && !tenant->pending_head)
+         tenant->vtime = MAX2(tenant->vtime, rast->vtime);
 
+      scene->tenant = tenant;
+      scene->rast_next = NULL;
+      scene->rast_seqno = ++rast->seqno;
+      scene->rast_refs = 0;
+      scene->rast_drained = false;
 
-void
-lp_rast_finish(struct lp_rasterizer *rast)
-{
-   if (rast->num_threads == 0) {
-      /* nothing to do */
-   } else {
-      /* wait for work to complete */
-      for (unsigned i = 0; i < rast->num_threads; i++) {
-         util_semaphore_wait(&rast->tasks[i].work_done);
-      }
+      if (tenant->pending_tail)
+         tenant->pending_tail->rast_next = scene;
+      else
+         tenant->pending_head = scene;
+      tenant->pending_tail = scene;
+
+      /* Make threads busy with other scenes come back to the scheduler */
+      p_atomic_inc(&rast->num_runnable);
+
+      /* signal the threads that there's work to do */
+      cnd_broadcast(&rast->work);
+      mtx_unlock(&rast->mutex);
    }
+
+   LP_DBG(DEBUG_SETUP, "%s done \n", __func__);
 }
 
 
 /**
  * This is the thread's main entrypoint.
  * It's a simple loop:
- *   1. wait for work
- *   2. do work
- *   3. signal that we're done
+ *   1. pick the next scene to work on, or wait for work
+ *   2. rasterize some of its bins
+ *   3. account for the work, retire the scene if it's done
  */
 static int
 thread_function(void *init_data)
@@ -1180,56 +1356,53 @@ thread_function(void *init_data)
    snprintf(thread_name, sizeof thread_name, "llvmpipe-%u", task->thread_index);
    u_thread_setname(thread_name);
 
+   if (rast->pin_threads)
+      lp_thread_bind_l3(task->thread_index, rast->num_threads);
+
    /* Make sure that denorms are treated like zeros. This is
     * the behavior required by D3D10. OpenGL doesn't care.
     */
    unsigned fpstate = util_fpstate_get();
    util_fpstate_set_denorms_to_zero(fpstate);
 
-   while (1) {
-      /* wait for work */
-      if (debug)
-         debug_printf("thread %d waiting for work\n", task->thread_index);
-      util_semaphore_wait(&task->work_ready);
+   mtx_lock(&rast->mutex);
 
-      if (rast->exit_flag)
-         break;
+   while (!rast->exit_flag) {
+      struct lp_scene *scene = pick_scene(rast);
 
-      if (task->thread_index == 0) {
-         /* thread[0]:
-          *  - get next scene to rasterize
-          *  - map the framebuffer surfaces
-          */
-         lp_rast_begin(rast, lp_scene_dequeue(rast->full_scenes, true));
+      if (!scene) {
+         /* wait for work */
+         if (debug)
+            debug_printf("thread %d waiting for work\n", task->thread_index);
+         cnd_wait(&rast->work, &rast->mutex);
+         continue;
       }
 
-      /* Wait for all threads to get here so that threads[1+] don't
-       * get a null rast->curr_scene pointer.
-       */
-      util_barrier_wait(&rast->barrier);
+      struct lp_rast_tenant *tenant = scene->tenant;
+      uint64_t cost = 0;
+
+      scene->rast_refs++;
+      mtx_unlock(&rast->mutex);
 
       /* do work */
       if (debug)
          debug_printf("thread %d doing work\n", task->thread_index);
 
-      rasterize_scene(task, rast->curr_scene);
+      bool drained = rasterize_scene(task, scene, &cost);
 
-      /* wait for all threads to finish with this scene */
-      util_barrier_wait(&rast->barrier);
+      mtx_lock(&rast->mutex);
 
-      /* XXX: shouldn't be necessary:
-       */
-      if (task->thread_index == 0) {
-         lp_rast_end(rast);
-      }
+      tenant->vtime += cost * LP_RAST_PRIORITY_HIGH / tenant->weight;
 
-      /* signal done with work */
-      if (debug)
-         debug_printf("thread %d done working\n", task->thread_index);
+      if (drained)
+         scene->rast_drained = true;
 
-      util_semaphore_signal(&task->work_done);
+      if (--scene->rast_refs == 0 && scene->rast_drained)
+         finish_scene(rast, scene);
    }
 
+   mtx_unlock(&rast->mutex);
+
 #ifdef _WIN32
    util_semaphore_signal(&task->exited);
 #endif
@@ -1246,8 +1419,6 @@ create_rast_threads(struct lp_rasterizer *rast)
 {
    /* NOTE: if num_threads is zero, we won't use any threads */
    for (unsigned i = 0; i < rast->num_threads; i++) {
-      util_semaphore_init(&rast->tasks[i].work_ready, 0);
-      util_semaphore_init(&rast->tasks[i].work_done, 0);
 #ifdef _WIN32
       util_semaphore_init(&rast->tasks[i].exited, 0);
 #endif
@@ -1264,20 +1435,30 @@ create_rast_threads(struct lp_rasterizer *rast)
  * Create new lp_rasterizer.  If num_threads is zero, don't create any
  * new threads, do rendering synchronously.
  * \param num_threads  number of rasterizer threads to create
+ * \param pin_threads  pin the threads to L3 cache domains
  */
 struct lp_rasterizer *
-lp_rast_create(unsigned num_threads)
+lp_rast_create(unsigned num_threads, bool pin_threads)
 {
    struct lp_rasterizer *rast = CALLOC_STRUCT(lp_rasterizer);
    if (!rast) {
       goto no_rast;
    }
 
-   rast->full_scenes = lp_scene_queue_create();
-   if (!rast->full_scenes) {
-      goto no_full_scenes;
+   (void) mtx_init(&rast->mutex, mtx_plain);
+   cnd_init(&rast->work);
+   list_inithead(&rast->tenants);
+
+   rast->tasks = CALLOC(MAX2(1, num_threads), sizeof *rast->tasks);
+   rast->threads = CALLOC(MAX2(1, num_threads), sizeof *rast->threads);
+   if (!rast->tasks || !rast->threads) {
+      goto no_tasks;
    }
 
+   /* Apart from the allocator header, the per-thread format cache is
+    * first written by its own (possibly pinned) thread, so its pages end
+    * up on that thread's node.
+    */
    for (unsigned i = 0; i < MAX2(1, num_threads); i++) {
       struct lp_rasterizer_task *task = &rast->tasks[i];
       task->rast = rast;
@@ -1290,29 +1471,27 @@ lp_rast_create(unsigned num_threads)
    }
 
    rast->num_threads = num_threads;
+   rast->pin_threads = pin_threads;
 
    rast->no_rast = debug_get_bool_option("LP_NO_RAST", false);
 
    create_rast_threads(rast);
 
-   /* for synchronizing rasterization threads */
-   if (rast->num_threads > 0) {
-      util_barrier_init(&rast->barrier, rast->num_threads);
-   }
-
    memset(lp_dummy_tile, 0, sizeof lp_dummy_tile);
 
    return rast;
 
 no_thread_data_cache:
-   for (unsigned i = 0; i < MAX2(1, rast->num_threads); i++) {
+   for (unsigned i = 0; i < MAX2(1, num_threads); i++) {
       if (rast->tasks[i].thread_data.cache) {
          align_free(rast->tasks[i].thread_data.cache);
       }
    }
-
-   lp_scene_queue_destroy(rast->full_scenes);
-no_full_scenes:
+no_tasks:
+   FREE(rast->threads);
+   FREE(rast->tasks);
+   cnd_destroy(&rast->work);
+   mtx_destroy(&rast->mutex);
    FREE(rast);
 no_rast:
    return NULL;
@@ -1324,14 +1503,14 @@ no_rast:
 void
 lp_rast_destroy(struct lp_rasterizer *rast)
 {
-   /* Set exit_flag and signal each thread's work_ready semaphore.
+   /* Set exit_flag and wake up all threads.
     * Each thread will be woken up, notice that the exit_flag is set and
     * break out of its main loop.  The thread will then exit.
     */
+   mtx_lock(&rast->mutex);
    rast->exit_flag = true;
-   for (unsigned i = 0; i < rast->num_threads; i++) {
-      util_semaphore_signal(&rast->tasks[i].work_ready);
-   }
+   cnd_broadcast(&rast->work);
+   mtx_unlock(&rast->mutex);
 
    /* Wait for threads to terminate before cleaning up per-thread data.
     * We don't actually call pipe_thread_wait to avoid dead lock on Windows
@@ -1352,34 +1531,81 @@ lp_rast_destroy(struct lp_rasterizer *rast)
    }
 
    /* Clean up per-thread data */
-   for (unsigned i = 0; i < rast->num_threads; i++) {
-      util_semaphore_destroy(&rast->tasks[i].work_ready);
-      util_semaphore_destroy(&rast->tasks[i].work_done);
 #ifdef _WIN32
+   for (unsigned i = 0; i < rast->num_threads; i++) {
       util_semaphore_destroy(&rast->tasks[i].exited);
-#endif
    }
+#endif
    for (unsigned i = 0; i < MAX2(1, rast->num_threads); i++) {
       align_free(rast->tasks[i].thread_data.cache);
    }
 
-   lp_fence_reference(&rast->last_fence, NULL);
-
-   /* for synchronizing rasterization threads */
-   if (rast->num_threads > 0) {
-      util_barrier_destroy(&rast->barrier);
-   }
+   assert(list_is_empty(&rast->tenants));
 
-   lp_scene_queue_destroy(rast->full_scenes);
+   cnd_destroy(&rast->work);
+   mtx_destroy(&rast->mutex);
 
+   FREE(rast->threads);
+   FREE(rast->tasks);
    FREE(rast);
 }
 
 
+/**
+ * Register a new client (context) of the rasterizer.
+ * \param priority  one of LP_RAST_PRIORITY_x
+ */
+struct lp_rast_tenant *
+lp_rast_tenant_create(struct lp_rasterizer *rast, unsigned priority)
+{
+   struct lp_rast_tenant *tenant = CALLOC_STRUCT(lp_rast_tenant);
+   if (!tenant)
+      return NULL;
+
+   tenant->rast = rast;
+   tenant->weight = CLAMP(priority, LP_RAST_PRIORITY_LOW,
+                          LP_RAST_PRIORITY_HIGH);
+
+   mtx_lock(&rast->mutex);
+   tenant->vtime = rast->vtime;
+   list_addtail(&tenant->link, &rast->tenants);
+   mtx_unlock(&rast->mutex);
+
+   return tenant;
+}
+
+
+/**
+ * All scenes queued by the tenant must have finished.
+ */
 void
-lp_rast_fence(struct lp_rasterizer *rast,
+lp_rast_tenant_destroy(struct lp_rast_tenant *tenant)
+{
+   struct lp_rasterizer *rast = tenant->rast;
+
+   mtx_lock(&rast->mutex);
+   assert(!tenant->active && !tenant->pending_head);
+   list_del(&tenant->link);
+   mtx_unlock(&rast->mutex);
+
+   lp_fence_reference(&tenant->last_fence, NULL);
+   FREE(tenant);
+}
+
+
+/**
+ * Get the fence of the last scene queued by the tenant.
+ * May be called from any context.
+ */
+void
+lp_rast_fence(struct lp_rast_tenant *tenant,
               struct lp_fence **fence)
 {
-   if (fence)
-      lp_fence_reference((struct lp_fence **)fence, rast->last_fence);
+   struct lp_rasterizer *rast = tenant->rast;
+
+   if (fence) {
+      mtx_lock(&rast->mutex);
+      lp_fence_reference((struct lp_fence **)fence, tenant->last_fence);
+      mtx_unlock(&rast->mutex);
+   }
 }
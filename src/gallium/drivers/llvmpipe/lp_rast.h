@@ -44,6 +44,7 @@
 
 
 struct lp_rasterizer;
+struct lp_rast_tenant;
 struct lp_scene;
 struct lp_fence;
 struct cmd_bin;
@@ -231,18 +232,30 @@ GET_PLANES(const struct lp_rast_triangle *tri)
 }
 
 
+/**
+ * Tenant weights.  A tenant gets roughly weight / sum(weights) of the
+ * rasterizer threads while other tenants have work queued.
+ */
+#define LP_RAST_PRIORITY_LOW     1
+#define LP_RAST_PRIORITY_MEDIUM  4
+#define LP_RAST_PRIORITY_HIGH    16
+
+
 struct lp_rasterizer *
-lp_rast_create(unsigned num_threads);
+lp_rast_create(unsigned num_threads, bool pin_threads);
 
 void
 lp_rast_destroy(struct lp_rasterizer *);
 
+struct lp_rast_tenant *
+lp_rast_tenant_create(struct lp_rasterizer *rast, unsigned priority);
+
 void
-lp_rast_queue_scene(struct lp_rasterizer *rast,
-                     struct lp_scene *scene);
+lp_rast_tenant_destroy(struct lp_rast_tenant *tenant);
 
 void
-lp_rast_finish(struct lp_rasterizer *rast);
+lp_rast_queue_scene(struct lp_rast_tenant *tenant,
+                    struct lp_scene *scene);
 
 
 union lp_rast_cmd_arg {
@@ -435,7 +448,7 @@ void
 lp_debug_draw_bins_by_coverage(struct lp_scene *scene);
 
 void
-lp_rast_fence(struct lp_rasterizer *rast,
+lp_rast_fence(struct lp_rast_tenant *tenant,
               struct lp_fence **fence);
 
 #endif
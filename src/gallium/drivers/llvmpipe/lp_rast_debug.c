@@ -8,7 +8,8 @@ struct tile {
    int coverage;
    int overdraw;
    const struct lp_rast_state *state;
-   char data[TILE_SIZE][TILE_SIZE];
+   unsigned size;   /**< the scene's tile size */
+   char data[1 << LP_MAX_TILE_ORDER][1 << LP_MAX_TILE_ORDER];
 };
 
 
@@ -230,8 +231,8 @@ debug_rectangle(int x, int y,
 
    bool blend = tile->state->variant->key.blend.rt[0].blend_enable;
    unsigned count = 0;
-   for (unsigned i = 0; i < TILE_SIZE; i++) {
-      for (unsigned j = 0; j < TILE_SIZE; j++) {
+   for (unsigned i = 0; i < tile->size; i++) {
+      for (unsigned j = 0; j < tile->size; j++) {
          if (rect->box.x0 <= x + i &&
              rect->box.x1 >= x + i &&
              rect->box.y0 <= y + j &&
@@ -256,11 +257,11 @@ debug_blit_tile(int x, int y,
    if (inputs->disable)
       return 0;
 
-   for (unsigned i = 0; i < TILE_SIZE; i++)
-      for (unsigned j = 0; j < TILE_SIZE; j++)
+   for (unsigned i = 0; i < tile->size; i++)
+      for (unsigned j = 0; j < tile->size; j++)
          plot(tile, i, j, val, false);
 
-   return TILE_SIZE * TILE_SIZE;
+   return tile->size * tile->size;
 }
 
 
@@ -279,11 +280,11 @@ debug_shade_tile(int x, int y,
 
    bool blend = tile->state->variant->key.blend.rt[0].blend_enable;
 
-   for (unsigned i = 0; i < TILE_SIZE; i++)
-      for (unsigned j = 0; j < TILE_SIZE; j++)
+   for (unsigned i = 0; i < tile->size; i++)
+      for (unsigned j = 0; j < tile->size; j++)
          plot(tile, i, j, val, blend);
 
-   return TILE_SIZE * TILE_SIZE;
+   return tile->size * tile->size;
 }
 
 
@@ -293,11 +294,11 @@ debug_clear_tile(int x, int y,
                  struct tile *tile,
                  char val)
 {
-   for (unsigned i = 0; i < TILE_SIZE; i++)
-      for (unsigned j = 0; j < TILE_SIZE; j++)
+   for (unsigned i = 0; i < tile->size; i++)
+      for (unsigned j = 0; j < tile->size; j++)
          plot(tile, i, j, val, false);
 
-   return TILE_SIZE * TILE_SIZE;
+   return tile->size * tile->size;
 }
 
 
@@ -329,8 +330,8 @@ debug_triangle(int tilex, int tiley,
       nr_planes++;
    }
 
-   for (y = 0; y < TILE_SIZE; y++) {
-      for (x = 0; x < TILE_SIZE; x++) {
+   for (y = 0; y < tile->size; y++) {
+      for (x = 0; x < tile->size; x++) {
          for (i = 0; i < nr_planes; i++)
             if (plane[i].c <= 0)
                goto out;
@@ -344,7 +345,7 @@ debug_triangle(int tilex, int tiley,
       }
 
       for (i = 0; i < nr_planes; i++) {
-         plane[i].c += IMUL64(plane[i].dcdx, TILE_SIZE);
+         plane[i].c += IMUL64(plane[i].dcdx, tile->size);
          plane[i].c += plane[i].dcdy;
       }
    }
@@ -356,15 +357,17 @@ static void
 do_debug_bin(struct tile *tile,
              const struct cmd_bin *bin,
              int x, int y,
+             unsigned tile_size,
              bool print_cmds)
 {
    unsigned k, j = 0;
    const struct cmd_block *block;
 
-   int tx = x * TILE_SIZE;
-   int ty = y * TILE_SIZE;
+   int tx = x * tile_size;
+   int ty = y * tile_size;
 
    memset(tile->data, ' ', sizeof tile->data);
+   tile->size = tile_size;
    tile->coverage = 0;
    tile->overdraw = 0;
    tile->state = NULL;
@@ -425,16 +428,17 @@ do_debug_bin(struct tile *tile,
 
 
 void
-lp_debug_bin(const struct cmd_bin *bin, int i, int j)
+lp_debug_bin(const struct lp_scene *scene, const struct cmd_bin *bin,
+             int i, int j)
 {
    struct tile tile;
 
    if (bin->head) {
-      do_debug_bin(&tile, bin, i, j, true);
+      do_debug_bin(&tile, bin, i, j, scene->tile_size, true);
 
       debug_printf("------------------------------------------------------------------\n");
-      for (int y = 0; y < TILE_SIZE; y++) {
-         for (int x = 0; x < TILE_SIZE; x++) {
+      for (int y = 0; y < tile.size; y++) {
+         for (int x = 0; x < tile.size; x++) {
             debug_printf("%c", tile.data[y][x]);
          }
          debug_printf("|\n");
@@ -480,18 +484,19 @@ lp_debug_draw_bins_by_coverage(struct lp_scene *scene)
 
          if (bin->head) {
             struct tile tile;
-            //lp_debug_bin(bin, x, y);
+            //lp_debug_bin(scene, bin, x, y);
 
-            do_debug_bin(&tile, bin, x, y, false);
+            do_debug_bin(&tile, bin, x, y, scene->tile_size, false);
 
+            const unsigned tile_pixels = tile.size * tile.size;
             total += tile.coverage;
-            possible += 64*64;
+            possible += tile_pixels;
 
-            if (tile.coverage == 64*64)
+            if (tile.coverage == tile_pixels)
                debug_printf("*");
             else if (tile.coverage) {
                const char *bits = "0123456789";
-               int bit = tile.coverage/(64.0*64.0)*10;
+               int bit = tile.coverage / (double)tile_pixels * 10;
                debug_printf("%c", bits[MIN2(bit,10)]);
             }
             else
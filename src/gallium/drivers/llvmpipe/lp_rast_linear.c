@@ -32,7 +32,6 @@
 #include "util/u_surface.h"
 #include "util/u_pack_color.h"
 
-#include "lp_scene_queue.h"
 #include "lp_debug.h"
 #include "lp_fence.h"
 #include "lp_perf.h"
@@ -29,9 +29,12 @@
 #define LP_RAST_PRIV_H
 
 #include "util/format/u_format.h"
+#include "util/list.h"
+#include "util/u_math.h"
 #include "util/u_thread.h"
 #include "gallivm/lp_bld_debug.h"
 #include "lp_memory.h"
+#include "lp_perf.h"
 #include "lp_rast.h"
 #include "lp_scene.h"
 #include "lp_state.h"
@@ -42,6 +45,10 @@
 #define TILE_VECTOR_HEIGHT 4
 #define TILE_VECTOR_WIDTH 4
 
+/** Hierarchical Z block size (16x16) and blocks per row of the largest tile */
+#define LP_HIZ_ORDER 4
+#define LP_HIZ_STRIDE (1 << (LP_MAX_TILE_ORDER - LP_HIZ_ORDER))
+
 /* If we crash in a jitted function, we can examine jit_line and jit_state
  * to get some info.  This is not thread-safe, however.
  */
@@ -100,40 +107,83 @@ struct lp_rasterizer_task
    /** Non-interpolated passthru state and occlude counter for visible pixels */
    struct lp_jit_thread_data thread_data;
 
-   util_semaphore work_ready;
-   util_semaphore work_done;
+   /**
+    * Hierarchical Z: upper bound of the depth buffer contents of each
+    * 16x16 block of the current tile, only valid if lp_scene::hiz.
+    */
+   float hiz_zmax[LP_HIZ_STRIDE * LP_HIZ_STRIDE];
+
 #ifdef _WIN32
    util_semaphore exited;
 #endif
 };
 
 
+/**
+ * A client of the rasterizer, one per setup context.
+ * Scenes of a tenant are rasterized one at a time, in submission order.
+ * All fields are protected by lp_rasterizer::mutex.
+ */
+struct lp_rast_tenant
+{
+   struct list_head link;
+   struct lp_rasterizer *rast;
+
+   /** Share of the threads relative to other tenants, LP_RAST_PRIORITY_x */
+   unsigned weight;
+
+   /** Weighted amount of work rasterized so far, for fair scheduling */
+   uint64_t vtime;
+
+   /** The scene being rasterized, if any */
+   struct lp_scene *active;
+
+   /** Queued scenes, linked through lp_scene::rast_next */
+   struct lp_scene *pending_head, *pending_tail;
+
+   /** Fence of the last queued scene, only touched by the owning context */
+   struct lp_fence *last_fence;
+};
+
+
 /**
  * This is the state required while rasterizing tiles.
  * Note that this contains per-thread information too.
- * The tile size is TILE_SIZE x TILE_SIZE pixels.
+ * The tile size is picked per scene, see lp_scene::tile_size.
+ *
+ * Threads pick a scene from the tenant which has received the least
+ * weighted service so far, rasterize a few bins of it and, if other
+ * tenants are waiting, go back to pick again.  Several scenes from
+ * different contexts can thus be in flight at once.
  */
 struct lp_rasterizer
 {
    bool exit_flag;
    bool no_rast;  /**< For debugging/profiling */
 
-   /** The incoming queue of scenes ready to rasterize */
-   struct lp_scene_queue *full_scenes;
+   /** Protects the tenants and their scene lists */
+   mtx_t mutex;
+   cnd_t work;
 
-   /** The scene currently being rasterized by the threads */
-   struct lp_scene *curr_scene;
+   struct list_head tenants;
 
-   /** A task object for each rasterization thread */
-   struct lp_rasterizer_task tasks[LP_MAX_THREADS];
+   /** Submission counter, orders scenes across tenants */
+   uint64_t seqno;
 
-   unsigned num_threads;
-   thrd_t threads[LP_MAX_THREADS];
+   /** Virtual time of the last tenant picked */
+   uint64_t vtime;
 
-   /** For synchronizing the rasterization threads */
-   util_barrier barrier;
+   /** Number of tenants with work a thread could pick right now */
+   unsigned num_runnable;
 
-   struct lp_fence *last_fence;
+   /** A task object for each rasterization thread (at least one) */
+   struct lp_rasterizer_task *tasks;
+
+   unsigned num_threads;
+   thrd_t *threads;
+
+   /** Pin each thread to an L3 cache domain, see lp_thread_bind_l3() */
+   bool pin_threads;
 };
 
 
@@ -151,7 +201,7 @@ lp_rast_shade_quads_mask(struct lp_rasterizer_task *task,
 
 
 /**
- * Get the pointer to a 4x4 color block (within a 64x64 tile).
+ * Get the pointer to a 4x4 color block (within the current tile).
  * \param x, y location of 4x4 block in window coords
  */
 static inline uint8_t *
@@ -159,8 +209,8 @@ lp_rast_get_color_block_pointer(struct lp_rasterizer_task *task,
                                 unsigned buf, unsigned x, unsigned y,
                                 unsigned layer, unsigned view_index)
 {
-   assert(x < task->scene->tiles_x * TILE_SIZE);
-   assert(y < task->scene->tiles_y * TILE_SIZE);
+   assert(x < task->scene->tiles_x * task->scene->tile_size);
+   assert(y < task->scene->tiles_y * task->scene->tile_size);
    assert((x % TILE_VECTOR_WIDTH) == 0);
    assert((y % TILE_VECTOR_HEIGHT) == 0);
    assert(buf < task->scene->fb.nr_cbufs);
@@ -169,10 +219,10 @@ lp_rast_get_color_block_pointer(struct lp_rasterizer_task *task,
    /*
     * We don't actually benefit from having per tile cbuf/zsbuf pointers,
     * it's just extra work - the mul/add would be exactly the same anyway.
-    * Fortunately the extra work (modulo) here is very cheap at least...
+    * Fortunately the extra work (subtraction) here is very cheap at least...
     */
-   unsigned px = x % TILE_SIZE;
-   unsigned py = y % TILE_SIZE;
+   unsigned px = x - task->x;
+   unsigned py = y - task->y;
 
    unsigned pixel_offset = px * task->scene->cbufs[buf].format_bytes +
                            py * task->scene->cbufs[buf].stride;
@@ -189,21 +239,21 @@ lp_rast_get_color_block_pointer(struct lp_rasterizer_task *task,
 
 
 /**
- * Get the pointer to a 4x4 depth block (within a 64x64 tile).
+ * Get the pointer to a 4x4 depth block (within the current tile).
  * \param x, y location of 4x4 block in window coords
  */
 static inline uint8_t *
 lp_rast_get_depth_block_pointer(struct lp_rasterizer_task *task,
                                 unsigned x, unsigned y, unsigned layer, unsigned view_index)
 {
-   assert(x < task->scene->tiles_x * TILE_SIZE);
-   assert(y < task->scene->tiles_y * TILE_SIZE);
+   assert(x < task->scene->tiles_x * task->scene->tile_size);
+   assert(y < task->scene->tiles_y * task->scene->tile_size);
    assert((x % TILE_VECTOR_WIDTH) == 0);
    assert((y % TILE_VECTOR_HEIGHT) == 0);
    assert(task->depth_tile);
 
-   unsigned px = x % TILE_SIZE;
-   unsigned py = y % TILE_SIZE;
+   unsigned px = x - task->x;
+   unsigned py = y - task->y;
 
    unsigned pixel_offset = px * task->scene->zsbuf.format_bytes +
                            py * task->scene->zsbuf.stride;
@@ -218,6 +268,151 @@ lp_rast_get_depth_block_pointer(struct lp_rasterizer_task *task,
 }
 
 
+/*
+ * Hierarchical Z.
+ *
+ * For each 16x16 block of the tile being rasterized we keep an upper
+ * bound of the values in the depth buffer.  It is unknown (+inf) when the
+ * tile is started, set by depth clears and lowered by fully covered blocks
+ * of variants with hiz_update.  Fragments of variants with hiz_cull that
+ * are all farther away than that bound can't pass the depth test, so the
+ * shader isn't run for them at all.
+ */
+
+
+/** Set the depth bound of all blocks of the tile. */
+static inline void
+lp_rast_hiz_reset(struct lp_rasterizer_task *task, float zmax)
+{
+   for (unsigned i = 0; i < ARRAY_SIZE(task->hiz_zmax); i++)
+      task->hiz_zmax[i] = zmax;
+}
+
+
+/**
+ * Conservative range of the interpolated depth over the w x h pixels at
+ * x, y, before clamping.  Widened to cover rounding differences to the
+ * shader's interpolation and the depth buffer's precision.
+ */
+static inline void
+lp_rast_hiz_depth_range(const struct lp_rasterizer_task *task,
+                        const struct lp_rast_shader_inputs *inputs,
+                        unsigned x, unsigned y, unsigned w, unsigned h,
+                        float *zmin, float *zmax)
+{
+   const float a0 = GET_A0(inputs)[0][2];
+   const float dzdx = GET_DADX(inputs)[0][2];
+   const float dzdy = GET_DADY(inputs)[0][2];
+   const float zx = dzdx * (float)x;
+   const float zy = dzdy * (float)y;
+   const float ex = dzdx * (float)(w - 1);
+   const float ey = dzdy * (float)(h - 1);
+   const float z = a0 + zx + zy;
+   const float err =
+      (fabsf(a0) + fabsf(zx) + fabsf(zy) + fabsf(ex) + fabsf(ey)) *
+      (4.0f * FLT_EPSILON) + task->scene->hiz_eps;
+
+   *zmin = z + MIN2(ex, 0.0f) + MIN2(ey, 0.0f) - err;
+   *zmax = z + MAX2(ex, 0.0f) + MAX2(ey, 0.0f) + err;
+}
+
+
+/**
+ * Whether no fragment of the w x h pixels at x, y (within the current
+ * tile) can pass the depth test.
+ */
+static inline bool
+lp_rast_hiz_cull(const struct lp_rasterizer_task *task,
+                 const struct lp_rast_shader_inputs *inputs,
+                 unsigned x, unsigned y, unsigned w, unsigned h)
+{
+   const struct lp_rast_state *state = task->state;
+
+   if (!task->scene->hiz || !state->variant->hiz_cull)
+      return false;
+
+   const unsigned bx0 = (x - task->x) >> LP_HIZ_ORDER;
+   const unsigned by0 = (y - task->y) >> LP_HIZ_ORDER;
+   const unsigned bx1 = (x - task->x + w - 1) >> LP_HIZ_ORDER;
+   const unsigned by1 = (y - task->y + h - 1) >> LP_HIZ_ORDER;
+   float bound = -INFINITY;
+
+   for (unsigned by = by0; by <= by1; by++)
+      for (unsigned bx = bx0; bx <= bx1; bx++)
+         bound = MAX2(bound, task->hiz_zmax[by * LP_HIZ_STRIDE + bx]);
+
+   if (bound == INFINITY)
+      return false;
+
+   const struct lp_jit_viewport *vp =
+      &state->jit_context.viewports[inputs->viewport_index];
+   float zmin, zmax;
+
+   lp_rast_hiz_depth_range(task, inputs, x, y, w, h, &zmin, &zmax);
+
+   /* The shader may clamp depth to [0, 1] and to the viewport's depth
+    * range, which can only bring it down to 1.0 or max_depth.  Written
+    * as a conjunction so NaN never culls.
+    */
+   return zmin > bound && vp->max_depth > bound && 1.0f > bound;
+}
+
+
+/**
+ * The 16x16 block at x, y was completely covered and shaded, lower its
+ * depth bound.
+ */
+static inline void
+lp_rast_hiz_update(struct lp_rasterizer_task *task,
+                   const struct lp_rast_shader_inputs *inputs,
+                   unsigned x, unsigned y)
+{
+   const struct lp_rast_state *state = task->state;
+
+   if (!task->scene->hiz || !state->variant->hiz_update)
+      return;
+
+   const struct lp_jit_viewport *vp =
+      &state->jit_context.viewports[inputs->viewport_index];
+   float *block = &task->hiz_zmax[((y - task->y) >> LP_HIZ_ORDER) * LP_HIZ_STRIDE +
+                                  ((x - task->x) >> LP_HIZ_ORDER)];
+   float zmin, zmax;
+
+   lp_rast_hiz_depth_range(task, inputs, x, y,
+                           1 << LP_HIZ_ORDER, 1 << LP_HIZ_ORDER,
+                           &zmin, &zmax);
+   if (isnan(zmax))
+      return;
+
+   /* Clamping may raise depth up to 0.0 or min_depth. */
+   zmax = MAX3(zmax, vp->min_depth, 0.0f);
+
+   *block = MIN2(*block, zmax);
+}
+
+
+/**
+ * The w x h pixels at x, y may get farther away, forget what we know
+ * about their blocks.
+ */
+static inline void
+lp_rast_hiz_invalidate(struct lp_rasterizer_task *task,
+                       unsigned x, unsigned y, unsigned w, unsigned h)
+{
+   if (!task->scene->hiz || !task->state->variant->hiz_invalidate)
+      return;
+
+   const unsigned bx0 = (x - task->x) >> LP_HIZ_ORDER;
+   const unsigned by0 = (y - task->y) >> LP_HIZ_ORDER;
+   const unsigned bx1 = (x - task->x + w - 1) >> LP_HIZ_ORDER;
+   const unsigned by1 = (y - task->y + h - 1) >> LP_HIZ_ORDER;
+
+   for (unsigned by = by0; by <= by1; by++)
+      for (unsigned bx = bx0; bx <= bx1; bx++)
+         task->hiz_zmax[by * LP_HIZ_STRIDE + bx] = INFINITY;
+}
+
+
 /**
  * Shade all pixels in a 4x4 block.  The fragment code omits the
  * triangle in/out tests.
@@ -268,7 +463,13 @@ lp_rast_shade_quads_all(struct lp_rasterizer_task *task,
     * The rasterizer may produce fragments outside our
     * allocated 4x4 blocks hence need to filter them out here.
     */
-   if ((x % TILE_SIZE) < task->width && (y % TILE_SIZE) < task->height) {
+   if (x - task->x < task->width && y - task->y < task->height) {
+      if (lp_rast_hiz_cull(task, inputs, x, y, 4, 4)) {
+         LP_COUNT(nr_hiz_culled_4);
+         return;
+      }
+      lp_rast_hiz_invalidate(task, x, y, 4, 4);
+
       /* Propagate non-interpolated raster state. */
       task->thread_data.raster_state.viewport_index = inputs->viewport_index;
       task->thread_data.raster_state.view_index = inputs->view_index;
@@ -464,7 +665,8 @@ lp_rast_set_state(struct lp_rasterizer_task *task,
                   const union lp_rast_cmd_arg arg);
 
 void
-lp_debug_bin(const struct cmd_bin *bin, int x, int y);
+lp_debug_bin(const struct lp_scene *scene, const struct cmd_bin *bin,
+             int x, int y);
 
 void
 lp_linear_rasterize_bin(struct lp_rasterizer_task *task,
@@ -128,8 +128,8 @@ intersect_rect_and_tile(struct lp_rasterizer_task *task,
 {
    box->x0 = task->x;
    box->y0 = task->y;
-   box->x1 = task->x + TILE_SIZE - 1;
-   box->y1 = task->y + TILE_SIZE - 1;
+   box->x1 = task->x + task->scene->tile_size - 1;
+   box->y1 = task->y + task->scene->tile_size - 1;
 
    assert(u_rect_test_intersection(&rect->box, box));
 
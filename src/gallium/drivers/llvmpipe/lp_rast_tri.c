@@ -57,9 +57,17 @@ block_full_16(struct lp_rasterizer_task *task,
 {
    assert(x % 16 == 0);
    assert(y % 16 == 0);
+
+   if (lp_rast_hiz_cull(task, &tri->inputs, x, y, 16, 16)) {
+      LP_COUNT(nr_hiz_culled_16);
+      return;
+   }
+
    for (unsigned iy = 0; iy < 16; iy += 4)
       for (unsigned ix = 0; ix < 16; ix += 4)
          block_full_4(task, tri, x + ix, y + iy);
+
+   lp_rast_hiz_update(task, &tri->inputs, x, y);
 }
 
 static inline unsigned
@@ -190,33 +190,38 @@ TAG(do_block_16)(struct lp_rasterizer_task *task,
 
 
 /**
- * Scan the tile in chunks and figure out which pixels to rasterize
- * for this triangle.
+ * Scan a 64x64 block in 16x16 chunks and figure out which pixels to
+ * rasterize for this triangle.
+ * Planes in accept_mask are known to be trivially accepted for the whole
+ * block and are replaced by one which never rejects, keeping NR_PLANES
+ * planes to evaluate.
+ * Chunks set in outmask are skipped.
  */
-void
-TAG(lp_rast_triangle)(struct lp_rasterizer_task *task,
-                      const union lp_rast_cmd_arg arg)
+static void
+TAG(do_block_64)(struct lp_rasterizer_task *task,
+                 const struct lp_rast_triangle *tri,
+                 unsigned plane_mask,
+                 unsigned accept_mask,
+                 int x, int y,
+                 unsigned outmask)
 {
-   const struct lp_rast_triangle *tri = arg.triangle.tri;
-   unsigned plane_mask = arg.triangle.plane_mask;
    const struct lp_rast_plane *tri_plane = GET_PLANES(tri);
-   const int x = task->x, y = task->y;
    struct lp_rast_plane plane[NR_PLANES];
    int64_t c[NR_PLANES];
-   unsigned outmask, inmask, partmask, partial_mask;
+   unsigned inmask, partmask, partial_mask;
    unsigned j = 0;
 
-   if (tri->inputs.disable) {
-      /* This triangle was partially binned and has been disabled */
-      return;
-   }
-
-   outmask = 0;                 /* outside one or more trivial reject planes */
    partmask = 0;                /* outside one or more trivial accept planes */
 
    while (plane_mask) {
       int i = ffs(plane_mask) - 1;
       plane[j] = tri_plane[i];
+      if (accept_mask & (1 << i)) {
+         plane[j].c = FIXED_ONE;
+         plane[j].dcdx = 0;
+         plane[j].dcdy = 0;
+         plane[j].eo = 0;
+      }
       plane_mask &= ~(1 << i);
       c[j] = plane[j].c + IMUL64(plane[j].dcdy, y) - IMUL64(plane[j].dcdx, x);
 
@@ -295,7 +300,7 @@ TAG(lp_rast_triangle)(struct lp_rasterizer_task *task,
 
    /* Mask of sub-blocks which are inside all trivial accept planes:
     */
-   inmask = ~partmask & 0xffff;
+   inmask = ~partmask & ~outmask & 0xffff;
 
    /* Mask of sub-blocks which are inside all trivial reject planes,
     * but outside at least one trivial accept plane:
@@ -324,6 +329,12 @@ TAG(lp_rast_triangle)(struct lp_rasterizer_task *task,
       partial_mask &= ~(1 << i);
 
       LP_COUNT(nr_partially_covered_16);
+
+      if (lp_rast_hiz_cull(task, &tri->inputs, px, py, 16, 16)) {
+         LP_COUNT(nr_hiz_culled_16);
+         continue;
+      }
+
       TAG(do_block_16)(task, tri, plane, px, py, cx);
    }
 
@@ -344,6 +355,79 @@ TAG(lp_rast_triangle)(struct lp_rasterizer_task *task,
 }
 
 
+/**
+ * Scan the tile in chunks and figure out which pixels to rasterize
+ * for this triangle.
+ */
+void
+TAG(lp_rast_triangle)(struct lp_rasterizer_task *task,
+                      const union lp_rast_cmd_arg arg)
+{
+   const struct lp_rast_triangle *tri = arg.triangle.tri;
+   const unsigned plane_mask = arg.triangle.plane_mask;
+   const unsigned tile_order = task->scene->tile_order;
+
+   if (tri->inputs.disable) {
+      /* This triangle was partially binned and has been disabled */
+      return;
+   }
+
+   if (lp_rast_hiz_cull(task, &tri->inputs, task->x, task->y,
+                        task->width, task->height)) {
+      LP_COUNT(nr_hiz_culled_64);
+      return;
+   }
+
+   if (tile_order == TILE_ORDER) {
+      TAG(do_block_64)(task, tri, plane_mask, 0, task->x, task->y, 0);
+   } else if (tile_order < TILE_ORDER) {
+      /* Only the top left 2x2 16x16 chunks are part of a 32x32 tile. */
+      TAG(do_block_64)(task, tri, plane_mask, 0, task->x, task->y, 0xffcc);
+   } else {
+      /*
+       * Walk the 128x128 tile as 64x64 quadrants.  Each quadrant is first
+       * tested against the planes with 64 bit math just like setup does
+       * when binning, so the 32 bit math in do_block_64 never sees planes
+       * which are far away from the quadrant.
+       */
+      const struct lp_rast_plane *tri_plane = GET_PLANES(tri);
+
+      for (unsigned qy = 0; qy < task->height; qy += TILE_SIZE) {
+         for (unsigned qx = 0; qx < task->width; qx += TILE_SIZE) {
+            const int x = task->x + qx, y = task->y + qy;
+            unsigned mask = plane_mask, accept_mask = 0;
+            bool out = false;
+
+            while (mask) {
+               int i = ffs(mask) - 1;
+               const struct lp_rast_plane *p = &tri_plane[i];
+               const int64_t c = p->c + IMUL64(p->dcdy, y) - IMUL64(p->dcdx, x);
+               const int64_t eo = (int64_t)p->eo << TILE_ORDER;
+               const int64_t ei = ((int64_t)p->dcdy - p->dcdx -
+                                   (int64_t)p->eo) << TILE_ORDER;
+
+               mask &= ~(1 << i);
+
+               if (c + eo < 0) {
+                  out = true;
+                  break;
+               }
+               if (c + ei - 1 >= 0)
+                  accept_mask |= 1 << i;
+            }
+
+            if (out) {
+               LP_COUNT(nr_empty_64);
+               continue;
+            }
+
+            TAG(do_block_64)(task, tri, plane_mask, accept_mask, x, y, 0);
+         }
+      }
+   }
+}
+
+
 #if DETECT_ARCH_SSE && defined(TRI_16)
 /* XXX: special case this when intersection is not required.
  *      - tile completely within bbox,
@@ -357,17 +441,18 @@ TRI_16(struct lp_rasterizer_task *task,
    const struct lp_rast_plane *plane = GET_PLANES(tri);
    unsigned mask = arg.triangle.plane_mask;
    __m128i cstep4[NR_PLANES][4];
+   const int tile_size = task->scene->tile_size;
    int x = (mask & 0xff);
    int y = (mask >> 8);
    unsigned outmask = 0;    /* outside one or more trivial reject planes */
 
-   if (x + 12 >= 64) {
-      int i = ((x + 12) - 64) / 4;
+   if (x + 12 >= tile_size) {
+      int i = ((x + 12) - tile_size) / 4;
       outmask |= right_mask_tab[i];
    }
 
-   if (y + 12 >= 64) {
-      int i = ((y + 12) - 64) / 4;
+   if (y + 12 >= tile_size) {
+      int i = ((y + 12) - tile_size) / 4;
       outmask |= bottom_mask_tab[i];
    }
 
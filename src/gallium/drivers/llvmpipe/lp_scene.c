@@ -73,6 +73,11 @@ lp_scene_create(struct lp_setup_context *setup)
    scene->setup = setup;
    scene->data.head = &scene->data.first;
 
+   if (!lp_bin_sched_init(&scene->sched, setup->num_threads)) {
+      slab_free_st(&setup->scene_slab, scene);
+      return NULL;
+   }
+
    (void) mtx_init(&scene->mutex, mtx_plain);
 
 #if MESA_DEBUG
@@ -102,6 +107,7 @@ lp_scene_destroy(struct lp_scene *scene)
 {
    lp_scene_end_rasterization(scene);
    mtx_destroy(&scene->mutex);
+   lp_bin_sched_destroy(&scene->sched);
    free(scene->tiles);
    assert(scene->data.head == &scene->data.first);
    slab_free_st(&scene->setup->scene_slab, scene);
@@ -147,6 +153,7 @@ lp_scene_bin_reset(struct lp_scene *scene, unsigned x, unsigned y)
    struct cmd_bin *bin = lp_scene_get_bin(scene, x, y);
 
    bin->last_state = NULL;
+   bin->cost = 0;
    bin->head = bin->tail;
    if (bin->tail) {
       bin->tail->next = NULL;
@@ -197,6 +204,28 @@ lp_scene_begin_rasterization(struct lp_scene *scene)
 
    struct pipe_surface *zsbuf = &scene->fb.zsbuf;
    init_scene_texture(&scene->zsbuf, zsbuf->texture ? zsbuf : NULL);
+
+   /*
+    * The rasterizer tracks the depth of a single layer and doesn't know
+    * about sample positions, so only do hierarchical Z for the simple case.
+    */
+   scene->hiz = false;
+   if (scene->zsbuf.map &&
+       scene->fb_max_layer == 0 &&
+       scene->fb_max_samples <= 1 &&
+       !(LP_PERF & PERF_NO_HIZ)) {
+      const struct util_format_description *desc =
+         util_format_description(zsbuf->format);
+
+      if (util_format_has_depth(desc)) {
+         const struct util_format_channel_description *chan =
+            &desc->channel[desc->swizzle[0]];
+
+         scene->hiz = true;
+         scene->hiz_eps = chan->type == UTIL_FORMAT_TYPE_FLOAT ?
+            0.0f : 1.0f / (float)((1ull << chan->size) - 1);
+      }
+   }
 }
 
 
@@ -534,75 +563,88 @@ lp_scene_is_resource_referenced(const struct lp_scene *scene,
 }
 
 
-/** advance curr_x,y to the next bin */
-static bool
-next_bin(struct lp_scene *scene)
+/**
+ * Does scene have to wait for prev to finish?  True if either scene
+ * writes a resource the other one references.
+ */
+bool
+lp_scene_depends_on(const struct lp_scene *scene,
+                    const struct lp_scene *prev)
 {
-   scene->curr_x++;
-   if (scene->curr_x >= scene->tiles_x) {
-      scene->curr_x = 0;
-      scene->curr_y++;
+   const struct resource_ref *ref;
+
+   for (unsigned j = 0; j < scene->fb.nr_cbufs; j++) {
+      if (scene->fb.cbufs[j].texture &&
+          lp_scene_is_resource_referenced(prev, scene->fb.cbufs[j].texture))
+         return true;
    }
-   if (scene->curr_y >= scene->tiles_y) {
-      /* no more bins */
-      return false;
+   if (scene->fb.zsbuf.texture &&
+       lp_scene_is_resource_referenced(prev, scene->fb.zsbuf.texture))
+      return true;
+
+   for (ref = scene->writeable_resources; ref; ref = ref->next) {
+      for (int i = 0; i < ref->count; i++)
+         if (lp_scene_is_resource_referenced(prev, ref->resource[i]))
+            return true;
    }
-   return true;
+
+   for (ref = scene->resources; ref; ref = ref->next) {
+      for (int i = 0; i < ref->count; i++)
+         if (lp_scene_is_resource_referenced(prev, ref->resource[i]) &
+             LP_REFERENCED_FOR_WRITE)
+            return true;
+   }
+
+   return false;
 }
 
 
 void
-lp_scene_bin_iter_begin(struct lp_scene *scene)
+lp_scene_bin_iter_begin(struct lp_scene *scene, unsigned num_threads)
 {
-   scene->curr_x = scene->curr_y = -1;
+   lp_bin_sched_begin(&scene->sched, scene->tiles,
+                      scene->tiles_x, scene->tiles_y,
+                      MAX2(1, num_threads));
 }
 
 
 /**
- * Return pointer to next bin to be rendered.
- * The lp_scene::curr_x and ::curr_y fields will be advanced.
+ * Return pointer to next bin to be rendered by the given thread.
  * Multiple rendering threads will call this function to get a chunk
  * of work (a bin) to work on.
  */
 struct cmd_bin *
-lp_scene_bin_iter_next(struct lp_scene *scene , int *x, int *y)
+lp_scene_bin_iter_next(struct lp_scene *scene, unsigned thread_index,
+                       int *x, int *y)
 {
-   struct cmd_bin *bin = NULL;
+   unsigned idx;
 
-   mtx_lock(&scene->mutex);
-
-   if (scene->curr_x < 0) {
-      /* first bin */
-      scene->curr_x = 0;
-      scene->curr_y = 0;
-   } else if (!next_bin(scene)) {
-      /* no more bins left */
-      goto end;
-   }
-
-   bin = lp_scene_get_bin(scene, scene->curr_x, scene->curr_y);
-   *x = scene->curr_x;
-   *y = scene->curr_y;
+   if (!lp_bin_sched_next(&scene->sched, thread_index, &idx))
+      return NULL;
 
-end:
-   /*printf("return bin %p at %d, %d\n", (void *) bin, *bin_x, *bin_y);*/
-   mtx_unlock(&scene->mutex);
-   return bin;
+   *x = idx % scene->tiles_x;
+   *y = idx / scene->tiles_x;
+   return &scene->tiles[idx];
 }
 
 
 void
 lp_scene_begin_binning(struct lp_scene *scene,
-                       struct pipe_framebuffer_state *fb)
+                       struct pipe_framebuffer_state *fb,
+                       unsigned tile_order)
 {
    assert(lp_scene_is_empty(scene));
+   assert(tile_order >= LP_MIN_TILE_ORDER &&
+          tile_order <= LP_MAX_TILE_ORDER);
 
    util_copy_framebuffer_state(&scene->fb, fb);
 
-   scene->tiles_x = align(fb->width, TILE_SIZE) / TILE_SIZE;
-   scene->tiles_y = align(fb->height, TILE_SIZE) / TILE_SIZE;
-   assert(scene->tiles_x <= TILES_X);
-   assert(scene->tiles_y <= TILES_Y);
+   scene->tile_order = tile_order;
+   scene->tile_size = 1 << tile_order;
+   scene->tiles_x = align(fb->width, scene->tile_size) >> tile_order;
+   scene->tiles_y = align(fb->height, scene->tile_size) >> tile_order;
+   scene->num_prims = 0;
+   assert(scene->tiles_x * scene->tiles_y <= TILES_X * TILES_Y);
 
    unsigned num_required_tiles = scene->tiles_x * scene->tiles_y;
    if (scene->num_alloced_tiles < num_required_tiles) {
@@ -614,6 +656,9 @@ lp_scene_begin_binning(struct lp_scene *scene,
       scene->num_alloced_tiles = num_required_tiles;
    }
 
+   /* On failure the scheduler falls back to raster order. */
+   (void) lp_bin_sched_reserve(&scene->sched, num_required_tiles);
+
    /*
     * Determine how many layers the fb has (used for clamping layer value).
     * OpenGL (but not d3d10) permits different amount of layers per rt,
@@ -656,3 +701,133 @@ lp_scene_end_binning(struct lp_scene *scene)
          lp_debug_bins(scene);
    }
 }
+
+
+/**
+ * Prepare a partial scene to bin primitives for the given scene on
+ * another thread.  The partial scene shares the scene's framebuffer
+ * setup but has its own bins and data blocks.
+ */
+bool
+lp_scene_begin_partial(struct lp_scene *partial,
+                       const struct lp_scene *scene)
+{
+   unsigned num_tiles = scene->tiles_x * scene->tiles_y;
+
+   assert(!scene->partial);
+   assert(partial->data.head == &partial->data.first);
+
+   if (partial->num_alloced_tiles < num_tiles) {
+      struct cmd_bin *tiles = reallocarray(partial->tiles, num_tiles,
+                                           sizeof(struct cmd_bin));
+      if (!tiles)
+         return false;
+      partial->tiles = tiles;
+      partial->num_alloced_tiles = num_tiles;
+   }
+   memset(partial->tiles, 0, sizeof(struct cmd_bin) * num_tiles);
+
+   partial->partial = true;
+   partial->tile_order = scene->tile_order;
+   partial->tile_size = scene->tile_size;
+   partial->tiles_x = scene->tiles_x;
+   partial->tiles_y = scene->tiles_y;
+   partial->num_prims = 0;
+   partial->fb_max_layer = scene->fb_max_layer;
+   partial->fb_max_samples = scene->fb_max_samples;
+   partial->had_queries = scene->had_queries;
+   partial->permit_linear_rasterizer = scene->permit_linear_rasterizer;
+
+   /* Shallow copy, the scene holds the references. */
+   memcpy(&partial->fb, &scene->fb, sizeof partial->fb);
+
+   /* The embedded first block can't be handed over to the scene, so
+    * mark it full and let every allocation come from malloc'ed blocks.
+    */
+   partial->data.first.used = DATA_BLOCK_SIZE;
+   partial->data.first.next = NULL;
+   partial->scene_size = 0;
+   partial->alloc_failed = false;
+
+   return true;
+}
+
+
+/**
+ * Append the partial scene's commands to the scene, bin by bin, and hand
+ * over its data blocks.  Commands binned into the partial scene end up
+ * after everything already in the scene, preserving primitive order.
+ * Returns false, leaving the scene untouched, if the result would exceed
+ * LP_SCENE_MAX_SIZE.
+ */
+bool
+lp_scene_merge_partial(struct lp_scene *scene, struct lp_scene *partial)
+{
+   unsigned num_tiles = scene->tiles_x * scene->tiles_y;
+
+   assert(partial->partial && !partial->alloc_failed);
+   assert(partial->tile_order == scene->tile_order);
+   assert(partial->tiles_x == scene->tiles_x);
+   assert(partial->tiles_y == scene->tiles_y);
+
+   if (scene->scene_size + partial->scene_size > LP_SCENE_MAX_SIZE)
+      return false;
+
+   for (unsigned i = 0; i < num_tiles; i++) {
+      struct cmd_bin *src = &partial->tiles[i];
+      struct cmd_bin *dst = &scene->tiles[i];
+
+      if (!src->head)
+         continue;
+
+      if (dst->tail)
+         dst->tail->next = src->head;
+      else
+         dst->head = src->head;
+      dst->tail = src->tail;
+      dst->last_state = src->last_state;
+      dst->cost += src->cost;
+   }
+
+   if (partial->data.head != &partial->data.first) {
+      struct data_block *last = partial->data.head;
+      while (last->next != &partial->data.first)
+         last = last->next;
+
+      /* Keep the scene's current block at the head so allocation
+       * continues where it left off.
+       */
+      last->next = scene->data.head->next;
+      scene->data.head->next = partial->data.head;
+      partial->data.head = &partial->data.first;
+   }
+
+   scene->scene_size += partial->scene_size;
+   scene->num_prims += partial->num_prims;
+
+   lp_scene_end_partial(partial);
+   return true;
+}
+
+
+/**
+ * Drop whatever is left in a partial scene.
+ */
+void
+lp_scene_end_partial(struct lp_scene *partial)
+{
+   struct data_block *block, *tmp;
+
+   for (block = partial->data.head; block != &partial->data.first;
+        block = tmp) {
+      tmp = block->next;
+      FREE(block);
+   }
+
+   partial->data.head = &partial->data.first;
+   partial->data.first.used = 0;
+   partial->data.first.next = NULL;
+   partial->scene_size = 0;
+   partial->alloc_failed = false;
+   memset(&partial->fb, 0, sizeof partial->fb);
+}
@@ -38,12 +38,14 @@
 #include "util/u_thread.h"
 #include "lp_rast.h"
 #include "lp_debug.h"
+#include "lp_bin_sched.h"
 
-struct lp_scene_queue;
 struct lp_rast_state;
 
 /* We're limited to 2K by 2K for 32bit fixed point rasterization.
  * Will need a 64-bit version for larger framebuffers.
+ * Scenes using smaller tiles than TILE_SIZE may not have more bins than
+ * TILES_X * TILES_Y in total.
  */
 #define TILES_X (LP_MAX_WIDTH / TILE_SIZE)
 #define TILES_Y (LP_MAX_HEIGHT / TILE_SIZE)
@@ -98,6 +100,7 @@ struct cmd_bin {
    const struct lp_rast_state *last_state;  /* most recent state set in bin */
    struct cmd_block *head;
    struct cmd_block *tail;
+   unsigned cost;  /**< rasterization cost estimate, see lp_bin_sched */
 };
 
 
@@ -145,6 +148,13 @@ struct lp_scene {
    struct lp_fence *fence;
    struct lp_setup_context *setup;
 
+   /* Rasterizer scheduling state, protected by lp_rasterizer::mutex */
+   struct lp_rast_tenant *tenant;
+   struct lp_scene *rast_next;
+   uint64_t rast_seqno;
+   unsigned rast_refs;    /**< threads currently working on the scene */
+   bool rast_drained;     /**< all bins have been handed out */
+
    /* The queries still active at end of scene */
    struct llvmpipe_query *active_queries[LP_MAX_ACTIVE_BINNED_QUERIES];
    unsigned num_active_queries;
@@ -165,6 +175,11 @@ struct lp_scene {
    /* max samples for bound framebuffer */
    unsigned fb_max_samples;
 
+   /* Hierarchical Z culling is usable, set by begin_rasterization() */
+   bool hiz;
+   /** Depth buffer resolution, added to hierarchical Z bounds */
+   float hiz_eps;
+
    /** the framebuffer to render the scene into */
    struct pipe_framebuffer_state fb;
 
@@ -191,13 +206,27 @@ struct lp_scene {
    bool alloc_failed;
    bool permit_linear_rasterizer;
 
+   /** Private binning target of a setup binner thread, see lp_setup_mt.c.
+    * Never rasterized, its bins get appended to the real scene.
+    */
+   bool partial;
+
+   /**
+    * Tile size of this scene, 1 << tile_order pixels square, with
+    * tile_order between LP_MIN_TILE_ORDER and LP_MAX_TILE_ORDER.
+    */
+   unsigned tile_order, tile_size;
+
    /**
     * Number of active tiles in each dimension.
     * This basically the framebuffer size divided by tile size
     */
    unsigned tiles_x, tiles_y;
 
-   int curr_x, curr_y;  /**< for iterating over bins */
+   /** Number of primitives binned, used to pick the next scene's tiles */
+   unsigned num_prims;
+
+   struct lp_bin_sched sched;  /**< for iterating over bins */
    mtx_t mutex;
 
    unsigned num_alloced_tiles;
@@ -228,6 +257,9 @@ bool lp_scene_add_resource_reference(struct lp_scene *scene,
 unsigned lp_scene_is_resource_referenced(const struct lp_scene *scene,
                                          const struct pipe_resource *resource);
 
+bool lp_scene_depends_on(const struct lp_scene *scene,
+                         const struct lp_scene *prev);
+
 bool lp_scene_add_frag_shader_reference(struct lp_scene *scene,
                                         struct lp_fragment_shader_variant *variant);
 
@@ -344,6 +376,8 @@ lp_scene_bin_command(struct lp_scene *scene,
       tail->count++;
    }
 
+   bin->cost++;
+
    return true;
 }
 
@@ -398,10 +432,11 @@ lp_scene_get_num_bins(const struct lp_scene *scene)
 
 
 void
-lp_scene_bin_iter_begin(struct lp_scene *scene);
+lp_scene_bin_iter_begin(struct lp_scene *scene, unsigned num_threads);
 
 struct cmd_bin *
-lp_scene_bin_iter_next(struct lp_scene *scene, int *x, int *y);
+lp_scene_bin_iter_next(struct lp_scene *scene, unsigned thread_index,
+                       int *x, int *y);
 
 
 
@@ -409,7 +444,8 @@ lp_scene_bin_iter_next(struct lp_scene *scene, int *x, int *y);
  */
 void
 lp_scene_begin_binning(struct lp_scene *scene,
-                       struct pipe_framebuffer_state *fb);
+                       struct pipe_framebuffer_state *fb,
+                       unsigned tile_order);
 
 void
 lp_scene_end_binning(struct lp_scene *scene);
@@ -424,4 +460,17 @@ void
 lp_scene_end_rasterization(struct lp_scene *scene);
 
 
+/* Partial scenes for parallel binning
+ */
+bool
+lp_scene_begin_partial(struct lp_scene *partial,
+                       const struct lp_scene *scene);
+
+bool
+lp_scene_merge_partial(struct lp_scene *scene, struct lp_scene *partial);
+
+void
+lp_scene_end_partial(struct lp_scene *partial);
+
+
 #endif /* LP_SCENE_H */
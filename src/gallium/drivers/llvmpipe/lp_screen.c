@@ -102,6 +102,7 @@ static const struct debug_named_value lp_perf_flags[] = {
    { "no_alphatest",   PERF_NO_ALPHATEST, NULL },
    { "no_rast_linear", PERF_NO_RAST_LINEAR, NULL },
    { "no_shade",       PERF_NO_SHADE, NULL },
+   { "no_hiz",         PERF_NO_HIZ, NULL },
    DEBUG_NAMED_VALUE_END
 };
 
@@ -222,6 +223,9 @@ llvmpipe_init_screen_caps(struct pipe_screen *screen)
    caps->max_dual_source_render_targets = 1;
    caps->max_stream_output_buffers = PIPE_MAX_SO_BUFFERS;
    caps->max_render_targets = PIPE_MAX_COLOR_BUFS;
+   caps->context_priority_mask = PIPE_CONTEXT_PRIORITY_LOW |
+                                 PIPE_CONTEXT_PRIORITY_MEDIUM |
+                                 PIPE_CONTEXT_PRIORITY_HIGH;
    caps->occlusion_query = true;
    caps->query_timestamp = true;
    caps->timer_resolution = true;
@@ -784,7 +788,6 @@ llvmpipe_destroy_screen(struct pipe_screen *_screen)
    close(screen->fd_mem_alloc);
    mtx_destroy(&screen->mem_mutex);
 #endif
-   mtx_destroy(&screen->rast_mutex);
    mtx_destroy(&screen->cs_mutex);
    FREE(screen);
 }
@@ -888,6 +891,7 @@ llvmpipe_screen_get_fd(struct pipe_screen *_screen)
 
 void
 lp_disk_cache_find_shader(struct llvmpipe_screen *screen,
+                          enum lp_jit_kind kind,
                           struct lp_cached_code *cache,
                           unsigned char ir_sha1_cache_key[20])
 {
@@ -902,9 +906,11 @@ lp_disk_cache_find_shader(struct llvmpipe_screen *screen,
    uint8_t *buffer = disk_cache_get(screen->disk_shader_cache,
                                     sha1, &binary_size);
    if (!buffer) {
+      p_atomic_inc(&lp_jit_count[kind].cache_misses);
       cache->data_size = 0;
       return;
    }
+   p_atomic_inc(&lp_jit_count[kind].cache_hits);
    cache->data_size = binary_size;
    cache->data = buffer;
 }
@@ -935,13 +941,14 @@ llvmpipe_screen_late_init(struct llvmpipe_screen *screen)
    if (screen->late_init_done)
       goto out;
 
-   screen->rast = lp_rast_create(screen->num_threads);
+   screen->rast = lp_rast_create(screen->num_threads, screen->pin_threads);
    if (!screen->rast) {
       ret = false;
       goto out;
    }
 
-   screen->cs_tpool = lp_cs_tpool_create(screen->num_threads);
+   screen->cs_tpool = lp_cs_tpool_create(screen->num_threads,
+                                         screen->pin_threads);
    if (!screen->cs_tpool) {
       lp_rast_destroy(screen->rast);
       ret = false;
@@ -1014,6 +1021,20 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    screen->num_threads = debug_get_num_option("LP_NUM_THREADS",
                                               screen->num_threads);
    screen->num_threads = MIN2(screen->num_threads, LP_MAX_THREADS);
+   screen->pin_threads = debug_get_bool_option("LP_PIN_THREADS", false);
+   screen->num_bin_threads = debug_get_num_option("LP_BIN_THREADS", 0);
+   screen->num_bin_threads = MIN2(screen->num_bin_threads,
+                                  LP_MAX_BIN_THREADS);
+   screen->num_fs_compile_threads =
+      debug_get_num_option("LP_FS_COMPILE_THREADS", 0);
+   screen->num_fs_compile_threads = MIN2(screen->num_fs_compile_threads,
+                                         LP_MAX_FS_COMPILE_THREADS);
+   screen->tile_size = debug_get_num_option("LP_TILE_SIZE", 0);
+   if (screen->tile_size) {
+      screen->tile_size = CLAMP(util_next_power_of_two(screen->tile_size),
+                                1 << LP_MIN_TILE_ORDER,
+                                1 << LP_MAX_TILE_ORDER);
+   }
 
    for (unsigned i = 0; i < MESA_SHADER_MESH_STAGES; i++)
       screen->base.nir_options[i] = &gallivm_nir_options;
@@ -1047,7 +1068,6 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    list_inithead(&screen->ctx_list);
    (void) mtx_init(&screen->ctx_mutex, mtx_plain);
    (void) mtx_init(&screen->cs_mutex, mtx_plain);
-   (void) mtx_init(&screen->rast_mutex, mtx_plain);
 
    (void) mtx_init(&screen->late_mutex, mtx_plain);
 
@@ -41,6 +41,7 @@
 #include "util/vma.h"
 #include "gallivm/lp_bld.h"
 #include "gallivm/lp_bld_misc.h"
+#include "lp_perf.h"
 
 struct sw_winsys;
 struct lp_cs_tpool;
@@ -52,13 +53,16 @@ struct llvmpipe_screen
    struct sw_winsys *winsys;
 
    unsigned num_threads;
+   unsigned num_bin_threads;
+   unsigned tile_size;
+   unsigned num_fs_compile_threads;
+   bool pin_threads;
 
    /* Increments whenever textures are modified.  Contexts can track this.
     */
    unsigned timestamp;
 
    struct lp_rasterizer *rast;
-   mtx_t rast_mutex;
 
    struct lp_cs_tpool *cs_tpool;
    mtx_t cs_mutex;
@@ -91,6 +95,7 @@ struct llvmpipe_screen
 
 void
 lp_disk_cache_find_shader(struct llvmpipe_screen *screen,
+                          enum lp_jit_kind kind,
                           struct lp_cached_code *cache,
                           unsigned char ir_sha1_cache_key[20]);
 
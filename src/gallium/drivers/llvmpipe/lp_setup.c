@@ -35,6 +35,7 @@
 #include <limits.h>
 
 #include "pipe/p_defines.h"
+#include "util/format/u_format.h"
 #include "util/u_framebuffer.h"
 #include "util/u_inlines.h"
 #include "util/u_memory.h"
@@ -77,6 +78,72 @@ lp_setup_wait_empty_scene(struct lp_setup_context *setup)
 }
 
 
+/**
+ * Below this many default-size tiles per rasterizer thread, switch to
+ * 32x32 tiles.  The bin scheduler steals work, so a couple of tiles per
+ * thread already keep every thread busy.  Smaller tiles quadruple the
+ * bins each large triangle is binned into, so they only pay off when some
+ * threads would otherwise get no tile at all; a 1920x1080 target (510
+ * tiles) keeps 64x64 tiles up to 255 threads.
+ */
+#define LP_MIN_TILES_PER_THREAD 2
+
+/** Tiles per thread that must remain after switching to 128x128 tiles */
+#define LP_TILES_PER_THREAD 8
+
+/** Largest color + depth footprint of a 128x128 tile, in bytes */
+#define LP_TILE_MAX_FOOTPRINT (256 * 1024)
+
+
+/**
+ * Pick the tile size for the next scene.
+ *
+ * Render targets too small to give every rasterizer thread a couple of
+ * tiles get 32x32 tiles.  Large targets with light geometry (judged by the
+ * previous scene) get 128x128 tiles, which quarters the number of bins to
+ * set up, walk and bin large triangles into, as long as such a tile's
+ * color and depth data still fit comfortably in the cache.
+ */
+static unsigned
+lp_setup_choose_tile_order(const struct lp_setup_context *setup)
+{
+   const struct pipe_framebuffer_state *fb = &setup->fb;
+
+   /* The linear rasterizer works on 64 pixel wide rows. */
+   if (setup->permit_linear_rasterizer)
+      return TILE_ORDER;
+
+   /* Scenes may not have more bins than with the default tile size. */
+   if (setup->tile_size &&
+       DIV_ROUND_UP(fb->width, setup->tile_size) *
+       DIV_ROUND_UP(fb->height, setup->tile_size) <= TILES_X * TILES_Y)
+      return util_logbase2(setup->tile_size);
+
+   const unsigned num_threads = MAX2(setup->num_threads, 1);
+   const unsigned num_tiles = DIV_ROUND_UP(fb->width, TILE_SIZE) *
+                              DIV_ROUND_UP(fb->height, TILE_SIZE);
+
+   if (num_tiles < LP_MIN_TILES_PER_THREAD * num_threads)
+      return LP_MIN_TILE_ORDER;
+
+   unsigned bytes_per_pixel = 0;
+   for (unsigned i = 0; i < fb->nr_cbufs; i++) {
+      if (fb->cbufs[i].texture)
+         bytes_per_pixel += util_format_get_blocksize(fb->cbufs[i].format);
+   }
+   if (fb->zsbuf.texture)
+      bytes_per_pixel += util_format_get_blocksize(fb->zsbuf.format);
+   bytes_per_pixel *= MAX2(util_framebuffer_get_num_samples(fb), 1);
+
+   if (num_tiles >= 4 * LP_TILES_PER_THREAD * num_threads &&
+       setup->last_scene_prims <= num_tiles &&
+       (bytes_per_pixel << (2 * LP_MAX_TILE_ORDER)) <= LP_TILE_MAX_FOOTPRINT)
+      return LP_MAX_TILE_ORDER;
+
+   return TILE_ORDER;
+}
+
+
 static void
 lp_setup_get_empty_scene(struct lp_setup_context *setup)
 {
@@ -142,7 +209,8 @@ lp_setup_get_empty_scene(struct lp_setup_context *setup)
       }
    }
 
-   lp_scene_begin_binning(setup->scene, &setup->fb);
+   lp_scene_begin_binning(setup->scene, &setup->fb,
+                          lp_setup_choose_tile_order(setup));
 }
 
 
@@ -210,6 +278,7 @@ lp_setup_reset(struct lp_setup_context *setup)
 
    /* no current bin */
    setup->scene = NULL;
+   setup->scene_seqno++;
 
    /* Reset some state:
     */
@@ -230,7 +299,6 @@ static void
 lp_setup_rasterize_scene(struct lp_setup_context *setup)
 {
    struct lp_scene *scene = setup->scene;
-   struct llvmpipe_screen *screen = llvmpipe_screen(scene->pipe->screen);
 
    scene->num_active_queries = setup->active_binned_queries;
    memcpy(scene->active_queries, setup->active_queries,
@@ -238,9 +306,9 @@ lp_setup_rasterize_scene(struct lp_setup_context *setup)
 
    lp_scene_end_binning(scene);
 
-   mtx_lock(&screen->rast_mutex);
-   lp_rast_queue_scene(screen->rast, scene);
-   mtx_unlock(&screen->rast_mutex);
+   setup->last_scene_prims = scene->num_prims;
+
+   lp_rast_queue_scene(setup->rast_tenant, scene);
 
    lp_setup_reset(setup);
 
@@ -258,7 +326,7 @@ begin_binning(struct lp_setup_context *setup)
 
    /* Always create a fence:
     */
-   scene->fence = lp_fence_create(MAX2(1, setup->num_threads));
+   scene->fence = lp_fence_create(1);
    if (!scene->fence)
       return false;
 
@@ -416,6 +484,17 @@ lp_setup_flush(struct lp_setup_context *setup,
 }
 
 
+/**
+ * Return the fence of the last scene this context queued.
+ */
+void
+lp_setup_fence(struct lp_setup_context *setup,
+               struct lp_fence **fence)
+{
+   lp_rast_fence(setup->rast_tenant, fence);
+}
+
+
 void
 lp_setup_bind_framebuffer(struct lp_setup_context *setup,
                           const struct pipe_framebuffer_state *fb)
@@ -787,6 +866,28 @@ lp_setup_set_stencil_ref_values(struct lp_setup_context *setup,
 }
 
 
+void
+lp_setup_set_stencil_masks(struct lp_setup_context *setup,
+                           const struct pipe_stencil_state stencil[2])
+{
+   struct lp_jit_context *jit_context = &setup->fs.current.jit_context;
+
+   LP_DBG(DEBUG_SETUP, "%s 0x%x 0x%x\n", __func__,
+          stencil[0].valuemask, stencil[0].writemask);
+
+   if (jit_context->stencil_valuemask_front != stencil[0].valuemask ||
+       jit_context->stencil_valuemask_back != stencil[1].valuemask ||
+       jit_context->stencil_writemask_front != stencil[0].writemask ||
+       jit_context->stencil_writemask_back != stencil[1].writemask) {
+      jit_context->stencil_valuemask_front = stencil[0].valuemask;
+      jit_context->stencil_valuemask_back = stencil[1].valuemask;
+      jit_context->stencil_writemask_front = stencil[0].writemask;
+      jit_context->stencil_writemask_back = stencil[1].writemask;
+      setup->dirty |= LP_SETUP_NEW_FS;
+   }
+}
+
+
 void
 lp_setup_set_blend_color(struct lp_setup_context *setup,
                          const struct pipe_blend_color *blend_color)
@@ -1337,6 +1438,7 @@ lp_setup_update_state(struct lp_setup_context *setup,
 void
 lp_setup_destroy(struct lp_setup_context *setup)
 {
+   lp_setup_mt_destroy(setup);
    lp_setup_reset(setup);
 
    util_unreference_framebuffer_state(&setup->fb);
@@ -1373,6 +1475,8 @@ lp_setup_destroy(struct lp_setup_context *setup)
    LP_DBG(DEBUG_SETUP, "number of scenes used: %d\n", setup->num_active_scenes);
    slab_destroy(&setup->scene_slab);
 
+   lp_rast_tenant_destroy(setup->rast_tenant);
+
    FREE(setup);
 }
 
@@ -1384,7 +1488,8 @@ lp_setup_destroy(struct lp_setup_context *setup)
  */
 struct lp_setup_context *
 lp_setup_create(struct pipe_context *pipe,
-                struct draw_context *draw)
+                struct draw_context *draw,
+                unsigned priority)
 {
    struct llvmpipe_screen *screen = llvmpipe_screen(pipe->screen);
    struct lp_setup_context *setup = CALLOC_STRUCT(lp_setup_context);
@@ -1392,6 +1497,8 @@ lp_setup_create(struct pipe_context *pipe,
       goto no_setup;
    }
 
+   setup->num_bin_threads = screen->num_bin_threads;
+   setup->tile_size = screen->tile_size;
    lp_setup_init_vbuf(setup);
 
    setup->psize_slot = -1;
@@ -1404,6 +1511,12 @@ lp_setup_create(struct pipe_context *pipe,
    setup->pipe = pipe;
 
    setup->num_threads = screen->num_threads;
+
+   setup->rast_tenant = lp_rast_tenant_create(screen->rast, priority);
+   if (!setup->rast_tenant) {
+      goto no_tenant;
+   }
+
    setup->vbuf = draw_vbuf_stage(draw, &setup->base);
    if (!setup->vbuf) {
       goto no_vbuf;
@@ -1443,6 +1556,8 @@ no_scenes:
 
    setup->vbuf->destroy(setup->vbuf);
 no_vbuf:
+   lp_rast_tenant_destroy(setup->rast_tenant);
+no_tenant:
    FREE(setup);
 no_setup:
    return NULL;
@@ -1540,10 +1655,7 @@ lp_setup_end_query(struct lp_setup_context *setup, struct llvmpipe_query *pq)
          setup->scene->had_queries |= true;
       }
    } else {
-      struct llvmpipe_screen *screen = llvmpipe_screen(setup->pipe->screen);
-      mtx_lock(&screen->rast_mutex);
-      lp_rast_fence(screen->rast, &pq->fence);
-      mtx_unlock(&screen->rast_mutex);
+      lp_rast_fence(setup->rast_tenant, &pq->fence);
    }
 
 fail:
@@ -1577,6 +1689,14 @@ lp_setup_flush_and_restart(struct lp_setup_context *setup)
 {
    if (0) debug_printf("%s\n", __func__);
 
+   /* A binner thread can't flush, lp_setup_mt_triangles() will rebin
+    * this chunk on the main thread instead.
+    */
+   if (setup->scene->partial) {
+      setup->scene->alloc_failed = true;
+      return false;
+   }
+
    assert(setup->state == SETUP_ACTIVE);
 
    if (!set_scene_state(setup, SETUP_FLUSHED, __func__))
@@ -44,10 +44,12 @@ struct llvmpipe_query;
 struct pipe_fence_handle;
 struct lp_setup_variant;
 struct lp_setup_context;
+struct lp_fence;
 
 struct lp_setup_context *
 lp_setup_create(struct pipe_context *pipe,
-                struct draw_context *draw);
+                struct draw_context *draw,
+                unsigned priority);
 
 void
 lp_setup_clear(struct lp_setup_context *setup,
@@ -60,6 +62,10 @@ void
 lp_setup_flush(struct lp_setup_context *setup,
                const char *reason);
 
+void
+lp_setup_fence(struct lp_setup_context *setup,
+               struct lp_fence **fence);
+
 void
 lp_setup_bind_framebuffer(struct lp_setup_context *setup,
                           const struct pipe_framebuffer_state *fb);
@@ -105,6 +111,10 @@ void
 lp_setup_set_stencil_ref_values(struct lp_setup_context *setup,
                                 const uint8_t refs[2]);
 
+void
+lp_setup_set_stencil_masks(struct lp_setup_context *setup,
+                           const struct pipe_stencil_state stencil[2]);
+
 void
 lp_setup_set_blend_color(struct lp_setup_context *setup,
                          const struct pipe_blend_color *blend_color);
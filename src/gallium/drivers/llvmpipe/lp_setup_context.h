@@ -53,6 +53,7 @@
 #define LP_SETUP_NEW_SSBOS       0x20
 
 struct lp_setup_variant;
+struct lp_setup_mt;
 
 
 /** Max number of scenes */
@@ -91,10 +92,25 @@ struct lp_setup_context
    unsigned num_threads;
    unsigned scene_idx;
 
+   /** Our queue on the screen's shared rasterizer */
+   struct lp_rast_tenant *rast_tenant;
+
    struct slab_mempool scene_slab;
    int num_active_scenes;
    struct lp_scene *scenes[MAX_SCENES];  /**< all the scenes */
    struct lp_scene *scene;               /**< current scene being built */
+   unsigned scene_seqno;                 /**< bumped whenever scene is dropped */
+
+   /** Forced tile size (LP_TILE_SIZE), or 0 to pick one per scene */
+   unsigned tile_size;
+   /** Primitives binned into the last scene, see lp_setup_choose_tile_order() */
+   unsigned last_scene_prims;
+
+   /** Parallel binning (LP_BIN_THREADS), see lp_setup_mt.c */
+   unsigned num_bin_threads;
+   struct lp_setup_mt *mt;
+   /** Chunks binned by a worker and merged, checked by lp_test_setup_mt */
+   unsigned mt_merged_chunks;
 
    struct llvmpipe_query *active_queries[LP_MAX_ACTIVE_BINNED_QUERIES];
    unsigned active_binned_queries;
@@ -241,6 +257,16 @@ lp_setup_update_state(struct lp_setup_context *setup,
 void
 lp_setup_destroy(struct lp_setup_context *setup);
 
+bool
+lp_setup_mt_triangles(struct lp_setup_context *setup,
+                      const void *vertex_buffer,
+                      unsigned stride,
+                      const uint16_t *indices,
+                      unsigned nr);
+
+void
+lp_setup_mt_destroy(struct lp_setup_context *setup);
+
 bool
 lp_setup_flush_and_restart(struct lp_setup_context *setup);
 
@@ -0,0 +1,240 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * Parallel binning of large triangle lists.
+ *
+ * A draw is cut into contiguous chunks of triangles.  The first chunk is
+ * binned by the calling thread straight into the current scene while the
+ * other chunks are binned by LP_BIN_THREADS worker threads, each into a
+ * private "partial" scene using its own copy of the setup context.  The
+ * partial scenes are then appended to the current scene in chunk order,
+ * bin by bin, so every tile still sees the primitives in API order.
+ *
+ * Workers never flush.  If a worker runs out of space, or the calling
+ * thread had to flush the scene while the workers were running, the
+ * affected chunks are simply binned again on the calling thread.
+ */
+
+#include "util/u_math.h"
+#include "util/u_memory.h"
+#include "util/u_queue.h"
+#include "lp_context.h"
+#include "lp_limits.h"
+#include "lp_scene.h"
+#include "lp_setup_context.h"
+
+
+/** Don't bother splitting off chunks smaller than this many triangles */
+#define LP_SETUP_MT_MIN_TRIS 64
+
+
+typedef const float (*const_float4_ptr)[4];
+
+
+struct lp_setup_mt_job {
+   struct util_queue_fence fence;
+
+   /** Private copy of the setup context, binning into partial */
+   struct lp_setup_context setup;
+   struct lp_scene *partial;
+
+   const void *vertex_buffer;
+   const uint16_t *indices;
+   unsigned stride;
+   unsigned start, end;
+
+   bool queued;
+};
+
+
+struct lp_setup_mt {
+   struct util_queue queue;
+   unsigned num_jobs;
+   struct lp_setup_mt_job jobs[LP_MAX_BIN_THREADS];
+};
+
+
+static inline const_float4_ptr
+get_vert(const void *vertex_buffer, int index, int stride)
+{
+   return (const_float4_ptr)((char *)vertex_buffer + index * stride);
+}
+
+
+static void
+bin_triangles(struct lp_setup_context *setup,
+              const void *vertex_buffer,
+              unsigned stride,
+              const uint16_t *indices,
+              unsigned start, unsigned end)
+{
+   if (indices) {
+      for (unsigned i = start + 2; i < end; i += 3) {
+         setup->triangle(setup,
+                         get_vert(vertex_buffer, indices[i-2], stride),
+                         get_vert(vertex_buffer, indices[i-1], stride),
+                         get_vert(vertex_buffer, indices[i-0], stride));
+      }
+   } else {
+      for (unsigned i = start + 2; i < end; i += 3) {
+         setup->triangle(setup,
+                         get_vert(vertex_buffer, i-2, stride),
+                         get_vert(vertex_buffer, i-1, stride),
+                         get_vert(vertex_buffer, i-0, stride));
+      }
+   }
+}
+
+
+static void
+bin_job(void *data, void *gdata, int thread_index)
+{
+   struct lp_setup_mt_job *job = data;
+
+   bin_triangles(&job->setup, job->vertex_buffer, job->stride,
+                 job->indices, job->start, job->end);
+}
+
+
+static struct lp_setup_mt *
+lp_setup_mt_create(struct lp_setup_context *setup)
+{
+   struct lp_setup_mt *mt = CALLOC_STRUCT(lp_setup_mt);
+   if (!mt)
+      return NULL;
+
+   if (!util_queue_init(&mt->queue, "lpbin", setup->num_bin_threads,
+                        setup->num_bin_threads, 0, NULL)) {
+      FREE(mt);
+      return NULL;
+   }
+
+   for (unsigned i = 0; i < setup->num_bin_threads; i++) {
+      struct lp_setup_mt_job *job = &mt->jobs[i];
+
+      job->partial = lp_scene_create(setup);
+      if (!job->partial)
+         break;
+
+      util_queue_fence_init(&job->fence);
+      mt->num_jobs++;
+   }
+
+   return mt;
+}
+
+
+void
+lp_setup_mt_destroy(struct lp_setup_context *setup)
+{
+   struct lp_setup_mt *mt = setup->mt;
+
+   if (!mt)
+      return;
+
+   util_queue_destroy(&mt->queue);
+
+   for (unsigned i = 0; i < mt->num_jobs; i++) {
+      util_queue_fence_destroy(&mt->jobs[i].fence);
+      lp_scene_destroy(mt->jobs[i].partial);
+   }
+
+   FREE(mt);
+   setup->mt = NULL;
+}
+
+
+/**
+ * Bin a MESA_PRIM_TRIANGLES draw with the help of the binner threads.
+ * Returns false if the draw isn't worth or safe to split, in which case
+ * the caller bins it as usual.
+ */
+bool
+lp_setup_mt_triangles(struct lp_setup_context *setup,
+                      const void *vertex_buffer,
+                      unsigned stride,
+                      const uint16_t *indices,
+                      unsigned nr)
+{
+   const struct llvmpipe_context *lp = llvmpipe_context(setup->pipe);
+   const unsigned num_tris = nr / 3;
+
+   if (setup->num_bin_threads == 0 ||
+       num_tris < 2 * LP_SETUP_MT_MIN_TRIS)
+      return false;
+
+   /* The rect/blit paths and the pipeline statistics counters aren't
+    * prepared to run on several threads.
+    */
+   if (setup->permit_linear_rasterizer ||
+       lp->active_statistics_queries)
+      return false;
+
+   if (!setup->scene || setup->state != SETUP_ACTIVE)
+      return false;
+
+   if (!setup->mt) {
+      setup->mt = lp_setup_mt_create(setup);
+      if (!setup->mt)
+         return false;
+   }
+
+   struct lp_setup_mt *mt = setup->mt;
+   const unsigned num_chunks =
+      MIN2(mt->num_jobs + 1, num_tris / LP_SETUP_MT_MIN_TRIS);
+   const unsigned chunk = DIV_ROUND_UP(num_tris, num_chunks) * 3;
+   const unsigned seqno = setup->scene_seqno;
+
+   if (num_chunks < 2)
+      return false;
+
+   for (unsigned i = 1; i < num_chunks; i++) {
+      struct lp_setup_mt_job *job = &mt->jobs[i - 1];
+
+      job->start = MIN2(i * chunk, num_tris * 3);
+      job->end = MIN2(job->start + chunk, num_tris * 3);
+      job->queued = job->start < job->end &&
+                    lp_scene_begin_partial(job->partial, setup->scene);
+      if (!job->queued)
+         continue;
+
+      memcpy(&job->setup, setup, sizeof *setup);
+      job->setup.scene = job->partial;
+      job->vertex_buffer = vertex_buffer;
+      job->indices = indices;
+      job->stride = stride;
+
+      util_queue_add_job(&mt->queue, job, &job->fence, bin_job, NULL, 0);
+   }
+
+   bin_triangles(setup, vertex_buffer, stride, indices,
+                 0, MIN2(chunk, num_tris * 3));
+
+   for (unsigned i = 1; i < num_chunks; i++) {
+      struct lp_setup_mt_job *job = &mt->jobs[i - 1];
+
+      if (job->queued) {
+         util_queue_fence_wait(&job->fence);
+
+         /* The partial scene refers to state stored in the scene it was
+          * started from, so it can only go into that same scene.
+          */
+         if (setup->scene_seqno == seqno &&
+             !job->partial->alloc_failed &&
+             lp_scene_merge_partial(setup->scene, job->partial)) {
+            setup->mt_merged_chunks++;
+            continue;
+         }
+
+         lp_scene_end_partial(job->partial);
+      }
+
+      bin_triangles(setup, vertex_buffer, stride, indices,
+                    job->start, job->end);
+   }
+
+   return true;
+}
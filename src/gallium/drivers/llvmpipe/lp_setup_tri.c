@@ -786,8 +786,12 @@ lp_setup_bin_triangle(struct lp_setup_context *setup,
                       unsigned viewport_index)
 {
    struct lp_scene *scene = setup->scene;
+   const unsigned tile_order = scene->tile_order;
+   const int tile_size = scene->tile_size;
    unsigned cmd;
 
+   scene->num_prims++;
+
    /* What is the largest power-of-two boundary this triangle crosses:
     */
    const int dx = floor_pot((bbox->x0 ^ bbox->x1) |
@@ -818,21 +822,21 @@ lp_setup_bin_triangle(struct lp_setup_context *setup,
 
    /* Determine which tile(s) intersect the triangle's bounding box
     */
-   if (dx < TILE_SIZE) {
-      const int ix0 = bbox->x0 / TILE_SIZE;
-      const int iy0 = bbox->y0 / TILE_SIZE;
-      unsigned px = bbox->x0 & 63 & ~3;
-      unsigned py = bbox->y0 & 63 & ~3;
+   if (dx < tile_size) {
+      const int ix0 = bbox->x0 >> tile_order;
+      const int iy0 = bbox->y0 >> tile_order;
+      unsigned px = bbox->x0 & (tile_size - 1) & ~3;
+      unsigned py = bbox->y0 & (tile_size - 1) & ~3;
 
-      assert(iy0 == bbox->y1 / TILE_SIZE &&
-             ix0 == bbox->x1 / TILE_SIZE);
+      assert(iy0 == bbox->y1 >> tile_order &&
+             ix0 == bbox->x1 >> tile_order);
 
       if (nr_planes == 3) {
          if (sz < 4) {
             /* Triangle is contained in a single 4x4 stamp:
              */
-            assert(px + 4 <= TILE_SIZE);
-            assert(py + 4 <= TILE_SIZE);
+            assert(px + 4 <= tile_size);
+            assert(py + 4 <= tile_size);
             if (setup->multisample)
                cmd = LP_RAST_OP_MS_TRIANGLE_3_4;
             else
@@ -851,11 +855,11 @@ lp_setup_bin_triangle(struct lp_setup_context *setup,
              * dimensions if the triangle is 16 pixels in one dimension but 4
              * in the other. So budge the 16x16 back inside the tile.
              */
-            px = MIN2(px, TILE_SIZE - 16);
-            py = MIN2(py, TILE_SIZE - 16);
+            px = MIN2(px, tile_size - 16);
+            py = MIN2(py, tile_size - 16);
 
-            assert(px + 16 <= TILE_SIZE);
-            assert(py + 16 <= TILE_SIZE);
+            assert(px + 16 <= tile_size);
+            assert(py + 16 <= tile_size);
 
             if (setup->multisample)
                cmd = LP_RAST_OP_MS_TRIANGLE_3_16;
@@ -866,11 +870,11 @@ lp_setup_bin_triangle(struct lp_setup_context *setup,
                                                lp_rast_arg_triangle_contained(tri, px, py));
          }
       } else if (nr_planes == 4 && sz < 16) {
-         px = MIN2(px, TILE_SIZE - 16);
-         py = MIN2(py, TILE_SIZE - 16);
+         px = MIN2(px, tile_size - 16);
+         py = MIN2(py, tile_size - 16);
 
-         assert(px + 16 <= TILE_SIZE);
-         assert(py + 16 <= TILE_SIZE);
+         assert(px + 16 <= tile_size);
+         assert(py + 16 <= tile_size);
 
          if (setup->multisample)
             cmd = LP_RAST_OP_MS_TRIANGLE_4_16;
@@ -900,23 +904,23 @@ lp_setup_bin_triangle(struct lp_setup_context *setup,
       int64_t xstep[MAX_PLANES];
       int64_t ystep[MAX_PLANES];
 
-      const int ix0 = trimmed_box.x0 / TILE_SIZE;
-      const int iy0 = trimmed_box.y0 / TILE_SIZE;
-      const int ix1 = trimmed_box.x1 / TILE_SIZE;
-      const int iy1 = trimmed_box.y1 / TILE_SIZE;
+      const int ix0 = trimmed_box.x0 >> tile_order;
+      const int iy0 = trimmed_box.y0 >> tile_order;
+      const int ix1 = trimmed_box.x1 >> tile_order;
+      const int iy1 = trimmed_box.y1 >> tile_order;
 
       for (int i = 0; i < nr_planes; i++) {
          c[i] = (plane[i].c +
-                 IMUL64(plane[i].dcdy, iy0) * TILE_SIZE -
-                 IMUL64(plane[i].dcdx, ix0) * TILE_SIZE);
+                 IMUL64(plane[i].dcdy, iy0) * tile_size -
+                 IMUL64(plane[i].dcdx, ix0) * tile_size);
 
          ei[i] = (plane[i].dcdy -
                   plane[i].dcdx -
-                  (int64_t)plane[i].eo) << TILE_ORDER;
+                  (int64_t)plane[i].eo) << tile_order;
 
-         eo[i] = (int64_t)plane[i].eo << TILE_ORDER;
-         xstep[i] = -(((int64_t)plane[i].dcdx) << TILE_ORDER);
-         ystep[i] = ((int64_t)plane[i].dcdy) << TILE_ORDER;
+         eo[i] = (int64_t)plane[i].eo << tile_order;
+         xstep[i] = -(((int64_t)plane[i].dcdx) << tile_order);
+         ystep[i] = ((int64_t)plane[i].dcdy) << tile_order;
       }
 
       tri->inputs.is_blit = lp_setup_is_blit(setup, &tri->inputs);
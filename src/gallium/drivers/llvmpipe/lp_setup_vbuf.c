@@ -53,6 +53,11 @@
 
 #define LP_MAX_VBUF_SIZE    4096
 
+/* With binner threads, let the draw module hand us whole segments so there
+ * is enough work per call to split.
+ */
+#define LP_MAX_VBUF_SIZE_MT (256 * 1024)
+
 
 
 /** cast wrapper */
@@ -223,7 +228,9 @@ lp_setup_draw_elements(struct vbuf_render *vbr, const uint16_t *indices, uint nr
       break;
 
    case MESA_PRIM_TRIANGLES:
-      if (nr % 6 == 0 && !uses_constant_interp) {
+      if (lp_setup_mt_triangles(setup, vertex_buffer, stride, indices, nr)) {
+         /* binned in parallel */
+      } else if (nr % 6 == 0 && !uses_constant_interp) {
          for (i = 5; i < nr; i += 6) {
             rect(setup,
                  get_vert(vertex_buffer, indices[i-5], stride),
@@ -431,7 +438,9 @@ lp_setup_draw_arrays(struct vbuf_render *vbr, uint start, uint nr)
       break;
 
    case MESA_PRIM_TRIANGLES:
-      if (nr % 6 == 0 && !uses_constant_interp) {
+      if (lp_setup_mt_triangles(setup, vertex_buffer, stride, NULL, nr)) {
+         /* binned in parallel */
+      } else if (nr % 6 == 0 && !uses_constant_interp) {
          for (i = 5; i < nr; i += 6) {
             rect(setup,
                  get_vert(vertex_buffer, i-5, stride),
@@ -706,7 +715,8 @@ void
 lp_setup_init_vbuf(struct lp_setup_context *setup)
 {
    setup->base.max_indices = LP_MAX_VBUF_INDEXES;
-   setup->base.max_vertex_buffer_bytes = LP_MAX_VBUF_SIZE;
+   setup->base.max_vertex_buffer_bytes = setup->num_bin_threads ?
+      LP_MAX_VBUF_SIZE_MT : LP_MAX_VBUF_SIZE;
 
    setup->base.get_vertex_info = lp_setup_get_vertex_info;
    setup->base.allocate_vertices = lp_setup_allocate_vertices;
@@ -82,6 +82,21 @@
 #define LP_CSNEW_SSBOS 0x10
 #define LP_CSNEW_IMAGES 0x20
 
+/**
+ * State that fragment shader variants can read at runtime from the JIT
+ * context instead of baking it into their key, so that changing it doesn't
+ * build a new variant.  Opted into with pipe_context::set_dynamic_state(),
+ * which lavapipe does per pipeline; variants built without it keep the
+ * state as constants.
+ *
+ * The alpha and stencil reference values, blend color, depth bounds and
+ * sample mask are always runtime state, and polygon mode and culling are
+ * resolved before the fragment shader runs; none of them are variant key
+ * bits.  The depth and stencil functions, stencil ops, blend equations and
+ * color write masks have no dynamic flag yet and are still key bits.
+ */
+#define LP_DYNAMIC_STENCIL_MASKS PIPE_DYNAMIC_STENCIL_MASKS
+
 struct vertex_info;
 struct pipe_context;
 struct llvmpipe_context;
@@ -126,6 +141,15 @@ llvmpipe_set_framebuffer_state(struct pipe_context *,
 void
 llvmpipe_update_fs(struct llvmpipe_context *lp);
 
+void
+llvmpipe_poll_fs_compile(struct llvmpipe_context *lp);
+
+void
+llvmpipe_init_fs_compile_queue(struct llvmpipe_context *lp);
+
+void
+llvmpipe_destroy_fs_compile_queue(struct llvmpipe_context *lp);
+
 void
 llvmpipe_update_setup(struct llvmpipe_context *lp);
 
@@ -224,6 +224,29 @@ llvmpipe_set_sample_locations(struct pipe_context *pipe,
 }
 
 
+/**
+ * Select which PIPE_DYNAMIC_x state the fragment shader variants read at
+ * runtime.  Frontends set this per pipeline, for the state the application
+ * changes between draws.
+ */
+static void
+llvmpipe_set_dynamic_state(struct pipe_context *pipe, unsigned flags)
+{
+   struct llvmpipe_context *llvmpipe = llvmpipe_context(pipe);
+
+   flags &= LP_DYNAMIC_STENCIL_MASKS;
+
+   if (flags == llvmpipe->dynamic_state)
+      return;
+
+   draw_flush(llvmpipe->draw);
+
+   llvmpipe->dynamic_state = flags;
+
+   llvmpipe->dirty |= LP_NEW_DEPTH_STENCIL_ALPHA;
+}
+
+
 void
 llvmpipe_init_blend_funcs(struct llvmpipe_context *llvmpipe)
 {
@@ -236,6 +259,7 @@ llvmpipe_init_blend_funcs(struct llvmpipe_context *llvmpipe)
    llvmpipe->pipe.delete_depth_stencil_alpha_state = llvmpipe_delete_depth_stencil_state;
 
    llvmpipe->pipe.set_blend_color = llvmpipe_set_blend_color;
+   llvmpipe->pipe.set_dynamic_state = llvmpipe_set_dynamic_state;
 
    llvmpipe->pipe.set_stencil_ref = llvmpipe_set_stencil_ref;
    llvmpipe->pipe.set_sample_mask = llvmpipe_set_sample_mask;
@@ -1302,9 +1302,10 @@ generate_variant(struct llvmpipe_context *lp,
 
    lp_cs_get_ir_cache_key(variant, ir_sha1_cache_key);
 
-   lp_disk_cache_find_shader(screen, &cached, ir_sha1_cache_key);
+   lp_disk_cache_find_shader(screen, LP_JIT_CS, &cached, ir_sha1_cache_key);
    if (!cached.data_size)
       needs_caching = true;
+   variant->cache_hit = !needs_caching;
 
    variant->gallivm = gallivm_create(module_name, &lp->context, &cached);
    if (!variant->gallivm) {
@@ -1446,6 +1447,7 @@ llvmpipe_update_cs_variant(struct llvmpipe_context *lp,
       t1 = os_time_get();
       dt = t1 - t0;
       LP_COUNT_ADD(llvm_compile_time, dt);
+      lp_jit_count_compile(LP_JIT_CS, dt, variant && variant->cache_hit);
       LP_COUNT_ADD(nr_llvm_compiles, 2);  /* emit vs. omit in/out test */
 
       /* Put the new variant into the list */
@@ -108,6 +108,7 @@
 #include "lp_screen.h"
 #include "compiler/nir/nir_serialize.h"
 #include "util/mesa-sha1.h"
+#include "util/hash_table.h"
 
 
 /** Fragment shader number (for debugging) */
@@ -785,6 +786,21 @@ generate_fs_loop(struct gallivm_state *gallivm,
    stencil_refs[0] = lp_build_broadcast(gallivm, int_vec_type, stencil_refs[0]);
    stencil_refs[1] = lp_build_broadcast(gallivm, int_vec_type, stencil_refs[1]);
 
+   LLVMValueRef stencil_valuemask_vals[2], stencil_writemask_vals[2];
+   LLVMValueRef *stencil_valuemasks = NULL, *stencil_writemasks = NULL;
+   if (key->dynamic_stencil_masks && key->stencil[0].enabled) {
+      stencil_valuemask_vals[0] = lp_jit_context_stencil_valuemask_front(gallivm, context_type, context_ptr);
+      stencil_valuemask_vals[1] = lp_jit_context_stencil_valuemask_back(gallivm, context_type, context_ptr);
+      stencil_writemask_vals[0] = lp_jit_context_stencil_writemask_front(gallivm, context_type, context_ptr);
+      stencil_writemask_vals[1] = lp_jit_context_stencil_writemask_back(gallivm, context_type, context_ptr);
+      for (unsigned i = 0; i < 2; i++) {
+         stencil_valuemask_vals[i] = lp_build_broadcast(gallivm, int_vec_type, stencil_valuemask_vals[i]);
+         stencil_writemask_vals[i] = lp_build_broadcast(gallivm, int_vec_type, stencil_writemask_vals[i]);
+      }
+      stencil_valuemasks = stencil_valuemask_vals;
+      stencil_writemasks = stencil_writemask_vals;
+   }
+
    LLVMValueRef consts_ptr = lp_jit_resources_constants(gallivm, resources_type, resources_ptr);
 
    LLVMValueRef ssbo_ptr = lp_jit_resources_ssbos(gallivm, resources_type, resources_ptr);
@@ -958,6 +974,8 @@ generate_fs_loop(struct gallivm_state *gallivm,
                                   key->multisample ? NULL : &mask,
                                   &s_mask,
                                   stencil_refs,
+                                  stencil_valuemasks,
+                                  stencil_writemasks,
                                   z, z_fb, s_fb,
                                   facing,
                                   min_depth_bounds, max_depth_bounds,
@@ -1385,6 +1403,8 @@ generate_fs_loop(struct gallivm_state *gallivm,
                                   key->multisample ? NULL : &mask,
                                   &s_mask,
                                   stencil_refs,
+                                  stencil_valuemasks,
+                                  stencil_writemasks,
                                   z, z_fb, s_fb,
                                   facing,
                                   min_depth_bounds, max_depth_bounds,
@@ -3694,6 +3714,8 @@ dump_fs_variant_key(struct lp_fragment_shader_variant_key *key)
          debug_printf("stencil[%u].writemask = 0x%x\n", i, key->stencil[i].writemask);
       }
    }
+   if (key->dynamic_stencil_masks)
+      debug_printf("dynamic_stencil_masks = 1\n");
 
    if (key->alpha.enabled) {
       debug_printf("alpha.func = %s\n", util_str_func(key->alpha.func, true));
@@ -3835,11 +3857,18 @@ lp_fs_get_ir_cache_key(struct lp_fragment_shader_variant *variant,
 /**
  * Generate a new fragment shader variant from the shader code and
  * other state indicated by the key.
+ *
+ * With no_opt the variant is compiled without LLVM optimizations, unless
+ * optimized code for it is found in the disk cache; variant->no_opt tells
+ * which one happened.
  */
 static struct lp_fragment_shader_variant *
 generate_variant(struct llvmpipe_context *lp,
                  struct lp_fragment_shader *shader,
-                 const struct lp_fragment_shader_variant_key *key)
+                 const struct lp_fragment_shader_variant_key *key,
+                 lp_context_ref *context,
+                 unsigned no,
+                 bool no_opt)
 {
    struct nir_shader *nir = shader->base.ir.nir;
    struct lp_fragment_shader_variant *variant =
@@ -3858,26 +3887,36 @@ generate_variant(struct llvmpipe_context *lp,
    struct lp_cached_code cached = { 0 };
    unsigned char ir_sha1_cache_key[20];
    bool needs_caching = false;
+   bool variant_cache_hit = false;
    if (shader->base.ir.nir) {
       lp_fs_get_ir_cache_key(variant, ir_sha1_cache_key);
 
-      lp_disk_cache_find_shader(screen, &cached, ir_sha1_cache_key);
-      if (!cached.data_size)
-         needs_caching = true;
+      lp_disk_cache_find_shader(screen, LP_JIT_FS, &cached,
+                                ir_sha1_cache_key);
+      variant_cache_hit = cached.data_size != 0;
+      if (cached.data_size)
+         no_opt = false;
+      else
+         needs_caching = !no_opt;
    }
 
    char module_name[64];
    snprintf(module_name, sizeof(module_name), "fs%u_variant%u",
-            shader->no, shader->variants_created);
-   variant->gallivm = gallivm_create(module_name, &lp->context, &cached);
+            shader->no, no);
+   variant->gallivm = gallivm_create(module_name, context, &cached);
    if (!variant->gallivm) {
       FREE(variant);
       return NULL;
    }
 
+   if (no_opt)
+      gallivm_set_no_opt(variant->gallivm);
+
    variant->list_item_global.base = variant;
    variant->list_item_local.base = variant;
-   variant->no = shader->variants_created++;
+   variant->no = no;
+   variant->no_opt = no_opt;
+   variant->cache_hit = variant_cache_hit;
 
    /*
     * Determine whether we are touching all channels in the color buffer.
@@ -3929,6 +3968,40 @@ generate_variant(struct llvmpipe_context *lp,
          shader->info.cbuf[0][3].file != TGSI_FILE_NULL
          ? true : false;
 
+   /* Depth only ever decreases with a LESS/LEQUAL test, so fragments
+    * farther than what is known to be in the depth buffer can't pass.
+    * Culling them must not skip stencil updates or memory writes.
+    */
+   const bool depth_less =
+         key->depth.enabled &&
+         (key->depth.func == PIPE_FUNC_LESS ||
+          key->depth.func == PIPE_FUNC_LEQUAL);
+
+   variant->hiz_cull =
+         depth_less &&
+         !key->stencil[0].enabled &&
+         !key->stencil[1].enabled &&
+         !(nir->info.outputs_written & BITFIELD64_BIT(FRAG_RESULT_DEPTH)) &&
+         (!nir->info.writes_memory || nir->info.fs.early_fragment_tests);
+
+   /* Every covered fragment passing the test writes its depth. */
+   variant->hiz_update =
+         variant->hiz_cull &&
+         key->depth.writemask &&
+         !key->alpha.enabled &&
+         !key->multisample &&
+         !key->blend.alpha_to_coverage &&
+         !key->depth.depth_bounds_test &&
+         !nir->info.fs.uses_discard &&
+         !(nir->info.outputs_written & BITFIELD64_BIT(FRAG_RESULT_SAMPLE_MASK));
+
+   variant->hiz_invalidate =
+         key->depth.enabled &&
+         key->depth.writemask &&
+         !depth_less &&
+         key->depth.func != PIPE_FUNC_NEVER &&
+         key->depth.func != PIPE_FUNC_EQUAL;
+
    /* We only care about opaque blits for now */
    if (variant->opaque &&
        (shader->kind == LP_FS_KIND_BLIT_RGBA ||
@@ -4085,6 +4158,160 @@ generate_variant(struct llvmpipe_context *lp,
 }
 
 
+/**
+ * Background compilation of an optimized variant.  Until it finishes,
+ * draws use a stand-in variant of the same key which was compiled
+ * without LLVM optimizations.
+ */
+struct lp_fs_compile_job {
+   struct util_queue_fence fence;
+   struct llvmpipe_context *lp;
+
+   /** Copy of the shader with a private NIR, as compiling modifies it */
+   struct lp_fragment_shader shader;
+
+   /** The optimized variant, once compiled */
+   struct lp_fragment_shader_variant *variant;
+   unsigned no;
+
+   int64_t compile_time;
+   int64_t stand_in_time;
+
+   /* key is variable-sized, must be last */
+   struct lp_fragment_shader_variant_key key;
+};
+
+
+static void
+fs_compile_job_execute(void *data, void *gdata, int thread_index)
+{
+   struct lp_fs_compile_job *job = data;
+   struct llvmpipe_context *lp = job->lp;
+
+   /* LLVM contexts aren't thread-safe, each thread has its own. */
+   int64_t t0 = os_time_get();
+   job->variant = generate_variant(lp, &job->shader, &job->key,
+                                   &lp->fs_compile_contexts[thread_index],
+                                   job->no, false);
+   job->compile_time = os_time_get() - t0;
+   lp_jit_count_compile(LP_JIT_FS, job->compile_time,
+                        job->variant && job->variant->cache_hit);
+}
+
+
+static void
+fs_compile_job_queue(struct llvmpipe_context *lp,
+                     struct lp_fragment_shader_variant *stand_in,
+                     int64_t stand_in_time)
+{
+   struct lp_fragment_shader *shader = stand_in->shader;
+   struct lp_fs_compile_job *job =
+      MALLOC(sizeof *job + shader->variant_key_size - sizeof job->key);
+   if (!job)
+      return;
+
+   memset(job, 0, sizeof *job);
+
+   memcpy(&job->shader, shader, sizeof *shader);
+   job->shader.base.ir.nir = nir_shader_clone(NULL, shader->base.ir.nir);
+   if (!job->shader.base.ir.nir) {
+      FREE(job);
+      return;
+   }
+
+   job->lp = lp;
+   job->no = shader->variants_created++;
+   job->stand_in_time = stand_in_time;
+   memcpy(&job->key, &stand_in->key, shader->variant_key_size);
+   util_queue_fence_init(&job->fence);
+
+   stand_in->compile_job = job;
+   util_queue_add_job(&lp->fs_compile_queue, job, &job->fence,
+                      fs_compile_job_execute, NULL, 0);
+}
+
+
+/**
+ * Cancel or wait for the stand-in's compile job and free it.
+ */
+static void
+fs_compile_job_destroy(struct llvmpipe_context *lp,
+                       struct lp_fragment_shader_variant *stand_in)
+{
+   struct lp_fs_compile_job *job = stand_in->compile_job;
+
+   util_queue_drop_job(&lp->fs_compile_queue, &job->fence);
+
+   if (job->variant) {
+      /* Don't let go of a reference on our private shader copy. */
+      job->variant->shader = NULL;
+      lp_fs_variant_reference(lp, &job->variant, NULL);
+   }
+
+   util_queue_fence_destroy(&job->fence);
+   ralloc_free(job->shader.base.ir.nir);
+   FREE(job);
+
+   stand_in->compile_job = NULL;
+   if (lp->fs_stand_in == stand_in)
+      lp->fs_stand_in = NULL;
+}
+
+
+/**
+ * Replace the stand-in by the optimized variant if that has finished
+ * compiling.  Returns the variant to use.
+ */
+static struct lp_fragment_shader_variant *
+fs_compile_job_finish(struct llvmpipe_context *lp,
+                      struct lp_fragment_shader_variant *stand_in)
+{
+   struct lp_fs_compile_job *job = stand_in->compile_job;
+
+   if (!util_queue_fence_is_signalled(&job->fence))
+      return stand_in;
+
+   struct lp_fragment_shader_variant *variant = job->variant;
+   if (!variant) {
+      /* Compilation failed, keep the stand-in. */
+      fs_compile_job_destroy(lp, stand_in);
+      return stand_in;
+   }
+
+   job->variant = NULL;
+   variant->shader = NULL;
+   lp_fs_reference(lp, &variant->shader, stand_in->shader);
+   variant->compile_time = job->compile_time;
+   memcpy(variant->dynamic_stencil_masks, stand_in->dynamic_stencil_masks,
+          sizeof variant->dynamic_stencil_masks);
+   variant->num_dynamic_stencil_masks = stand_in->num_dynamic_stencil_masks;
+
+   list_replace(&stand_in->list_item_local.list,
+                &variant->list_item_local.list);
+   list_replace(&stand_in->list_item_global.list,
+                &variant->list_item_global.list);
+   lp->nr_fs_instrs += variant->nr_instrs;
+   lp->nr_fs_instrs -= stand_in->nr_instrs;
+
+   LP_COUNT(nr_fs_async_compiles);
+   LP_COUNT_ADD(fs_async_compile_time, job->compile_time);
+   /* The optimized compile can be quicker than the stand-in was, in which
+    * case compiling in the background didn't avoid any stall.
+    */
+   if (job->compile_time > job->stand_in_time) {
+      LP_COUNT_ADD(fs_async_stall_avoided,
+                   job->compile_time - job->stand_in_time);
+   }
+
+   fs_compile_job_destroy(lp, stand_in);
+
+   /* Scenes may still hold references to the stand-in. */
+   lp_fs_variant_reference(lp, &stand_in, NULL);
+
+   return variant;
+}
+
+
 static void *
 llvmpipe_create_fs_state(struct pipe_context *pipe,
                          const struct pipe_shader_state *templ)
@@ -4224,6 +4451,9 @@ llvmpipe_remove_shader_variant(struct llvmpipe_context *lp,
                    lp->nr_fs_variants, variant->nr_instrs, lp->nr_fs_instrs);
    }
 
+   if (variant->compile_job)
+      fs_compile_job_destroy(lp, variant);
+
    /* remove from shader's list */
    list_del(&variant->list_item_local.list);
    variant->shader->variants_cached--;
@@ -4519,6 +4749,17 @@ make_variant_key(struct llvmpipe_context *lp,
          key->zsbuf_format = zsbuf_format;
          memcpy(&key->stencil, &lp->depth_stencil->stencil,
                 sizeof key->stencil);
+
+         /* The masks come from the JIT context, only whether stencil
+          * gets written at all changes the code.
+          */
+         if (lp->dynamic_state & LP_DYNAMIC_STENCIL_MASKS) {
+            key->dynamic_stencil_masks = 1;
+            for (unsigned i = 0; i < 2; i++) {
+               key->stencil[i].valuemask = 0xff;
+               key->stencil[i].writemask = key->stencil[i].writemask ? 0xff : 0;
+            }
+         }
       }
       if (llvmpipe_resource_is_1d(lp->framebuffer.zsbuf.texture)) {
          key->resource_1d = true;
@@ -4756,6 +4997,146 @@ make_variant_key(struct llvmpipe_context *lp,
 }
 
 
+/**
+ * Variant eviction uses GreedyDual-Size: each variant gets a priority of
+ * the current clock plus its compile cost per instruction whenever it is
+ * created or used, and the variant with the lowest priority is evicted
+ * first, advancing the clock to its priority.  Variants which are slow to
+ * build but small are kept over big or cheap ones (e.g. reloaded from the
+ * disk cache), while the clock ages out those that aren't used anymore.
+ */
+static void
+fs_variant_touch(struct llvmpipe_context *lp,
+                 struct lp_fragment_shader_variant *variant)
+{
+   variant->cache_priority = lp->fs_cache_clock +
+      (double)(variant->compile_time + 1) / (variant->nr_instrs + 1);
+}
+
+
+struct fs_evict_candidate {
+   struct lp_fragment_shader_variant *variant;
+   unsigned lru_order;
+};
+
+
+static int
+fs_evict_candidate_compare(const void *_a, const void *_b)
+{
+   const struct fs_evict_candidate *a = _a, *b = _b;
+
+   if (a->variant->cache_priority != b->variant->cache_priority)
+      return a->variant->cache_priority < b->variant->cache_priority ? -1 : 1;
+   return a->lru_order < b->lru_order ? -1 : 1;
+}
+
+
+static void
+fs_variant_evict(struct llvmpipe_context *lp,
+                 struct lp_fragment_shader_variant *victim)
+{
+   lp->fs_cache_clock = MAX2(lp->fs_cache_clock, victim->cache_priority);
+
+   /* Remember the key, to tell recompiles of evicted variants apart. */
+   struct lp_fragment_shader *shader = victim->shader;
+   shader->evicted_keys[shader->next_evicted_key++ % LP_FS_MAX_EVICTED_KEYS] =
+      _mesa_hash_data(&victim->key, shader->variant_key_size) | 1;
+
+   p_atomic_inc(&lp_jit_count[LP_JIT_FS].evictions);
+
+   llvmpipe_remove_shader_variant(lp, victim);
+   lp_fs_variant_reference(lp, &victim, NULL);
+}
+
+
+/**
+ * Evict at least \p count variants, and more while the cache is over its
+ * instruction budget, in order of priority.  Sorting once per batch keeps
+ * the cost per evicted variant logarithmic instead of scanning all of them
+ * for each one.
+ */
+static void
+fs_variants_evict(struct llvmpipe_context *lp, unsigned count)
+{
+   const unsigned num_variants = list_length(&lp->fs_variants_list.list);
+   if (!num_variants)
+      return;
+
+   struct fs_evict_candidate *candidates =
+      MALLOC(num_variants * sizeof(*candidates));
+   if (!candidates)
+      return;
+
+   /* Ties go to the least recently used variant */
+   unsigned n = 0;
+   list_for_each_entry_rev(struct lp_fs_variant_list_item, li,
+                           &lp->fs_variants_list.list, list) {
+      candidates[n].variant = li->base;
+      candidates[n].lru_order = n;
+      n++;
+   }
+   qsort(candidates, n, sizeof(*candidates), fs_evict_candidate_compare);
+
+   for (unsigned i = 0;
+        i < n && (i < count ||
+                  lp->nr_fs_variants >= LP_MAX_SHADER_VARIANTS ||
+                  lp->nr_fs_instrs >= LP_MAX_SHADER_INSTRUCTIONS);
+        i++)
+      fs_variant_evict(lp, candidates[i].variant);
+
+   FREE(candidates);
+}
+
+
+static bool
+fs_variant_was_evicted(struct lp_fragment_shader *shader,
+                       const struct lp_fragment_shader_variant_key *key)
+{
+   const uint32_t key_hash = _mesa_hash_data(key, shader->variant_key_size) | 1;
+   const unsigned num_keys =
+      MIN2(shader->next_evicted_key, LP_FS_MAX_EVICTED_KEYS);
+
+   for (unsigned i = 0; i < num_keys; i++) {
+      if (shader->evicted_keys[i] == key_hash) {
+         /* Forget it, so that only the first recompile counts */
+         shader->evicted_keys[i] = 0;
+         return true;
+      }
+   }
+   return false;
+}
+
+
+/**
+ * Count the variants a variant with runtime stencil masks stands in for:
+ * each distinct set of masks it is used with would have been a variant of
+ * its own.  Only the first few sets are tracked.
+ */
+static void
+fs_variant_count_dynamic_state(struct llvmpipe_context *lp,
+                               struct lp_fragment_shader_variant *variant)
+{
+   const struct pipe_stencil_state *stencil = lp->depth_stencil->stencil;
+   uint32_t masks = stencil[0].valuemask | stencil[0].writemask << 8;
+   if (stencil[1].enabled)
+      masks |= stencil[1].valuemask << 16 | (uint32_t)stencil[1].writemask << 24;
+
+   for (unsigned i = 0; i < variant->num_dynamic_stencil_masks; i++) {
+      if (variant->dynamic_stencil_masks[i] == masks)
+         return;
+   }
+
+   if (variant->num_dynamic_stencil_masks ==
+       ARRAY_SIZE(variant->dynamic_stencil_masks))
+      return;
+
+   /* The first set is the one the variant was built for */
+   if (variant->num_dynamic_stencil_masks)
+      p_atomic_inc(&lp_jit_count[LP_JIT_FS].avoided);
+   variant->dynamic_stencil_masks[variant->num_dynamic_stencil_masks++] = masks;
+}
+
+
 /**
  * Update fragment shader state.  This is called just prior to drawing
  * something when some fragment-related state has changed.
@@ -4780,10 +5161,17 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
    }
 
    if (variant) {
-      /* Move this variant to the head of the list to implement LRU
-       * deletion of shader's when we have too many.
+      if (variant->compile_job)
+         variant = fs_compile_job_finish(lp, variant);
+
+      if (key->dynamic_stencil_masks)
+         fs_variant_count_dynamic_state(lp, variant);
+
+      /* Move this variant to the head of the list, which breaks ties
+       * between equally valuable variants in LRU order.
        */
       list_move_to(&variant->list_item_global.list, &lp->fs_variants_list.list);
+      fs_variant_touch(lp, variant);
    } else {
       /* variant not found, create it now */
 
@@ -4794,14 +5182,11 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
                       lp->nr_fs_variants ? lp->nr_fs_instrs / lp->nr_fs_variants : 0);
       }
 
-      /* First, check if we've exceeded the max number of shader variants.
-       * If so, free 6.25% of them (the least recently used ones).
+      /* First, check if we've exceeded the max number of shader variants
+       * or the instruction budget, and if so evict the least valuable ones:
+       * 6.25% of them, so that this doesn't happen on every new variant.
        */
-      const unsigned variants_to_cull =
-         lp->nr_fs_variants >= LP_MAX_SHADER_VARIANTS
-         ? LP_MAX_SHADER_VARIANTS / 16 : 0;
-
-      if (variants_to_cull ||
+      if (lp->nr_fs_variants >= LP_MAX_SHADER_VARIANTS ||
           lp->nr_fs_instrs >= LP_MAX_SHADER_INSTRUCTIONS) {
          if (gallivm_debug & GALLIVM_DEBUG_PERF) {
             debug_printf("Evicting FS: %u fs variants,\t%u total variants,"
@@ -4811,40 +5196,34 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
                          lp->nr_fs_variants ? lp->nr_fs_instrs / lp->nr_fs_variants : 0);
          }
 
-         /*
-          * We need to re-check lp->nr_fs_variants because an arbitrarily
-          * large number of shader variants (potentially all of them) could
-          * be pending for destruction on flush.
-          */
-
-         for (unsigned i = 0;
-              i < variants_to_cull ||
-                 lp->nr_fs_instrs >= LP_MAX_SHADER_INSTRUCTIONS;
-              i++) {
-            struct lp_fs_variant_list_item *item;
-            if (list_is_empty(&lp->fs_variants_list.list)) {
-               break;
-            }
-            item = list_last_entry(&lp->fs_variants_list.list,
-                                   struct lp_fs_variant_list_item, list);
-            assert(item);
-            assert(item->base);
-            llvmpipe_remove_shader_variant(lp, item->base);
-            struct lp_fragment_shader_variant *variant = item->base;
-            lp_fs_variant_reference(lp, &variant, NULL);
-         }
+         fs_variants_evict(lp, lp->nr_fs_variants >= LP_MAX_SHADER_VARIANTS
+                               ? LP_MAX_SHADER_VARIANTS / 16 : 0);
       }
 
+      if (fs_variant_was_evicted(shader, key))
+         p_atomic_inc(&lp_jit_count[LP_JIT_FS].recompiles);
+
       /*
-       * Generate the new variant.
+       * Generate the new variant.  With background compile threads, only
+       * a quick unoptimized variant is built here.
        */
+      const bool no_opt = lp->num_fs_compile_threads > 0;
       int64_t t0 = os_time_get();
-      variant = generate_variant(lp, shader, key);
+      variant = generate_variant(lp, shader, key, &lp->context,
+                                 shader->variants_created++, no_opt);
       int64_t t1 = os_time_get();
       int64_t dt = t1 - t0;
       LP_COUNT_ADD(llvm_compile_time, dt);
+      lp_jit_count_compile(LP_JIT_FS, dt, variant && variant->cache_hit);
       LP_COUNT_ADD(nr_llvm_compiles, 2);  /* emit vs. omit in/out test */
 
+      if (variant) {
+         variant->compile_time = dt;
+         fs_variant_touch(lp, variant);
+         if (key->dynamic_stencil_masks)
+            fs_variant_count_dynamic_state(lp, variant);
+      }
+
       /* Put the new variant into the list */
       if (variant) {
          list_add(&variant->list_item_local.list, &shader->variants.list);
@@ -4852,14 +5231,81 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
          lp->nr_fs_variants++;
          lp->nr_fs_instrs += variant->nr_instrs;
          shader->variants_cached++;
+
+         if (variant->no_opt)
+            fs_compile_job_queue(lp, variant, dt);
       }
    }
 
+   lp->fs_stand_in = variant && variant->compile_job ? variant : NULL;
+
    /* Bind this variant */
    lp_setup_set_fs_variant(lp->setup, variant);
 }
 
 
+/**
+ * Called before drawing while an unoptimized variant is bound, to switch
+ * to the optimized one as soon as it is ready.
+ */
+void
+llvmpipe_poll_fs_compile(struct llvmpipe_context *lp)
+{
+   struct lp_fragment_shader_variant *variant = lp->fs_stand_in;
+
+   if (util_queue_fence_is_signalled(&variant->compile_job->fence))
+      lp->dirty |= LP_NEW_FS;
+}
+
+
+void
+llvmpipe_init_fs_compile_queue(struct llvmpipe_context *lp)
+{
+#ifndef USE_GLOBAL_LLVM_CONTEXT
+   struct llvmpipe_screen *screen = llvmpipe_screen(lp->pipe.screen);
+   unsigned num_threads = screen->num_fs_compile_threads;
+   unsigned i;
+
+   if (!num_threads)
+      return;
+
+   for (i = 0; i < num_threads; i++) {
+      lp_context_create(&lp->fs_compile_contexts[i]);
+      if (!lp->fs_compile_contexts[i].ref)
+         goto fail;
+   }
+
+   if (!util_queue_init(&lp->fs_compile_queue, "lpfs", 64, num_threads,
+                        UTIL_QUEUE_INIT_RESIZE_IF_FULL |
+                        UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY, NULL))
+      goto fail;
+
+   lp->num_fs_compile_threads = num_threads;
+   return;
+
+fail:
+   while (i--)
+      lp_context_destroy(&lp->fs_compile_contexts[i]);
+#endif
+}
+
+
+void
+llvmpipe_destroy_fs_compile_queue(struct llvmpipe_context *lp)
+{
+   if (!lp->num_fs_compile_threads)
+      return;
+
+   util_queue_finish(&lp->fs_compile_queue);
+   util_queue_destroy(&lp->fs_compile_queue);
+
+   for (unsigned i = 0; i < lp->num_fs_compile_threads; i++)
+      lp_context_destroy(&lp->fs_compile_contexts[i]);
+
+   lp->num_fs_compile_threads = 0;
+}
+
+
 void
 llvmpipe_init_fs_funcs(struct llvmpipe_context *llvmpipe)
 {
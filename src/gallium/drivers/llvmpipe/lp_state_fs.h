@@ -41,8 +41,12 @@
 #include "lp_jit.h"
 
 struct lp_fragment_shader;
+struct lp_fs_compile_job;
 
 
+/** Evicted variant keys remembered per shader to count recompiles */
+#define LP_FS_MAX_EVICTED_KEYS 64
+
 /** Indexes into jit_function[] array */
 #define RAST_WHOLE 0
 #define RAST_EDGE_TEST 1
@@ -89,6 +93,7 @@ struct lp_fragment_shader_variant_key
    unsigned no_ms_sample_mask_out:1;
    unsigned restrict_depth_values:1;
    unsigned sample_locations_enabled:1;
+   unsigned dynamic_stencil_masks:1;  /**< LP_DYNAMIC_STENCIL_MASKS */
 
    enum pipe_format zsbuf_format;
    enum pipe_format cbuf_format[PIPE_MAX_COLOR_BUFS];
@@ -154,6 +159,22 @@ struct lp_fragment_shader_variant
    unsigned opaque:1;
    unsigned blit:1;
    unsigned linear_input_mask:16;
+
+   /*
+    * Hierarchical Z: fragments behind the known depth may be culled
+    * before shading, fully covered blocks lower the known depth, and
+    * the known depth must be dropped where depth may increase.
+    */
+   unsigned hiz_cull:1;
+   unsigned hiz_update:1;
+   unsigned hiz_invalidate:1;
+
+   /* Compiled without optimizations, to be replaced by compile_job's
+    * result.
+    */
+   unsigned no_opt:1;
+   struct lp_fs_compile_job *compile_job;
+
    struct pipe_reference reference;
 
    struct gallivm_state *gallivm;
@@ -190,6 +211,17 @@ struct lp_fragment_shader_variant
    /* Total number of LLVM instructions generated */
    unsigned nr_instrs;
 
+   /* Time it took to build, in microseconds, and eviction priority */
+   int64_t compile_time;
+   bool cache_hit;
+   double cache_priority;
+
+   /* Distinct runtime stencil masks this variant was used with, which
+    * would each have needed their own variant as key bits.
+    */
+   uint32_t dynamic_stencil_masks[4];
+   unsigned num_dynamic_stencil_masks;
+
    struct lp_fs_variant_list_item list_item_global, list_item_local;
    struct lp_fragment_shader *shader;
 
@@ -222,6 +254,13 @@ struct lp_fragment_shader
    unsigned variants_created;
    unsigned variants_cached;
 
+   /**
+    * Hashes of the keys of the last evicted variants, for lp_jit_count.
+    * Once full, the oldest one is overwritten.
+    */
+   uint32_t evicted_keys[LP_FS_MAX_EVICTED_KEYS];
+   unsigned next_evicted_key;
+
    /** Fragment shader input interpolation info */
    struct lp_shader_input inputs[PIPE_MAX_SHADER_INPUTS];
 };
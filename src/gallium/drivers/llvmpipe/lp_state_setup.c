@@ -29,6 +29,7 @@
 #include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/os_time.h"
+#include "util/mesa-sha1.h"
 #include "gallivm/lp_bld_arit.h"
 #include "gallivm/lp_bld_bitarit.h"
 #include "gallivm/lp_bld_const.h"
@@ -628,6 +629,20 @@ init_args(struct gallivm_state *gallivm,
 }
 
 
+static void
+lp_setup_get_ir_cache_key(const struct lp_setup_variant_key *key,
+                          unsigned char ir_sha1_cache_key[20])
+{
+   static const char setup_tag[] = "llvmpipe setup";
+
+   struct mesa_sha1 ctx;
+   _mesa_sha1_init(&ctx);
+   _mesa_sha1_update(&ctx, setup_tag, sizeof setup_tag);
+   _mesa_sha1_update(&ctx, key, key->size);
+   _mesa_sha1_final(&ctx, ir_sha1_cache_key);
+}
+
+
 /**
  * Generate the runtime callable function for the coefficient calculation.
  *
@@ -636,7 +651,8 @@ static struct lp_setup_variant *
 generate_setup_variant(struct lp_setup_variant_key *key,
                        struct llvmpipe_context *lp)
 {
-   int64_t t0 = 0, t1;
+   struct llvmpipe_screen *screen = llvmpipe_screen(lp->pipe.screen);
+   int64_t t0 = os_time_get(), t1;
 
    if (0)
       goto fail;
@@ -647,22 +663,30 @@ generate_setup_variant(struct lp_setup_variant_key *key,
 
    variant->no = setup_no++;
 
-   char func_name[64];
-   snprintf(func_name, sizeof(func_name), "setup_variant_%u",
+   /* The function name must not depend on the variant number, as the
+    * code may come from the disk cache.
+    */
+   const char *func_name = "setup_variant";
+   char module_name[64];
+   snprintf(module_name, sizeof(module_name), "setup_variant_%u",
             variant->no);
 
+   struct lp_cached_code cached = { 0 };
+   unsigned char ir_sha1_cache_key[20];
+   lp_setup_get_ir_cache_key(key, ir_sha1_cache_key);
+   lp_disk_cache_find_shader(screen, LP_JIT_SETUP, &cached,
+                             ir_sha1_cache_key);
+   const bool needs_caching = !cached.data_size;
+
    struct gallivm_state *gallivm;
-   variant->gallivm = gallivm = gallivm_create(func_name, &lp->context, NULL);
+   variant->gallivm = gallivm = gallivm_create(module_name, &lp->context,
+                                               &cached);
    if (!variant->gallivm) {
       goto fail;
    }
 
    LLVMBuilderRef builder = gallivm->builder;
 
-   if (LP_DEBUG & DEBUG_COUNTERS) {
-      t0 = os_time_get();
-   }
-
    memcpy(&variant->key, key, key->size);
    variant->list_item_global.base = variant;
 
@@ -743,13 +767,17 @@ generate_setup_variant(struct lp_setup_variant_key *key,
    if (!variant->jit_function)
       goto fail;
 
+   if (needs_caching)
+      lp_disk_cache_insert_shader(screen, &cached, ir_sha1_cache_key);
+
    gallivm_free_ir(variant->gallivm);
 
    /*
     * Update timing information:
     */
+   t1 = os_time_get();
+   lp_jit_count_compile(LP_JIT_SETUP, t1 - t0, !needs_caching);
    if (LP_DEBUG & DEBUG_COUNTERS) {
-      t1 = os_time_get();
       LP_COUNT_ADD(llvm_compile_time, t1 - t0);
       LP_COUNT_ADD(nr_llvm_compiles, 1);
    }
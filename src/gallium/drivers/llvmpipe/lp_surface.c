@@ -35,6 +35,445 @@
 #include "lp_texture.h"
 #include "lp_query.h"
 #include "lp_rast.h"
+#include "lp_screen.h"
+#include "lp_cs_tpool.h"
+
+
+/**
+ * Number of chunks a transfer of the given size is split into, 1 if it
+ * should run on the calling thread.
+ */
+static unsigned
+lp_transfer_chunks(struct pipe_context *pipe, uint64_t size)
+{
+   struct lp_cs_tpool *pool = llvmpipe_screen(pipe->screen)->cs_tpool;
+
+   if (!pool || pool->num_threads == 0)
+      return 1;
+
+   uint64_t chunks = size / LP_TRANSFER_CHUNK_SIZE;
+   return MAX2(MIN2(chunks, pool->num_threads * 4), 1);
+}
+
+
+static void
+lp_transfer_run(struct pipe_context *pipe, lp_cs_tpool_task_func work,
+                void *data, unsigned count)
+{
+   struct lp_cs_tpool *pool = llvmpipe_screen(pipe->screen)->cs_tpool;
+
+   /* Without threads lp_cs_tpool_queue_task() runs the work itself and
+    * returns NULL, same as when the task can't be allocated.
+    */
+   if (count > 1 && pool && pool->num_threads > 0) {
+      struct lp_cs_tpool_task *task =
+         lp_cs_tpool_queue_task(pool, work, data, count);
+      if (task) {
+         lp_cs_tpool_wait_for_task(pool, &task);
+         return;
+      }
+   }
+
+   struct lp_cs_local_mem lmem = { 0 };
+   for (unsigned i = 0; i < count; i++)
+      work(data, i, &lmem);
+   FREE(lmem.local_mem_ptr);
+}
+
+
+/**
+ * A linear range split into chunks of chunk_size bytes, which is a
+ * multiple of value_size for fills.
+ */
+struct lp_transfer_linear {
+   uint8_t *dst;
+   const uint8_t *src;
+   const void *value;
+   unsigned value_size;
+   uint64_t size;
+   uint64_t chunk_size;
+};
+
+
+static void
+lp_copy_linear_chunk(void *data, int iter_idx, struct lp_cs_local_mem *lmem)
+{
+   const struct lp_transfer_linear *lin = data;
+   const uint64_t offset = iter_idx * lin->chunk_size;
+
+   memcpy(lin->dst + offset, lin->src + offset,
+          MIN2(lin->chunk_size, lin->size - offset));
+}
+
+
+static void
+lp_fill_linear_chunk(void *data, int iter_idx, struct lp_cs_local_mem *lmem)
+{
+   const struct lp_transfer_linear *lin = data;
+   const uint64_t offset = iter_idx * lin->chunk_size;
+   const uint64_t size = MIN2(lin->chunk_size, lin->size - offset);
+   uint8_t *dst = lin->dst + offset;
+
+   switch (lin->value_size) {
+   case 1:
+      memset(dst, *(uint8_t *)lin->value, size);
+      break;
+   case 4:
+      util_memset32(dst, *(uint32_t *)lin->value, size / 4);
+      break;
+   default:
+      for (uint64_t i = 0; i < size; i += lin->value_size)
+         memcpy(&dst[i], lin->value, lin->value_size);
+      break;
+   }
+}
+
+
+static void
+lp_transfer_linear(struct pipe_context *pipe, lp_cs_tpool_task_func work,
+                   struct lp_transfer_linear *lin)
+{
+   const unsigned align = MAX2(lin->value_size, 1) * 64;
+
+   if (!lin->size)
+      return;
+
+   unsigned chunks = lp_transfer_chunks(pipe, lin->size);
+   lin->chunk_size = align64(DIV_ROUND_UP(lin->size, chunks), align);
+   lp_transfer_run(pipe, work, lin,
+                   DIV_ROUND_UP(lin->size, lin->chunk_size));
+}
+
+
+/**
+ * A box split into bands of band_height pixel rows, a whole number of
+ * block rows, and band_depth layers, bands_per_slice bands per band_depth
+ * layers.  A box that isn't split is a single band.
+ */
+struct lp_transfer_box {
+   uint8_t *dst;
+   const uint8_t *src;
+   enum pipe_format format;
+   unsigned dst_stride;
+   uint64_t dst_slice_stride;
+   int src_stride;
+   uint64_t src_slice_stride;
+   unsigned dst_x, dst_y;
+   unsigned src_x, src_y;
+   unsigned width, height;
+   unsigned band_height;
+   unsigned band_depth;
+   unsigned bands_per_slice;
+   union util_color *uc;
+   /* Blits convert from format to dst_format, averaging the samples */
+   enum pipe_format dst_format;
+   unsigned nr_samples;
+   unsigned sample_stride;
+};
+
+
+static unsigned
+lp_transfer_box_split(struct pipe_context *pipe, struct lp_transfer_box *box,
+                      unsigned depth)
+{
+   const unsigned bw = util_format_get_blockwidth(box->format);
+   const unsigned bh = util_format_get_blockheight(box->format);
+   const unsigned rows = DIV_ROUND_UP(box->height, bh);
+   const uint64_t row_size = (uint64_t)DIV_ROUND_UP(box->width, bw) *
+                             util_format_get_blocksize(box->format);
+
+   unsigned chunks = lp_transfer_chunks(pipe, row_size * rows * depth);
+   if (chunks <= 1 || rows == 0) {
+      box->band_height = box->height;
+      box->band_depth = depth;
+      box->bands_per_slice = 1;
+      return 1;
+   }
+
+   /* Whole layers first, then bands of rows within each layer. */
+   unsigned bands = MIN2(DIV_ROUND_UP(chunks, depth), rows);
+   unsigned band_rows = DIV_ROUND_UP(rows, bands);
+
+   box->band_height = band_rows * bh;
+   box->band_depth = 1;
+   box->bands_per_slice = DIV_ROUND_UP(rows, band_rows);
+   return box->bands_per_slice * depth;
+}
+
+
+static void
+lp_copy_box_band(void *data, int iter_idx, struct lp_cs_local_mem *lmem)
+{
+   const struct lp_transfer_box *box = data;
+   const unsigned z = iter_idx / box->bands_per_slice * box->band_depth;
+   const unsigned y = (iter_idx % box->bands_per_slice) * box->band_height;
+
+   util_copy_box(box->dst, box->format,
+                 box->dst_stride, box->dst_slice_stride,
+                 box->dst_x, box->dst_y + y, z,
+                 box->width, MIN2(box->band_height, box->height - y),
+                 box->band_depth,
+                 box->src, box->src_stride, box->src_slice_stride,
+                 box->src_x, box->src_y + y, z);
+}
+
+
+void
+llvmpipe_copy_box(struct pipe_context *pipe,
+                  uint8_t *dst, enum pipe_format format,
+                  unsigned dst_stride, uint64_t dst_slice_stride,
+                  unsigned dst_x, unsigned dst_y, unsigned dst_z,
+                  unsigned width, unsigned height, unsigned depth,
+                  const uint8_t *src,
+                  int src_stride, uint64_t src_slice_stride,
+                  unsigned src_x, unsigned src_y, unsigned src_z)
+{
+   const unsigned bw = util_format_get_blockwidth(format);
+   const unsigned bh = util_format_get_blockheight(format);
+   const unsigned bs = util_format_get_blocksize(format);
+
+   dst += dst_z * dst_slice_stride;
+   src += src_z * src_slice_stride;
+
+   /* A single row, such as a buffer range, is split into linear chunks */
+   if (depth == 1 && DIV_ROUND_UP(height, bh) == 1) {
+      struct lp_transfer_linear lin = {
+         .dst = dst + dst_y / bh * dst_stride + dst_x / bw * bs,
+         .src = src + (int64_t)(src_y / bh) * src_stride + src_x / bw * bs,
+         .size = (uint64_t)DIV_ROUND_UP(width, bw) * bs,
+      };
+      lp_transfer_linear(pipe, lp_copy_linear_chunk, &lin);
+      return;
+   }
+
+   /* util_copy_rect() handles flipped sources row by row */
+   if (src_stride < 0) {
+      util_copy_box(dst, format, dst_stride, dst_slice_stride,
+                    dst_x, dst_y, 0, width, height, depth,
+                    src, src_stride, src_slice_stride, src_x, src_y, 0);
+      return;
+   }
+
+   struct lp_transfer_box box = {
+      .dst = dst,
+      .src = src,
+      .format = format,
+      .dst_stride = dst_stride,
+      .dst_slice_stride = dst_slice_stride,
+      .src_stride = src_stride,
+      .src_slice_stride = src_slice_stride,
+      .dst_x = dst_x,
+      .dst_y = dst_y,
+      .src_x = src_x,
+      .src_y = src_y,
+      .width = width,
+      .height = height,
+   };
+
+   unsigned count = lp_transfer_box_split(pipe, &box, depth);
+   lp_transfer_run(pipe, lp_copy_box_band, &box, count);
+}
+
+
+static void
+lp_fill_box_band(void *data, int iter_idx, struct lp_cs_local_mem *lmem)
+{
+   const struct lp_transfer_box *box = data;
+   const unsigned z = iter_idx / box->bands_per_slice * box->band_depth;
+   const unsigned y = (iter_idx % box->bands_per_slice) * box->band_height;
+
+   util_fill_box(box->dst + z * box->dst_slice_stride, box->format,
+                 box->dst_stride, box->dst_slice_stride,
+                 box->dst_x, box->dst_y + y, 0,
+                 box->width, MIN2(box->band_height, box->height - y),
+                 box->band_depth, box->uc);
+}
+
+
+void
+llvmpipe_fill_box(struct pipe_context *pipe,
+                  uint8_t *dst, enum pipe_format format,
+                  unsigned stride, uintptr_t layer_stride,
+                  unsigned x, unsigned y, unsigned z,
+                  unsigned width, unsigned height, unsigned depth,
+                  union util_color *uc)
+{
+   struct lp_transfer_box box = {
+      .dst = dst + z * layer_stride,
+      .format = format,
+      .dst_stride = stride,
+      .dst_slice_stride = layer_stride,
+      .dst_x = x,
+      .dst_y = y,
+      .width = width,
+      .height = height,
+      .uc = uc,
+   };
+
+   unsigned count = lp_transfer_box_split(pipe, &box, depth);
+   lp_transfer_run(pipe, lp_fill_box_band, &box, count);
+}
+
+
+/**
+ * Converts a band of a blit through rows of 32-bit float RGBA, averaging
+ * the source samples.  src and dst point at the origins of the boxes.
+ */
+static void
+lp_blit_box_band(void *data, int iter_idx, struct lp_cs_local_mem *lmem)
+{
+   const struct lp_transfer_box *box = data;
+   const unsigned z0 = iter_idx / box->bands_per_slice * box->band_depth;
+   const unsigned y0 = (iter_idx % box->bands_per_slice) * box->band_height;
+   const unsigned height = MIN2(box->band_height, box->height - y0);
+   const unsigned row_size = box->width * 4 * sizeof(float);
+
+   if (lmem->local_size < 2 * row_size) {
+      lmem->local_mem_ptr = REALLOC(lmem->local_mem_ptr, lmem->local_size,
+                                    2 * row_size);
+      lmem->local_size = lmem->local_mem_ptr ? 2 * row_size : 0;
+      if (!lmem->local_mem_ptr)
+         return;
+   }
+
+   float *rgba = lmem->local_mem_ptr;
+   float *sample_rgba = rgba + box->width * 4;
+
+   for (unsigned z = z0; z < z0 + box->band_depth; z++) {
+      for (unsigned y = y0; y < y0 + height; y++) {
+         const uint8_t *src = box->src + z * box->src_slice_stride +
+                              (uint64_t)y * box->src_stride;
+         uint8_t *dst = box->dst + z * box->dst_slice_stride +
+                        (uint64_t)y * box->dst_stride;
+
+         util_format_unpack_rgba(box->format, rgba, src, box->width);
+
+         if (box->nr_samples > 1) {
+            for (unsigned s = 1; s < box->nr_samples; s++) {
+               util_format_unpack_rgba(box->format, sample_rgba,
+                                       src + s * box->sample_stride,
+                                       box->width);
+               for (unsigned i = 0; i < box->width * 4; i++)
+                  rgba[i] += sample_rgba[i];
+            }
+
+            const float scale = 1.0f / box->nr_samples;
+            for (unsigned i = 0; i < box->width * 4; i++)
+               rgba[i] *= scale;
+         }
+
+         util_format_pack_rgba(box->dst_format, dst, rgba, box->width);
+      }
+   }
+}
+
+
+static bool
+lp_box_in_level(const struct pipe_resource *res, unsigned level,
+                const struct pipe_box *box)
+{
+   return box->x >= 0 && box->y >= 0 && box->z >= 0 &&
+          box->width > 0 && box->height > 0 && box->depth > 0 &&
+          box->x + box->width <= (int)u_minify(res->width0, level) &&
+          box->y + box->height <= (int)u_minify(res->height0, level) &&
+          box->z + box->depth <= (int)util_num_layers(res, level);
+}
+
+
+static bool
+lp_format_blits_as_rgba(enum pipe_format resource_format,
+                        enum pipe_format format)
+{
+   return !util_format_is_depth_or_stencil(format) &&
+          !util_format_is_pure_integer(format) &&
+          util_format_get_blockwidth(format) == 1 &&
+          util_format_get_blockheight(format) == 1 &&
+          util_format_get_blocksize(format) ==
+          util_format_get_blocksize(resource_format);
+}
+
+
+/**
+ * Blits and resolves without scaling, flipping or per-pixel state on the
+ * cs thread pool.  Anything else, and blits too small to split, is left to
+ * u_blitter, whose draws already run on the rasterizer threads.
+ */
+static bool
+lp_blit_split(struct pipe_context *pipe, const struct pipe_blit_info *info)
+{
+   struct pipe_resource *src = info->src.resource;
+   struct pipe_resource *dst = info->dst.resource;
+   const enum pipe_format src_format = info->src.format;
+   const enum pipe_format dst_format = info->dst.format;
+
+   if (info->mask != PIPE_MASK_RGBA || info->scissor_enable ||
+       info->swizzle_enable || info->alpha_blend || info->dst_sample ||
+       info->num_window_rectangles || info->window_rectangle_include ||
+       dst->nr_samples > 1 ||
+       src->target == PIPE_BUFFER || dst->target == PIPE_BUFFER ||
+       ((src->flags | dst->flags) & PIPE_RESOURCE_FLAG_SPARSE))
+      return false;
+
+   if (info->src.box.width != info->dst.box.width ||
+       info->src.box.height != info->dst.box.height ||
+       info->src.box.depth != info->dst.box.depth ||
+       !lp_box_in_level(src, info->src.level, &info->src.box) ||
+       !lp_box_in_level(dst, info->dst.level, &info->dst.box))
+      return false;
+
+   if (!lp_format_blits_as_rgba(src->format, src_format) ||
+       !lp_format_blits_as_rgba(dst->format, dst_format))
+      return false;
+
+   const struct util_format_unpack_description *unpack =
+      util_format_unpack_description(src_format);
+   const struct util_format_pack_description *pack =
+      util_format_pack_description(dst_format);
+   if (!unpack || !unpack->unpack_rgba || !pack || !pack->pack_rgba_float)
+      return false;
+
+   struct lp_transfer_box box = {
+      .format = src_format,
+      .width = info->src.box.width,
+      .height = info->src.box.height,
+      .dst_format = dst_format,
+      .nr_samples = MAX2(src->nr_samples, 1),
+      .sample_stride = llvmpipe_sample_stride(src),
+   };
+
+   unsigned count = lp_transfer_box_split(pipe, &box, info->src.box.depth);
+   if (count <= 1)
+      return false;
+
+   struct pipe_transfer *src_trans, *dst_trans;
+   const uint8_t *src_map =
+      llvmpipe_transfer_map_ms(pipe, src, info->src.level, PIPE_MAP_READ, 0,
+                               &info->src.box, &src_trans);
+   if (!src_map)
+      return false;
+
+   uint8_t *dst_map = pipe->texture_map(pipe, dst, info->dst.level,
+                                        PIPE_MAP_WRITE |
+                                        PIPE_MAP_DISCARD_RANGE,
+                                        &info->dst.box, &dst_trans);
+   if (!dst_map) {
+      pipe->texture_unmap(pipe, src_trans);
+      return false;
+   }
+
+   box.dst = dst_map;
+   box.dst_stride = dst_trans->stride;
+   box.dst_slice_stride = dst_trans->layer_stride;
+   box.src = src_map;
+   box.src_stride = src_trans->stride;
+   box.src_slice_stride = src_trans->layer_stride;
+
+   lp_transfer_run(pipe, lp_blit_box_band, &box, count);
+
+   pipe->texture_unmap(pipe, dst_trans);
+   pipe->texture_unmap(pipe, src_trans);
+   return true;
+}
 
 
 static void
@@ -69,14 +508,14 @@ lp_resource_copy_ms(struct pipe_context *pipe,
          return;
       }
 
-      util_copy_box(dst_map,
-                    src_format,
-                    dst_trans->stride, dst_trans->layer_stride,
-                    0, 0, 0,
-                    src_box->width, src_box->height, src_box->depth,
-                    src_map,
-                    src_trans->stride, src_trans->layer_stride,
-                    0, 0, 0);
+      llvmpipe_copy_box(pipe, dst_map,
+                        src_format,
+                        dst_trans->stride, dst_trans->layer_stride,
+                        0, 0, 0,
+                        src_box->width, src_box->height, src_box->depth,
+                        src_map,
+                        src_trans->stride, src_trans->layer_stride,
+                        0, 0, 0);
       pipe->texture_unmap(pipe, dst_trans);
       pipe->texture_unmap(pipe, src_trans);
    }
@@ -111,8 +550,77 @@ lp_resource_copy(struct pipe_context *pipe,
                           src, src_level, src_box);
       return;
    }
-   util_resource_copy_region(pipe, dst, dst_level, dstx, dsty, dstz,
-                             src, src_level, src_box);
+   util_resource_copy_region_with_copy_box(pipe, dst, dst_level,
+                                           dstx, dsty, dstz,
+                                           src, src_level, src_box,
+                                           llvmpipe_copy_box);
+}
+
+
+static void
+lp_image_copy_buffer(struct pipe_context *pipe,
+                     struct pipe_resource *dst,
+                     struct pipe_resource *src,
+                     unsigned buffer_offset,
+                     unsigned buffer_stride,
+                     unsigned buffer_layer_stride,
+                     unsigned level,
+                     const struct pipe_box *box)
+{
+   const bool to_buffer = dst->target == PIPE_BUFFER;
+   struct pipe_resource *buffer = to_buffer ? dst : src;
+   struct pipe_resource *image = to_buffer ? src : dst;
+   const enum pipe_format format = image->format;
+   const unsigned rows = util_format_get_nblocksy(format, box->height);
+   const unsigned row_size = util_format_get_stride(format, box->width);
+
+   if (!buffer_stride)
+      buffer_stride = row_size;
+   if (!buffer_layer_stride)
+      buffer_layer_stride = buffer_stride * rows;
+
+   struct pipe_box buffer_box;
+   u_box_1d(buffer_offset,
+            (box->depth - 1) * buffer_layer_stride +
+            (rows - 1) * buffer_stride + row_size,
+            &buffer_box);
+
+   struct pipe_transfer *buffer_trans, *image_trans;
+   uint8_t *buffer_map =
+      pipe->buffer_map(pipe, buffer, 0,
+                       to_buffer ? PIPE_MAP_WRITE | PIPE_MAP_DISCARD_RANGE :
+                                   PIPE_MAP_READ,
+                       &buffer_box, &buffer_trans);
+   if (!buffer_map)
+      return;
+
+   uint8_t *image_map =
+      pipe->texture_map(pipe, image, level,
+                        to_buffer ? PIPE_MAP_READ :
+                                    PIPE_MAP_WRITE | PIPE_MAP_DISCARD_RANGE,
+                        box, &image_trans);
+   if (!image_map) {
+      pipe->buffer_unmap(pipe, buffer_trans);
+      return;
+   }
+
+   if (to_buffer) {
+      llvmpipe_copy_box(pipe, buffer_map, format,
+                        buffer_stride, buffer_layer_stride, 0, 0, 0,
+                        box->width, box->height, box->depth,
+                        image_map, image_trans->stride,
+                        image_trans->layer_stride, 0, 0, 0);
+   } else {
+      llvmpipe_copy_box(pipe, image_map, format,
+                        image_trans->stride, image_trans->layer_stride,
+                        0, 0, 0,
+                        box->width, box->height, box->depth,
+                        buffer_map, buffer_stride, buffer_layer_stride,
+                        0, 0, 0);
+   }
+
+   pipe->texture_unmap(pipe, image_trans);
+   pipe->buffer_unmap(pipe, buffer_trans);
 }
 
 
@@ -137,14 +645,17 @@ lp_blit(struct pipe_context *pipe,
        blit_info->src.resource->nr_samples > 1 &&
        blit_info->dst.resource->nr_samples < 2 &&
        blit_info->sample0_only) {
-      util_resource_copy_region(pipe, blit_info->dst.resource,
-                                blit_info->dst.level, blit_info->dst.box.x,
-                                blit_info->dst.box.y, blit_info->dst.box.z,
-                                blit_info->src.resource, blit_info->src.level,
-                                &blit_info->src.box);
+      lp_resource_copy(pipe, blit_info->dst.resource,
+                       blit_info->dst.level, blit_info->dst.box.x,
+                       blit_info->dst.box.y, blit_info->dst.box.z,
+                       blit_info->src.resource, blit_info->src.level,
+                       &blit_info->src.box);
       return;
    }
 
+   if (lp_blit_split(pipe, blit_info))
+      return;
+
    if (!util_blitter_is_blit_supported(lp->blitter, &info)) {
       debug_printf("llvmpipe: blit unsupported %s -> %s\n",
                    util_format_short_name(info.src.resource->format),
@@ -278,7 +789,8 @@ llvmpipe_get_sample_position(struct pipe_context *pipe,
 
 
 static void
-lp_clear_color_texture_helper(struct pipe_transfer *dst_trans,
+lp_clear_color_texture_helper(struct pipe_context *pipe,
+                              struct pipe_transfer *dst_trans,
                               uint8_t *dst_map,
                               enum pipe_format format,
                               const union pipe_color_union *color,
@@ -291,9 +803,9 @@ lp_clear_color_texture_helper(struct pipe_transfer *dst_trans,
 
    util_pack_color_union(format, &uc, color);
 
-   util_fill_box(dst_map, format,
-                 dst_trans->stride, dst_trans->layer_stride,
-                 0, 0, 0, width, height, depth, &uc);
+   llvmpipe_fill_box(pipe, dst_map, format,
+                     dst_trans->stride, dst_trans->layer_stride,
+                     0, 0, 0, width, height, depth, &uc);
 }
 
 
@@ -314,7 +826,7 @@ lp_clear_color_texture_msaa(struct pipe_context *pipe,
       return;
 
    if (dst_trans->stride > 0) {
-      lp_clear_color_texture_helper(dst_trans, dst_map, format, color,
+      lp_clear_color_texture_helper(pipe, dst_trans, dst_map, format, color,
                                     box->width, box->height, box->depth);
    }
    pipe->texture_unmap(pipe, dst_trans);
@@ -439,11 +951,30 @@ llvmpipe_clear_texture(struct pipe_context *pipe,
 {
    const struct util_format_description *desc =
           util_format_description(tex->format);
+   union pipe_color_union color;
+
    if (tex->nr_samples <= 1) {
-      util_clear_texture_sw(pipe, tex, level, box, data);
+      if (util_format_is_depth_or_stencil(tex->format) ||
+          util_format_is_int64(desc) || level > tex->last_level) {
+         util_clear_texture_sw(pipe, tex, level, box, data);
+         return;
+      }
+
+      struct pipe_transfer *dst_trans;
+      uint8_t *dst_map = pipe->texture_map(pipe, tex, level, PIPE_MAP_WRITE,
+                                           box, &dst_trans);
+      if (!dst_map)
+         return;
+
+      if (dst_trans->stride > 0) {
+         util_format_unpack_rgba(tex->format, color.ui, data, 1);
+         lp_clear_color_texture_helper(pipe, dst_trans, dst_map, tex->format,
+                                       &color, box->width, box->height,
+                                       box->depth);
+      }
+      pipe->texture_unmap(pipe, dst_trans);
       return;
    }
-   union pipe_color_union color;
 
    if (util_format_is_depth_or_stencil(tex->format)) {
       unsigned clear = 0;
@@ -491,19 +1022,17 @@ llvmpipe_clear_buffer(struct pipe_context *pipe,
    u_box_1d(offset, size, &box);
 
    char *dst = pipe->buffer_map(pipe, res, 0, PIPE_MAP_WRITE, &box, &dst_t);
+   if (!dst)
+      return;
+
+   struct lp_transfer_linear lin = {
+      .dst = (uint8_t *)dst,
+      .value = clear_value,
+      .value_size = clear_value_size,
+      .size = size,
+   };
+   lp_transfer_linear(pipe, lp_fill_linear_chunk, &lin);
 
-   switch (clear_value_size) {
-   case 1:
-      memset(dst, *(uint8_t *)clear_value, size);
-      break;
-   case 4:
-      util_memset32(dst, *(uint32_t *)clear_value, size / 4);
-      break;
-   default:
-      for (unsigned i = 0; i < size; i += clear_value_size)
-         memcpy(&dst[i], clear_value, clear_value_size);
-      break;
-   }
    pipe->buffer_unmap(pipe, dst_t);
 }
 
@@ -519,6 +1048,7 @@ llvmpipe_init_surface_functions(struct llvmpipe_context *lp)
    lp->pipe.clear_texture = llvmpipe_clear_texture;
    lp->pipe.clear_buffer = llvmpipe_clear_buffer;
    lp->pipe.resource_copy_region = lp_resource_copy;
+   lp->pipe.image_copy_buffer = lp_image_copy_buffer;
    lp->pipe.blit = lp_blit;
    lp->pipe.flush_resource = lp_flush_resource;
    lp->pipe.get_sample_position = llvmpipe_get_sample_position;
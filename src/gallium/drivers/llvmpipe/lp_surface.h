@@ -32,11 +32,44 @@
 #define LP_SURFACE_H
 
 
+#include <stdint.h>
+
+#include "util/format/u_formats.h"
+
 struct llvmpipe_context;
+struct pipe_context;
+union util_color;
 
 
 extern void
 llvmpipe_init_surface_functions(struct llvmpipe_context *lp);
 
 
+/**
+ * Same as util_copy_box(), but large copies are split into bands of rows
+ * and layers, or linear chunks for a single row, which run on the cs
+ * thread pool.  Usable as a util_copy_box_func.
+ */
+void
+llvmpipe_copy_box(struct pipe_context *pipe,
+                  uint8_t *dst, enum pipe_format format,
+                  unsigned dst_stride, uint64_t dst_slice_stride,
+                  unsigned dst_x, unsigned dst_y, unsigned dst_z,
+                  unsigned width, unsigned height, unsigned depth,
+                  const uint8_t *src,
+                  int src_stride, uint64_t src_slice_stride,
+                  unsigned src_x, unsigned src_y, unsigned src_z);
+
+/**
+ * Same as util_fill_box(), but large fills run on the cs thread pool.
+ */
+void
+llvmpipe_fill_box(struct pipe_context *pipe,
+                  uint8_t *dst, enum pipe_format format,
+                  unsigned stride, uintptr_t layer_stride,
+                  unsigned x, unsigned y, unsigned z,
+                  unsigned width, unsigned height, unsigned depth,
+                  union util_color *uc);
+
+
 #endif /* LP_SURFACE_H */
@@ -0,0 +1,259 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @file
+ * Unit test and benchmark for the work-stealing bin scheduler.
+ *
+ * A synthetic scene with a few very expensive tiles is rasterized by
+ * 1..N threads which only burn cycles proportional to each bin's cost.
+ * We check that every non-empty bin is handed out exactly once and report
+ * tiles/s for the scheduler alongside the old mutex + raster order walk.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "util/os_time.h"
+#include "util/u_atomic.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_thread.h"
+
+#include "lp_bin_sched.h"
+#include "lp_limits.h"
+#include "lp_scene.h"
+#include "lp_test.h"
+
+
+#define SCENE_TILES_X 32
+#define SCENE_TILES_Y 32
+#define NUM_BINS (SCENE_TILES_X * SCENE_TILES_Y)
+
+
+struct bin_sched_test {
+   struct cmd_bin bins[NUM_BINS];
+   unsigned visited[NUM_BINS];
+
+   struct lp_bin_sched sched;
+   bool use_mutex;
+
+   /* baseline: the old lp_scene_bin_iter_next() */
+   mtx_t mutex;
+   unsigned curr;
+
+   util_barrier barrier;
+};
+
+
+struct bin_sched_thread {
+   struct bin_sched_test *test;
+   unsigned index;
+   thrd_t handle;
+};
+
+
+static struct cmd_block dummy_block;
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "result\t"
+           "scheduler\t"
+           "threads\t"
+           "tiles_per_sec\n");
+
+   fflush(fp);
+}
+
+
+/** Pretend to rasterize a bin. */
+static void
+burn(unsigned cost)
+{
+   volatile unsigned x = 0;
+   for (unsigned i = 0; i < cost * 64; i++)
+      x += i;
+}
+
+
+static bool
+next_bin_mutex(struct bin_sched_test *test, unsigned *idx)
+{
+   bool ret = false;
+
+   mtx_lock(&test->mutex);
+   if (test->curr < NUM_BINS) {
+      *idx = test->curr++;
+      ret = true;
+   }
+   mtx_unlock(&test->mutex);
+
+   return ret;
+}
+
+
+static int
+thread_func(void *data)
+{
+   struct bin_sched_thread *thread = data;
+   struct bin_sched_test *test = thread->test;
+   unsigned idx;
+
+   util_barrier_wait(&test->barrier);
+
+   if (test->use_mutex) {
+      while (next_bin_mutex(test, &idx)) {
+         if (test->bins[idx].head) {
+            p_atomic_inc(&test->visited[idx]);
+            burn(test->bins[idx].cost);
+         }
+      }
+   } else {
+      while (lp_bin_sched_next(&test->sched, thread->index, &idx)) {
+         p_atomic_inc(&test->visited[idx]);
+         burn(test->bins[idx].cost);
+      }
+   }
+
+   return 0;
+}
+
+
+static void
+init_bins(struct bin_sched_test *test)
+{
+   for (unsigned y = 0; y < SCENE_TILES_Y; y++) {
+      for (unsigned x = 0; x < SCENE_TILES_X; x++) {
+         struct cmd_bin *bin = &test->bins[y * SCENE_TILES_X + x];
+
+         /* Leave a band of empty bins, put heavy overdraw in one corner. */
+         if (x == SCENE_TILES_X / 2) {
+            bin->head = NULL;
+            bin->cost = 0;
+         } else {
+            bin->head = &dummy_block;
+            bin->cost = (x < 4 && y < 4) ? 2000 : 20 + (rand() % 20);
+         }
+      }
+   }
+}
+
+
+static bool
+test_bin_sched(unsigned verbose, FILE *fp,
+               unsigned num_threads, bool use_mutex)
+{
+   struct bin_sched_test *test = CALLOC_STRUCT(bin_sched_test);
+   struct bin_sched_thread *threads = CALLOC(num_threads, sizeof *threads);
+   bool success = true;
+   unsigned num_tiles = 0;
+
+   if (!test || !threads) {
+      FREE(threads);
+      FREE(test);
+      return false;
+   }
+
+   init_bins(test);
+   test->use_mutex = use_mutex;
+   (void) mtx_init(&test->mutex, mtx_plain);
+   util_barrier_init(&test->barrier, num_threads + 1);
+
+   if (!lp_bin_sched_init(&test->sched, num_threads) ||
+       !lp_bin_sched_reserve(&test->sched, NUM_BINS)) {
+      success = false;
+      goto out;
+   }
+
+   lp_bin_sched_begin(&test->sched, test->bins,
+                      SCENE_TILES_X, SCENE_TILES_Y, num_threads);
+
+   for (unsigned i = 0; i < num_threads; i++) {
+      threads[i].test = test;
+      threads[i].index = i;
+      if (u_thread_create(&threads[i].handle, thread_func, &threads[i]) !=
+          thrd_success) {
+         fprintf(stderr, "failed to create thread %u\n", i);
+         abort();
+      }
+   }
+
+   int64_t start = os_time_get_nano();
+   util_barrier_wait(&test->barrier);
+   for (unsigned i = 0; i < num_threads; i++)
+      thrd_join(threads[i].handle, NULL);
+   int64_t end = os_time_get_nano();
+
+   for (unsigned i = 0; i < NUM_BINS; i++) {
+      unsigned expected = test->bins[i].head ? 1 : 0;
+      if (test->visited[i] != expected) {
+         fprintf(stderr, "bin %u visited %u times, expected %u\n",
+                 i, test->visited[i], expected);
+         success = false;
+      }
+      num_tiles += expected;
+   }
+
+   double tiles_per_sec = num_tiles / ((end - start) * 1e-9);
+
+   if (verbose || !success) {
+      printf("%s: %-6s %2u threads: %10.0f tiles/s\n",
+             success ? "PASS" : "FAIL",
+             use_mutex ? "mutex" : "sched",
+             num_threads, tiles_per_sec);
+      fflush(stdout);
+   }
+
+   if (fp) {
+      fprintf(fp, "%s\t%s\t%u\t%f\n",
+              success ? "pass" : "fail",
+              use_mutex ? "mutex" : "sched",
+              num_threads, tiles_per_sec);
+      fflush(fp);
+   }
+
+out:
+   lp_bin_sched_destroy(&test->sched);
+   util_barrier_destroy(&test->barrier);
+   mtx_destroy(&test->mutex);
+   FREE(threads);
+   FREE(test);
+   return success;
+}
+
+
+bool
+test_all(unsigned verbose, FILE *fp)
+{
+   unsigned max_threads = MIN2(util_get_cpu_caps()->nr_cpus, LP_MAX_THREADS);
+   bool success = true;
+
+   /* 1, 2, 4, ... threads, always finishing with max_threads */
+   for (unsigned n = 1;; n = MIN2(n * 2, max_threads)) {
+      success &= test_bin_sched(verbose, fp, n, true);
+      success &= test_bin_sched(verbose, fp, n, false);
+      if (n == max_threads)
+         break;
+   }
+
+   return success;
+}
+
+
+bool
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   return test_all(verbose, fp);
+}
+
+
+bool
+test_single(unsigned verbose, FILE *fp)
+{
+   return test_bin_sched(verbose, fp, 1, false);
+}
@@ -0,0 +1,263 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @file
+ * Unit test for pipe_context::set_dynamic_state.
+ *
+ * Draws a quad with a stencil test for several sets of stencil compare
+ * and write masks, checking the color and stencil values written.  With
+ * PIPE_DYNAMIC_STENCIL_MASKS the same fragment shader variant must serve
+ * every set, which shows in the "avoided" JIT counter.  The test is run on
+ * the llvmpipe context and on one wrapped by the trace driver, which has to
+ * forward the hook.
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pipe/p_context.h"
+#include "pipe/p_defines.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+#include "util/u_atomic.h"
+#include "util/u_draw.h"
+#include "util/u_inlines.h"
+#include "util/u_memory.h"
+#include "driver_trace/tr_public.h"
+#include "frontend/sw_winsys.h"
+#include "sw/null/null_sw_winsys.h"
+
+#include "lp_perf.h"
+#include "lp_public.h"
+#include "lp_test.h"
+#include "lp_test_render.h"
+
+
+#define SIZE 64
+#define CLEAR_STENCIL 0x5a
+#define STENCIL_REF 0x0a
+
+
+struct mask_set {
+   uint8_t valuemask;
+   uint8_t writemask;
+};
+
+static const struct mask_set mask_sets[] = {
+   { 0x0f, 0xff },
+   { 0xff, 0x0f },
+   { 0x03, 0xf0 },
+   { 0xf0, 0x3c },
+};
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "result\t"
+           "screen\t"
+           "dynamic\t"
+           "avoided\n");
+
+   fflush(fp);
+}
+
+
+/**
+ * Draw a quad covering the framebuffer with the given stencil masks and
+ * check the center pixel.
+ */
+static bool
+draw_masks(struct lp_test_target *target, const struct mask_set *masks)
+{
+   struct pipe_context *pipe = target->pipe;
+   struct pipe_depth_stencil_alpha_state dsa;
+   struct pipe_transfer *transfer;
+   void *dsa_cso;
+
+   memset(&dsa, 0, sizeof dsa);
+   dsa.stencil[0].enabled = 1;
+   dsa.stencil[0].func = PIPE_FUNC_EQUAL;
+   dsa.stencil[0].fail_op = PIPE_STENCIL_OP_KEEP;
+   dsa.stencil[0].zfail_op = PIPE_STENCIL_OP_KEEP;
+   dsa.stencil[0].zpass_op = PIPE_STENCIL_OP_REPLACE;
+   dsa.stencil[0].valuemask = masks->valuemask;
+   dsa.stencil[0].writemask = masks->writemask;
+   dsa_cso = pipe->create_depth_stencil_alpha_state(pipe, &dsa);
+   pipe->bind_depth_stencil_alpha_state(pipe, dsa_cso);
+
+   union pipe_color_union clear_color = { .f = { 0.0f, 0.0f, 0.0f, 0.0f } };
+   pipe->clear(pipe, PIPE_CLEAR_COLOR0 | PIPE_CLEAR_DEPTHSTENCIL, NULL,
+               &clear_color, 1.0, CLEAR_STENCIL);
+
+   util_draw_arrays(pipe, MESA_PRIM_TRIANGLES, 0, 6);
+   lp_test_finish(pipe);
+
+   pipe->bind_depth_stencil_alpha_state(pipe, NULL);
+   pipe->delete_depth_stencil_alpha_state(pipe, dsa_cso);
+
+   const bool pass =
+      ((STENCIL_REF ^ CLEAR_STENCIL) & masks->valuemask) == 0;
+   const uint32_t expected_color = pass ? 0xffffffff : 0;
+   const uint8_t expected_stencil = pass ?
+      (CLEAR_STENCIL & ~masks->writemask) | (STENCIL_REF & masks->writemask) :
+      CLEAR_STENCIL;
+
+   uint32_t color = 0, zs = 0;
+   const uint32_t *map =
+      pipe_texture_map(pipe, target->cbuf, 0, 0, PIPE_MAP_READ,
+                       SIZE / 2, SIZE / 2, 1, 1, &transfer);
+   if (map) {
+      color = *map;
+      pipe_texture_unmap(pipe, transfer);
+   }
+
+   map = pipe_texture_map(pipe, target->zsbuf, 0, 0, PIPE_MAP_READ,
+                          SIZE / 2, SIZE / 2, 1, 1, &transfer);
+   if (map) {
+      zs = *map;
+      pipe_texture_unmap(pipe, transfer);
+   }
+
+   /* Z24_UNORM_S8_UINT keeps the stencil in the top byte */
+   const uint8_t stencil = zs >> 24;
+   if (color != expected_color || stencil != expected_stencil) {
+      printf("masks 0x%02x/0x%02x: color 0x%08x, stencil 0x%02x, "
+             "expected 0x%08x, 0x%02x\n",
+             masks->valuemask, masks->writemask, color, stencil,
+             expected_color, expected_stencil);
+      return false;
+   }
+
+   return true;
+}
+
+
+static bool
+test_dynamic_state(unsigned verbose, FILE *fp, struct pipe_screen *screen,
+                   const char *screen_name, bool dynamic)
+{
+   struct lp_test_target target;
+   bool success = true;
+
+   static const float corners[6][2] = {
+      { -1, -1 }, { 1, -1 }, { 1, 1 },
+      { -1, -1 }, { 1, 1 }, { -1, 1 },
+   };
+   struct lp_test_vertex verts[6];
+   for (unsigned i = 0; i < 6; i++) {
+      verts[i] = (struct lp_test_vertex) {
+         .pos = { corners[i][0], corners[i][1], 0.0f, 1.0f },
+         .color = { 1.0f, 1.0f, 1.0f, 1.0f },
+      };
+   }
+
+   if (!lp_test_target_init(&target, screen, 0, SIZE,
+                            PIPE_FORMAT_B8G8R8A8_UNORM,
+                            PIPE_FORMAT_Z24_UNORM_S8_UINT, verts))
+      return false;
+
+   struct pipe_context *pipe = target.pipe;
+
+   if (dynamic) {
+      if (!pipe->set_dynamic_state) {
+         printf("%s: no set_dynamic_state\n", screen_name);
+         lp_test_target_fini(&target);
+         return false;
+      }
+      pipe->set_dynamic_state(pipe, PIPE_DYNAMIC_STENCIL_MASKS);
+   }
+
+   struct pipe_stencil_ref ref = { .ref_value = { STENCIL_REF, STENCIL_REF } };
+   pipe->set_stencil_ref(pipe, ref);
+
+   const uint64_t avoided_before = p_atomic_read(&lp_jit_count[LP_JIT_FS].avoided);
+
+   for (unsigned i = 0; i < ARRAY_SIZE(mask_sets); i++)
+      success &= draw_masks(&target, &mask_sets[i]);
+
+   const uint64_t avoided =
+      p_atomic_read(&lp_jit_count[LP_JIT_FS].avoided) - avoided_before;
+
+   /* Every set but the first is served by the same variant */
+   const uint64_t expected_avoided = dynamic ? ARRAY_SIZE(mask_sets) - 1 : 0;
+   if (avoided != expected_avoided) {
+      printf("%s: %" PRIu64 " variants avoided, expected %" PRIu64 "\n",
+             screen_name, avoided, expected_avoided);
+      success = false;
+   }
+
+   if (verbose || !success) {
+      printf("%s: %s, %s masks, %" PRIu64 " variants avoided\n",
+             success ? "PASS" : "FAIL", screen_name,
+             dynamic ? "dynamic" : "static", avoided);
+      fflush(stdout);
+   }
+
+   if (fp) {
+      fprintf(fp, "%s\t%s\t%u\t%" PRIu64 "\n",
+              success ? "pass" : "fail", screen_name, dynamic, avoided);
+      fflush(fp);
+   }
+
+   lp_test_target_fini(&target);
+   return success;
+}
+
+
+bool
+test_all(unsigned verbose, FILE *fp)
+{
+   struct sw_winsys *winsys;
+   struct pipe_screen *screen, *trace_screen;
+   bool success = true;
+
+   /* Enables the trace driver, without keeping the trace */
+   setenv("GALLIUM_TRACE", "/dev/null", 0);
+
+   winsys = null_sw_create();
+   if (!winsys)
+      return false;
+
+   screen = llvmpipe_create_screen(winsys);
+   if (!screen) {
+      winsys->destroy(winsys);
+      return false;
+   }
+
+   success &= test_dynamic_state(verbose, fp, screen, "llvmpipe", false);
+   success &= test_dynamic_state(verbose, fp, screen, "llvmpipe", true);
+
+   /* Takes over the llvmpipe screen when it wraps it */
+   trace_screen = trace_screen_create(screen);
+   if (trace_screen != screen) {
+      success &= test_dynamic_state(verbose, fp, trace_screen, "trace", true);
+   } else {
+      printf("trace driver not enabled, skipping\n");
+   }
+
+   trace_screen->destroy(trace_screen);
+   winsys->destroy(winsys);
+   return success;
+}
+
+
+bool
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   return test_all(verbose, fp);
+}
+
+
+bool
+test_single(unsigned verbose, FILE *fp)
+{
+   return test_all(verbose, fp);
+}
@@ -0,0 +1,326 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @file
+ * Unit test and benchmark for hierarchical Z culling.
+ *
+ * Draws layers of opaque, slightly slanted quads with a LESS depth test
+ * front to back, back to front and in random order, with some depth
+ * writes using an ALWAYS test in the middle so the known depth has to be
+ * dropped again.  The color and depth buffers must match the ones
+ * rendered with LP_PERF=no_hiz bit for bit.  The time to draw and
+ * rasterize is reported for both.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pipe/p_context.h"
+#include "pipe/p_defines.h"
+#include "pipe/p_screen.h"
+#include "util/format/u_format.h"
+#include "util/os_time.h"
+#include "util/u_draw.h"
+#include "util/u_memory.h"
+#include "frontend/sw_winsys.h"
+#include "sw/null/null_sw_winsys.h"
+
+#include "lp_debug.h"
+#include "lp_public.h"
+#include "lp_test.h"
+#include "lp_test_render.h"
+
+
+enum draw_order {
+   FRONT_TO_BACK,
+   BACK_TO_FRONT,
+   RANDOM_ORDER,
+};
+
+static const char *order_names[] = {
+   [FRONT_TO_BACK] = "front_to_back",
+   [BACK_TO_FRONT] = "back_to_front",
+   [RANDOM_ORDER] = "random",
+};
+
+static const unsigned sizes[] = { 256, 1024 };
+
+static const enum pipe_format zs_formats[] = {
+   PIPE_FORMAT_Z16_UNORM,
+   PIPE_FORMAT_Z24_UNORM_S8_UINT,
+   PIPE_FORMAT_Z32_FLOAT,
+};
+
+static const unsigned layer_counts[] = { 16, 128 };
+
+/** Quads drawn with an ALWAYS depth test between the two halves */
+#define NUM_ALWAYS_QUADS 4
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "result\t"
+           "size\t"
+           "format\t"
+           "layers\t"
+           "order\t"
+           "hiz_ms\t"
+           "no_hiz_ms\n");
+
+   fflush(fp);
+}
+
+
+static void
+make_quad(struct lp_test_vertex *verts, unsigned *seed, float z, float size)
+{
+   const float x0 = (lp_test_rnd(seed) - 0.5f) * (2.0f - size) - size * 0.5f;
+   const float y0 = (lp_test_rnd(seed) - 0.5f) * (2.0f - size) - size * 0.5f;
+   const float x1 = x0 + size, y1 = y0 + size;
+   const float slant = (lp_test_rnd(seed) - 0.5f) * 0.05f;
+   const float color[4] = {
+      lp_test_rnd(seed), lp_test_rnd(seed), lp_test_rnd(seed), 1.0f
+   };
+   const float corners[6][2] = {
+      { x0, y0 }, { x1, y0 }, { x0, y1 },
+      { x0, y1 }, { x1, y0 }, { x1, y1 },
+   };
+
+   for (unsigned v = 0; v < 6; v++) {
+      verts[v].pos[0] = corners[v][0];
+      verts[v].pos[1] = corners[v][1];
+      verts[v].pos[2] = z + slant * corners[v][0];
+      verts[v].pos[3] = 1.0f;
+      memcpy(verts[v].color, color, sizeof color);
+   }
+}
+
+
+/**
+ * Two quads per layer, the first num_layers go in with a LESS test, then
+ * NUM_ALWAYS_QUADS with ALWAYS, then the remaining num_layers.
+ */
+static struct lp_test_vertex *
+make_vertices(unsigned num_layers, enum draw_order order)
+{
+   const unsigned num_quads = 2 * num_layers + NUM_ALWAYS_QUADS;
+   struct lp_test_vertex *verts = MALLOC(num_quads * 6 * sizeof *verts);
+   unsigned seed = 1;
+
+   if (!verts)
+      return NULL;
+
+   for (unsigned i = 0; i < 2 * num_layers; i++) {
+      const unsigned q = i < num_layers ? i : i + NUM_ALWAYS_QUADS;
+      const unsigned layer = i % num_layers;
+      float z;
+
+      switch (order) {
+      case FRONT_TO_BACK:
+         z = -0.9f + 1.8f * layer / num_layers;
+         break;
+      case BACK_TO_FRONT:
+         z = 0.9f - 1.8f * layer / num_layers;
+         break;
+      default:
+         z = -0.9f + 1.8f * lp_test_rnd(&seed);
+         break;
+      }
+
+      make_quad(&verts[q * 6], &seed, z, 1.2f + lp_test_rnd(&seed) * 0.8f);
+   }
+
+   /* Far away quads, which push the depth buffer back */
+   for (unsigned i = 0; i < NUM_ALWAYS_QUADS; i++)
+      make_quad(&verts[(num_layers + i) * 6], &seed, 0.95f, 1.0f);
+
+   return verts;
+}
+
+
+static void
+draw_scene(struct pipe_context *pipe, void *less_cso, void *always_cso,
+           unsigned num_layers)
+{
+   union pipe_color_union clear_color = { .f = { 0.0f, 0.0f, 0.0f, 0.0f } };
+
+   pipe->clear(pipe, PIPE_CLEAR_COLOR0 | PIPE_CLEAR_DEPTHSTENCIL, NULL,
+               &clear_color, 1.0, 0);
+   pipe->bind_depth_stencil_alpha_state(pipe, less_cso);
+   util_draw_arrays(pipe, MESA_PRIM_TRIANGLES, 0, num_layers * 6);
+   pipe->bind_depth_stencil_alpha_state(pipe, always_cso);
+   util_draw_arrays(pipe, MESA_PRIM_TRIANGLES, num_layers * 6,
+                    NUM_ALWAYS_QUADS * 6);
+   pipe->bind_depth_stencil_alpha_state(pipe, less_cso);
+   util_draw_arrays(pipe, MESA_PRIM_TRIANGLES,
+                    (num_layers + NUM_ALWAYS_QUADS) * 6, num_layers * 6);
+}
+
+
+/**
+ * Render the scene and return the color and depth buffer contents.
+ */
+static bool
+render(struct pipe_screen *screen, const struct lp_test_vertex *verts,
+       unsigned num_layers, unsigned size, enum pipe_format zs_format,
+       bool hiz, uint8_t **color, uint8_t **depth, double *total_ms)
+{
+   struct lp_test_target target;
+   struct pipe_depth_stencil_alpha_state dsa;
+   void *less_cso, *always_cso;
+   const int saved_perf = LP_PERF;
+
+   *color = *depth = NULL;
+
+   if (!lp_test_target_init(&target, screen, 0, size,
+                            PIPE_FORMAT_B8G8R8A8_UNORM, zs_format, verts))
+      return false;
+
+   struct pipe_context *pipe = target.pipe;
+
+   memset(&dsa, 0, sizeof dsa);
+   dsa.depth_enabled = 1;
+   dsa.depth_writemask = 1;
+   dsa.depth_func = PIPE_FUNC_LESS;
+   less_cso = pipe->create_depth_stencil_alpha_state(pipe, &dsa);
+   dsa.depth_func = PIPE_FUNC_ALWAYS;
+   always_cso = pipe->create_depth_stencil_alpha_state(pipe, &dsa);
+
+   /* Checked when the scene starts rasterizing */
+   if (hiz)
+      LP_PERF &= ~PERF_NO_HIZ;
+   else
+      LP_PERF |= PERF_NO_HIZ;
+
+   /* Draw once so the shaders are compiled. */
+   draw_scene(pipe, less_cso, always_cso, num_layers);
+   lp_test_finish(pipe);
+
+   int64_t start = os_time_get_nano();
+   draw_scene(pipe, less_cso, always_cso, num_layers);
+   lp_test_finish(pipe);
+   int64_t end = os_time_get_nano();
+
+   LP_PERF = saved_perf;
+
+   *total_ms = (end - start) * 1e-6;
+
+   *color = lp_test_read_texture(pipe, target.cbuf);
+   *depth = lp_test_read_texture(pipe, target.zsbuf);
+
+   pipe->bind_depth_stencil_alpha_state(pipe, NULL);
+   pipe->delete_depth_stencil_alpha_state(pipe, less_cso);
+   pipe->delete_depth_stencil_alpha_state(pipe, always_cso);
+   lp_test_target_fini(&target);
+   return *color && *depth;
+}
+
+
+static bool
+test_hiz(unsigned verbose, FILE *fp, struct pipe_screen *screen,
+         unsigned size, enum pipe_format zs_format, unsigned num_layers,
+         enum draw_order order)
+{
+   const char *format_name = util_format_short_name(zs_format);
+   struct lp_test_vertex *verts = make_vertices(num_layers, order);
+   uint8_t *ref_color = NULL, *ref_depth = NULL, *color = NULL, *depth = NULL;
+   double hiz_ms = 0.0, no_hiz_ms = 0.0;
+   bool success = false;
+
+   if (!verts)
+      return false;
+
+   if (render(screen, verts, num_layers, size, zs_format, false,
+              &ref_color, &ref_depth, &no_hiz_ms) &&
+       render(screen, verts, num_layers, size, zs_format, true,
+              &color, &depth, &hiz_ms)) {
+      success =
+         memcmp(color, ref_color, size * size * 4) == 0 &&
+         memcmp(depth, ref_depth,
+                size * size * util_format_get_blocksize(zs_format)) == 0;
+   }
+
+   if (verbose || !success) {
+      printf("%s: %4ux%-4u %-14s %3u layers %-13s: %8.3f ms, no hiz %8.3f ms\n",
+             success ? "PASS" : "FAIL", size, size, format_name,
+             num_layers, order_names[order], hiz_ms, no_hiz_ms);
+      fflush(stdout);
+   }
+
+   if (fp) {
+      fprintf(fp, "%s\t%u\t%s\t%u\t%s\t%f\t%f\n",
+              success ? "pass" : "fail", size, format_name, num_layers,
+              order_names[order], hiz_ms, no_hiz_ms);
+      fflush(fp);
+   }
+
+   FREE(ref_color);
+   FREE(ref_depth);
+   FREE(color);
+   FREE(depth);
+   FREE(verts);
+   return success;
+}
+
+
+static bool
+run_tests(unsigned verbose, FILE *fp, bool single)
+{
+   struct sw_winsys *winsys;
+   struct pipe_screen *screen;
+   bool success = true;
+
+   winsys = null_sw_create();
+   if (!winsys)
+      return false;
+
+   screen = llvmpipe_create_screen(winsys);
+   if (!screen) {
+      winsys->destroy(winsys);
+      return false;
+   }
+
+   if (single) {
+      success = test_hiz(verbose, fp, screen, 512, PIPE_FORMAT_Z32_FLOAT,
+                         64, FRONT_TO_BACK);
+   } else {
+      for (unsigned s = 0; s < ARRAY_SIZE(sizes); s++)
+         for (unsigned f = 0; f < ARRAY_SIZE(zs_formats); f++)
+            for (unsigned l = 0; l < ARRAY_SIZE(layer_counts); l++)
+               for (unsigned o = 0; o < ARRAY_SIZE(order_names); o++)
+                  success &= test_hiz(verbose, fp, screen, sizes[s],
+                                      zs_formats[f], layer_counts[l], o);
+   }
+
+   screen->destroy(screen);
+   winsys->destroy(winsys);
+   return success;
+}
+
+
+bool
+test_all(unsigned verbose, FILE *fp)
+{
+   return run_tests(verbose, fp, false);
+}
+
+
+bool
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   return test_all(verbose, fp);
+}
+
+
+bool
+test_single(unsigned verbose, FILE *fp)
+{
+   return run_tests(verbose, fp, true);
+}
@@ -0,0 +1,396 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @file
+ * Unit test and benchmark for sharing the rasterizer between contexts.
+ *
+ * Measures the frame latency of a context drawing a small scene alone,
+ * and while another context keeps the rasterizer threads busy with large
+ * scenes, once at the default priority and once with the small scene's
+ * context at PIPE_CONTEXT_HIGH_PRIORITY.  The small scene must render the
+ * same every time.
+ *
+ * Also maps a texture that another context has rendered to without
+ * waiting, which must wait for that rendering (llvmpipe_flush_resource),
+ * and reports how long the map took.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "c11/threads.h"
+#include "pipe/p_context.h"
+#include "pipe/p_defines.h"
+#include "pipe/p_screen.h"
+#include "util/os_time.h"
+#include "util/u_atomic.h"
+#include "util/u_draw.h"
+#include "util/u_memory.h"
+#include "frontend/sw_winsys.h"
+#include "sw/null/null_sw_winsys.h"
+
+#include "lp_public.h"
+#include "lp_test.h"
+#include "lp_test_render.h"
+
+
+#define SMALL_SIZE 256
+#define SMALL_TRIS 64
+#define BIG_SIZE 1024
+#define BIG_TRIS 20000
+#define NUM_FRAMES 64
+
+
+enum load {
+   LOAD_NONE,
+   LOAD_BUSY,
+   LOAD_BUSY_HIGH_PRIORITY,
+   LOAD_COUNT,
+};
+
+static const char *load_names[LOAD_COUNT] = {
+   "alone",
+   "busy",
+   "busy_high_priority",
+};
+
+
+struct scene {
+   struct lp_test_target target;
+   void *blend_cso;
+   void *dsa_cso;
+   unsigned num_tris;
+};
+
+
+struct busy_scene {
+   struct scene scene;
+   thrd_t thread;
+   unsigned stop;
+   unsigned frames;
+};
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "result\t"
+           "load\t"
+           "median_ms\t"
+           "max_ms\t"
+           "busy_frames\n");
+
+   fflush(fp);
+}
+
+
+static bool
+scene_init(struct scene *scene, struct pipe_screen *screen,
+           unsigned context_flags, unsigned size,
+           const struct lp_test_vertex *verts, unsigned num_tris)
+{
+   struct pipe_depth_stencil_alpha_state dsa;
+
+   if (!lp_test_target_init(&scene->target, screen, context_flags, size,
+                            PIPE_FORMAT_B8G8R8A8_UNORM,
+                            PIPE_FORMAT_Z32_FLOAT, verts))
+      return false;
+
+   struct pipe_context *pipe = scene->target.pipe;
+
+   scene->blend_cso = lp_test_create_alpha_blend(pipe);
+   pipe->bind_blend_state(pipe, scene->blend_cso);
+
+   memset(&dsa, 0, sizeof dsa);
+   scene->dsa_cso = pipe->create_depth_stencil_alpha_state(pipe, &dsa);
+   pipe->bind_depth_stencil_alpha_state(pipe, scene->dsa_cso);
+
+   scene->num_tris = num_tris;
+   return true;
+}
+
+
+static void
+scene_fini(struct scene *scene)
+{
+   struct pipe_context *pipe = scene->target.pipe;
+
+   pipe->bind_depth_stencil_alpha_state(pipe, NULL);
+   pipe->delete_depth_stencil_alpha_state(pipe, scene->dsa_cso);
+   pipe->bind_blend_state(pipe, NULL);
+   pipe->delete_blend_state(pipe, scene->blend_cso);
+   lp_test_target_fini(&scene->target);
+}
+
+
+/**
+ * Draw and flush the scene, without waiting for it.
+ */
+static void
+scene_draw(struct scene *scene)
+{
+   struct pipe_context *pipe = scene->target.pipe;
+   union pipe_color_union clear_color = { .f = { 0.0f, 0.0f, 0.0f, 0.0f } };
+
+   pipe->clear(pipe, PIPE_CLEAR_COLOR0 | PIPE_CLEAR_DEPTH, NULL, &clear_color,
+               1.0, 0);
+   util_draw_arrays(pipe, MESA_PRIM_TRIANGLES, 0, scene->num_tris * 3);
+   pipe->flush(pipe, NULL, 0);
+}
+
+
+static int
+busy_thread(void *data)
+{
+   struct busy_scene *busy = data;
+
+   while (!p_atomic_read(&busy->stop)) {
+      scene_draw(&busy->scene);
+      lp_test_finish(busy->scene.target.pipe);
+      p_atomic_inc(&busy->frames);
+   }
+
+   return 0;
+}
+
+
+static int
+compare_ms(const void *a, const void *b)
+{
+   const double ms_a = *(const double *)a, ms_b = *(const double *)b;
+   return ms_a < ms_b ? -1 : ms_a > ms_b;
+}
+
+
+/**
+ * Time NUM_FRAMES frames of the small scene, each drawn and waited for,
+ * and return the final rendering.
+ */
+static uint8_t *
+measure_frames(struct scene *scene, double *median_ms, double *max_ms)
+{
+   struct pipe_context *pipe = scene->target.pipe;
+   double frame_ms[NUM_FRAMES];
+
+   for (unsigned i = 0; i < NUM_FRAMES; i++) {
+      int64_t start = os_time_get_nano();
+      scene_draw(scene);
+      lp_test_finish(pipe);
+      frame_ms[i] = (os_time_get_nano() - start) * 1e-6;
+   }
+
+   qsort(frame_ms, NUM_FRAMES, sizeof frame_ms[0], compare_ms);
+   *median_ms = frame_ms[NUM_FRAMES / 2];
+   *max_ms = frame_ms[NUM_FRAMES - 1];
+
+   return lp_test_read_texture(pipe, scene->target.cbuf);
+}
+
+
+static void
+report(unsigned verbose, FILE *fp, bool success, const char *name,
+       double median_ms, double max_ms, unsigned busy_frames)
+{
+   if (verbose || !success) {
+      printf("%s: %-18s: median %8.3f ms, max %8.3f ms, %4u busy frames\n",
+             success ? "PASS" : "FAIL", name, median_ms, max_ms,
+             busy_frames);
+      fflush(stdout);
+   }
+
+   if (fp) {
+      fprintf(fp, "%s\t%s\t%f\t%f\t%u\n",
+              success ? "pass" : "fail", name, median_ms, max_ms,
+              busy_frames);
+      fflush(fp);
+   }
+}
+
+
+/**
+ * Measure the small scene's frame latency under the given load.  With
+ * LOAD_NONE the rendering is returned in *ref, otherwise it is compared
+ * against it.
+ */
+static bool
+test_latency(unsigned verbose, FILE *fp, struct pipe_screen *screen,
+             enum load load, const struct lp_test_vertex *small_verts,
+             const struct lp_test_vertex *big_verts, uint8_t **ref)
+{
+   const unsigned flags =
+      load == LOAD_BUSY_HIGH_PRIORITY ? PIPE_CONTEXT_HIGH_PRIORITY : 0;
+   struct scene small;
+   struct busy_scene busy;
+   double median_ms = 0.0, max_ms = 0.0;
+   uint8_t *pixels;
+   bool success;
+
+   if (!scene_init(&small, screen, flags, SMALL_SIZE, small_verts,
+                   SMALL_TRIS))
+      return false;
+
+   /* Compile the shaders before anything is measured */
+   scene_draw(&small);
+   lp_test_finish(small.target.pipe);
+
+   memset(&busy, 0, sizeof busy);
+   if (load != LOAD_NONE) {
+      if (!scene_init(&busy.scene, screen, 0, BIG_SIZE, big_verts,
+                      BIG_TRIS)) {
+         scene_fini(&small);
+         return false;
+      }
+
+      if (thrd_create(&busy.thread, busy_thread, &busy) != thrd_success) {
+         scene_fini(&busy.scene);
+         scene_fini(&small);
+         return false;
+      }
+
+      /* Wait for the large scenes to be compiled and queued */
+      while (!p_atomic_read(&busy.frames))
+         os_time_sleep(1000);
+   }
+
+   pixels = measure_frames(&small, &median_ms, &max_ms);
+
+   if (load != LOAD_NONE) {
+      p_atomic_set(&busy.stop, 1);
+      thrd_join(busy.thread, NULL);
+      scene_fini(&busy.scene);
+   }
+   scene_fini(&small);
+
+   if (load == LOAD_NONE) {
+      success = pixels != NULL;
+      *ref = pixels;
+   } else {
+      success = pixels && *ref &&
+                memcmp(pixels, *ref, SMALL_SIZE * SMALL_SIZE * 4) == 0;
+      FREE(pixels);
+   }
+
+   report(verbose, fp, success, load_names[load], median_ms, max_ms,
+          busy.frames);
+   return success;
+}
+
+
+/**
+ * Map a texture from another context while its rendering is still in
+ * flight.  The map must wait for it.
+ */
+static bool
+test_flush_resource(unsigned verbose, FILE *fp, struct pipe_screen *screen,
+                    const struct lp_test_vertex *big_verts)
+{
+   struct scene writer, reader;
+   uint8_t *ref, *pixels;
+   bool success;
+
+   if (!scene_init(&writer, screen, 0, BIG_SIZE, big_verts, BIG_TRIS))
+      return false;
+   if (!scene_init(&reader, screen, 0, SMALL_SIZE, big_verts, SMALL_TRIS)) {
+      scene_fini(&writer);
+      return false;
+   }
+
+   struct pipe_context *pipe = writer.target.pipe;
+
+   scene_draw(&writer);
+   lp_test_finish(pipe);
+   ref = lp_test_read_texture(pipe, writer.target.cbuf);
+
+   /* Anything but what the scene renders */
+   union pipe_color_union clear_color = { .f = { 1.0f, 1.0f, 1.0f, 1.0f } };
+   pipe->clear(pipe, PIPE_CLEAR_COLOR0, NULL, &clear_color, 1.0, 0);
+   lp_test_finish(pipe);
+
+   scene_draw(&writer);
+
+   int64_t start = os_time_get_nano();
+   pixels = lp_test_read_texture(reader.target.pipe, writer.target.cbuf);
+   double map_ms = (os_time_get_nano() - start) * 1e-6;
+
+   success = ref && pixels &&
+             memcmp(pixels, ref, BIG_SIZE * BIG_SIZE * 4) == 0;
+
+   report(verbose, fp, success, "flush_resource", map_ms, map_ms, 0);
+
+   FREE(pixels);
+   FREE(ref);
+   scene_fini(&reader);
+   scene_fini(&writer);
+   return success;
+}
+
+
+static bool
+run_tests(unsigned verbose, FILE *fp, bool single)
+{
+   struct sw_winsys *winsys;
+   struct pipe_screen *screen;
+   struct lp_test_vertex *small_verts, *big_verts;
+   uint8_t *ref = NULL;
+   bool success = true;
+
+   winsys = null_sw_create();
+   if (!winsys)
+      return false;
+
+   screen = llvmpipe_create_screen(winsys);
+   if (!screen) {
+      winsys->destroy(winsys);
+      return false;
+   }
+
+   small_verts = lp_test_make_triangles(SMALL_TRIS, 0.1f, 0.5f);
+   big_verts = lp_test_make_triangles(BIG_TRIS, 0.3f, 0.8f);
+   if (!small_verts || !big_verts) {
+      success = false;
+      goto out;
+   }
+
+   success &= test_flush_resource(verbose, fp, screen, big_verts);
+
+   success &= test_latency(verbose, fp, screen, LOAD_NONE,
+                           small_verts, big_verts, &ref);
+   for (unsigned load = LOAD_BUSY; load < LOAD_COUNT && !single; load++)
+      success &= test_latency(verbose, fp, screen, load,
+                              small_verts, big_verts, &ref);
+
+out:
+   FREE(ref);
+   FREE(big_verts);
+   FREE(small_verts);
+   screen->destroy(screen);
+   winsys->destroy(winsys);
+   return success;
+}
+
+
+bool
+test_all(unsigned verbose, FILE *fp)
+{
+   return run_tests(verbose, fp, false);
+}
+
+
+bool
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   return test_all(verbose, fp);
+}
+
+
+bool
+test_single(unsigned verbose, FILE *fp)
+{
+   return run_tests(verbose, fp, true);
+}
@@ -0,0 +1,260 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <string.h>
+
+#include "pipe/p_defines.h"
+#include "pipe/p_state.h"
+#include "util/format/u_format.h"
+#include "util/u_inlines.h"
+#include "util/u_memory.h"
+#include "util/u_simple_shaders.h"
+
+#include "lp_test_render.h"
+
+
+float
+lp_test_rnd(unsigned *seed)
+{
+   *seed = *seed * 1103515245 + 12345;
+   return ((*seed >> 16) & 0x7fff) / 32767.0f;
+}
+
+
+/**
+ * Random, half transparent triangles, the same ones on every call.
+ * Sizes are in normalized device coordinates.
+ */
+struct lp_test_vertex *
+lp_test_make_triangles(unsigned num_tris, float min_size, float max_size)
+{
+   struct lp_test_vertex *verts = MALLOC(num_tris * 3 * sizeof *verts);
+   unsigned seed = 1;
+
+   if (!verts)
+      return NULL;
+
+   for (unsigned t = 0; t < num_tris; t++) {
+      float cx = lp_test_rnd(&seed) * 2.0f - 1.0f;
+      float cy = lp_test_rnd(&seed) * 2.0f - 1.0f;
+      float size = min_size + lp_test_rnd(&seed) * (max_size - min_size);
+      float color[4] = {
+         lp_test_rnd(&seed), lp_test_rnd(&seed), lp_test_rnd(&seed), 0.5f
+      };
+
+      for (unsigned v = 0; v < 3; v++) {
+         struct lp_test_vertex *vert = &verts[t * 3 + v];
+         vert->pos[0] = cx + (lp_test_rnd(&seed) - 0.5f) * size * 2.0f;
+         vert->pos[1] = cy + (lp_test_rnd(&seed) - 0.5f) * size * 2.0f;
+         vert->pos[2] = 0.0f;
+         vert->pos[3] = 1.0f;
+         memcpy(vert->color, color, sizeof color);
+      }
+   }
+
+   return verts;
+}
+
+
+/**
+ * Create a context with the given PIPE_CONTEXT_x flags, rendering to new
+ * size x size color and depth/stencil buffers, with everything but the
+ * blend and depth/stencil/alpha state bound.  verts must outlive the
+ * target.
+ */
+bool
+lp_test_target_init(struct lp_test_target *target,
+                    struct pipe_screen *screen,
+                    unsigned context_flags,
+                    unsigned size,
+                    enum pipe_format format,
+                    enum pipe_format zs_format,
+                    const struct lp_test_vertex *verts)
+{
+   struct pipe_context *pipe;
+   struct pipe_resource templ;
+   struct pipe_framebuffer_state fb;
+   struct pipe_rasterizer_state rast;
+   struct pipe_vertex_element ve[2];
+   struct pipe_vertex_buffer vbuf;
+   struct pipe_viewport_state vp;
+   const enum tgsi_semantic semantic_names[] =
+      { TGSI_SEMANTIC_POSITION, TGSI_SEMANTIC_COLOR };
+   const unsigned semantic_indexes[] = { 0, 0 };
+
+   memset(target, 0, sizeof *target);
+   target->size = size;
+
+   pipe = screen->context_create(screen, NULL, context_flags);
+   if (!pipe)
+      return false;
+   target->pipe = pipe;
+
+   memset(&templ, 0, sizeof templ);
+   templ.target = PIPE_TEXTURE_2D;
+   templ.format = format;
+   templ.width0 = size;
+   templ.height0 = size;
+   templ.depth0 = 1;
+   templ.array_size = 1;
+   templ.bind = PIPE_BIND_RENDER_TARGET;
+   target->cbuf = screen->resource_create(screen, &templ);
+
+   templ.format = zs_format;
+   templ.bind = PIPE_BIND_DEPTH_STENCIL;
+   target->zsbuf = screen->resource_create(screen, &templ);
+
+   if (!target->cbuf || !target->zsbuf) {
+      lp_test_target_fini(target);
+      return false;
+   }
+
+   memset(&fb, 0, sizeof fb);
+   fb.width = size;
+   fb.height = size;
+   fb.nr_cbufs = 1;
+   fb.cbufs[0].texture = target->cbuf;
+   fb.cbufs[0].format = format;
+   fb.zsbuf.texture = target->zsbuf;
+   fb.zsbuf.format = zs_format;
+   pipe->set_framebuffer_state(pipe, &fb);
+
+   memset(&rast, 0, sizeof rast);
+   rast.cull_face = PIPE_FACE_NONE;
+   rast.half_pixel_center = 1;
+   rast.bottom_edge_rule = 1;
+   rast.depth_clip_near = 1;
+   rast.depth_clip_far = 1;
+   target->rast_cso = pipe->create_rasterizer_state(pipe, &rast);
+   pipe->bind_rasterizer_state(pipe, target->rast_cso);
+
+   memset(&vp, 0, sizeof vp);
+   vp.scale[0] = size / 2.0f;
+   vp.scale[1] = size / 2.0f;
+   vp.scale[2] = 0.5f;
+   vp.translate[0] = size / 2.0f;
+   vp.translate[1] = size / 2.0f;
+   vp.translate[2] = 0.5f;
+   pipe->set_viewport_states(pipe, 0, 1, &vp);
+
+   memset(ve, 0, sizeof ve);
+   for (unsigned i = 0; i < 2; i++) {
+      ve[i].src_offset = i * 4 * sizeof(float);
+      ve[i].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+      ve[i].src_stride = sizeof(struct lp_test_vertex);
+   }
+   target->ve_cso = pipe->create_vertex_elements_state(pipe, 2, ve);
+   pipe->bind_vertex_elements_state(pipe, target->ve_cso);
+
+   target->vs = util_make_vertex_passthrough_shader(pipe, 2, semantic_names,
+                                                    semantic_indexes, false);
+   pipe->bind_vs_state(pipe, target->vs);
+   target->fs =
+      util_make_fragment_passthrough_shader(pipe, TGSI_SEMANTIC_COLOR,
+                                            TGSI_INTERPOLATE_PERSPECTIVE,
+                                            true);
+   pipe->bind_fs_state(pipe, target->fs);
+
+   memset(&vbuf, 0, sizeof vbuf);
+   vbuf.is_user_buffer = true;
+   vbuf.buffer.user = verts;
+   pipe->set_vertex_buffers(pipe, 1, &vbuf);
+
+   return true;
+}
+
+
+/**
+ * Destroy the context and the buffers.  The caller unbinds and deletes
+ * the state it created itself.
+ */
+void
+lp_test_target_fini(struct lp_test_target *target)
+{
+   struct pipe_context *pipe = target->pipe;
+
+   if (target->vs) {
+      pipe->bind_vs_state(pipe, NULL);
+      pipe->bind_fs_state(pipe, NULL);
+      pipe->delete_vs_state(pipe, target->vs);
+      pipe->delete_fs_state(pipe, target->fs);
+      pipe->delete_vertex_elements_state(pipe, target->ve_cso);
+      pipe->delete_rasterizer_state(pipe, target->rast_cso);
+
+      struct pipe_framebuffer_state fb;
+      memset(&fb, 0, sizeof fb);
+      pipe->set_framebuffer_state(pipe, &fb);
+   }
+
+   pipe_resource_reference(&target->zsbuf, NULL);
+   pipe_resource_reference(&target->cbuf, NULL);
+   pipe->destroy(pipe);
+   target->pipe = NULL;
+}
+
+
+/**
+ * Blend the triangles over each other so the result depends on the order
+ * they are drawn in, in every pixel.
+ */
+void *
+lp_test_create_alpha_blend(struct pipe_context *pipe)
+{
+   struct pipe_blend_state blend;
+
+   memset(&blend, 0, sizeof blend);
+   blend.rt[0].blend_enable = 1;
+   blend.rt[0].rgb_func = PIPE_BLEND_ADD;
+   blend.rt[0].rgb_src_factor = PIPE_BLENDFACTOR_SRC_ALPHA;
+   blend.rt[0].rgb_dst_factor = PIPE_BLENDFACTOR_INV_SRC_ALPHA;
+   blend.rt[0].alpha_func = PIPE_BLEND_ADD;
+   blend.rt[0].alpha_src_factor = PIPE_BLENDFACTOR_ONE;
+   blend.rt[0].alpha_dst_factor = PIPE_BLENDFACTOR_ONE;
+   blend.rt[0].colormask = PIPE_MASK_RGBA;
+   return pipe->create_blend_state(pipe, &blend);
+}
+
+
+/**
+ * Flush and wait for the rendering to finish.
+ */
+void
+lp_test_finish(struct pipe_context *pipe)
+{
+   struct pipe_screen *screen = pipe->screen;
+   struct pipe_fence_handle *fence = NULL;
+
+   pipe->flush(pipe, &fence, 0);
+   screen->fence_finish(screen, NULL, fence, OS_TIMEOUT_INFINITE);
+   screen->fence_reference(screen, &fence, NULL);
+}
+
+
+/**
+ * Copy out the first level of a 2D texture, with tightly packed rows.
+ */
+uint8_t *
+lp_test_read_texture(struct pipe_context *pipe, struct pipe_resource *tex)
+{
+   const unsigned row_size =
+      tex->width0 * util_format_get_blocksize(tex->format);
+   struct pipe_transfer *transfer;
+   uint8_t *pixels = NULL;
+
+   const uint8_t *map = pipe_texture_map(pipe, tex, 0, 0, PIPE_MAP_READ,
+                                         0, 0, tex->width0, tex->height0,
+                                         &transfer);
+   if (map) {
+      pixels = MALLOC(tex->height0 * row_size);
+      if (pixels) {
+         for (unsigned y = 0; y < tex->height0; y++)
+            memcpy(pixels + y * row_size, map + y * transfer->stride,
+                   row_size);
+      }
+      pipe_texture_unmap(pipe, transfer);
+   }
+
+   return pixels;
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @file
+ * Shared fixture of the tests that render through a whole llvmpipe
+ * context: a square color and depth/stencil buffer, and pass-through
+ * shaders drawing the position and color of struct lp_test_vertex.
+ */
+
+#ifndef LP_TEST_RENDER_H
+#define LP_TEST_RENDER_H
+
+
+#include <stdint.h>
+
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+
+
+struct lp_test_vertex {
+   float pos[4];
+   float color[4];
+};
+
+
+struct lp_test_target {
+   struct pipe_context *pipe;
+   struct pipe_resource *cbuf;
+   struct pipe_resource *zsbuf;
+   unsigned size;
+
+   void *rast_cso;
+   void *ve_cso;
+   void *vs;
+   void *fs;
+};
+
+
+float
+lp_test_rnd(unsigned *seed);
+
+
+struct lp_test_vertex *
+lp_test_make_triangles(unsigned num_tris, float min_size, float max_size);
+
+
+bool
+lp_test_target_init(struct lp_test_target *target,
+                    struct pipe_screen *screen,
+                    unsigned context_flags,
+                    unsigned size,
+                    enum pipe_format format,
+                    enum pipe_format zs_format,
+                    const struct lp_test_vertex *verts);
+
+
+void
+lp_test_target_fini(struct lp_test_target *target);
+
+
+void *
+lp_test_create_alpha_blend(struct pipe_context *pipe);
+
+
+void
+lp_test_finish(struct pipe_context *pipe);
+
+
+uint8_t *
+lp_test_read_texture(struct pipe_context *pipe, struct pipe_resource *tex);
+
+
+#endif /* !LP_TEST_RENDER_H */
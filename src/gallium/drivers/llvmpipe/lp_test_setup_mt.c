@@ -0,0 +1,227 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @file
+ * Unit test and benchmark for parallel binning (LP_BIN_THREADS).
+ *
+ * Draws a large list of overlapping, alpha-blended triangles with 0..N
+ * binner threads.  Blending makes the result depend on primitive order in
+ * every pixel, so the rendering must match the single threaded one bit for
+ * bit.  The time spent in draw_vbo (i.e. binning) is reported alongside.
+ *
+ * A depth buffer is bound, with depth testing off, as the linear
+ * rasterizer used for color-only framebuffers never bins in parallel.
+ * Every run with binner threads must have merged chunks binned by them.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pipe/p_context.h"
+#include "pipe/p_defines.h"
+#include "pipe/p_screen.h"
+#include "util/os_time.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_draw.h"
+#include "util/u_memory.h"
+#include "frontend/sw_winsys.h"
+#include "sw/null/null_sw_winsys.h"
+
+#include "lp_context.h"
+#include "lp_limits.h"
+#include "lp_public.h"
+#include "lp_screen.h"
+#include "lp_setup_context.h"
+#include "lp_test.h"
+#include "lp_test_render.h"
+
+
+#define SIZE 512
+#define NUM_TRIS 20000
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "result\t"
+           "bin_threads\t"
+           "merged_chunks\t"
+           "draw_ms\t"
+           "total_ms\n");
+
+   fflush(fp);
+}
+
+
+/**
+ * Render the triangles with the given number of binner threads and
+ * return the color buffer contents.
+ */
+static uint32_t *
+render(struct pipe_screen *screen, const struct lp_test_vertex *verts,
+       unsigned num_bin_threads, unsigned *merged_chunks,
+       double *draw_ms, double *total_ms)
+{
+   struct lp_test_target target;
+   struct pipe_depth_stencil_alpha_state dsa;
+   uint32_t *pixels;
+   void *blend_cso, *dsa_cso;
+
+   /* Picked up by lp_setup_create() */
+   llvmpipe_screen(screen)->num_bin_threads = num_bin_threads;
+
+   if (!lp_test_target_init(&target, screen, 0, SIZE,
+                            PIPE_FORMAT_B8G8R8A8_UNORM,
+                            PIPE_FORMAT_Z32_FLOAT, verts))
+      return NULL;
+
+   struct pipe_context *pipe = target.pipe;
+
+   blend_cso = lp_test_create_alpha_blend(pipe);
+   pipe->bind_blend_state(pipe, blend_cso);
+
+   memset(&dsa, 0, sizeof dsa);
+   dsa_cso = pipe->create_depth_stencil_alpha_state(pipe, &dsa);
+   pipe->bind_depth_stencil_alpha_state(pipe, dsa_cso);
+
+   union pipe_color_union clear_color = { .f = { 0.0f, 0.0f, 0.0f, 0.0f } };
+   pipe->clear(pipe, PIPE_CLEAR_COLOR0, NULL, &clear_color, 0.0, 0);
+
+   int64_t start = os_time_get_nano();
+   util_draw_arrays(pipe, MESA_PRIM_TRIANGLES, 0, NUM_TRIS * 3);
+   int64_t drawn = os_time_get_nano();
+   lp_test_finish(pipe);
+   int64_t end = os_time_get_nano();
+
+   *merged_chunks = llvmpipe_context(pipe)->setup->mt_merged_chunks;
+   *draw_ms = (drawn - start) * 1e-6;
+   *total_ms = (end - start) * 1e-6;
+
+   pixels = (uint32_t *)lp_test_read_texture(pipe, target.cbuf);
+
+   pipe->bind_depth_stencil_alpha_state(pipe, NULL);
+   pipe->delete_depth_stencil_alpha_state(pipe, dsa_cso);
+   pipe->bind_blend_state(pipe, NULL);
+   pipe->delete_blend_state(pipe, blend_cso);
+   lp_test_target_fini(&target);
+   return pixels;
+}
+
+
+static bool
+test_setup_mt(unsigned verbose, FILE *fp, struct pipe_screen *screen,
+              const struct lp_test_vertex *verts, const uint32_t *ref,
+              unsigned num_bin_threads)
+{
+   unsigned merged_chunks = 0;
+   double draw_ms, total_ms;
+   uint32_t *pixels = render(screen, verts, num_bin_threads, &merged_chunks,
+                             &draw_ms, &total_ms);
+   bool success = pixels && merged_chunks > 0 &&
+                  memcmp(pixels, ref, SIZE * SIZE * sizeof *pixels) == 0;
+
+   if (verbose || !success) {
+      printf("%s: %2u bin threads: %5u merged chunks, "
+             "draw %8.3f ms, total %8.3f ms\n",
+             success ? "PASS" : "FAIL", num_bin_threads, merged_chunks,
+             draw_ms, total_ms);
+      fflush(stdout);
+   }
+
+   if (fp) {
+      fprintf(fp, "%s\t%u\t%u\t%f\t%f\n",
+              success ? "pass" : "fail", num_bin_threads, merged_chunks,
+              draw_ms, total_ms);
+      fflush(fp);
+   }
+
+   FREE(pixels);
+   return success;
+}
+
+
+static bool
+test_setup_mt_threads(unsigned verbose, FILE *fp, unsigned max_bin_threads)
+{
+   struct sw_winsys *winsys;
+   struct pipe_screen *screen;
+   struct lp_test_vertex *verts;
+   uint32_t *ref;
+   unsigned merged_chunks;
+   double draw_ms, total_ms;
+   bool success = true;
+
+   winsys = null_sw_create();
+   if (!winsys)
+      return false;
+
+   screen = llvmpipe_create_screen(winsys);
+   if (!screen) {
+      winsys->destroy(winsys);
+      return false;
+   }
+
+   verts = lp_test_make_triangles(NUM_TRIS, 0.05f, 0.55f);
+   ref = verts ? render(screen, verts, 0, &merged_chunks,
+                        &draw_ms, &total_ms) : NULL;
+   if (!ref) {
+      success = false;
+      goto out;
+   }
+
+   if (verbose) {
+      printf("PASS:  0 bin threads: %5u merged chunks, "
+             "draw %8.3f ms, total %8.3f ms\n",
+             merged_chunks, draw_ms, total_ms);
+      fflush(stdout);
+   }
+
+   if (fp) {
+      fprintf(fp, "pass\t0\t%u\t%f\t%f\n", merged_chunks, draw_ms, total_ms);
+      fflush(fp);
+   }
+
+   /* 1, 2, 4, ... threads, always finishing with max_bin_threads */
+   for (unsigned n = 1;; n = MIN2(n * 2, max_bin_threads)) {
+      success &= test_setup_mt(verbose, fp, screen, verts, ref, n);
+      if (n == max_bin_threads)
+         break;
+   }
+
+out:
+   FREE(ref);
+   FREE(verts);
+   screen->destroy(screen);
+   winsys->destroy(winsys);
+   return success;
+}
+
+
+bool
+test_all(unsigned verbose, FILE *fp)
+{
+   unsigned max_bin_threads =
+      CLAMP(util_get_cpu_caps()->nr_cpus, 1, LP_MAX_BIN_THREADS);
+
+   return test_setup_mt_threads(verbose, fp, max_bin_threads);
+}
+
+
+bool
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   return test_all(verbose, fp);
+}
+
+
+bool
+test_single(unsigned verbose, FILE *fp)
+{
+   return test_setup_mt_threads(verbose, fp, 1);
+}
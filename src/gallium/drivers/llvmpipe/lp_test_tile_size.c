@@ -0,0 +1,250 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @file
+ * Unit test and benchmark for the per-scene tile size.
+ *
+ * Draws overlapping, alpha-blended triangles into render targets of
+ * various sizes and formats with every tile size (LP_TILE_SIZE) plus the
+ * automatic choice.  The rendering must match the one with the default
+ * 64x64 tiles bit for bit.  The time to draw and rasterize is reported,
+ * giving a matrix from which the crossover points can be read.  A depth
+ * buffer is bound, even though depth testing is off, since the linear
+ * rasterizer a lone color buffer would get always uses 64x64 tiles.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pipe/p_context.h"
+#include "pipe/p_defines.h"
+#include "pipe/p_screen.h"
+#include "util/format/u_format.h"
+#include "util/os_time.h"
+#include "util/u_draw.h"
+#include "util/u_memory.h"
+#include "frontend/sw_winsys.h"
+#include "sw/null/null_sw_winsys.h"
+
+#include "lp_limits.h"
+#include "lp_public.h"
+#include "lp_screen.h"
+#include "lp_test.h"
+#include "lp_test_render.h"
+
+
+static const unsigned sizes[] = { 128, 512, 2048 };
+
+static const enum pipe_format formats[] = {
+   PIPE_FORMAT_B8G8R8A8_UNORM,
+   PIPE_FORMAT_R16G16B16A16_FLOAT,
+   PIPE_FORMAT_R32G32B32A32_FLOAT,
+};
+
+static const unsigned prim_counts[] = { 16, 256, 4096 };
+
+/* 0 lets the driver pick */
+static const unsigned tile_sizes[] = { 32, 128, 0 };
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "result\t"
+           "size\t"
+           "format\t"
+           "prims\t"
+           "tile_size\t"
+           "total_ms\n");
+
+   fflush(fp);
+}
+
+
+/**
+ * Render the triangles with the given tile size and return the color
+ * buffer contents.
+ */
+static uint8_t *
+render(struct pipe_screen *screen, const struct lp_test_vertex *verts,
+       unsigned num_tris, unsigned size, enum pipe_format format,
+       unsigned tile_size, double *total_ms)
+{
+   struct lp_test_target target;
+   struct pipe_depth_stencil_alpha_state dsa;
+   uint8_t *pixels;
+   void *blend_cso, *dsa_cso;
+
+   /* Picked up by lp_setup_create() */
+   llvmpipe_screen(screen)->tile_size = tile_size;
+
+   if (!lp_test_target_init(&target, screen, 0, size, format,
+                            PIPE_FORMAT_Z32_FLOAT, verts))
+      return NULL;
+
+   struct pipe_context *pipe = target.pipe;
+
+   blend_cso = lp_test_create_alpha_blend(pipe);
+   pipe->bind_blend_state(pipe, blend_cso);
+
+   memset(&dsa, 0, sizeof dsa);
+   dsa_cso = pipe->create_depth_stencil_alpha_state(pipe, &dsa);
+   pipe->bind_depth_stencil_alpha_state(pipe, dsa_cso);
+
+   /* Draw once so the shaders are compiled and the previous scene's
+    * primitive count is known when the measured scene starts.
+    */
+   union pipe_color_union clear_color = { .f = { 0.0f, 0.0f, 0.0f, 0.0f } };
+   pipe->clear(pipe, PIPE_CLEAR_COLOR0 | PIPE_CLEAR_DEPTH, NULL, &clear_color,
+               1.0, 0);
+   util_draw_arrays(pipe, MESA_PRIM_TRIANGLES, 0, num_tris * 3);
+   lp_test_finish(pipe);
+
+   int64_t start = os_time_get_nano();
+   pipe->clear(pipe, PIPE_CLEAR_COLOR0 | PIPE_CLEAR_DEPTH, NULL, &clear_color,
+               1.0, 0);
+   util_draw_arrays(pipe, MESA_PRIM_TRIANGLES, 0, num_tris * 3);
+   lp_test_finish(pipe);
+   int64_t end = os_time_get_nano();
+
+   *total_ms = (end - start) * 1e-6;
+
+   pixels = lp_test_read_texture(pipe, target.cbuf);
+
+   pipe->bind_depth_stencil_alpha_state(pipe, NULL);
+   pipe->delete_depth_stencil_alpha_state(pipe, dsa_cso);
+   pipe->bind_blend_state(pipe, NULL);
+   pipe->delete_blend_state(pipe, blend_cso);
+   lp_test_target_fini(&target);
+   return pixels;
+}
+
+
+static void
+report(unsigned verbose, FILE *fp, bool success,
+       unsigned size, enum pipe_format format, unsigned num_tris,
+       unsigned tile_size, double total_ms)
+{
+   const char *format_name = util_format_short_name(format);
+
+   if (verbose || !success) {
+      printf("%s: %4ux%-4u %-14s %5u tris, tile %3u%s: %8.3f ms\n",
+             success ? "PASS" : "FAIL", size, size, format_name, num_tris,
+             tile_size ? tile_size : TILE_SIZE,
+             tile_size ? "" : " (auto)", total_ms);
+      fflush(stdout);
+   }
+
+   if (fp) {
+      if (tile_size)
+         fprintf(fp, "%s\t%u\t%s\t%u\t%u\t%f\n",
+                 success ? "pass" : "fail", size, format_name, num_tris,
+                 tile_size, total_ms);
+      else
+         fprintf(fp, "%s\t%u\t%s\t%u\tauto\t%f\n",
+                 success ? "pass" : "fail", size, format_name, num_tris,
+                 total_ms);
+      fflush(fp);
+   }
+}
+
+
+static bool
+test_tile_size(unsigned verbose, FILE *fp, struct pipe_screen *screen,
+               unsigned size, enum pipe_format format, unsigned num_tris)
+{
+   const unsigned image_size =
+      size * size * util_format_get_blocksize(format);
+   struct lp_test_vertex *verts =
+      lp_test_make_triangles(num_tris, 0.02f, 0.22f);
+   double total_ms;
+   bool success = true;
+
+   if (!verts)
+      return false;
+
+   uint8_t *ref = render(screen, verts, num_tris, size, format,
+                         TILE_SIZE, &total_ms);
+   if (!ref) {
+      FREE(verts);
+      return false;
+   }
+
+   report(verbose, fp, true, size, format, num_tris, TILE_SIZE, total_ms);
+
+   for (unsigned i = 0; i < ARRAY_SIZE(tile_sizes); i++) {
+      uint8_t *pixels = render(screen, verts, num_tris, size, format,
+                               tile_sizes[i], &total_ms);
+      bool match = pixels && memcmp(pixels, ref, image_size) == 0;
+
+      report(verbose, fp, match, size, format, num_tris,
+             tile_sizes[i], total_ms);
+      success &= match;
+      FREE(pixels);
+   }
+
+   FREE(ref);
+   FREE(verts);
+   return success;
+}
+
+
+static bool
+run_tests(unsigned verbose, FILE *fp, bool single)
+{
+   struct sw_winsys *winsys;
+   struct pipe_screen *screen;
+   bool success = true;
+
+   winsys = null_sw_create();
+   if (!winsys)
+      return false;
+
+   screen = llvmpipe_create_screen(winsys);
+   if (!screen) {
+      winsys->destroy(winsys);
+      return false;
+   }
+
+   if (single) {
+      success = test_tile_size(verbose, fp, screen, 512,
+                               PIPE_FORMAT_B8G8R8A8_UNORM, 256);
+   } else {
+      for (unsigned s = 0; s < ARRAY_SIZE(sizes); s++)
+         for (unsigned f = 0; f < ARRAY_SIZE(formats); f++)
+            for (unsigned p = 0; p < ARRAY_SIZE(prim_counts); p++)
+               success &= test_tile_size(verbose, fp, screen, sizes[s],
+                                         formats[f], prim_counts[p]);
+   }
+
+   screen->destroy(screen);
+   winsys->destroy(winsys);
+   return success;
+}
+
+
+bool
+test_all(unsigned verbose, FILE *fp)
+{
+   return run_tests(verbose, fp, false);
+}
+
+
+bool
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   return test_all(verbose, fp);
+}
+
+
+bool
+test_single(unsigned verbose, FILE *fp)
+{
+   return run_tests(verbose, fp, true);
+}
@@ -0,0 +1,932 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @file
+ * Unit test and benchmark for copies and fills on the cs thread pool.
+ *
+ * Copies and clears large textures and buffers with 0..N pool threads
+ * (LP_NUM_THREADS) and checks every byte of the result.  The bandwidth of
+ * each operation is reported in GB/s.  Sub-boxes at unaligned offsets,
+ * boxes of several layers too small to split, copies between formats with
+ * different block dimensions, copies between images and padded buffers,
+ * resolves and converting blits are checked against the same operation
+ * done on the CPU.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pipe/p_context.h"
+#include "pipe/p_defines.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+#include "util/format/u_format.h"
+#include "util/os_time.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_inlines.h"
+#include "util/u_memory.h"
+#include "frontend/sw_winsys.h"
+#include "sw/null/null_sw_winsys.h"
+
+#include "lp_limits.h"
+#include "lp_public.h"
+#include "lp_screen.h"
+#include "lp_test.h"
+#include "lp_test_render.h"
+#include "lp_texture.h"
+
+
+#define TEX_SIZE 2048
+#define TEX_LAYERS 4
+#define BUFFER_SIZE (TEX_SIZE * TEX_SIZE * TEX_LAYERS * 4)
+#define NUM_ITERATIONS 4
+
+#define CLEAR_VALUE 0x5a3c96e1
+
+#define SUB_TEX_SIZE 512
+#define SUB_BUFFER_SIZE (4 * 1024 * 1024)
+
+#define RESOLVE_SAMPLES 4
+
+
+enum transfer_op {
+   OP_COPY_TEXTURE,
+   OP_COPY_BUFFER,
+   OP_CLEAR_TEXTURE,
+   OP_CLEAR_BUFFER,
+   OP_COUNT,
+};
+
+static const char *op_names[OP_COUNT] = {
+   "copy_texture",
+   "copy_buffer",
+   "clear_texture",
+   "clear_buffer",
+};
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "result\t"
+           "threads\t"
+           "op\t"
+           "gbps\n");
+
+   fflush(fp);
+}
+
+
+static void
+report(unsigned verbose, FILE *fp, bool success, unsigned num_threads,
+       const char *name, double gbps)
+{
+   if (verbose || !success) {
+      printf("%s: %3u threads: %-18s %8.2f GB/s\n",
+             success ? "PASS" : "FAIL", num_threads, name, gbps);
+      fflush(stdout);
+   }
+
+   if (fp) {
+      fprintf(fp, "%s\t%u\t%s\t%f\n",
+              success ? "pass" : "fail", num_threads, name, gbps);
+      fflush(fp);
+   }
+}
+
+
+static struct pipe_resource *
+create_resource(struct pipe_screen *screen, bool buffer)
+{
+   struct pipe_resource templ;
+
+   memset(&templ, 0, sizeof templ);
+   if (buffer) {
+      templ.target = PIPE_BUFFER;
+      templ.format = PIPE_FORMAT_R8_UNORM;
+      templ.width0 = BUFFER_SIZE;
+      templ.height0 = 1;
+   } else {
+      templ.target = PIPE_TEXTURE_2D_ARRAY;
+      templ.format = PIPE_FORMAT_R8G8B8A8_UNORM;
+      templ.width0 = TEX_SIZE;
+      templ.height0 = TEX_SIZE;
+      templ.bind = PIPE_BIND_SAMPLER_VIEW | PIPE_BIND_RENDER_TARGET;
+   }
+   templ.depth0 = 1;
+   templ.array_size = buffer ? 1 : TEX_LAYERS;
+
+   return screen->resource_create(screen, &templ);
+}
+
+
+static void
+get_box(const struct pipe_resource *res, struct pipe_box *box)
+{
+   if (res->target == PIPE_BUFFER)
+      u_box_1d(0, BUFFER_SIZE, box);
+   else
+      u_box_3d(0, 0, 0, TEX_SIZE, TEX_SIZE, TEX_LAYERS, box);
+}
+
+
+/**
+ * Calls fn on every row of 32-bit texels of the resource.
+ */
+static bool
+for_each_row(struct pipe_context *pipe, struct pipe_resource *res,
+             unsigned usage,
+             bool (*fn)(uint32_t *row, unsigned count, unsigned index))
+{
+   struct pipe_transfer *transfer;
+   struct pipe_box box;
+   bool ret = true;
+
+   get_box(res, &box);
+   uint8_t *map;
+   if (res->target == PIPE_BUFFER)
+      map = pipe->buffer_map(pipe, res, 0, usage, &box, &transfer);
+   else
+      map = pipe->texture_map(pipe, res, 0, usage, &box, &transfer);
+   if (!map)
+      return false;
+
+   if (res->target == PIPE_BUFFER) {
+      ret = fn((uint32_t *)map, BUFFER_SIZE / 4, 0);
+   } else {
+      for (unsigned z = 0; z < TEX_LAYERS && ret; z++) {
+         for (unsigned y = 0; y < TEX_SIZE && ret; y++) {
+            uint8_t *row = map + z * transfer->layer_stride +
+                           y * transfer->stride;
+            ret = fn((uint32_t *)row, TEX_SIZE, z * TEX_SIZE + y);
+         }
+      }
+   }
+
+   if (res->target == PIPE_BUFFER)
+      pipe->buffer_unmap(pipe, transfer);
+   else
+      pipe->texture_unmap(pipe, transfer);
+   return ret;
+}
+
+
+static uint32_t
+pattern(unsigned index, unsigned i)
+{
+   return (index * 0x9e3779b1) ^ (i * 0x85ebca6b);
+}
+
+
+static bool
+write_pattern(uint32_t *row, unsigned count, unsigned index)
+{
+   for (unsigned i = 0; i < count; i++)
+      row[i] = pattern(index, i);
+   return true;
+}
+
+
+static bool
+check_pattern(uint32_t *row, unsigned count, unsigned index)
+{
+   for (unsigned i = 0; i < count; i++) {
+      if (row[i] != pattern(index, i))
+         return false;
+   }
+   return true;
+}
+
+
+static bool
+check_clear(uint32_t *row, unsigned count, unsigned index)
+{
+   for (unsigned i = 0; i < count; i++) {
+      if (row[i] != CLEAR_VALUE)
+         return false;
+   }
+   return true;
+}
+
+
+static void
+run_op(struct pipe_context *pipe, enum transfer_op op,
+       struct pipe_resource *dst, struct pipe_resource *src)
+{
+   const uint32_t value = CLEAR_VALUE;
+   struct pipe_box box;
+
+   get_box(dst, &box);
+
+   switch (op) {
+   case OP_COPY_TEXTURE:
+   case OP_COPY_BUFFER:
+      pipe->resource_copy_region(pipe, dst, 0, 0, 0, 0, src, 0, &box);
+      break;
+   case OP_CLEAR_TEXTURE:
+      pipe->clear_texture(pipe, dst, 0, &box, &value);
+      break;
+   case OP_CLEAR_BUFFER:
+      pipe->clear_buffer(pipe, dst, 0, BUFFER_SIZE, &value, sizeof value);
+      break;
+   default:
+      break;
+   }
+}
+
+
+static bool
+test_op(unsigned verbose, FILE *fp, struct pipe_context *pipe,
+        unsigned num_threads, enum transfer_op op)
+{
+   const bool buffer = op == OP_COPY_BUFFER || op == OP_CLEAR_BUFFER;
+   const bool copy = op == OP_COPY_TEXTURE || op == OP_COPY_BUFFER;
+   struct pipe_resource *dst = create_resource(pipe->screen, buffer);
+   struct pipe_resource *src = copy ? create_resource(pipe->screen, buffer) : NULL;
+   double gbps = 0.0;
+   bool success = false;
+
+   if (!dst || (copy && !src))
+      goto out;
+
+   if (copy && !for_each_row(pipe, src, PIPE_MAP_WRITE, write_pattern))
+      goto out;
+
+   /* Once to fault the destination in, then timed */
+   run_op(pipe, op, dst, src);
+
+   int64_t start = os_time_get_nano();
+   for (unsigned i = 0; i < NUM_ITERATIONS; i++)
+      run_op(pipe, op, dst, src);
+   int64_t end = os_time_get_nano();
+
+   /* bytes per nanosecond are GB/s */
+   gbps = (double)BUFFER_SIZE * NUM_ITERATIONS / MAX2(end - start, 1);
+
+   success = for_each_row(pipe, dst, PIPE_MAP_READ,
+                          copy ? check_pattern : check_clear);
+
+out:
+   report(verbose, fp, success, num_threads, op_names[op], gbps);
+
+   pipe_resource_reference(&src, NULL);
+   pipe_resource_reference(&dst, NULL);
+   return success;
+}
+
+
+/**
+ * A copy or clear of part of a resource.  The box is in source texels for
+ * copies and in destination texels for clears, or in bytes for buffers.
+ */
+struct sub_case {
+   const char *name;
+   enum transfer_op op;
+   enum pipe_format src_format;
+   enum pipe_format dst_format;
+   unsigned x, y, z, width, height, depth;
+   unsigned dst_x, dst_y, dst_z;
+};
+
+static const struct sub_case sub_cases[] = {
+   { "copy_sub_box", OP_COPY_TEXTURE,
+     PIPE_FORMAT_R8G8B8A8_UNORM, PIPE_FORMAT_R8G8B8A8_UNORM,
+     3, 5, 1, 401, 333, 2, 17, 9, 2 },
+   /* Below the split threshold, so one chunk on the calling thread */
+   { "copy_small_layers", OP_COPY_TEXTURE,
+     PIPE_FORMAT_R8G8B8A8_UNORM, PIPE_FORMAT_R8G8B8A8_UNORM,
+     1, 2, 0, 31, 17, TEX_LAYERS, 4, 3, 0 },
+   { "copy_cast", OP_COPY_TEXTURE,
+     PIPE_FORMAT_R32_UINT, PIPE_FORMAT_R8G8B8A8_UNORM,
+     0, 0, 0, SUB_TEX_SIZE, SUB_TEX_SIZE, TEX_LAYERS, 0, 0, 0 },
+   { "copy_bc_to_rgba", OP_COPY_TEXTURE,
+     PIPE_FORMAT_DXT1_RGBA, PIPE_FORMAT_R16G16B16A16_UINT,
+     8, 4, 0, 256, 128, 3, 5, 7, 1 },
+   { "copy_rgba_to_bc", OP_COPY_TEXTURE,
+     PIPE_FORMAT_R16G16B16A16_UINT, PIPE_FORMAT_DXT1_RGBA,
+     5, 7, 1, 64, 32, 3, 8, 4, 0 },
+#ifdef NDEBUG
+   /* Rejected, with an assertion in debug builds; dst must stay untouched */
+   { "copy_bs_mismatch", OP_COPY_TEXTURE,
+     PIPE_FORMAT_R8G8B8A8_UNORM, PIPE_FORMAT_R16G16B16A16_UINT,
+     0, 0, 0, 64, 64, 1, 0, 0, 0 },
+#endif
+   { "copy_buffer_sub", OP_COPY_BUFFER,
+     PIPE_FORMAT_R8_UNORM, PIPE_FORMAT_R8_UNORM,
+     12345, 0, 0, 2 * 1024 * 1024 + 13, 1, 1, 4099, 0, 0 },
+   { "clear_sub_box", OP_CLEAR_TEXTURE,
+     PIPE_FORMAT_NONE, PIPE_FORMAT_R8G8B8A8_UNORM,
+     7, 11, 1, 300, 400, 2 },
+   { "clear_small_layers", OP_CLEAR_TEXTURE,
+     PIPE_FORMAT_NONE, PIPE_FORMAT_R8G8B8A8_UNORM,
+     5, 6, 0, 29, 13, TEX_LAYERS },
+   { "clear_buffer_sub", OP_CLEAR_BUFFER,
+     PIPE_FORMAT_NONE, PIPE_FORMAT_R8_UNORM,
+     4100, 0, 0, 2 * 1024 * 1024 + 8, 1, 1 },
+};
+
+
+/**
+ * Size of a resource in block rows of row_bytes, for the CPU copies.
+ */
+static void
+get_layout(const struct pipe_resource *res, unsigned *row_bytes,
+           unsigned *rows, unsigned *layers)
+{
+   *row_bytes = DIV_ROUND_UP(res->width0, util_format_get_blockwidth(res->format)) *
+                util_format_get_blocksize(res->format);
+   *rows = DIV_ROUND_UP(res->height0, util_format_get_blockheight(res->format));
+   *layers = res->array_size;
+}
+
+
+static struct pipe_resource *
+create_sub_resource(struct pipe_screen *screen, enum transfer_op op,
+                    enum pipe_format format)
+{
+   const bool buffer = op == OP_COPY_BUFFER || op == OP_CLEAR_BUFFER;
+   struct pipe_resource templ;
+
+   memset(&templ, 0, sizeof templ);
+   templ.target = buffer ? PIPE_BUFFER : PIPE_TEXTURE_2D_ARRAY;
+   templ.format = format;
+   templ.width0 = buffer ? SUB_BUFFER_SIZE : SUB_TEX_SIZE;
+   templ.height0 = buffer ? 1 : SUB_TEX_SIZE;
+   templ.depth0 = 1;
+   templ.array_size = buffer ? 1 : TEX_LAYERS;
+   templ.bind = buffer ? 0 : PIPE_BIND_SAMPLER_VIEW;
+
+   if (!buffer &&
+       !screen->is_format_supported(screen, format, templ.target, 0, 0,
+                                    templ.bind))
+      return NULL;
+
+   return screen->resource_create(screen, &templ);
+}
+
+
+/**
+ * Copies the whole resource to or from a tightly packed image.
+ */
+static bool
+transfer_image(struct pipe_context *pipe, struct pipe_resource *res,
+               uint8_t *image, bool write)
+{
+   const unsigned usage = write ? PIPE_MAP_WRITE : PIPE_MAP_READ;
+   struct pipe_transfer *transfer;
+   unsigned row_bytes, rows, layers;
+   struct pipe_box box;
+
+   get_layout(res, &row_bytes, &rows, &layers);
+   u_box_3d(0, 0, 0, res->width0, res->height0, layers, &box);
+
+   uint8_t *map;
+   if (res->target == PIPE_BUFFER)
+      map = pipe->buffer_map(pipe, res, 0, usage, &box, &transfer);
+   else
+      map = pipe->texture_map(pipe, res, 0, usage, &box, &transfer);
+   if (!map)
+      return false;
+
+   for (unsigned z = 0; z < layers; z++) {
+      for (unsigned y = 0; y < rows; y++) {
+         uint8_t *row = map + z * transfer->layer_stride + y * transfer->stride;
+         uint8_t *img = image + ((uint64_t)z * rows + y) * row_bytes;
+         if (write)
+            memcpy(row, img, row_bytes);
+         else
+            memcpy(img, row, row_bytes);
+      }
+   }
+
+   if (res->target == PIPE_BUFFER)
+      pipe->buffer_unmap(pipe, transfer);
+   else
+      pipe->texture_unmap(pipe, transfer);
+   return true;
+}
+
+
+/**
+ * Applies the case to the packed images the way the driver should.
+ */
+static void
+apply_sub_case(const struct sub_case *c, const struct pipe_resource *dst,
+               uint8_t *dst_image, const struct pipe_resource *src,
+               const uint8_t *src_image)
+{
+   const enum pipe_format dst_format = dst->format;
+   const unsigned bs = util_format_get_blocksize(dst_format);
+   unsigned row_bytes, rows, layers;
+
+   get_layout(dst, &row_bytes, &rows, &layers);
+
+   if (c->op == OP_CLEAR_TEXTURE || c->op == OP_CLEAR_BUFFER) {
+      const uint32_t value = CLEAR_VALUE;
+      const unsigned value_size = c->op == OP_CLEAR_BUFFER ? sizeof value : bs;
+
+      for (unsigned z = c->z; z < c->z + c->depth; z++) {
+         for (unsigned y = c->y; y < c->y + c->height; y++) {
+            uint8_t *row = dst_image + ((uint64_t)z * rows + y) * row_bytes;
+            for (unsigned x = c->x; x < c->x + c->width; x += value_size / bs)
+               memcpy(row + x * bs, &value, value_size);
+         }
+      }
+      return;
+   }
+
+   const enum pipe_format src_format = src->format;
+   if (util_format_get_blocksize(src_format) != bs)
+      return;
+
+   const unsigned sbw = util_format_get_blockwidth(src_format);
+   const unsigned sbh = util_format_get_blockheight(src_format);
+   const unsigned dbw = util_format_get_blockwidth(dst_format);
+   const unsigned dbh = util_format_get_blockheight(dst_format);
+   const unsigned cols = DIV_ROUND_UP(c->width, sbw);
+   const unsigned copy_rows = DIV_ROUND_UP(c->height, sbh);
+   unsigned src_row_bytes, src_rows, src_layers;
+
+   get_layout(src, &src_row_bytes, &src_rows, &src_layers);
+
+   for (unsigned z = 0; z < c->depth; z++) {
+      for (unsigned y = 0; y < copy_rows; y++) {
+         memcpy(dst_image +
+                ((uint64_t)(c->dst_z + z) * rows + c->dst_y / dbh + y) * row_bytes +
+                c->dst_x / dbw * bs,
+                src_image +
+                ((uint64_t)(c->z + z) * src_rows + c->y / sbh + y) * src_row_bytes +
+                c->x / sbw * bs,
+                cols * bs);
+      }
+   }
+}
+
+
+static bool
+test_sub_case(unsigned verbose, FILE *fp, struct pipe_context *pipe,
+              unsigned num_threads, const struct sub_case *c)
+{
+   const bool copy = c->op == OP_COPY_TEXTURE || c->op == OP_COPY_BUFFER;
+   struct pipe_resource *dst =
+      create_sub_resource(pipe->screen, c->op, c->dst_format);
+   struct pipe_resource *src = copy ?
+      create_sub_resource(pipe->screen, c->op, c->src_format) : NULL;
+   uint8_t *src_image = NULL, *expected = NULL, *result = NULL;
+   unsigned row_bytes, rows, layers;
+   double gbps = 0.0;
+   bool success = false;
+
+   if (!dst || (copy && !src)) {
+      /* Compressed formats may not be available */
+      if (verbose)
+         printf("SKIP: %3u threads: %s\n", num_threads, c->name);
+      pipe_resource_reference(&src, NULL);
+      pipe_resource_reference(&dst, NULL);
+      return true;
+   }
+
+   get_layout(dst, &row_bytes, &rows, &layers);
+   const size_t size = (size_t)row_bytes * rows * layers;
+   expected = CALLOC(1, size);
+   result = MALLOC(size);
+   if (!expected || !result || !transfer_image(pipe, dst, expected, true))
+      goto out;
+
+   if (copy) {
+      get_layout(src, &row_bytes, &rows, &layers);
+      const size_t src_size = (size_t)row_bytes * rows * layers;
+      src_image = MALLOC(src_size);
+      if (!src_image)
+         goto out;
+      for (size_t i = 0; i < src_size; i++)
+         src_image[i] = pattern(i >> 12, i) >> 24;
+      if (!transfer_image(pipe, src, src_image, true))
+         goto out;
+   }
+
+   const uint32_t value = CLEAR_VALUE;
+   struct pipe_box box;
+   u_box_3d(c->x, c->y, c->z, c->width, c->height, c->depth, &box);
+
+   int64_t start = os_time_get_nano();
+   switch (c->op) {
+   case OP_COPY_TEXTURE:
+   case OP_COPY_BUFFER:
+      pipe->resource_copy_region(pipe, dst, 0, c->dst_x, c->dst_y, c->dst_z,
+                                 src, 0, &box);
+      break;
+   case OP_CLEAR_TEXTURE:
+      pipe->clear_texture(pipe, dst, 0, &box, &value);
+      break;
+   case OP_CLEAR_BUFFER:
+      pipe->clear_buffer(pipe, dst, c->x, c->width, &value, sizeof value);
+      break;
+   default:
+      break;
+   }
+   int64_t end = os_time_get_nano();
+
+   const enum pipe_format format = copy ? c->src_format : c->dst_format;
+   const uint64_t bytes =
+      (uint64_t)DIV_ROUND_UP(c->width, util_format_get_blockwidth(format)) *
+      DIV_ROUND_UP(c->height, util_format_get_blockheight(format)) *
+      c->depth * util_format_get_blocksize(format);
+   gbps = (double)bytes / MAX2(end - start, 1);
+
+   apply_sub_case(c, dst, expected, src, src_image);
+   success = transfer_image(pipe, dst, result, false) &&
+             memcmp(result, expected, size) == 0;
+
+out:
+   report(verbose, fp, success, num_threads, c->name, gbps);
+
+   FREE(src_image);
+   FREE(expected);
+   FREE(result);
+   pipe_resource_reference(&src, NULL);
+   pipe_resource_reference(&dst, NULL);
+   return success;
+}
+
+
+/**
+ * Address of a texel in the packed image of a resource, see get_layout().
+ */
+static uint8_t *
+sub_texel(uint8_t *image, const struct pipe_resource *res,
+          unsigned x, unsigned y, unsigned z)
+{
+   unsigned row_bytes, rows, layers;
+
+   get_layout(res, &row_bytes, &rows, &layers);
+   return image + ((uint64_t)z * rows + y) * row_bytes +
+          x * util_format_get_blocksize(res->format);
+}
+
+
+/**
+ * Reads a sub-box of a texture into a buffer with padded rows and layers
+ * through image_copy_buffer, and writes it back to another texture at a
+ * different offset.
+ */
+static bool
+test_image_copy_buffer(unsigned verbose, FILE *fp, struct pipe_context *pipe,
+                       unsigned num_threads)
+{
+   const struct pipe_box src_box = {
+      .x = 3, .y = 5, .z = 1, .width = 401, .height = 333, .depth = 2,
+   };
+   const struct pipe_box dst_box = {
+      .x = 17, .y = 9, .z = 2, .width = 401, .height = 333, .depth = 2,
+   };
+   const unsigned offset = 4099;
+   const unsigned stride = (src_box.width + 7) * 4;
+   const unsigned layer_stride = stride * (src_box.height + 3);
+   struct pipe_resource *src =
+      create_sub_resource(pipe->screen, OP_COPY_TEXTURE,
+                          PIPE_FORMAT_R8G8B8A8_UNORM);
+   struct pipe_resource *dst =
+      create_sub_resource(pipe->screen, OP_COPY_TEXTURE,
+                          PIPE_FORMAT_R8G8B8A8_UNORM);
+   struct pipe_resource *buf =
+      create_sub_resource(pipe->screen, OP_COPY_BUFFER, PIPE_FORMAT_R8_UNORM);
+   uint8_t *src_image = NULL, *buf_image = NULL, *dst_image = NULL;
+   uint8_t *result = NULL;
+   unsigned row_bytes, rows, layers;
+   bool success = false;
+   double gbps = 0.0;
+
+   if (!src || !dst || !buf)
+      goto out;
+
+   get_layout(src, &row_bytes, &rows, &layers);
+   const size_t tex_size = (size_t)row_bytes * rows * layers;
+   src_image = MALLOC(tex_size);
+   dst_image = CALLOC(1, tex_size);
+   buf_image = CALLOC(1, SUB_BUFFER_SIZE);
+   result = MALLOC(MAX2(tex_size, SUB_BUFFER_SIZE));
+   if (!src_image || !dst_image || !buf_image || !result)
+      goto out;
+
+   for (size_t i = 0; i < tex_size; i++)
+      src_image[i] = pattern(i >> 12, i) >> 24;
+   if (!transfer_image(pipe, src, src_image, true) ||
+       !transfer_image(pipe, dst, dst_image, true) ||
+       !transfer_image(pipe, buf, buf_image, true))
+      goto out;
+
+   int64_t start = os_time_get_nano();
+   pipe->image_copy_buffer(pipe, buf, src, offset, stride, layer_stride, 0,
+                           &src_box);
+   int64_t end = os_time_get_nano();
+   gbps = (double)src_box.width * src_box.height * src_box.depth * 4 /
+          MAX2(end - start, 1);
+
+   pipe->image_copy_buffer(pipe, dst, buf, offset, stride, layer_stride, 0,
+                           &dst_box);
+
+   for (unsigned z = 0; z < src_box.depth; z++) {
+      for (unsigned y = 0; y < src_box.height; y++) {
+         uint8_t *buf_row = buf_image + offset + z * layer_stride + y * stride;
+         memcpy(buf_row,
+                sub_texel(src_image, src, src_box.x, src_box.y + y,
+                          src_box.z + z),
+                src_box.width * 4);
+         memcpy(sub_texel(dst_image, dst, dst_box.x, dst_box.y + y,
+                          dst_box.z + z),
+                buf_row, dst_box.width * 4);
+      }
+   }
+
+   success = transfer_image(pipe, buf, result, false) &&
+             memcmp(result, buf_image, SUB_BUFFER_SIZE) == 0 &&
+             transfer_image(pipe, dst, result, false) &&
+             memcmp(result, dst_image, tex_size) == 0;
+
+out:
+   report(verbose, fp, success, num_threads, "image_copy_buffer", gbps);
+
+   FREE(src_image);
+   FREE(dst_image);
+   FREE(buf_image);
+   FREE(result);
+   pipe_resource_reference(&buf, NULL);
+   pipe_resource_reference(&dst, NULL);
+   pipe_resource_reference(&src, NULL);
+   return success;
+}
+
+
+/**
+ * Resolves a multisampled texture through pipe->blit.  Sample s of every
+ * channel is (base & 0xf0) + 4 * s, so the average is exact.  Large enough
+ * resolves run on the thread pool, the others, including every one with no
+ * pool threads, go through u_blitter, and both must match.
+ */
+static bool
+test_resolve(unsigned verbose, FILE *fp, struct pipe_context *pipe,
+             unsigned num_threads)
+{
+   struct pipe_screen *screen = pipe->screen;
+   struct pipe_resource templ;
+   struct pipe_resource *src = NULL, *dst = NULL;
+   uint8_t *expected = NULL, *result = NULL;
+   const size_t size = SUB_TEX_SIZE * SUB_TEX_SIZE * 4;
+   double gbps = 0.0;
+   bool success = false;
+
+   memset(&templ, 0, sizeof templ);
+   templ.target = PIPE_TEXTURE_2D;
+   templ.format = PIPE_FORMAT_R8G8B8A8_UNORM;
+   templ.width0 = SUB_TEX_SIZE;
+   templ.height0 = SUB_TEX_SIZE;
+   templ.depth0 = 1;
+   templ.array_size = 1;
+   templ.bind = PIPE_BIND_SAMPLER_VIEW | PIPE_BIND_RENDER_TARGET;
+   dst = screen->resource_create(screen, &templ);
+
+   templ.nr_samples = templ.nr_storage_samples = RESOLVE_SAMPLES;
+   src = screen->resource_create(screen, &templ);
+
+   expected = MALLOC(size);
+   result = MALLOC(size);
+   if (!src || !dst || !expected || !result)
+      goto out;
+
+   struct pipe_box box;
+   u_box_2d(0, 0, SUB_TEX_SIZE, SUB_TEX_SIZE, &box);
+
+   for (unsigned s = 0; s < RESOLVE_SAMPLES; s++) {
+      struct pipe_transfer *transfer;
+      uint8_t *map = llvmpipe_transfer_map_ms(pipe, src, 0, PIPE_MAP_WRITE,
+                                              s, &box, &transfer);
+      if (!map)
+         goto out;
+
+      for (unsigned y = 0; y < SUB_TEX_SIZE; y++) {
+         for (unsigned i = 0; i < SUB_TEX_SIZE * 4; i++) {
+            const uint8_t base = (pattern(y, i) >> 24) & 0xf0;
+            map[y * transfer->stride + i] = base + 4 * s;
+            expected[(y * SUB_TEX_SIZE * 4) + i] =
+               base + 2 * (RESOLVE_SAMPLES - 1);
+         }
+      }
+      pipe->texture_unmap(pipe, transfer);
+   }
+
+   struct pipe_blit_info info;
+   memset(&info, 0, sizeof info);
+   info.src.resource = src;
+   info.src.format = src->format;
+   info.src.box = box;
+   info.dst.resource = dst;
+   info.dst.format = dst->format;
+   info.dst.box = box;
+   info.mask = PIPE_MASK_RGBA;
+   info.filter = PIPE_TEX_FILTER_NEAREST;
+
+   int64_t start = os_time_get_nano();
+   pipe->blit(pipe, &info);
+   lp_test_finish(pipe);
+   int64_t end = os_time_get_nano();
+   gbps = (double)size * RESOLVE_SAMPLES / MAX2(end - start, 1);
+
+   success = transfer_image(pipe, dst, result, false) &&
+             memcmp(result, expected, size) == 0;
+
+out:
+   report(verbose, fp, success, num_threads, "resolve", gbps);
+
+   FREE(expected);
+   FREE(result);
+   pipe_resource_reference(&dst, NULL);
+   pipe_resource_reference(&src, NULL);
+   return success;
+}
+
+
+/**
+ * Blits a sub-box from RGBA to BGRA, which swaps the red and blue bytes,
+ * through pipe->blit.
+ */
+static bool
+test_blit_convert(unsigned verbose, FILE *fp, struct pipe_context *pipe,
+                  unsigned num_threads)
+{
+   const struct pipe_box src_box = {
+      .x = 3, .y = 5, .z = 1, .width = 401, .height = 333, .depth = 2,
+   };
+   const struct pipe_box dst_box = {
+      .x = 17, .y = 9, .z = 2, .width = 401, .height = 333, .depth = 2,
+   };
+   struct pipe_resource *src =
+      create_sub_resource(pipe->screen, OP_COPY_TEXTURE,
+                          PIPE_FORMAT_R8G8B8A8_UNORM);
+   struct pipe_resource *dst =
+      create_sub_resource(pipe->screen, OP_COPY_TEXTURE,
+                          PIPE_FORMAT_B8G8R8A8_UNORM);
+   uint8_t *src_image = NULL, *expected = NULL, *result = NULL;
+   unsigned row_bytes, rows, layers;
+   double gbps = 0.0;
+   bool success = false;
+
+   if (!src || !dst)
+      goto out;
+
+   get_layout(src, &row_bytes, &rows, &layers);
+   const size_t size = (size_t)row_bytes * rows * layers;
+   src_image = MALLOC(size);
+   expected = CALLOC(1, size);
+   result = MALLOC(size);
+   if (!src_image || !expected || !result)
+      goto out;
+
+   for (size_t i = 0; i < size; i++)
+      src_image[i] = pattern(i >> 12, i) >> 24;
+   if (!transfer_image(pipe, src, src_image, true) ||
+       !transfer_image(pipe, dst, expected, true))
+      goto out;
+
+   struct pipe_blit_info info;
+   memset(&info, 0, sizeof info);
+   info.src.resource = src;
+   info.src.format = src->format;
+   info.src.box = src_box;
+   info.dst.resource = dst;
+   info.dst.format = dst->format;
+   info.dst.box = dst_box;
+   info.mask = PIPE_MASK_RGBA;
+   info.filter = PIPE_TEX_FILTER_NEAREST;
+
+   int64_t start = os_time_get_nano();
+   pipe->blit(pipe, &info);
+   lp_test_finish(pipe);
+   int64_t end = os_time_get_nano();
+   gbps = (double)src_box.width * src_box.height * src_box.depth * 4 /
+          MAX2(end - start, 1);
+
+   for (unsigned z = 0; z < src_box.depth; z++) {
+      for (unsigned y = 0; y < src_box.height; y++) {
+         const uint8_t *s = sub_texel(src_image, src, src_box.x,
+                                      src_box.y + y, src_box.z + z);
+         uint8_t *d = sub_texel(expected, dst, dst_box.x,
+                                dst_box.y + y, dst_box.z + z);
+         for (unsigned x = 0; x < src_box.width; x++) {
+            d[x * 4 + 0] = s[x * 4 + 2];
+            d[x * 4 + 1] = s[x * 4 + 1];
+            d[x * 4 + 2] = s[x * 4 + 0];
+            d[x * 4 + 3] = s[x * 4 + 3];
+         }
+      }
+   }
+
+   success = transfer_image(pipe, dst, result, false) &&
+             memcmp(result, expected, size) == 0;
+
+out:
+   report(verbose, fp, success, num_threads, "blit_convert", gbps);
+
+   FREE(src_image);
+   FREE(expected);
+   FREE(result);
+   pipe_resource_reference(&dst, NULL);
+   pipe_resource_reference(&src, NULL);
+   return success;
+}
+
+
+static bool
+test_threads(unsigned verbose, FILE *fp, struct sw_winsys *winsys,
+             unsigned num_threads, bool single)
+{
+   struct pipe_screen *screen;
+   struct pipe_context *pipe;
+   bool success = true;
+
+   screen = llvmpipe_create_screen(winsys);
+   if (!screen)
+      return false;
+
+   /* Picked up when the first context creates the thread pool */
+   llvmpipe_screen(screen)->num_threads = num_threads;
+
+   pipe = screen->context_create(screen, NULL, 0);
+   if (!pipe) {
+      screen->destroy(screen);
+      return false;
+   }
+
+   for (unsigned op = 0; op < OP_COUNT; op++) {
+      if (single && op != OP_COPY_TEXTURE)
+         continue;
+      success &= test_op(verbose, fp, pipe, num_threads, op);
+   }
+
+   for (unsigned i = 0; i < ARRAY_SIZE(sub_cases); i++)
+      success &= test_sub_case(verbose, fp, pipe, num_threads, &sub_cases[i]);
+
+   success &= test_image_copy_buffer(verbose, fp, pipe, num_threads);
+   success &= test_resolve(verbose, fp, pipe, num_threads);
+   success &= test_blit_convert(verbose, fp, pipe, num_threads);
+
+   pipe->destroy(pipe);
+   screen->destroy(screen);
+   return success;
+}
+
+
+static bool
+run_tests(unsigned verbose, FILE *fp, bool single)
+{
+   unsigned max_threads =
+      CLAMP(util_get_cpu_caps()->nr_cpus, 1, LP_MAX_THREADS);
+   struct sw_winsys *winsys;
+   bool success = true;
+
+   winsys = null_sw_create();
+   if (!winsys)
+      return false;
+
+   success &= test_threads(verbose, fp, winsys, 0, single);
+
+   /* 1, 2, 4, ... threads, always finishing with max_threads */
+   for (unsigned n = 1; !single; n = MIN2(n * 2, max_threads)) {
+      success &= test_threads(verbose, fp, winsys, n, false);
+      if (n == max_threads)
+         break;
+   }
+
+   if (single)
+      success &= test_threads(verbose, fp, winsys, max_threads, true);
+
+   winsys->destroy(winsys);
+   return success;
+}
+
+
+bool
+test_all(unsigned verbose, FILE *fp)
+{
+   return run_tests(verbose, fp, false);
+}
+
+
+bool
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   return test_all(verbose, fp);
+}
+
+
+bool
+test_single(unsigned verbose, FILE *fp)
+{
+   return run_tests(verbose, fp, true);
+}
@@ -57,6 +57,7 @@
 #include "lp_setup.h"
 #include "lp_state.h"
 #include "lp_rast.h"
+#include "lp_surface.h"
 
 #include "frontend/sw_winsys.h"
 #include "git_sha1.h"
@@ -1897,6 +1898,42 @@ llvmpipe_init_screen_resource_funcs(struct pipe_screen *screen)
 }
 
 
+/**
+ * Like u_default_texture_subdata(), but large uploads are split across the
+ * cs thread pool.
+ */
+static void
+llvmpipe_texture_subdata(struct pipe_context *pipe,
+                         struct pipe_resource *resource,
+                         unsigned level,
+                         unsigned usage,
+                         const struct pipe_box *box,
+                         const void *data,
+                         unsigned stride,
+                         uintptr_t layer_stride)
+{
+   struct pipe_transfer *transfer = NULL;
+
+   assert(!(usage & PIPE_MAP_READ));
+
+   usage |= PIPE_MAP_WRITE | PIPE_MAP_DISCARD_RANGE;
+
+   uint8_t *map = pipe->texture_map(pipe, resource, level, usage, box,
+                                    &transfer);
+   if (!map)
+      return;
+
+   llvmpipe_copy_box(pipe, map, resource->format,
+                     transfer->stride, transfer->layer_stride,
+                     0, 0, 0,
+                     box->width, box->height, box->depth,
+                     data, stride, layer_stride,
+                     0, 0, 0);
+
+   pipe->texture_unmap(pipe, transfer);
+}
+
+
 void
 llvmpipe_init_context_resource_funcs(struct pipe_context *pipe)
 {
@@ -1907,7 +1944,7 @@ llvmpipe_init_context_resource_funcs(struct pipe_context *pipe)
 
    pipe->transfer_flush_region = u_default_transfer_flush_region;
    pipe->buffer_subdata = u_default_buffer_subdata;
-   pipe->texture_subdata = u_default_texture_subdata;
+   pipe->texture_subdata = llvmpipe_texture_subdata;
 
    pipe->memory_barrier = llvmpipe_memory_barrier;
 }
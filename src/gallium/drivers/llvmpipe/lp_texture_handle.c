@@ -35,6 +35,7 @@
 #include "pipe/p_context.h"
 #include "pipe/p_screen.h"
 #include "util/mesa-sha1.h"
+#include "util/os_time.h"
 
 static const char *image_function_base_hash = "8ca89d7a4ab5830be6a1ba1140844081235b01164a8fce8316ca6a2f81f1a899";
 static const char *sample_function_base_hash = "0789b032c4a1ddba086e07496fe2a992b1ee08f78c0884a2923564b1ed52b9cc";
@@ -312,11 +313,15 @@ compile_function(struct llvmpipe_context *ctx, struct gallivm_state *gallivm, LL
                  bool needs_caching,
                  uint8_t cache_key[SHA1_DIGEST_LENGTH])
 {
+   int64_t t0 = os_time_get();
+
    gallivm_verify_function(gallivm, function);
    gallivm_compile_module(gallivm);
 
    void *function_ptr = func_to_pointer(gallivm_jit_function(gallivm, function, func_name));
 
+   lp_jit_count_compile(LP_JIT_TEXTURE, os_time_get() - t0, !needs_caching);
+
    if (needs_caching)
       lp_disk_cache_insert_shader(llvmpipe_screen(ctx->pipe.screen), gallivm->cache, cache_key);
 
@@ -383,7 +388,7 @@ compile_image_function(struct llvmpipe_context *ctx, struct lp_static_texture_st
    _mesa_sha1_final(&hash_ctx, cache_key);
 
    struct lp_cached_code cached = { 0 };
-   lp_disk_cache_find_shader(llvmpipe_screen(ctx->pipe.screen), &cached, cache_key);
+   lp_disk_cache_find_shader(llvmpipe_screen(ctx->pipe.screen), LP_JIT_TEXTURE, &cached, cache_key);
    bool needs_caching = !cached.data_size;
 
    struct gallivm_state *gallivm = gallivm_create("image_function", get_llvm_context(ctx), &cached);
@@ -540,7 +545,7 @@ compile_sample_function(struct llvmpipe_context *ctx, struct lp_texture_handle_s
    _mesa_sha1_final(&hash_ctx, cache_key);
 
    struct lp_cached_code cached = { 0 };
-   lp_disk_cache_find_shader(llvmpipe_screen(ctx->pipe.screen), &cached, cache_key);
+   lp_disk_cache_find_shader(llvmpipe_screen(ctx->pipe.screen), LP_JIT_TEXTURE, &cached, cache_key);
    bool needs_caching = !cached.data_size;
 
    struct gallivm_state *gallivm = gallivm_create("sample_function", get_llvm_context(ctx), &cached);
@@ -641,7 +646,7 @@ compile_size_function(struct llvmpipe_context *ctx, struct lp_texture_handle_sta
    _mesa_sha1_final(&hash_ctx, cache_key);
 
    struct lp_cached_code cached = { 0 };
-   lp_disk_cache_find_shader(llvmpipe_screen(ctx->pipe.screen), &cached, cache_key);
+   lp_disk_cache_find_shader(llvmpipe_screen(ctx->pipe.screen), LP_JIT_TEXTURE, &cached, cache_key);
    bool needs_caching = !cached.data_size;
 
    struct gallivm_state *gallivm = gallivm_create("size_function", get_llvm_context(ctx), &cached);
@@ -867,7 +872,7 @@ compile_jit_sample_function(struct llvmpipe_context *ctx, uint32_t sample_key)
    _mesa_sha1_final(&hash_ctx, cache_key);
 
    struct lp_cached_code cached = { 0 };
-   lp_disk_cache_find_shader(llvmpipe_screen(ctx->pipe.screen), &cached, cache_key);
+   lp_disk_cache_find_shader(llvmpipe_screen(ctx->pipe.screen), LP_JIT_TEXTURE, &cached, cache_key);
    bool needs_caching = !cached.data_size;
 
    struct gallivm_state *gallivm = gallivm_create("jit_sample_function", get_llvm_context(ctx), &cached);
@@ -988,7 +993,7 @@ compile_jit_fetch_function(struct llvmpipe_context *ctx, uint32_t sample_key)
    _mesa_sha1_final(&hash_ctx, cache_key);
 
    struct lp_cached_code cached = { 0 };
-   lp_disk_cache_find_shader(llvmpipe_screen(ctx->pipe.screen), &cached, cache_key);
+   lp_disk_cache_find_shader(llvmpipe_screen(ctx->pipe.screen), LP_JIT_TEXTURE, &cached, cache_key);
    bool needs_caching = !cached.data_size;
 
    struct gallivm_state *gallivm = gallivm_create("jit_fetch_function", get_llvm_context(ctx), &cached);
@@ -1107,7 +1112,7 @@ compile_jit_size_function(struct llvmpipe_context *ctx, bool samples)
    _mesa_sha1_final(&hash_ctx, cache_key);
 
    struct lp_cached_code cached = { 0 };
-   lp_disk_cache_find_shader(llvmpipe_screen(ctx->pipe.screen), &cached, cache_key);
+   lp_disk_cache_find_shader(llvmpipe_screen(ctx->pipe.screen), LP_JIT_TEXTURE, &cached, cache_key);
    bool needs_caching = !cached.data_size;
 
    struct gallivm_state *gallivm = gallivm_create("jit_size_function", get_llvm_context(ctx), &cached);
@@ -0,0 +1,57 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LP_THREAD_H
+#define LP_THREAD_H
+
+#include "util/macros.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_thread.h"
+
+
+/**
+ * Pin the calling worker thread to one L3 cache domain (LP_PIN_THREADS).
+ *
+ * Workers are assigned to domains in contiguous blocks, so threads with
+ * neighbouring indices (which get neighbouring screen regions from the bin
+ * scheduler) share a cache.  L3 domains rather than NUMA nodes are used
+ * because u_cpu_detect only reports the cache topology and Mesa doesn't
+ * depend on libnuma.  An L3 domain never spans NUMA nodes, so memory the
+ * thread first touches after this call still lands on its local node.
+ *
+ * The domain is intersected with the affinity the thread inherited, so a
+ * mask set with taskset or a cgroup cpuset is never widened.  A thread
+ * whose domain lies entirely outside that mask is left unpinned.
+ */
+static inline void
+lp_thread_bind_l3(unsigned index, unsigned num_threads)
+{
+   const struct util_cpu_caps_t *caps = util_get_cpu_caps();
+   util_affinity_mask inherited, mask = { 0 };
+   bool empty = true;
+
+   if (caps->num_L3_caches <= 1 || !caps->L3_affinity_mask)
+      return;
+
+   unsigned l3 = index * caps->num_L3_caches / num_threads;
+
+   /* There is no getter, so read the inherited mask while setting the
+    * domain, then narrow or restore it.
+    */
+   if (!util_set_current_thread_affinity(caps->L3_affinity_mask[l3],
+                                         inherited, caps->num_cpu_mask_bits))
+      return;
+
+   for (unsigned i = 0; i < DIV_ROUND_UP(caps->num_cpu_mask_bits, 32); i++) {
+      mask[i] = inherited[i] & caps->L3_affinity_mask[l3][i];
+      empty &= !mask[i];
+   }
+
+   util_set_current_thread_affinity(empty ? inherited : mask, NULL,
+                                    caps->num_cpu_mask_bits);
+}
+
+
+#endif /* LP_THREAD_H */
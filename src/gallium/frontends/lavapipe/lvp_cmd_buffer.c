@@ -80,14 +80,257 @@ VKAPI_ATTR VkResult VKAPI_CALL lvp_BeginCommandBuffer(
    VK_FROM_HANDLE(lvp_cmd_buffer, cmd_buffer, commandBuffer);
 
    vk_command_buffer_begin(&cmd_buffer->vk, pBeginInfo);
+   cmd_buffer->reusable =
+      !(pBeginInfo->flags & VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
 
    return VK_SUCCESS;
 }
 
+/* State which a command can make redundant when it sets it again. */
+enum lvp_cmd_state {
+   LVP_CMD_STATE_PIPELINE,
+   LVP_CMD_STATE_VIEWPORT,
+   LVP_CMD_STATE_SCISSOR,
+   LVP_CMD_STATE_LINE_WIDTH,
+   LVP_CMD_STATE_DEPTH_BIAS,
+   LVP_CMD_STATE_BLEND_CONSTANTS,
+   LVP_CMD_STATE_DEPTH_BOUNDS,
+   LVP_CMD_STATE_STENCIL_COMPARE_MASK,
+   LVP_CMD_STATE_STENCIL_WRITE_MASK,
+   LVP_CMD_STATE_STENCIL_REFERENCE,
+   LVP_CMD_STATE_STENCIL_OP,
+   LVP_CMD_STATE_CULL_MODE,
+   LVP_CMD_STATE_FRONT_FACE,
+   LVP_CMD_STATE_PRIMITIVE_TOPOLOGY,
+   LVP_CMD_STATE_DEPTH_TEST_ENABLE,
+   LVP_CMD_STATE_DEPTH_WRITE_ENABLE,
+   LVP_CMD_STATE_DEPTH_COMPARE_OP,
+   LVP_CMD_STATE_DEPTH_BOUNDS_TEST_ENABLE,
+   LVP_CMD_STATE_STENCIL_TEST_ENABLE,
+   LVP_CMD_STATE_DEPTH_BIAS_ENABLE,
+   LVP_CMD_STATE_PRIMITIVE_RESTART_ENABLE,
+   LVP_CMD_STATE_RASTERIZER_DISCARD_ENABLE,
+   LVP_CMD_STATE_INDEX_BUFFER,
+   LVP_CMD_STATE_VERTEX_BUFFERS,
+   LVP_CMD_STATE_DESCRIPTOR_SETS,
+   LVP_CMD_STATE_PUSH_CONSTANTS,
+   LVP_CMD_STATE_COUNT,
+   /* Commands which don't change any state, like draws and dispatches */
+   LVP_CMD_STATE_NONE,
+   /* Commands which may change any state */
+   LVP_CMD_STATE_ALL,
+};
+
+static enum lvp_cmd_state
+cmd_state(enum vk_cmd_type type)
+{
+   switch ((unsigned)type) {
+   case VK_CMD_BIND_PIPELINE:
+      return LVP_CMD_STATE_PIPELINE;
+   case VK_CMD_SET_VIEWPORT:
+   case VK_CMD_SET_VIEWPORT_WITH_COUNT:
+      return LVP_CMD_STATE_VIEWPORT;
+   case VK_CMD_SET_SCISSOR:
+   case VK_CMD_SET_SCISSOR_WITH_COUNT:
+      return LVP_CMD_STATE_SCISSOR;
+   case VK_CMD_SET_LINE_WIDTH:
+      return LVP_CMD_STATE_LINE_WIDTH;
+   case VK_CMD_SET_DEPTH_BIAS:
+   case VK_CMD_SET_DEPTH_BIAS2_EXT:
+      return LVP_CMD_STATE_DEPTH_BIAS;
+   case VK_CMD_SET_BLEND_CONSTANTS:
+      return LVP_CMD_STATE_BLEND_CONSTANTS;
+   case VK_CMD_SET_DEPTH_BOUNDS:
+      return LVP_CMD_STATE_DEPTH_BOUNDS;
+   case VK_CMD_SET_STENCIL_COMPARE_MASK:
+      return LVP_CMD_STATE_STENCIL_COMPARE_MASK;
+   case VK_CMD_SET_STENCIL_WRITE_MASK:
+      return LVP_CMD_STATE_STENCIL_WRITE_MASK;
+   case VK_CMD_SET_STENCIL_REFERENCE:
+      return LVP_CMD_STATE_STENCIL_REFERENCE;
+   case VK_CMD_SET_STENCIL_OP:
+      return LVP_CMD_STATE_STENCIL_OP;
+   case VK_CMD_SET_CULL_MODE:
+      return LVP_CMD_STATE_CULL_MODE;
+   case VK_CMD_SET_FRONT_FACE:
+      return LVP_CMD_STATE_FRONT_FACE;
+   case VK_CMD_SET_PRIMITIVE_TOPOLOGY:
+      return LVP_CMD_STATE_PRIMITIVE_TOPOLOGY;
+   case VK_CMD_SET_DEPTH_TEST_ENABLE:
+      return LVP_CMD_STATE_DEPTH_TEST_ENABLE;
+   case VK_CMD_SET_DEPTH_WRITE_ENABLE:
+      return LVP_CMD_STATE_DEPTH_WRITE_ENABLE;
+   case VK_CMD_SET_DEPTH_COMPARE_OP:
+      return LVP_CMD_STATE_DEPTH_COMPARE_OP;
+   case VK_CMD_SET_DEPTH_BOUNDS_TEST_ENABLE:
+      return LVP_CMD_STATE_DEPTH_BOUNDS_TEST_ENABLE;
+   case VK_CMD_SET_STENCIL_TEST_ENABLE:
+      return LVP_CMD_STATE_STENCIL_TEST_ENABLE;
+   case VK_CMD_SET_DEPTH_BIAS_ENABLE:
+      return LVP_CMD_STATE_DEPTH_BIAS_ENABLE;
+   case VK_CMD_SET_PRIMITIVE_RESTART_ENABLE:
+      return LVP_CMD_STATE_PRIMITIVE_RESTART_ENABLE;
+   case VK_CMD_SET_RASTERIZER_DISCARD_ENABLE:
+      return LVP_CMD_STATE_RASTERIZER_DISCARD_ENABLE;
+   case VK_CMD_BIND_INDEX_BUFFER:
+   case VK_CMD_BIND_INDEX_BUFFER2:
+      return LVP_CMD_STATE_INDEX_BUFFER;
+   case VK_CMD_BIND_VERTEX_BUFFERS2:
+      return LVP_CMD_STATE_VERTEX_BUFFERS;
+   case VK_CMD_BIND_DESCRIPTOR_SETS2:
+      return LVP_CMD_STATE_DESCRIPTOR_SETS;
+   case VK_CMD_PUSH_CONSTANTS2:
+      return LVP_CMD_STATE_PUSH_CONSTANTS;
+   case VK_CMD_DRAW:
+   case VK_CMD_DRAW_MULTI_EXT:
+   case VK_CMD_DRAW_INDEXED:
+   case VK_CMD_DRAW_MULTI_INDEXED_EXT:
+   case VK_CMD_DRAW_INDIRECT:
+   case VK_CMD_DRAW_INDEXED_INDIRECT:
+   case VK_CMD_DRAW_INDIRECT_COUNT:
+   case VK_CMD_DRAW_INDEXED_INDIRECT_COUNT:
+   case VK_CMD_DRAW_MESH_TASKS_EXT:
+   case VK_CMD_DRAW_MESH_TASKS_INDIRECT_EXT:
+   case VK_CMD_DRAW_MESH_TASKS_INDIRECT_COUNT_EXT:
+   case VK_CMD_DISPATCH:
+   case VK_CMD_DISPATCH_BASE:
+   case VK_CMD_DISPATCH_INDIRECT:
+      return LVP_CMD_STATE_NONE;
+   default:
+      /* Secondaries, meta operations, shader objects, push descriptors,
+       * descriptor buffers, DGC, ...
+       */
+      return LVP_CMD_STATE_ALL;
+   }
+}
+
+static bool
+cmds_equal(const struct vk_cmd_queue_entry *a, const struct vk_cmd_queue_entry *b)
+{
+   if (a->type != b->type)
+      return false;
+
+   switch (a->type) {
+   case VK_CMD_SET_VIEWPORT:
+      return a->u.set_viewport.first_viewport == b->u.set_viewport.first_viewport &&
+             a->u.set_viewport.viewport_count == b->u.set_viewport.viewport_count &&
+             !memcmp(a->u.set_viewport.viewports, b->u.set_viewport.viewports,
+                     a->u.set_viewport.viewport_count * sizeof(VkViewport));
+   case VK_CMD_SET_VIEWPORT_WITH_COUNT:
+      return a->u.set_viewport_with_count.viewport_count == b->u.set_viewport_with_count.viewport_count &&
+             !memcmp(a->u.set_viewport_with_count.viewports, b->u.set_viewport_with_count.viewports,
+                     a->u.set_viewport_with_count.viewport_count * sizeof(VkViewport));
+   case VK_CMD_SET_SCISSOR:
+      return a->u.set_scissor.first_scissor == b->u.set_scissor.first_scissor &&
+             a->u.set_scissor.scissor_count == b->u.set_scissor.scissor_count &&
+             !memcmp(a->u.set_scissor.scissors, b->u.set_scissor.scissors,
+                     a->u.set_scissor.scissor_count * sizeof(VkRect2D));
+   case VK_CMD_SET_SCISSOR_WITH_COUNT:
+      return a->u.set_scissor_with_count.scissor_count == b->u.set_scissor_with_count.scissor_count &&
+             !memcmp(a->u.set_scissor_with_count.scissors, b->u.set_scissor_with_count.scissors,
+                     a->u.set_scissor_with_count.scissor_count * sizeof(VkRect2D));
+   case VK_CMD_BIND_VERTEX_BUFFERS2: {
+      const struct vk_cmd_bind_vertex_buffers2 *va = &a->u.bind_vertex_buffers2;
+      const struct vk_cmd_bind_vertex_buffers2 *vb = &b->u.bind_vertex_buffers2;
+      const uint32_t count = va->binding_count;
+      return va->first_binding == vb->first_binding &&
+             va->binding_count == vb->binding_count &&
+             !va->sizes == !vb->sizes && !va->strides == !vb->strides &&
+             !memcmp(va->buffers, vb->buffers, count * sizeof(VkBuffer)) &&
+             !memcmp(va->offsets, vb->offsets, count * sizeof(VkDeviceSize)) &&
+             (!va->sizes || !memcmp(va->sizes, vb->sizes, count * sizeof(VkDeviceSize))) &&
+             (!va->strides || !memcmp(va->strides, vb->strides, count * sizeof(VkDeviceSize)));
+   }
+   case VK_CMD_BIND_DESCRIPTOR_SETS2: {
+      const VkBindDescriptorSetsInfoKHR *ia = a->u.bind_descriptor_sets2.bind_descriptor_sets_info;
+      const VkBindDescriptorSetsInfoKHR *ib = b->u.bind_descriptor_sets2.bind_descriptor_sets_info;
+      return !ia->pNext && !ib->pNext &&
+             ia->stageFlags == ib->stageFlags &&
+             ia->layout == ib->layout &&
+             ia->firstSet == ib->firstSet &&
+             ia->descriptorSetCount == ib->descriptorSetCount &&
+             ia->dynamicOffsetCount == ib->dynamicOffsetCount &&
+             !memcmp(ia->pDescriptorSets, ib->pDescriptorSets,
+                     ia->descriptorSetCount * sizeof(VkDescriptorSet)) &&
+             (!ia->dynamicOffsetCount ||
+              !memcmp(ia->pDynamicOffsets, ib->pDynamicOffsets,
+                      ia->dynamicOffsetCount * sizeof(uint32_t)));
+   }
+   case VK_CMD_PUSH_CONSTANTS2: {
+      const VkPushConstantsInfoKHR *ia = a->u.push_constants2.push_constants_info;
+      const VkPushConstantsInfoKHR *ib = b->u.push_constants2.push_constants_info;
+      return !ia->pNext && !ib->pNext &&
+             ia->layout == ib->layout &&
+             ia->stageFlags == ib->stageFlags &&
+             ia->offset == ib->offset &&
+             ia->size == ib->size &&
+             !memcmp(ia->pValues, ib->pValues, ia->size);
+   }
+   case VK_CMD_SET_DEPTH_BIAS2_EXT:
+      return false;
+   default:
+      /* The remaining commands have no pointers, and entries are zeroed
+       * when they are allocated, padding included.
+       */
+      return !memcmp(&a->u, &b->u, vk_cmd_queue_type_sizes[a->type] -
+                                    offsetof(struct vk_cmd_queue_entry, u));
+   }
+}
+
+/**
+ * Prepares a reusable command buffer for being submitted many times: drops
+ * the commands which set state to the value it already has, so that
+ * lvp_execute_cmds() doesn't re-emit it on every submission.  Pipelines are
+ * still compiled by the first submission that binds them, compiling them
+ * here would need queue 0's lock, which is held for as long as it executes.
+ *
+ * A command is redundant if it is equal to the previous command which set
+ * the same state and nothing in between may have changed it.  Binding a
+ * pipeline applies its static state as well, so it can only be skipped when
+ * just draws, dispatches, descriptor sets and push constants were recorded
+ * since the same pipeline was bound.
+ */
+static void
+lvp_cmd_buffer_optimize(struct lvp_cmd_buffer *cmd_buffer)
+{
+   struct vk_cmd_queue_entry *last[LVP_CMD_STATE_COUNT] = { NULL };
+
+   list_for_each_entry_safe(struct vk_cmd_queue_entry, cmd,
+                            &cmd_buffer->vk.cmd_queue.cmds, cmd_link) {
+      const enum lvp_cmd_state state =
+         cmd->type < VK_CMD_TYPE_COUNT ? cmd_state(cmd->type) : LVP_CMD_STATE_ALL;
+
+      if (state == LVP_CMD_STATE_NONE)
+         continue;
+
+      if (state == LVP_CMD_STATE_ALL) {
+         memset(last, 0, sizeof(last));
+         continue;
+      }
+
+      if (last[state] && cmds_equal(last[state], cmd)) {
+         list_del(&cmd->cmd_link);
+         continue;
+      }
+
+      if (state == LVP_CMD_STATE_PIPELINE) {
+         memset(last, 0, sizeof(last));
+      } else if (state != LVP_CMD_STATE_DESCRIPTOR_SETS &&
+                 state != LVP_CMD_STATE_PUSH_CONSTANTS) {
+         last[LVP_CMD_STATE_PIPELINE] = NULL;
+      }
+
+      last[state] = cmd;
+   }
+}
+
 VKAPI_ATTR VkResult VKAPI_CALL lvp_EndCommandBuffer(
    VkCommandBuffer                             commandBuffer)
 {
    VK_FROM_HANDLE(lvp_cmd_buffer, cmd_buffer, commandBuffer);
 
+   if (cmd_buffer->reusable && !vk_command_buffer_has_error(&cmd_buffer->vk))
+      lvp_cmd_buffer_optimize(cmd_buffer);
+
    return vk_command_buffer_end(&cmd_buffer->vk);
 }
@@ -43,6 +43,41 @@ binding_has_immutable_samplers(const VkDescriptorSetLayoutBinding *binding)
    }
 }
 
+/* Everything lvp_lower_pipeline_layout() and the YCbCr lowering read from
+ * the layout, so pipeline cache keys can use vk.blake3.
+ */
+static void
+lvp_descriptor_set_layout_hash(struct lvp_descriptor_set_layout *layout)
+{
+   struct mesa_blake3 ctx;
+   _mesa_blake3_init(&ctx);
+
+   _mesa_blake3_update(&ctx, &layout->vk.flags, sizeof(layout->vk.flags));
+   _mesa_blake3_update(&ctx, &layout->binding_count, sizeof(layout->binding_count));
+   _mesa_blake3_update(&ctx, &layout->size, sizeof(layout->size));
+
+   for (uint32_t b = 0; b < layout->binding_count; b++) {
+      const struct lvp_descriptor_set_binding_layout *binding = &layout->binding[b];
+
+      _mesa_blake3_update(&ctx, binding,
+                          offsetof(struct lvp_descriptor_set_binding_layout, immutable_samplers));
+
+      if (!binding->immutable_samplers)
+         continue;
+
+      for (uint32_t i = 0; i < binding->array_size; i++) {
+         const struct vk_ycbcr_conversion *conversion =
+            binding->immutable_samplers[i]->vk.ycbcr_conversion;
+         const bool has_conversion = conversion != NULL;
+         _mesa_blake3_update(&ctx, &has_conversion, sizeof(has_conversion));
+         if (has_conversion)
+            _mesa_blake3_update(&ctx, &conversion->state, sizeof(conversion->state));
+      }
+   }
+
+   _mesa_blake3_final(&ctx, layout->vk.blake3);
+}
+
 static void
 lvp_descriptor_set_layout_destroy(struct vk_device *_device, struct vk_descriptor_set_layout *_layout)
 {
@@ -186,6 +221,8 @@ VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateDescriptorSetLayout(
 
    set_layout->dynamic_offset_count = dynamic_offset_count;
 
+   lvp_descriptor_set_layout_hash(set_layout);
+
    if (set_layout->binding_count == set_layout->immutable_sampler_count) {
       /* create a bindable set with all the immutable samplers */
       lvp_descriptor_set_create(device, set_layout, &set_layout->immutable_set);
@@ -753,195 +790,275 @@ VKAPI_ATTR void VKAPI_CALL lvp_GetDescriptorSetLayoutSupport(VkDevice device,
    pSupport->supported = true;
 }
 
-void
-lvp_descriptor_set_update_with_template(VkDevice _device, VkDescriptorSet descriptorSet,
-                                        VkDescriptorUpdateTemplate descriptorUpdateTemplate,
-                                        const void *pData)
+static void
+write_null_texture(struct lvp_device *device, struct lp_descriptor *desc,
+                   unsigned stride)
 {
-   VK_FROM_HANDLE(lvp_device, device, _device);
-   VK_FROM_HANDLE(lvp_descriptor_set, set, descriptorSet);
-   VK_FROM_HANDLE(vk_descriptor_update_template, templ, descriptorUpdateTemplate);
-   uint32_t i, j;
+   for (unsigned k = 0; k < stride; k++) {
+      desc[k].functions = device->null_texture_handle->functions;
+      desc[k].texture.sampler_index = 0;
+   }
+}
 
-   for (i = 0; i < templ->entry_count; ++i) {
-      struct vk_descriptor_template_entry *entry = &templ->entries[i];
+/* Runs one op of a compiled update template, see
+ * lvp_descriptor_update_program_compile().
+ */
+static void
+lvp_descriptor_update_op_execute(struct lvp_device *device, uint8_t *map,
+                                 const struct lvp_descriptor_update_op *op,
+                                 const uint8_t *pSrc)
+{
+   struct lp_descriptor *desc = (struct lp_descriptor *)map + op->dst;
+   const unsigned stride = op->dst_stride;
+   const size_t src_stride = op->src_stride;
 
-      const uint8_t *pSrc = ((const uint8_t *) pData) + entry->offset;
+   pSrc += op->src;
 
-      const struct lvp_descriptor_set_binding_layout *bind_layout =
-         &set->layout->binding[entry->binding];
+   switch (op->type) {
+   case VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK:
+      memcpy(map + op->dst, pSrc, op->count);
+      break;
 
-      if (entry->type == VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK) {
-         memcpy((uint8_t *)set->map + bind_layout->uniform_block_offset + entry->array_element, pSrc, entry->array_count);
-         continue;
-      }
+   case VK_DESCRIPTOR_TYPE_SAMPLER:
+      for (uint32_t j = 0; j < op->count; j++, desc += stride, pSrc += src_stride) {
+         const VkDescriptorImageInfo *info = (const VkDescriptorImageInfo *)pSrc;
+         VK_FROM_HANDLE(lvp_sampler, sampler, info->sampler);
 
-      struct lp_descriptor *desc = set->map;
-      desc += bind_layout->descriptor_index;
+         for (unsigned k = 0; k < stride; k++) {
+            desc[k].sampler = sampler->desc.sampler;
+            desc[k].texture.sampler_index = sampler->desc.texture.sampler_index;
+         }
+      }
+      break;
 
-      for (j = 0; j < entry->array_count; ++j) {
-         unsigned idx = j + entry->array_element;
+   case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+   case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE: {
+      const bool write_sampler = op->type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER &&
+                                 !op->immutable_samplers;
 
-         idx *= bind_layout->stride;
-         switch (entry->type) {
-         case VK_DESCRIPTOR_TYPE_SAMPLER: {
-            VkDescriptorImageInfo *info = (VkDescriptorImageInfo *)pSrc;
-            VK_FROM_HANDLE(lvp_sampler, sampler, info->sampler);
+      for (uint32_t j = 0; j < op->count; j++, desc += stride, pSrc += src_stride) {
+         const VkDescriptorImageInfo *info = (const VkDescriptorImageInfo *)pSrc;
+         VK_FROM_HANDLE(lvp_image_view, iview, info->imageView);
 
-            for (unsigned k = 0; k < bind_layout->stride; k++) {
-               desc[idx + k].sampler = sampler->desc.sampler;
-               desc[idx + k].texture.sampler_index = sampler->desc.texture.sampler_index;
-            }
-            break;
+         if (!iview) {
+            write_null_texture(device, desc, stride);
+            continue;
          }
-         case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER: {
-            VkDescriptorImageInfo *info = (VkDescriptorImageInfo *)pSrc;
-            VK_FROM_HANDLE(lvp_image_view, iview, info->imageView);
 
-            if (iview) {
-               for (unsigned p = 0; p < iview->plane_count; p++) {
-                  lp_jit_bindless_texture_from_pipe(&desc[idx + p].texture, iview->planes[p].sv);
-                  desc[idx + p].functions = iview->planes[p].texture_handle->functions;
-               }
+         for (unsigned p = 0; p < iview->plane_count; p++) {
+            lp_jit_bindless_texture_from_pipe(&desc[p].texture, iview->planes[p].sv);
+            desc[p].functions = iview->planes[p].texture_handle->functions;
+         }
 
-               if (!bind_layout->immutable_samplers) {
-                  VK_FROM_HANDLE(lvp_sampler, sampler, info->sampler);
+         if (write_sampler) {
+            VK_FROM_HANDLE(lvp_sampler, sampler, info->sampler);
 
-                  for (unsigned p = 0; p < iview->plane_count; p++) {
-                     desc[idx + p].sampler = sampler->desc.sampler;
-                     desc[idx + p].texture.sampler_index = sampler->desc.texture.sampler_index;
-                  }
-               }
-            } else {
-               for (unsigned k = 0; k < bind_layout->stride; k++) {
-                  desc[idx + k].functions = device->null_texture_handle->functions;
-                  desc[idx + k].texture.sampler_index = 0;
-               }
+            for (unsigned p = 0; p < iview->plane_count; p++) {
+               desc[p].sampler = sampler->desc.sampler;
+               desc[p].texture.sampler_index = sampler->desc.texture.sampler_index;
             }
-            break;
          }
-         case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE: {
-            VkDescriptorImageInfo *info = (VkDescriptorImageInfo *)pSrc;
-            VK_FROM_HANDLE(lvp_image_view, iview, info->imageView);
+      }
+      break;
+   }
 
-            if (iview) {
-               for (unsigned p = 0; p < iview->plane_count; p++) {
-                  lp_jit_bindless_texture_from_pipe(&desc[idx + p].texture, iview->planes[p].sv);
-                  desc[idx + p].functions = iview->planes[p].texture_handle->functions;
-               }
-            } else {
-               for (unsigned k = 0; k < bind_layout->stride; k++) {
-                  desc[idx + k].functions = device->null_texture_handle->functions;
-                  desc[idx + k].texture.sampler_index = 0;
-               }
+   case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+   case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+      for (uint32_t j = 0; j < op->count; j++, desc += stride, pSrc += src_stride) {
+         VK_FROM_HANDLE(lvp_image_view, iview,
+                        ((const VkDescriptorImageInfo *)pSrc)->imageView);
+
+         if (iview) {
+            for (unsigned p = 0; p < iview->plane_count; p++) {
+               lp_jit_image_from_pipe(&desc[p].image, &iview->planes[p].iv);
+               desc[p].functions = iview->planes[p].image_handle->functions;
             }
-            break;
+         } else {
+            memset(desc, 0, sizeof(*desc) * stride);
+            for (unsigned k = 0; k < stride; k++)
+               desc[k].functions = device->null_image_handle->functions;
          }
-         case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-         case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT: {
-            VK_FROM_HANDLE(lvp_image_view, iview,
-                            ((VkDescriptorImageInfo *)pSrc)->imageView);
+      }
+      break;
 
-            if (iview) {
-               for (unsigned p = 0; p < iview->plane_count; p++) {
-                  lp_jit_image_from_pipe(&desc[idx + p].image, &iview->planes[p].iv);
-                  desc[idx + p].functions = iview->planes[p].image_handle->functions;
-               }
-            } else {
-               memset(&desc[idx], 0, sizeof(desc[idx]) * bind_layout->stride);
-               for (unsigned k = 0; k < bind_layout->stride; k++)
-                  desc[idx + k].functions = device->null_image_handle->functions;
-            }
-            break;
-         }
-         case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER: {
-            VK_FROM_HANDLE(lvp_buffer_view, bview,
-                            *(VkBufferView *)pSrc);
-            assert(bind_layout->stride == 1);
-            if (bview) {
-               lp_jit_bindless_texture_from_pipe(&desc[idx].texture, bview->sv);
-               desc[idx].functions = bview->texture_handle->functions;
-            } else {
-               desc[j].functions = device->null_texture_handle->functions;
-               desc[j].texture.sampler_index = 0;
-            }
-            break;
+   case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+      for (uint32_t j = 0; j < op->count; j++, desc++, pSrc += src_stride) {
+         VK_FROM_HANDLE(lvp_buffer_view, bview, *(const VkBufferView *)pSrc);
+
+         if (bview) {
+            lp_jit_bindless_texture_from_pipe(&desc->texture, bview->sv);
+            desc->functions = bview->texture_handle->functions;
+         } else {
+            write_null_texture(device, desc, 1);
          }
-         case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER: {
-            VK_FROM_HANDLE(lvp_buffer_view, bview,
-                            *(VkBufferView *)pSrc);
-            assert(bind_layout->stride == 1);
-            if (bview) {
-               lp_jit_image_from_pipe(&desc[idx].image, &bview->iv);
-               desc[idx].functions = bview->image_handle->functions;
-            } else {
-               memset(&desc[idx].image, 0, sizeof(desc[idx].image));
-               desc[idx].functions = device->null_image_handle->functions;
-            }
-            break;
+      }
+      break;
+
+   case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+      for (uint32_t j = 0; j < op->count; j++, desc++, pSrc += src_stride) {
+         VK_FROM_HANDLE(lvp_buffer_view, bview, *(const VkBufferView *)pSrc);
+
+         if (bview) {
+            lp_jit_image_from_pipe(&desc->image, &bview->iv);
+            desc->functions = bview->image_handle->functions;
+         } else {
+            memset(&desc->image, 0, sizeof(desc->image));
+            desc->functions = device->null_image_handle->functions;
          }
+      }
+      break;
 
-         case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
-         case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC: {
-            VkDescriptorBufferInfo *info = (VkDescriptorBufferInfo *)pSrc;
-            VK_FROM_HANDLE(lvp_buffer, buffer, info->buffer);
-            assert(bind_layout->stride == 1);
-            if (buffer) {
-               struct pipe_constant_buffer ubo = {
-                  .buffer = buffer->bo,
-                  .buffer_offset = info->offset,
-                  .buffer_size = info->range,
-               };
+   case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+   case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+      for (uint32_t j = 0; j < op->count; j++, desc++, pSrc += src_stride) {
+         const VkDescriptorBufferInfo *info = (const VkDescriptorBufferInfo *)pSrc;
+         VK_FROM_HANDLE(lvp_buffer, buffer, info->buffer);
+         struct pipe_constant_buffer ubo = { 0 };
+
+         if (buffer) {
+            ubo.buffer = buffer->bo;
+            ubo.buffer_offset = info->offset;
+            ubo.buffer_size = info->range;
+            if (info->range == VK_WHOLE_SIZE)
+               ubo.buffer_size = buffer->bo->width0 - ubo.buffer_offset;
+         }
 
-               if (info->range == VK_WHOLE_SIZE)
-                  ubo.buffer_size = buffer->bo->width0 - ubo.buffer_offset;
+         lp_jit_buffer_from_pipe_const(&desc->buffer, &ubo, device->pscreen);
+      }
+      break;
 
-               lp_jit_buffer_from_pipe_const(&desc[idx].buffer, &ubo, device->pscreen);
-            } else {
-               lp_jit_buffer_from_pipe_const(&desc[idx].buffer, &((struct pipe_constant_buffer){0}), device->pscreen);
-            }
-            break;
+   case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+   case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+      for (uint32_t j = 0; j < op->count; j++, desc++, pSrc += src_stride) {
+         const VkDescriptorBufferInfo *info = (const VkDescriptorBufferInfo *)pSrc;
+         VK_FROM_HANDLE(lvp_buffer, buffer, info->buffer);
+         struct pipe_shader_buffer ssbo = { 0 };
+
+         if (buffer) {
+            ssbo.buffer = buffer->bo;
+            ssbo.buffer_offset = info->offset;
+            ssbo.buffer_size = info->range;
+            if (info->range == VK_WHOLE_SIZE)
+               ssbo.buffer_size = buffer->bo->width0 - ssbo.buffer_offset;
          }
 
-         case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
-         case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC: {
-            VkDescriptorBufferInfo *info = (VkDescriptorBufferInfo *)pSrc;
-            VK_FROM_HANDLE(lvp_buffer, buffer, info->buffer);
-            assert(bind_layout->stride == 1);
+         lp_jit_buffer_from_pipe(&desc->buffer, &ssbo);
+      }
+      break;
 
-            if (buffer) {
-               struct pipe_shader_buffer ubo = {
-                  .buffer = buffer->bo,
-                  .buffer_offset = info->offset,
-                  .buffer_size = info->range,
-               };
+   case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR:
+      for (uint32_t j = 0; j < op->count; j++, desc++, pSrc += src_stride) {
+         VK_FROM_HANDLE(vk_acceleration_structure, accel_struct,
+                        *(const VkAccelerationStructureKHR *)pSrc);
+         desc->accel_struct = accel_struct ? vk_acceleration_structure_get_va(accel_struct) : 0;
+      }
+      break;
 
-               if (info->range == VK_WHOLE_SIZE)
-                  ubo.buffer_size = buffer->bo->width0 - ubo.buffer_offset;
+   default:
+      UNREACHABLE("Unsupported descriptor type");
+      break;
+   }
+}
 
-               lp_jit_buffer_from_pipe(&desc[idx].buffer, &ubo);
-            } else {
-               lp_jit_buffer_from_pipe(&desc[idx].buffer, &((struct pipe_shader_buffer){0}));
-            }
-            break;
-         }
+void
+lvp_descriptor_set_update_with_template(VkDevice _device, VkDescriptorSet descriptorSet,
+                                        VkDescriptorUpdateTemplate descriptorUpdateTemplate,
+                                        const void *pData)
+{
+   VK_FROM_HANDLE(lvp_device, device, _device);
+   VK_FROM_HANDLE(lvp_descriptor_set, set, descriptorSet);
+   VK_FROM_HANDLE(vk_descriptor_update_template, templ, descriptorUpdateTemplate);
+   const struct lvp_descriptor_update_program *program = templ->driver_data;
 
-         case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR: {
-            VK_FROM_HANDLE(vk_acceleration_structure, accel_struct, *(VkAccelerationStructureKHR *)pSrc);
-            desc[idx].accel_struct = accel_struct ? vk_acceleration_structure_get_va(accel_struct) : 0;
-            break;
-         }
+   for (uint32_t i = 0; i < program->op_count; i++)
+      lvp_descriptor_update_op_execute(device, set->map, &program->ops[i], pData);
+}
 
-         default:
-            UNREACHABLE("Unsupported descriptor type");
-            break;
-         }
+/* Turns the template entries into ops against the set layout, resolving the
+ * descriptor offsets up front and merging entries which continue each other
+ * in both the set and the user data.
+ */
+static void
+lvp_descriptor_update_program_compile(const struct vk_descriptor_update_template *templ,
+                                      const struct lvp_descriptor_set_layout *layout,
+                                      struct lvp_descriptor_update_program *program)
+{
+   program->op_count = 0;
 
-         pSrc += entry->stride;
+   for (uint32_t i = 0; i < templ->entry_count; i++) {
+      const struct vk_descriptor_template_entry *entry = &templ->entries[i];
+      const struct lvp_descriptor_set_binding_layout *bind_layout =
+         &layout->binding[entry->binding];
+      struct lvp_descriptor_update_op op = {
+         .type = entry->type,
+         .immutable_samplers = bind_layout->immutable_samplers != NULL,
+         .count = entry->array_count,
+         .dst_stride = bind_layout->stride,
+         .src = entry->offset,
+         .src_stride = entry->stride,
+      };
+
+      if (entry->type == VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK) {
+         op.dst = bind_layout->uniform_block_offset + entry->array_element;
+         op.dst_stride = 1;
+         op.src_stride = 1;
+      } else {
+         op.dst = bind_layout->descriptor_index +
+                  entry->array_element * bind_layout->stride;
+      }
+
+      if (program->op_count > 0) {
+         struct lvp_descriptor_update_op *prev = &program->ops[program->op_count - 1];
+
+         if (prev->type == op.type &&
+             prev->immutable_samplers == op.immutable_samplers &&
+             prev->dst_stride == op.dst_stride &&
+             prev->src_stride == op.src_stride &&
+             prev->dst + prev->count * prev->dst_stride == op.dst &&
+             prev->src + prev->count * prev->src_stride == op.src) {
+            prev->count += op.count;
+            continue;
+         }
       }
+
+      program->ops[program->op_count++] = op;
    }
 }
 
+VKAPI_ATTR VkResult VKAPI_CALL
+lvp_CreateDescriptorUpdateTemplate(VkDevice _device,
+                                   const VkDescriptorUpdateTemplateCreateInfo *pCreateInfo,
+                                   const VkAllocationCallbacks *pAllocator,
+                                   VkDescriptorUpdateTemplate *pDescriptorUpdateTemplate)
+{
+   VK_FROM_HANDLE(lvp_device, device, _device);
+   struct vk_descriptor_update_template *templ;
+   const struct vk_descriptor_set_layout *set_layout;
+
+   if (pCreateInfo->templateType == VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS) {
+      VK_FROM_HANDLE(lvp_pipeline_layout, layout, pCreateInfo->pipelineLayout);
+      set_layout = layout->vk.set_layouts[pCreateInfo->set];
+   } else {
+      set_layout = vk_descriptor_set_layout_from_handle(pCreateInfo->descriptorSetLayout);
+   }
+
+   /* Merging only ever makes the program shorter than the entry list */
+   const size_t program_size = sizeof(struct lvp_descriptor_update_program) +
+      pCreateInfo->descriptorUpdateEntryCount * sizeof(struct lvp_descriptor_update_op);
+
+   VkResult result = vk_descriptor_update_template_create(&device->vk, pCreateInfo,
+                                                          program_size, &templ);
+   if (result != VK_SUCCESS)
+      return result;
+
+   lvp_descriptor_update_program_compile(templ, vk_to_lvp_descriptor_set_layout(set_layout),
+                                         templ->driver_data);
+
+   *pDescriptorUpdateTemplate = vk_descriptor_update_template_to_handle(templ);
+
+   return VK_SUCCESS;
+}
+
 VKAPI_ATTR void VKAPI_CALL
 lvp_UpdateDescriptorSetWithTemplate(VkDevice device, VkDescriptorSet descriptorSet,
                                     VkDescriptorUpdateTemplate descriptorUpdateTemplate,
@@ -28,9 +28,13 @@
 #include "pipe-loader/pipe_loader.h"
 #include "git_sha1.h"
 #include "vk_cmd_enqueue_entrypoints.h"
+#include "vk_pipeline_cache.h"
 #include "vk_sampler.h"
 #include "vk_util.h"
 #include "util/detect.h"
+#include "util/disk_cache.h"
+#include "util/hex.h"
+#include "util/mesa-sha1.h"
 #include "pipe/p_defines.h"
 #include "pipe/p_state.h"
 #include "pipe/p_context.h"
@@ -888,6 +892,24 @@ static VkImageLayout lvp_host_copy_image_layouts[] = {
    VK_IMAGE_LAYOUT_FRAGMENT_SHADING_RATE_ATTACHMENT_OPTIMAL_KHR,
 };
 
+/* Pipeline caches hold serialized NIR, which is only stable within a
+ * build.
+ */
+static void
+lvp_device_get_pipeline_cache_uuid(void *uuid)
+{
+   struct mesa_sha1 ctx;
+   unsigned char sha1[SHA1_DIGEST_LENGTH];
+   _mesa_sha1_init(&ctx);
+   if (disk_cache_get_function_identifier(lvp_device_get_pipeline_cache_uuid, &ctx)) {
+      _mesa_sha1_final(&ctx, sha1);
+      memcpy(uuid, sha1, VK_UUID_SIZE);
+      return;
+   }
+
+   lvp_device_get_cache_uuid(uuid);
+}
+
 static void
 lvp_get_properties(const struct lvp_physical_device *device, struct vk_properties *p)
 {
@@ -1169,7 +1191,7 @@ lvp_get_properties(const struct lvp_physical_device *device, struct vk_propertie
       .deviceGeneratedCommandsMultiDrawIndirectCount = true,
 
       /* VK_EXT_external_memory_host */
-      .minImportedHostPointerAlignment = 4096,
+      .minImportedHostPointerAlignment = LVP_HOST_POINTER_ALIGNMENT,
 
       /* VK_EXT_custom_border_color */
       .maxCustomBorderColorSamplers = 32 * 1024,
@@ -1308,7 +1330,7 @@ lvp_get_properties(const struct lvp_physical_device *device, struct vk_propertie
 
    /* Vulkan 1.0 */
    strcpy(p->deviceName, device->pscreen->get_name(device->pscreen));
-   lvp_device_get_cache_uuid(p->pipelineCacheUUID);
+   lvp_device_get_pipeline_cache_uuid(p->pipelineCacheUUID);
 
    /* Vulkan 1.1 */
    device->pscreen->get_device_uuid(device->pscreen, (char*)(p->deviceUUID));
@@ -1427,9 +1449,19 @@ lvp_physical_device_init(struct lvp_physical_device *device,
    lvp_get_features(device, &device->vk.supported_features);
    lvp_get_properties(device, &device->vk.properties);
 
+#ifdef ENABLE_SHADER_CACHE
+   /* Lowered NIR from vk_pipeline_cache.  The LLVM object code for the
+    * variants stays in llvmpipe's own disk cache.
+    */
+   char timestamp[VK_UUID_SIZE * 2 + 1];
+   mesa_bytes_to_hex(timestamp, device->vk.properties.pipelineCacheUUID, VK_UUID_SIZE);
+   device->vk.disk_cache = disk_cache_create("lavapipe", timestamp, 0);
+#endif
+
 #ifdef LVP_USE_WSI_PLATFORM
    result = lvp_init_wsi(device);
    if (result != VK_SUCCESS) {
+      disk_cache_destroy(device->vk.disk_cache);
       vk_physical_device_finish(&device->vk);
       vk_error(instance, result);
       goto fail;
@@ -1447,6 +1479,7 @@ lvp_physical_device_finish(struct lvp_physical_device *device)
 #ifdef LVP_USE_WSI_PLATFORM
    lvp_finish_wsi(device);
 #endif
+   disk_cache_destroy(device->vk.disk_cache);
    device->pscreen->destroy(device->pscreen);
    vk_physical_device_finish(&device->vk);
 }
@@ -1622,7 +1655,7 @@ VKAPI_ATTR void VKAPI_CALL lvp_GetPhysicalDeviceQueueFamilyProperties2(
          VK_QUEUE_COMPUTE_BIT |
          VK_QUEUE_TRANSFER_BIT |
          (DETECT_OS_LINUX ? VK_QUEUE_SPARSE_BINDING_BIT : 0),
-         .queueCount = 1,
+         .queueCount = LVP_NUM_QUEUES,
          .timestampValidBits = 64,
          .minImageTransferGranularity = (VkExtent3D) { 1, 1, 1 },
       };
@@ -1682,6 +1715,8 @@ lvp_GetMemoryHostPointerPropertiesEXT(
 {
    switch (handleType) {
    case VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT: {
+      if ((uintptr_t)pHostPointer % LVP_HOST_POINTER_ALIGNMENT)
+         return VK_ERROR_INVALID_EXTERNAL_HANDLE;
       pMemoryHostPointerProperties->memoryTypeBits = 1;
       return VK_SUCCESS;
    }
@@ -1711,17 +1746,52 @@ VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vk_icdGetInstanceProcAddr(
    return lvp_GetInstanceProcAddr(instance, pName);
 }
 
+/* Deleting the pipelines' CSOs needs queue 0's lock, which queue 0 holds
+ * while it executes.  The other queues don't wait for it: if it is busy,
+ * queue 0 frees the pipelines after its own submit.
+ */
 static void
-destroy_pipelines(struct lvp_queue *queue)
+destroy_pipelines(struct lvp_device *device, bool wait)
 {
-   struct lvp_device *device = lvp_queue_device(queue);
-   simple_mtx_lock(&queue->lock);
-   while (util_dynarray_contains(&queue->pipeline_destroys, struct lvp_pipeline*)) {
-      lvp_pipeline_destroy(device, util_dynarray_pop(&queue->pipeline_destroys, struct lvp_pipeline*), true);
-   }
+   struct lvp_queue *queue = &device->queue;
+
+   if (wait)
+      simple_mtx_lock(&queue->lock);
+   else if (!simple_mtx_trylock(&queue->lock))
+      return;
+
+   simple_mtx_lock(&queue->pipeline_destroys_lock);
+   struct util_dynarray pipelines = queue->pipeline_destroys;
+   queue->pipeline_destroys = UTIL_DYNARRAY_INIT;
+   simple_mtx_unlock(&queue->pipeline_destroys_lock);
+
+   util_dynarray_foreach(&pipelines, struct lvp_pipeline *, pipeline)
+      lvp_pipeline_destroy(device, *pipeline, true);
+   util_dynarray_fini(&pipelines);
+
    simple_mtx_unlock(&queue->lock);
 }
 
+static void
+destroy_csos(struct lvp_queue *queue)
+{
+   simple_mtx_lock(&queue->cso_destroys_lock);
+   util_dynarray_foreach(&queue->cso_destroys, struct lvp_queue_cso, entry)
+      lvp_shader_cso_delete(queue->ctx, entry->stage, entry->cso);
+   util_dynarray_clear(&queue->cso_destroys);
+   simple_mtx_unlock(&queue->cso_destroys_lock);
+}
+
+static void
+destroy_queries(struct lvp_queue *queue)
+{
+   simple_mtx_lock(&queue->query_destroys_lock);
+   util_dynarray_foreach(&queue->query_destroys, struct pipe_query *, query)
+      queue->ctx->destroy_query(queue->ctx, *query);
+   util_dynarray_clear(&queue->query_destroys);
+   simple_mtx_unlock(&queue->query_destroys_lock);
+}
+
 static VkResult
 lvp_queue_submit(struct vk_queue *vk_queue,
                  struct vk_queue_submit *submit)
@@ -1772,7 +1842,9 @@ lvp_queue_submit(struct vk_queue *vk_queue,
          vk_sync_as_lvp_pipe_sync(submit->signals[i].sync);
       lvp_pipe_sync_signal_with_fence(device, sync, queue->last_fence);
    }
-   destroy_pipelines(queue);
+   destroy_pipelines(device, queue == &device->queue);
+   destroy_csos(queue);
+   destroy_queries(queue);
 
    return VK_SUCCESS;
 }
@@ -1797,10 +1869,24 @@ lvp_queue_init(struct lvp_device *device, struct lvp_queue *queue,
    queue->cso = cso_create_context(queue->ctx, CSO_NO_VBUF);
    queue->uploader = u_upload_create(queue->ctx, 1024 * 1024, PIPE_BIND_CONSTANT_BUFFER, PIPE_USAGE_STREAM, 0);
 
+   const struct lvp_physical_device *pdev = lvp_device_physical(device);
+   nir_builder b = nir_builder_init_simple_shader(MESA_SHADER_FRAGMENT, pdev->drv_options[MESA_SHADER_FRAGMENT], "dummy_frag");
+   struct pipe_shader_state shstate = {0};
+   shstate.type = PIPE_SHADER_IR_NIR;
+   shstate.ir.nir = b.shader;
+   queue->noop_fs = queue->ctx->create_fs_state(queue->ctx, &shstate);
+
+   queue->state = (uint8_t *)(device + 1) + index_in_family * lvp_get_rendering_state_size();
+
    queue->vk.driver_submit = lvp_queue_submit;
 
    simple_mtx_init(&queue->lock, mtx_plain);
+   simple_mtx_init(&queue->pipeline_destroys_lock, mtx_plain);
    queue->pipeline_destroys = UTIL_DYNARRAY_INIT;
+   simple_mtx_init(&queue->cso_destroys_lock, mtx_plain);
+   queue->cso_destroys = UTIL_DYNARRAY_INIT;
+   simple_mtx_init(&queue->query_destroys_lock, mtx_plain);
+   queue->query_destroys = UTIL_DYNARRAY_INIT;
 
    return VK_SUCCESS;
 }
@@ -1808,17 +1894,39 @@ lvp_queue_init(struct lvp_device *device, struct lvp_queue *queue,
 static void
 lvp_queue_finish(struct lvp_queue *queue)
 {
+   struct lvp_device *device = lvp_queue_device(queue);
+
    vk_queue_finish(&queue->vk);
 
-   destroy_pipelines(queue);
+   if (queue == &device->queue)
+      destroy_pipelines(device, true);
    simple_mtx_destroy(&queue->lock);
+   simple_mtx_destroy(&queue->pipeline_destroys_lock);
    util_dynarray_fini(&queue->pipeline_destroys);
 
+   destroy_csos(queue);
+   simple_mtx_destroy(&queue->cso_destroys_lock);
+   util_dynarray_fini(&queue->cso_destroys);
+
+   destroy_queries(queue);
+   simple_mtx_destroy(&queue->query_destroys_lock);
+   util_dynarray_fini(&queue->query_destroys);
+
+   queue->ctx->delete_fs_state(queue->ctx, queue->noop_fs);
+   if (queue->last_fence)
+      device->pscreen->fence_reference(device->pscreen, &queue->last_fence, NULL);
+
    u_upload_destroy(queue->uploader);
    cso_destroy_context(queue->cso);
    queue->ctx->destroy(queue->ctx);
 }
 
+static struct lvp_queue *
+lvp_device_queue(struct lvp_device *device, uint32_t index)
+{
+   return index == 0 ? &device->queue : &device->extra_queues[index - 1];
+}
+
 VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateDevice(
    VkPhysicalDevice                            physicalDevice,
    const VkDeviceCreateInfo*                   pCreateInfo,
@@ -1831,14 +1939,14 @@ VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateDevice(
 
    assert(pCreateInfo->sType == VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO);
 
+   /* One rendering state per queue follows the device. */
    size_t state_size = lvp_get_rendering_state_size();
    device = vk_zalloc2(&physical_device->vk.instance->alloc, pAllocator,
-                       sizeof(*device) + state_size, 8,
+                       sizeof(*device) + LVP_NUM_QUEUES * state_size, 8,
                        VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
    if (!device)
       return vk_error(instance, VK_ERROR_OUT_OF_HOST_MEMORY);
 
-   device->queue.state = device + 1;
    device->poison_mem = debug_get_bool_option("LVP_POISON_MEMORY", false);
    device->print_cmds = debug_get_bool_option("LVP_CMD_DEBUG", false);
 
@@ -1862,15 +1970,21 @@ VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateDevice(
 
    device->pscreen = physical_device->pscreen;
 
-   assert(pCreateInfo->queueCreateInfoCount <= LVP_NUM_QUEUES);
+   assert(pCreateInfo->queueCreateInfoCount <= 1);
    if (pCreateInfo->queueCreateInfoCount) {
-      assert(pCreateInfo->pQueueCreateInfos[0].queueFamilyIndex == 0);
-      assert(pCreateInfo->pQueueCreateInfos[0].queueCount == 1);
-      result = lvp_queue_init(device, &device->queue, pCreateInfo->pQueueCreateInfos, 0);
+      const VkDeviceQueueCreateInfo *queue_create = pCreateInfo->pQueueCreateInfos;
+      assert(queue_create->queueFamilyIndex == 0);
+      assert(queue_create->queueCount <= LVP_NUM_QUEUES);
+      for (uint32_t i = 0; i < queue_create->queueCount; i++) {
+         result = lvp_queue_init(device, lvp_device_queue(device, i), queue_create, i);
+         if (result != VK_SUCCESS)
+            break;
+         device->queue_count++;
+      }
    } else {
       /* VK_KHR_maintenance9 allows zero queues devices used to compile shaders only.
-      *  Since we only ever create a single queue, and it has no hardward backing it,
-      *  we can just create a dummy queue on the behalf of the user.
+      *  Since queue 0 has no hardware backing it, we can just create a dummy
+      *  queue on the behalf of the user.
       */
       const float fake_priority = 1.0f;
       const VkDeviceQueueCreateInfo dummy_create_info = {
@@ -1882,20 +1996,20 @@ VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateDevice(
          .pQueuePriorities = &fake_priority
       };
       result = lvp_queue_init(device, &device->queue, &dummy_create_info, 0);
+      if (result == VK_SUCCESS)
+         device->queue_count = 1;
    }
 
    if (result != VK_SUCCESS) {
+      for (uint32_t i = device->queue_count; i-- > 0;)
+         lvp_queue_finish(lvp_device_queue(device, i));
       vk_free(&device->vk.alloc, device);
       return result;
    }
 
-   nir_builder b = nir_builder_init_simple_shader(MESA_SHADER_FRAGMENT, physical_device->drv_options[MESA_SHADER_FRAGMENT], "dummy_frag");
-   struct pipe_shader_state shstate = {0};
-   shstate.type = PIPE_SHADER_IR_NIR;
-   shstate.ir.nir = b.shader;
-   device->noop_fs = device->queue.ctx->create_fs_state(device->queue.ctx, &shstate);
    _mesa_hash_table_init(&device->bda, NULL, _mesa_hash_pointer, _mesa_key_pointer_equal);
    simple_mtx_init(&device->bda_lock, mtx_plain);
+   simple_mtx_init(&device->compile_queue_lock, mtx_plain);
 
    uint32_t zero = 0;
    device->zero_buffer = pipe_buffer_create_with_data(device->queue.ctx, 0, PIPE_USAGE_IMMUTABLE, sizeof(uint32_t), &zero);
@@ -1918,6 +2032,15 @@ VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateDevice(
 
    lvp_device_init_accel_struct_state(device);
 
+   struct vk_pipeline_cache_create_info cache_info = {
+      .weak_ref = true,
+   };
+   device->vk.mem_cache = vk_pipeline_cache_create(&device->vk, &cache_info, NULL);
+   if (!device->vk.mem_cache) {
+      lvp_DestroyDevice(lvp_device_to_handle(device), pAllocator);
+      return vk_error(instance, VK_ERROR_OUT_OF_HOST_MEMORY);
+   }
+
    *pDevice = lvp_device_to_handle(device);
 
    return VK_SUCCESS;
@@ -1930,10 +2053,16 @@ VKAPI_ATTR void VKAPI_CALL lvp_DestroyDevice(
 {
    VK_FROM_HANDLE(lvp_device, device, _device);
 
+   if (util_queue_is_initialized(&device->compile_queue))
+      util_queue_destroy(&device->compile_queue);
+
    lvp_device_finish_accel_struct_state(device);
 
    vk_meta_device_finish(&device->vk, &device->meta);
 
+   if (device->vk.mem_cache)
+      vk_pipeline_cache_destroy(device->vk.mem_cache, NULL);
+
    util_dynarray_foreach(&device->bda_texture_handles, struct lp_texture_handle *, handle)
       device->queue.ctx->delete_texture_handle(device->queue.ctx, (uint64_t)(uintptr_t)*handle);
 
@@ -1947,15 +2076,16 @@ VKAPI_ATTR void VKAPI_CALL lvp_DestroyDevice(
    device->queue.ctx->delete_texture_handle(device->queue.ctx, (uint64_t)(uintptr_t)device->null_texture_handle);
    device->queue.ctx->delete_image_handle(device->queue.ctx, (uint64_t)(uintptr_t)device->null_image_handle);
 
-   device->queue.ctx->delete_fs_state(device->queue.ctx, device->noop_fs);
-
-   if (device->queue.last_fence)
-      device->pscreen->fence_reference(device->pscreen, &device->queue.last_fence, NULL);
    _mesa_hash_table_fini(&device->bda, NULL);
    simple_mtx_destroy(&device->bda_lock);
+   simple_mtx_destroy(&device->compile_queue_lock);
    pipe_resource_reference(&device->zero_buffer, NULL);
 
-   lvp_queue_finish(&device->queue);
+   /* Finish queue 0 first, the pipelines it still has to destroy hand their
+    * CSOs on the other queues over to those.
+    */
+   for (uint32_t i = 0; i < device->queue_count; i++)
+      lvp_queue_finish(lvp_device_queue(device, i));
    vk_device_finish(&device->vk);
    vk_free(&device->vk.alloc, device);
 }
@@ -2076,6 +2206,14 @@ VKAPI_ATTR VkResult VKAPI_CALL lvp_AllocateMemory(
    mem->backed_fd = -1;
 
    if (mem->vk.host_ptr) {
+      /* Buffers and images bound to this memory use the pointer directly as
+       * their storage, there is no staging copy to keep in sync.
+       */
+      if ((uintptr_t)mem->vk.host_ptr % LVP_HOST_POINTER_ALIGNMENT ||
+          pAllocateInfo->allocationSize % LVP_HOST_POINTER_ALIGNMENT) {
+         error = VK_ERROR_INVALID_EXTERNAL_HANDLE;
+         goto fail;
+      }
       mem->mem_alloc = (struct llvmpipe_memory_allocation) {
          .cpu_addr = mem->vk.host_ptr,
       };
@@ -90,6 +90,7 @@ struct lvp_conditional_rendering_state {
 struct rendering_state {
    struct pipe_context *pctx;
    struct lvp_device *device;
+   struct lvp_queue *queue;
    struct u_upload_mgr *uploader;
    struct cso_context *cso;
 
@@ -331,7 +332,7 @@ static void emit_compute_state(struct rendering_state *state)
    }
 
    if (state->compute_shader_dirty)
-      state->pctx->bind_compute_state(state->pctx, state->shaders[MESA_SHADER_COMPUTE]->shader_cso);
+      state->pctx->bind_compute_state(state->pctx, lvp_shader_get_cso(state->queue, state->shaders[MESA_SHADER_COMPUTE], false));
 
    state->compute_shader_dirty = false;
 
@@ -383,7 +384,7 @@ static void update_vertex_elements_buffer_index(struct rendering_state *state)
 static void emit_state(struct rendering_state *state)
 {
    if (!state->shaders[MESA_SHADER_FRAGMENT] && !state->noop_fs_bound) {
-      state->pctx->bind_fs_state(state->pctx, state->device->noop_fs);
+      state->pctx->bind_fs_state(state->pctx, state->queue->noop_fs);
       state->noop_fs_bound = true;
    }
    if (state->blend_dirty) {
@@ -646,37 +647,37 @@ handle_graphics_stages(struct rendering_state *state, VkShaderStageFlagBits shad
 
       switch (vk_stage) {
       case VK_SHADER_STAGE_FRAGMENT_BIT:
-         state->pctx->bind_fs_state(state->pctx, state->shaders[MESA_SHADER_FRAGMENT]->shader_cso);
+         state->pctx->bind_fs_state(state->pctx, lvp_shader_get_cso(state->queue, state->shaders[MESA_SHADER_FRAGMENT], false));
          state->noop_fs_bound = false;
          break;
       case VK_SHADER_STAGE_VERTEX_BIT:
-         state->pctx->bind_vs_state(state->pctx, state->shaders[MESA_SHADER_VERTEX]->shader_cso);
+         state->pctx->bind_vs_state(state->pctx, lvp_shader_get_cso(state->queue, state->shaders[MESA_SHADER_VERTEX], false));
          break;
       case VK_SHADER_STAGE_GEOMETRY_BIT:
-         state->pctx->bind_gs_state(state->pctx, state->shaders[MESA_SHADER_GEOMETRY]->shader_cso);
+         state->pctx->bind_gs_state(state->pctx, lvp_shader_get_cso(state->queue, state->shaders[MESA_SHADER_GEOMETRY], false));
          state->gs_output_lines = state->shaders[MESA_SHADER_GEOMETRY]->pipeline_nir->nir->info.gs.output_primitive == MESA_PRIM_LINES ? GS_OUTPUT_LINES : GS_OUTPUT_NOT_LINES;
          break;
       case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT:
-         state->pctx->bind_tcs_state(state->pctx, state->shaders[MESA_SHADER_TESS_CTRL]->shader_cso);
+         state->pctx->bind_tcs_state(state->pctx, lvp_shader_get_cso(state->queue, state->shaders[MESA_SHADER_TESS_CTRL], false));
          break;
       case VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT:
          state->tess_states[0] = NULL;
          state->tess_states[1] = NULL;
          if (dynamic_tess_origin) {
-            state->tess_states[0] = state->shaders[MESA_SHADER_TESS_EVAL]->shader_cso;
-            state->tess_states[1] = state->shaders[MESA_SHADER_TESS_EVAL]->tess_ccw_cso;
+            state->tess_states[0] = lvp_shader_get_cso(state->queue, state->shaders[MESA_SHADER_TESS_EVAL], false);
+            state->tess_states[1] = lvp_shader_get_cso(state->queue, state->shaders[MESA_SHADER_TESS_EVAL], true);
             state->pctx->bind_tes_state(state->pctx, state->tess_states[state->tess_ccw]);
          } else {
-            state->pctx->bind_tes_state(state->pctx, state->shaders[MESA_SHADER_TESS_EVAL]->shader_cso);
+            state->pctx->bind_tes_state(state->pctx, lvp_shader_get_cso(state->queue, state->shaders[MESA_SHADER_TESS_EVAL], false));
          }
          if (!dynamic_tess_origin)
             state->tess_ccw = false;
          break;
       case VK_SHADER_STAGE_TASK_BIT_EXT:
-         state->pctx->bind_ts_state(state->pctx, state->shaders[MESA_SHADER_TASK]->shader_cso);
+         state->pctx->bind_ts_state(state->pctx, lvp_shader_get_cso(state->queue, state->shaders[MESA_SHADER_TASK], false));
          break;
       case VK_SHADER_STAGE_MESH_BIT_EXT:
-         state->pctx->bind_ms_state(state->pctx, state->shaders[MESA_SHADER_MESH]->shader_cso);
+         state->pctx->bind_ms_state(state->pctx, lvp_shader_get_cso(state->queue, state->shaders[MESA_SHADER_MESH], false));
          break;
       default:
          assert(0);
@@ -740,7 +741,11 @@ static void handle_graphics_pipeline(struct lvp_pipeline *pipeline,
                                      struct rendering_state *state)
 {
    const struct vk_graphics_pipeline_state *ps = &pipeline->graphics_state;
-   lvp_pipeline_shaders_compile(pipeline, true);
+   /* Queue 0 executes with device->queue.lock held.  The other queues
+    * compile their own CSOs in lvp_shader_get_cso() instead of taking it.
+    */
+   if (state->queue == &state->device->queue)
+      lvp_pipeline_shaders_compile(pipeline, true);
    bool dynamic_tess_origin = BITSET_TEST(ps->dynamic, MESA_VK_DYNAMIC_TS_DOMAIN_ORIGIN);
    unbind_graphics_stages(state,
                           (~pipeline->graphics_state.shader_stages) &
@@ -815,6 +820,16 @@ static void handle_graphics_pipeline(struct lvp_pipeline *pipeline,
       state->rs_dirty = true;
    }
 
+   /* Let llvmpipe read dynamic stencil masks at runtime rather than build a
+    * fragment shader variant for each set of masks.
+    */
+   unsigned dynamic_state = 0;
+   if (BITSET_TEST(ps->dynamic, MESA_VK_DYNAMIC_DS_STENCIL_COMPARE_MASK) ||
+       BITSET_TEST(ps->dynamic, MESA_VK_DYNAMIC_DS_STENCIL_WRITE_MASK))
+      dynamic_state |= PIPE_DYNAMIC_STENCIL_MASKS;
+   if (state->pctx->set_dynamic_state)
+      state->pctx->set_dynamic_state(state->pctx, dynamic_state);
+
    if (ps->ds) {
       if (!BITSET_TEST(ps->dynamic, MESA_VK_DYNAMIC_DS_DEPTH_TEST_ENABLE))
          state->dsa_state.depth_enabled = ps->ds->depth.test_enable;
@@ -2121,8 +2136,9 @@ static void handle_copy_image_to_buffer2(struct vk_cmd_queue_entry *cmd,
 {
    const struct VkCopyImageToBufferInfo2 *copycmd = cmd->u.copy_image_to_buffer2.copy_image_to_buffer_info;
    VK_FROM_HANDLE(lvp_image, src_image, copycmd->srcImage);
-   struct pipe_box box, dbox;
-   struct pipe_transfer *src_t, *dst_t;
+   VK_FROM_HANDLE(lvp_buffer, dst_buffer, copycmd->dstBuffer);
+   struct pipe_box box;
+   struct pipe_transfer *src_t;
    uint8_t *src_data, *dst_data;
 
    for (uint32_t i = 0; i < copycmd->regionCount; i++) {
@@ -2137,26 +2153,6 @@ static void handle_copy_image_to_buffer2(struct vk_cmd_queue_entry *cmd,
       box.height = region->imageExtent.height;
       box.depth = src_image->vk.image_type == VK_IMAGE_TYPE_3D ? region->imageExtent.depth : subresource_layercount(src_image, &region->imageSubresource);
 
-      src_data = state->pctx->texture_map(state->pctx,
-                                           src_image->planes[plane].bo,
-                                           region->imageSubresource.mipLevel,
-                                           PIPE_MAP_READ,
-                                           &box,
-                                           &src_t);
-
-      dbox.x = region->bufferOffset;
-      dbox.y = 0;
-      dbox.z = 0;
-      dbox.width = lvp_buffer_from_handle(copycmd->dstBuffer)->bo->width0 - region->bufferOffset;
-      dbox.height = 1;
-      dbox.depth = 1;
-      dst_data = state->pctx->buffer_map(state->pctx,
-                                           lvp_buffer_from_handle(copycmd->dstBuffer)->bo,
-                                           0,
-                                           PIPE_MAP_WRITE,
-                                           &dbox,
-                                           &dst_t);
-
       enum pipe_format src_format = src_image->planes[plane].bo->format;
       enum pipe_format dst_format = src_format;
       if (util_format_is_depth_or_stencil(src_format)) {
@@ -2170,6 +2166,18 @@ static void handle_copy_image_to_buffer2(struct vk_cmd_queue_entry *cmd,
       const struct vk_image_buffer_layout buffer_layout =
          vk_image_buffer_copy_layout(&src_image->vk, &copycmd->pRegions[i]);
       if (src_format != dst_format) {
+         src_data = state->pctx->texture_map(state->pctx,
+                                              src_image->planes[plane].bo,
+                                              region->imageSubresource.mipLevel,
+                                              PIPE_MAP_READ,
+                                              &box,
+                                              &src_t);
+
+         /* Buffers stay mapped while they are bound, so write straight into
+          * the memory backing them, which may be imported from the client.
+          */
+         dst_data = (uint8_t *)dst_buffer->map + region->bufferOffset;
+
          lvp_image_copy_depth_box(dst_data, dst_format,
                         buffer_layout.row_stride_B,
                         buffer_layout.image_stride_B,
@@ -2178,18 +2186,18 @@ static void handle_copy_image_to_buffer2(struct vk_cmd_queue_entry *cmd,
                         region->imageExtent.height,
                         box.depth,
                         src_data, src_format, src_t->stride, src_t->layer_stride, 0, 0, 0);
+         state->pctx->texture_unmap(state->pctx, src_t);
       } else {
-         util_copy_box((uint8_t *)dst_data, src_format,
-                       buffer_layout.row_stride_B,
-                       buffer_layout.image_stride_B,
-                       0, 0, 0,
-                       region->imageExtent.width,
-                       region->imageExtent.height,
-                       box.depth,
-                       src_data, src_t->stride, src_t->layer_stride, 0, 0, 0);
+         /* The driver may split large readbacks across threads. */
+         state->pctx->image_copy_buffer(state->pctx,
+                                        dst_buffer->bo,
+                                        src_image->planes[plane].bo,
+                                        region->bufferOffset,
+                                        buffer_layout.row_stride_B,
+                                        buffer_layout.image_stride_B,
+                                        region->imageSubresource.mipLevel,
+                                        &box);
       }
-      state->pctx->texture_unmap(state->pctx, src_t);
-      state->pctx->buffer_unmap(state->pctx, dst_t);
    }
 }
 
@@ -2240,28 +2248,17 @@ static void handle_copy_buffer_to_image(struct vk_cmd_queue_entry *cmd,
 {
    const struct VkCopyBufferToImageInfo2 *copycmd = cmd->u.copy_buffer_to_image2.copy_buffer_to_image_info;
    VK_FROM_HANDLE(lvp_image, dst_image, copycmd->dstImage);
+   VK_FROM_HANDLE(lvp_buffer, src_buffer, copycmd->srcBuffer);
 
    for (uint32_t i = 0; i < copycmd->regionCount; i++) {
       const VkBufferImageCopy2 *region = &copycmd->pRegions[i];
-      struct pipe_box box, sbox;
-      struct pipe_transfer *src_t, *dst_t;
+      struct pipe_box box;
+      struct pipe_transfer *dst_t;
       void *src_data, *dst_data;
       const VkImageAspectFlagBits aspects = copycmd->pRegions[i].imageSubresource.aspectMask;
       uint8_t plane = lvp_image_aspects_to_plane(dst_image, aspects);
 
-      sbox.x = region->bufferOffset;
-      sbox.y = 0;
-      sbox.z = 0;
-      sbox.width = lvp_buffer_from_handle(copycmd->srcBuffer)->bo->width0;
-      sbox.height = 1;
-      sbox.depth = 1;
-      src_data = state->pctx->buffer_map(state->pctx,
-                                           lvp_buffer_from_handle(copycmd->srcBuffer)->bo,
-                                           0,
-                                           PIPE_MAP_READ,
-                                           &sbox,
-                                           &src_t);
-
+      src_data = (uint8_t *)src_buffer->map + region->bufferOffset;
 
       box.x = region->imageOffset.x;
       box.y = region->imageOffset.y;
@@ -2270,13 +2267,6 @@ static void handle_copy_buffer_to_image(struct vk_cmd_queue_entry *cmd,
       box.height = region->imageExtent.height;
       box.depth = dst_image->vk.image_type == VK_IMAGE_TYPE_3D ? region->imageExtent.depth : subresource_layercount(dst_image, &region->imageSubresource);
 
-      dst_data = state->pctx->texture_map(state->pctx,
-                                           dst_image->planes[plane].bo,
-                                           region->imageSubresource.mipLevel,
-                                           PIPE_MAP_WRITE,
-                                           &box,
-                                           &dst_t);
-
       enum pipe_format dst_format = dst_image->planes[plane].bo->format;
       enum pipe_format src_format = dst_format;
       if (util_format_is_depth_or_stencil(dst_format)) {
@@ -2290,6 +2280,12 @@ static void handle_copy_buffer_to_image(struct vk_cmd_queue_entry *cmd,
       const struct vk_image_buffer_layout buffer_layout =
          vk_image_buffer_copy_layout(&dst_image->vk, &copycmd->pRegions[i]);
       if (src_format != dst_format) {
+         dst_data = state->pctx->texture_map(state->pctx,
+                                              dst_image->planes[plane].bo,
+                                              region->imageSubresource.mipLevel,
+                                              PIPE_MAP_WRITE,
+                                              &box,
+                                              &dst_t);
          lvp_image_copy_depth_box(dst_data, dst_format,
                         dst_t->stride, dst_t->layer_stride,
                         0, 0, 0,
@@ -2300,20 +2296,16 @@ static void handle_copy_buffer_to_image(struct vk_cmd_queue_entry *cmd,
                         buffer_layout.row_stride_B,
                         buffer_layout.image_stride_B,
                         0, 0, 0);
+         state->pctx->texture_unmap(state->pctx, dst_t);
       } else {
-         util_copy_box(dst_data, dst_format,
-                       dst_t->stride, dst_t->layer_stride,
-                       0, 0, 0,
-                       region->imageExtent.width,
-                       region->imageExtent.height,
-                       box.depth,
-                       src_data,
-                       buffer_layout.row_stride_B,
-                       buffer_layout.image_stride_B,
-                       0, 0, 0);
+         /* The driver may split large uploads across threads. */
+         state->pctx->texture_subdata(state->pctx,
+                                      dst_image->planes[plane].bo,
+                                      region->imageSubresource.mipLevel,
+                                      0, &box, src_data,
+                                      buffer_layout.row_stride_B,
+                                      buffer_layout.image_stride_B);
       }
-      state->pctx->buffer_unmap(state->pctx, src_t);
-      state->pctx->texture_unmap(state->pctx, dst_t);
    }
 }
 
@@ -2840,6 +2832,24 @@ static void handle_pipeline_barrier(struct vk_cmd_queue_entry *cmd,
    finish_fence(state);
 }
 
+/* Queries belong to the context of the queue they were first used on, a
+ * query that moves to another queue is handed back to its owner and
+ * recreated on this queue's context.
+ */
+static struct pipe_query *
+get_query(struct rendering_state *state, struct lvp_query_pool *pool,
+          uint32_t idx, enum pipe_query_type type, unsigned index)
+{
+   if (pool->queries[idx] && pool->query_queue[idx] != state->queue)
+      lvp_query_pool_destroy_query(pool, idx, state->queue);
+
+   if (!pool->queries[idx]) {
+      pool->queries[idx] = state->pctx->create_query(state->pctx, type, index);
+      pool->query_queue[idx] = state->queue;
+   }
+   return pool->queries[idx];
+}
+
 static void handle_begin_query(struct vk_cmd_queue_entry *cmd,
                                struct rendering_state *state)
 {
@@ -2854,11 +2864,7 @@ static void handle_begin_query(struct vk_cmd_queue_entry *cmd,
 
    uint32_t count = util_bitcount(state->framebuffer.viewmask ? state->framebuffer.viewmask : BITFIELD_BIT(0));
    for (unsigned idx = 0; idx < count; idx++) {
-      if (!pool->queries[qcmd->query + idx]) {
-         enum pipe_query_type qtype = pool->base_type;
-         pool->queries[qcmd->query + idx] = state->pctx->create_query(state->pctx,
-                                                               qtype, 0);
-      }
+      get_query(state, pool, qcmd->query + idx, pool->base_type, 0);
 
       state->pctx->begin_query(state->pctx, pool->queries[qcmd->query + idx]);
       if (idx)
@@ -2891,11 +2897,7 @@ static void handle_begin_query_indexed_ext(struct vk_cmd_queue_entry *cmd,
 
    uint32_t count = util_bitcount(state->framebuffer.viewmask ? state->framebuffer.viewmask : BITFIELD_BIT(0));
    for (unsigned idx = 0; idx < count; idx++) {
-      if (!pool->queries[qcmd->query + idx]) {
-         enum pipe_query_type qtype = pool->base_type;
-         pool->queries[qcmd->query + idx] = state->pctx->create_query(state->pctx,
-                                                                      qtype, qcmd->index);
-      }
+      get_query(state, pool, qcmd->query + idx, pool->base_type, qcmd->index);
 
       state->pctx->begin_query(state->pctx, pool->queries[qcmd->query + idx]);
       if (idx)
@@ -2922,12 +2924,8 @@ static void handle_reset_query_pool(struct vk_cmd_queue_entry *cmd,
    if (pool->base_type >= PIPE_QUERY_TYPES)
       return;
 
-   for (unsigned i = qcmd->first_query; i < qcmd->first_query + qcmd->query_count; i++) {
-      if (pool->queries[i]) {
-         state->pctx->destroy_query(state->pctx, pool->queries[i]);
-         pool->queries[i] = NULL;
-      }
-   }
+   for (unsigned i = qcmd->first_query; i < qcmd->first_query + qcmd->query_count; i++)
+      lvp_query_pool_destroy_query(pool, i, state->queue);
 }
 
 static void handle_write_timestamp2(struct vk_cmd_queue_entry *cmd,
@@ -2941,9 +2939,7 @@ static void handle_write_timestamp2(struct vk_cmd_queue_entry *cmd,
 
    uint32_t count = util_bitcount(state->framebuffer.viewmask ? state->framebuffer.viewmask : BITFIELD_BIT(0));
    for (unsigned idx = 0; idx < count; idx++) {
-      if (!pool->queries[qcmd->query + idx]) {
-         pool->queries[qcmd->query + idx] = state->pctx->create_query(state->pctx, PIPE_QUERY_TIMESTAMP, 0);
-      }
+      get_query(state, pool, qcmd->query + idx, PIPE_QUERY_TIMESTAMP, 0);
 
       state->pctx->end_query(state->pctx, pool->queries[qcmd->query + idx]);
    }
@@ -3859,6 +3855,9 @@ handle_shaders(struct vk_cmd_queue_entry *cmd, struct rendering_state *state)
       VkShaderStageFlags all_gfx = VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_MESH_BIT_EXT | VK_SHADER_STAGE_TASK_BIT_EXT;
       unbind_graphics_stages(state, null_stages & all_gfx);
       handle_graphics_stages(state, vkstages & all_gfx, true);
+      /* all state is dynamic with shader objects */
+      if (state->pctx->set_dynamic_state)
+         state->pctx->set_dynamic_state(state->pctx, PIPE_DYNAMIC_STENCIL_MASKS);
       u_foreach_bit(i, new_stages) {
          handle_graphics_pushconsts(state, i, state->shaders[i]);
       }
@@ -4587,7 +4586,7 @@ lvp_trace_rays(struct rendering_state *state, VkTraceRaysIndirectCommand2KHR *co
       state->constbuf_dirty[MESA_SHADER_RAYGEN] = false;
    }
 
-   state->pctx->bind_compute_state(state->pctx, state->shaders[MESA_SHADER_RAYGEN]->shader_cso);
+   state->pctx->bind_compute_state(state->pctx, lvp_shader_get_cso(state->queue, state->shaders[MESA_SHADER_RAYGEN], false));
 
    state->pcbuf_dirty[MESA_SHADER_COMPUTE] = true;
    state->constbuf_dirty[MESA_SHADER_COMPUTE] = true;
@@ -5386,6 +5385,7 @@ VkResult lvp_execute_cmds(struct lvp_device *device,
    memset(state, 0, sizeof(*state));
    state->pctx = queue->ctx;
    state->device = device;
+   state->queue = queue;
    state->uploader = queue->uploader;
    state->cso = queue->cso;
    state->blend_dirty = true;
@@ -22,11 +22,15 @@
  */
 
 #include "lvp_private.h"
+#include "vk_deferred_operation.h"
 #include "vk_nir_convert_ycbcr.h"
 #include "vk_pipeline.h"
+#include "vk_pipeline_cache.h"
 #include "vk_render_pass.h"
 #include "vk_util.h"
 #include "glsl_types.h"
+#include "util/mesa-sha1.h"
+#include "util/u_cpu_detect.h"
 #include "util/os_time.h"
 #include "spirv/nir_spirv.h"
 #include "nir/nir_builder.h"
@@ -44,34 +48,63 @@
 
 typedef void (*cso_destroy_func)(struct pipe_context*, void*);
 
+void
+lvp_shader_cso_delete(struct pipe_context *ctx, mesa_shader_stage stage, void *cso)
+{
+   cso_destroy_func destroy[] = {
+      ctx->delete_vs_state,
+      ctx->delete_tcs_state,
+      ctx->delete_tes_state,
+      ctx->delete_gs_state,
+      ctx->delete_fs_state,
+      ctx->delete_compute_state,
+      ctx->delete_ts_state,
+      ctx->delete_ms_state,
+   };
+
+   destroy[stage](ctx, cso);
+}
+
+static void
+queue_cso_destroy(struct lvp_queue *queue, mesa_shader_stage stage, void *cso)
+{
+   if (!cso)
+      return;
+
+   struct lvp_queue_cso entry = {
+      .stage = stage,
+      .cso = cso,
+   };
+
+   simple_mtx_lock(&queue->cso_destroys_lock);
+   util_dynarray_append(&queue->cso_destroys, entry);
+   simple_mtx_unlock(&queue->cso_destroys_lock);
+}
+
 static void
 shader_destroy(struct lvp_device *device, struct lvp_shader *shader, bool locked)
 {
    if (!shader->pipeline_nir)
       return;
    mesa_shader_stage stage = shader->pipeline_nir->nir->info.stage;
-   cso_destroy_func destroy[] = {
-      device->queue.ctx->delete_vs_state,
-      device->queue.ctx->delete_tcs_state,
-      device->queue.ctx->delete_tes_state,
-      device->queue.ctx->delete_gs_state,
-      device->queue.ctx->delete_fs_state,
-      device->queue.ctx->delete_compute_state,
-      device->queue.ctx->delete_ts_state,
-      device->queue.ctx->delete_ms_state,
-   };
 
    if (!locked)
       simple_mtx_lock(&device->queue.lock);
 
    if (shader->shader_cso)
-      destroy[stage](device->queue.ctx, shader->shader_cso);
+      lvp_shader_cso_delete(device->queue.ctx, stage, shader->shader_cso);
    if (shader->tess_ccw_cso)
-      destroy[stage](device->queue.ctx, shader->tess_ccw_cso);
+      lvp_shader_cso_delete(device->queue.ctx, stage, shader->tess_ccw_cso);
 
    if (!locked)
       simple_mtx_unlock(&device->queue.lock);
 
+   /* The other queues' contexts may be busy, let them delete their CSOs. */
+   for (uint32_t i = 0; i < ARRAY_SIZE(shader->queue_cso); i++) {
+      queue_cso_destroy(&device->extra_queues[i], stage, shader->queue_cso[i]);
+      queue_cso_destroy(&device->extra_queues[i], stage, shader->queue_tess_ccw_cso[i]);
+   }
+
    lvp_pipeline_nir_ref(&shader->pipeline_nir, NULL);
    lvp_pipeline_nir_ref(&shader->tess_ccw, NULL);
 }
@@ -115,9 +148,9 @@ VKAPI_ATTR void VKAPI_CALL lvp_DestroyPipeline(
       return;
 
    if (pipeline->used) {
-      simple_mtx_lock(&device->queue.lock);
+      simple_mtx_lock(&device->queue.pipeline_destroys_lock);
       util_dynarray_append(&device->queue.pipeline_destroys, pipeline);
-      simple_mtx_unlock(&device->queue.lock);
+      simple_mtx_unlock(&device->queue.pipeline_destroys_lock);
    } else {
       lvp_pipeline_destroy(device, pipeline, false);
    }
@@ -474,22 +507,131 @@ lvp_shader_init(struct lvp_shader *shader, nir_shader *nir)
    shader->pipeline_nir = lvp_create_pipeline_nir(nir);
 }
 
+/* The lowered NIR of a stage only depends on the stage create info, the
+ * robustness state and the pipeline layout it is lowered against, so that
+ * is what goes into the vk_pipeline_cache key.  Returns false for stages
+ * that can't be cached.
+ */
+static bool
+lvp_shader_cache_key(struct lvp_pipeline *pipeline, const void *pipeline_pNext,
+                     const VkPipelineShaderStageCreateInfo *sinfo,
+                     unsigned char key[SHA1_DIGEST_LENGTH])
+{
+   struct lvp_device *device = lvp_pipeline_device(pipeline);
+
+   if (pipeline->type == LVP_PIPELINE_EXEC_GRAPH)
+      return false;
+#ifdef VK_ENABLE_BETA_EXTENSIONS
+   if (vk_find_struct_const(sinfo->pNext, PIPELINE_SHADER_STAGE_NODE_CREATE_INFO_AMDX))
+      return false;
+#endif
+
+   struct vk_pipeline_robustness_state robustness;
+   vk_pipeline_robustness_state_fill(&device->vk, &robustness, pipeline_pNext, sinfo->pNext);
+
+   unsigned char stage_sha1[SHA1_DIGEST_LENGTH];
+   vk_pipeline_hash_shader_stage(pipeline->flags, sinfo, &robustness, stage_sha1);
+
+   struct mesa_sha1 ctx;
+   _mesa_sha1_init(&ctx);
+   _mesa_sha1_update(&ctx, stage_sha1, sizeof(stage_sha1));
+
+   struct lvp_pipeline_layout *layout = pipeline->layout;
+   if (layout) {
+      _mesa_sha1_update(&ctx, &layout->vk.set_count, sizeof(layout->vk.set_count));
+      for (uint32_t i = 0; i < layout->vk.set_count; i++) {
+         static const blake3_hash null_set = {0};
+         const struct vk_descriptor_set_layout *set_layout = layout->vk.set_layouts[i];
+         _mesa_sha1_update(&ctx, set_layout ? set_layout->blake3 : null_set, sizeof(blake3_hash));
+      }
+      _mesa_sha1_update(&ctx, &layout->push_constant_size, sizeof(layout->push_constant_size));
+   }
+
+   bool debug_info = gallivm_debug & GALLIVM_DEBUG_SYMBOLS;
+   _mesa_sha1_update(&ctx, &debug_info, sizeof(debug_info));
+
+   _mesa_sha1_final(&ctx, key);
+   return true;
+}
+
 static VkResult
-lvp_shader_compile_to_ir(struct lvp_pipeline *pipeline, const void *pipeline_pNext,
-                         const VkPipelineShaderStageCreateInfo *sinfo)
+lvp_shader_compile_to_ir(struct lvp_pipeline *pipeline, struct vk_pipeline_cache *cache,
+                         const void *pipeline_pNext,
+                         const VkPipelineShaderStageCreateInfo *sinfo,
+                         VkPipelineCreationFeedback *stage_feedback,
+                         bool *cache_hit_out)
 {
+   struct lvp_device *device = lvp_pipeline_device(pipeline);
    mesa_shader_stage stage = vk_to_mesa_shader_stage(sinfo->stage);
    assert(stage <= LVP_SHADER_STAGES && stage != MESA_SHADER_NONE);
-   nir_shader *nir;
-   VkResult result = lvp_spirv_to_nir(pipeline, pipeline_pNext, sinfo, &nir);
+   int64_t t0 = os_time_get_nano();
+
+   unsigned char key[SHA1_DIGEST_LENGTH];
+   bool cacheable = lvp_shader_cache_key(pipeline, pipeline_pNext, sinfo, key);
+
+   bool cache_hit = false;
+   nir_shader *nir = NULL;
+   if (cacheable) {
+      nir = vk_pipeline_cache_lookup_nir(cache, key, sizeof(key),
+                                         lvp_device_physical(device)->drv_options[stage],
+                                         &cache_hit, NULL);
+   }
+
+   VkResult result = VK_SUCCESS;
+   if (!nir) {
+      if (pipeline->flags & VK_PIPELINE_CREATE_2_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT_KHR)
+         return VK_PIPELINE_COMPILE_REQUIRED;
+
+      result = lvp_spirv_to_nir(pipeline, pipeline_pNext, sinfo, &nir);
+      if (result == VK_SUCCESS && cacheable)
+         vk_pipeline_cache_add_nir(cache, key, sizeof(key), nir);
+   }
+
+   *cache_hit_out = cache_hit;
    if (result == VK_SUCCESS) {
       struct lvp_shader *shader = &pipeline->shaders[stage];
       lvp_shader_init(shader, nir);
       shader->push_constant_size = pipeline->layout->push_constant_size;
+
+      if (stage_feedback) {
+         stage_feedback->flags = VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT;
+         if (cache_hit)
+            stage_feedback->flags |= VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT;
+         stage_feedback->duration = os_time_get_nano() - t0;
+      }
    }
    return result;
 }
 
+/* Returns the stage feedback slot for pStages[index], if the app asked for
+ * one.
+ */
+static VkPipelineCreationFeedback *
+lvp_stage_feedback(const VkPipelineCreationFeedbackCreateInfo *feedback, uint32_t index)
+{
+   if (!feedback || index >= feedback->pipelineStageCreationFeedbackCount)
+      return NULL;
+   return &feedback->pPipelineStageCreationFeedbacks[index];
+}
+
+/* Fills the pipeline-level feedback.  A pipeline only counts as an
+ * application cache hit when every stage came out of the app's cache; hits
+ * in the device's internal cache don't count.
+ */
+static void
+lvp_pipeline_feedback(struct lvp_device *device, struct vk_pipeline_cache *cache,
+                      const VkPipelineCreationFeedbackCreateInfo *feedback,
+                      bool cache_hit, uint64_t t0)
+{
+   if (!feedback)
+      return;
+
+   feedback->pPipelineCreationFeedback->duration = os_time_get_nano() - t0;
+   feedback->pPipelineCreationFeedback->flags = VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT;
+   if (cache_hit && cache != device->vk.mem_cache)
+      feedback->pPipelineCreationFeedback->flags |= VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT;
+}
+
 static void
 merge_tess_info(struct shader_info *tes_info,
                 const struct shader_info *tcs_info)
@@ -576,14 +718,14 @@ lvp_pipeline_xfb_init(struct lvp_pipeline *pipeline)
 }
 
 static void *
-lvp_shader_compile_stage(struct lvp_device *device, struct lvp_shader *shader, nir_shader *nir)
+lvp_shader_compile_stage(struct pipe_context *ctx, struct lvp_shader *shader, nir_shader *nir)
 {
    if (nir->info.stage == MESA_SHADER_COMPUTE) {
       struct pipe_compute_state shstate = {0};
       shstate.prog = nir;
       shstate.ir_type = PIPE_SHADER_IR_NIR;
       shstate.static_shared_mem = nir->info.shared_size;
-      return device->queue.ctx->create_compute_state(device->queue.ctx, &shstate);
+      return ctx->create_compute_state(ctx, &shstate);
    } else {
       struct pipe_shader_state shstate = {0};
       shstate.type = PIPE_SHADER_IR_NIR;
@@ -592,19 +734,19 @@ lvp_shader_compile_stage(struct lvp_device *device, struct lvp_shader *shader, n
 
       switch (nir->info.stage) {
       case MESA_SHADER_FRAGMENT:
-         return device->queue.ctx->create_fs_state(device->queue.ctx, &shstate);
+         return ctx->create_fs_state(ctx, &shstate);
       case MESA_SHADER_VERTEX:
-         return device->queue.ctx->create_vs_state(device->queue.ctx, &shstate);
+         return ctx->create_vs_state(ctx, &shstate);
       case MESA_SHADER_GEOMETRY:
-         return device->queue.ctx->create_gs_state(device->queue.ctx, &shstate);
+         return ctx->create_gs_state(ctx, &shstate);
       case MESA_SHADER_TESS_CTRL:
-         return device->queue.ctx->create_tcs_state(device->queue.ctx, &shstate);
+         return ctx->create_tcs_state(ctx, &shstate);
       case MESA_SHADER_TESS_EVAL:
-         return device->queue.ctx->create_tes_state(device->queue.ctx, &shstate);
+         return ctx->create_tes_state(ctx, &shstate);
       case MESA_SHADER_TASK:
-         return device->queue.ctx->create_ts_state(device->queue.ctx, &shstate);
+         return ctx->create_ts_state(ctx, &shstate);
       case MESA_SHADER_MESH:
-         return device->queue.ctx->create_ms_state(device->queue.ctx, &shstate);
+         return ctx->create_ms_state(ctx, &shstate);
       default:
          UNREACHABLE("illegal shader");
          break;
@@ -622,7 +764,7 @@ lvp_shader_compile(struct lvp_device *device, struct lvp_shader *shader, nir_sha
    if (!locked)
       simple_mtx_lock(&device->queue.lock);
 
-   void *state = lvp_shader_compile_stage(device, shader, nir);
+   void *state = lvp_shader_compile_stage(device->queue.ctx, shader, nir);
 
    if (!locked)
       simple_mtx_unlock(&device->queue.lock);
@@ -630,6 +772,38 @@ lvp_shader_compile(struct lvp_device *device, struct lvp_shader *shader, nir_sha
    return state;
 }
 
+/**
+ * Returns the CSO to bind for the shader on the given queue.  Queue 0 uses
+ * the device-level CSO, the other queues build their own from the shader's
+ * NIR since llvmpipe doesn't support sharing shader CSOs between contexts
+ * which run concurrently.  They don't need the device-level CSO to exist,
+ * so they never wait for queue 0 to compile it.  Only the queue's own
+ * thread accesses its slot.
+ */
+void *
+lvp_shader_get_cso(struct lvp_queue *queue, struct lvp_shader *shader, bool tess_ccw)
+{
+   uint32_t index = queue->vk.index_in_family;
+   if (index == 0)
+      return tess_ccw ? shader->tess_ccw_cso : shader->shader_cso;
+
+   if (!(tess_ccw ? shader->tess_ccw : shader->pipeline_nir))
+      return NULL;
+
+   void **queue_cso = tess_ccw ? &shader->queue_tess_ccw_cso[index - 1] :
+                                 &shader->queue_cso[index - 1];
+   if (!*queue_cso) {
+      const struct lvp_physical_device *pdev =
+         lvp_device_physical(lvp_queue_device(queue));
+      nir_shader *nir = nir_shader_clone(NULL, tess_ccw ? shader->tess_ccw->nir :
+                                                          shader->pipeline_nir->nir);
+      pdev->pscreen->finalize_nir(pdev->pscreen, nir, true);
+      *queue_cso = lvp_shader_compile_stage(queue->ctx, shader, nir);
+   }
+
+   return *queue_cso;
+}
+
 #ifndef NDEBUG
 static bool
 layouts_equal(const struct lvp_descriptor_set_layout *a, const struct lvp_descriptor_set_layout *b)
@@ -742,14 +916,102 @@ copy_shader_sanitized(struct lvp_shader *dst, const struct lvp_shader *src)
    dst->tess_ccw = NULL; //this gets handled later
    assert(!dst->shader_cso);
    assert(!dst->tess_ccw_cso);
+   memset(dst->queue_cso, 0, sizeof(dst->queue_cso));
+   memset(dst->queue_tess_ccw_cso, 0, sizeof(dst->queue_tess_ccw_cso));
+}
+
+/* Translates one stage of a graphics pipeline to NIR. */
+struct lvp_stage_job {
+   struct util_queue_fence fence;
+   struct lvp_pipeline *pipeline;
+   struct vk_pipeline_cache *cache;
+   const void *pipeline_pNext;
+   const VkPipelineShaderStageCreateInfo *sinfo;
+   VkPipelineCreationFeedback *stage_feedback;
+   bool cache_hit;
+   VkResult result;
+};
+
+static void
+lvp_stage_job_execute(void *data, void *gdata, int thread_index)
+{
+   struct lvp_stage_job *job = data;
+   job->result = lvp_shader_compile_to_ir(job->pipeline, job->cache, job->pipeline_pNext,
+                                          job->sinfo, job->stage_feedback, &job->cache_hit);
+}
+
+/* Returns the compile queue, starting it on first use since most devices
+ * never compile anything in parallel.  The calling thread runs a job of
+ * its own, so it gets one thread less than there are CPUs, and none on a
+ * single CPU, where NULL is returned.
+ */
+static struct util_queue *
+lvp_device_compile_queue(struct lvp_device *device)
+{
+   simple_mtx_lock(&device->compile_queue_lock);
+   if (!util_queue_is_initialized(&device->compile_queue)) {
+      const unsigned nr_cpus = util_get_cpu_caps()->nr_cpus;
+      if (nr_cpus > 1) {
+         util_queue_init(&device->compile_queue, "lvp_compile", nr_cpus * 2,
+                         nr_cpus - 1, UTIL_QUEUE_INIT_RESIZE_IF_FULL, NULL);
+      }
+   }
+   simple_mtx_unlock(&device->compile_queue_lock);
+
+   return util_queue_is_initialized(&device->compile_queue) ?
+          &device->compile_queue : NULL;
+}
+
+/* A cache created with EXTERNALLY_SYNCHRONIZED skips its locks, so only one
+ * thread may use it at a time, even within a single command.
+ */
+static bool
+lvp_cache_is_externally_synchronized(const struct vk_pipeline_cache *cache)
+{
+   return cache &&
+          (cache->flags & VK_PIPELINE_CACHE_CREATE_EXTERNALLY_SYNCHRONIZED_BIT);
+}
+
+/* Stages only write their own lvp_shader, so they can be translated at the
+ * same time.  The first one runs on the calling thread.
+ */
+static void
+lvp_stage_jobs_run(struct lvp_device *device, struct lvp_stage_job *jobs,
+                   uint32_t count, bool parallel)
+{
+   struct util_queue *queue = NULL;
+   if (parallel && count > 1 && !lvp_cache_is_externally_synchronized(jobs[0].cache))
+      queue = lvp_device_compile_queue(device);
+   parallel = queue != NULL;
+
+   if (parallel) {
+      for (uint32_t i = 1; i < count; i++) {
+         util_queue_fence_init(&jobs[i].fence);
+         util_queue_add_job(queue, &jobs[i], &jobs[i].fence,
+                            lvp_stage_job_execute, NULL, 0);
+      }
+   }
+
+   for (uint32_t i = 0; i < (parallel ? 1 : count); i++)
+      lvp_stage_job_execute(&jobs[i], NULL, 0);
+
+   if (parallel) {
+      for (uint32_t i = 1; i < count; i++) {
+         util_queue_fence_wait(&jobs[i].fence);
+         util_queue_fence_destroy(&jobs[i].fence);
+      }
+   }
 }
 
 static VkResult
 lvp_graphics_pipeline_init(struct lvp_pipeline *pipeline,
                            struct lvp_device *device,
-                           struct lvp_pipeline_cache *cache,
+                           struct vk_pipeline_cache *cache,
                            const VkGraphicsPipelineCreateInfo *pCreateInfo,
-                           VkPipelineCreateFlagBits2KHR flags)
+                           VkPipelineCreateFlagBits2KHR flags,
+                           const VkPipelineCreationFeedbackCreateInfo *feedback,
+                           bool parallel_stages,
+                           bool *cache_hit)
 {
    pipeline->type = LVP_PIPELINE_GRAPHICS;
    pipeline->flags = flags;
@@ -833,6 +1095,8 @@ lvp_graphics_pipeline_init(struct lvp_pipeline *pipeline,
                                                    VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT |
                                                    VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT));
 
+   struct lvp_stage_job stage_jobs[LVP_SHADER_STAGES];
+   uint32_t stage_job_count = 0;
    for (uint32_t i = 0; i < pCreateInfo->stageCount; i++) {
       const VkPipelineShaderStageCreateInfo *sinfo = &pCreateInfo->pStages[i];
       mesa_shader_stage stage = vk_to_mesa_shader_stage(sinfo->stage);
@@ -843,11 +1107,26 @@ lvp_graphics_pipeline_init(struct lvp_pipeline *pipeline,
          if (!(pipeline->stages & VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT))
             continue;
       }
-      result = lvp_shader_compile_to_ir(pipeline, pCreateInfo->pNext, sinfo);
+      assert(stage_job_count < ARRAY_SIZE(stage_jobs));
+      stage_jobs[stage_job_count++] = (struct lvp_stage_job) {
+         .pipeline = pipeline,
+         .cache = cache,
+         .pipeline_pNext = pCreateInfo->pNext,
+         .sinfo = sinfo,
+         .stage_feedback = lvp_stage_feedback(feedback, i),
+      };
+   }
+   lvp_stage_jobs_run(device, stage_jobs, stage_job_count, parallel_stages);
+
+   unsigned stages_compiled = 0, stages_hit = 0;
+   for (uint32_t i = 0; i < stage_job_count; i++) {
+      result = stage_jobs[i].result;
       if (result != VK_SUCCESS)
          goto fail;
+      stages_compiled++;
+      stages_hit += stage_jobs[i].cache_hit;
 
-      switch (stage) {
+      switch (vk_to_mesa_shader_stage(stage_jobs[i].sinfo->stage)) {
       case MESA_SHADER_FRAGMENT:
          if (pipeline->shaders[MESA_SHADER_FRAGMENT].pipeline_nir->nir->info.fs.uses_sample_shading)
             pipeline->force_min_sample = true;
@@ -855,6 +1134,8 @@ lvp_graphics_pipeline_init(struct lvp_pipeline *pipeline,
       default: break;
       }
    }
+   *cache_hit = stages_compiled && stages_hit == stages_compiled;
+
    if (pCreateInfo->stageCount && pipeline->shaders[MESA_SHADER_TESS_EVAL].pipeline_nir) {
       nir_lower_patch_vertices(pipeline->shaders[MESA_SHADER_TESS_EVAL].pipeline_nir->nir, pipeline->shaders[MESA_SHADER_TESS_CTRL].pipeline_nir->nir->info.tess.tcs_vertices_out, NULL);
       merge_tess_info(&pipeline->shaders[MESA_SHADER_TESS_EVAL].pipeline_nir->nir->info, &pipeline->shaders[MESA_SHADER_TESS_CTRL].pipeline_nir->nir->info);
@@ -940,15 +1221,19 @@ lvp_graphics_pipeline_create(
    const VkGraphicsPipelineCreateInfo *pCreateInfo,
    VkPipelineCreateFlagBits2KHR flags,
    VkPipeline *pPipeline,
-   bool group)
+   bool group,
+   bool parallel_stages)
 {
    VK_FROM_HANDLE(lvp_device, device, _device);
-   VK_FROM_HANDLE(lvp_pipeline_cache, cache, _cache);
+   VK_FROM_HANDLE(vk_pipeline_cache, cache, _cache);
    struct lvp_pipeline *pipeline;
    VkResult result;
 
    assert(pCreateInfo->sType == VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO);
 
+   if (cache == NULL)
+      cache = device->vk.mem_cache;
+
    pipeline = vk_zalloc(&device->vk.alloc, sizeof(*pipeline), 8,
                          VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
    if (pipeline == NULL)
@@ -957,24 +1242,176 @@ lvp_graphics_pipeline_create(
    vk_object_base_init(&device->vk, &pipeline->base,
                        VK_OBJECT_TYPE_PIPELINE);
    uint64_t t0 = os_time_get_nano();
-   result = lvp_graphics_pipeline_init(pipeline, device, cache, pCreateInfo, flags);
+   VkPipelineCreationFeedbackCreateInfo *feedback = (void*)vk_find_struct_const(pCreateInfo->pNext, PIPELINE_CREATION_FEEDBACK_CREATE_INFO);
+   if (feedback && !group)
+      memset(feedback->pPipelineStageCreationFeedbacks, 0, sizeof(VkPipelineCreationFeedback) * feedback->pipelineStageCreationFeedbackCount);
+   else
+      feedback = NULL;
+
+   bool cache_hit;
+   result = lvp_graphics_pipeline_init(pipeline, device, cache, pCreateInfo, flags, feedback,
+                                       parallel_stages, &cache_hit);
    if (result != VK_SUCCESS) {
       vk_free(&device->vk.alloc, pipeline);
       return result;
    }
 
-   VkPipelineCreationFeedbackCreateInfo *feedback = (void*)vk_find_struct_const(pCreateInfo->pNext, PIPELINE_CREATION_FEEDBACK_CREATE_INFO);
-   if (feedback && !group) {
-      feedback->pPipelineCreationFeedback->duration = os_time_get_nano() - t0;
-      feedback->pPipelineCreationFeedback->flags = VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT;
-      memset(feedback->pPipelineStageCreationFeedbacks, 0, sizeof(VkPipelineCreationFeedback) * feedback->pipelineStageCreationFeedbackCount);
-   }
+   lvp_pipeline_feedback(device, cache, feedback, cache_hit, t0);
 
    *pPipeline = lvp_pipeline_to_handle(pipeline);
 
    return VK_SUCCESS;
 }
 
+struct lvp_pipeline_jobs *
+lvp_pipeline_jobs_alloc(struct lvp_device *device, uint32_t count)
+{
+   struct lvp_pipeline_jobs *jobs =
+      vk_zalloc(&device->vk.alloc, sizeof(*jobs) + count * sizeof(jobs->jobs[0]), 8,
+                VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+   if (!jobs)
+      return NULL;
+
+   jobs->device = device;
+   jobs->count = count;
+   return jobs;
+}
+
+static void
+lvp_pipeline_job_queue_execute(void *data, void *gdata, int thread_index)
+{
+   struct lvp_pipeline_job *job = data;
+
+   *job->pipeline = VK_NULL_HANDLE;
+   job->result = job->create(job);
+}
+
+static void
+lvp_pipeline_job_execute(void *data, uint32_t index)
+{
+   struct lvp_pipeline_jobs *jobs = data;
+   lvp_pipeline_job_queue_execute(&jobs->jobs[index], NULL, 0);
+}
+
+/* Settles the results the way creating the pipelines one after the other
+ * would have: the last failure is returned, and the pipelines following one
+ * which failed with EARLY_RETURN_ON_FAILURE are destroyed again.
+ */
+static VkResult
+lvp_pipeline_jobs_finish(void *data)
+{
+   struct lvp_pipeline_jobs *jobs = data;
+   struct lvp_device *device = jobs->device;
+   VkResult result = VK_SUCCESS;
+   bool returned = false;
+
+   for (uint32_t i = 0; i < jobs->count; i++) {
+      struct lvp_pipeline_job *job = &jobs->jobs[i];
+
+      if (returned) {
+         VK_FROM_HANDLE(lvp_pipeline, pipeline, *job->pipeline);
+         if (pipeline)
+            lvp_pipeline_destroy(device, pipeline, false);
+         *job->pipeline = VK_NULL_HANDLE;
+         continue;
+      }
+
+      if (job->result != VK_SUCCESS) {
+         result = job->result;
+         *job->pipeline = VK_NULL_HANDLE;
+         if (job->flags & VK_PIPELINE_CREATE_2_EARLY_RETURN_ON_FAILURE_BIT_KHR)
+            returned = true;
+      }
+   }
+
+   vk_free(&device->vk.alloc, jobs);
+   return result;
+}
+
+/* Creates the pipelines one after the other, stopping after a failure with
+ * EARLY_RETURN_ON_FAILURE.
+ */
+static void
+lvp_pipeline_jobs_execute_serial(void *data, UNUSED uint32_t index)
+{
+   struct lvp_pipeline_jobs *jobs = data;
+
+   for (uint32_t i = 0; i < jobs->count; i++) {
+      jobs->jobs[i].parallel_stages = jobs->count == 1;
+      lvp_pipeline_job_execute(jobs, i);
+      if (jobs->jobs[i].result != VK_SUCCESS &&
+          (jobs->jobs[i].flags & VK_PIPELINE_CREATE_2_EARLY_RETURN_ON_FAILURE_BIT_KHR)) {
+         for (uint32_t j = i + 1; j < jobs->count; j++)
+            *jobs->jobs[j].pipeline = VK_NULL_HANDLE;
+         break;
+      }
+   }
+}
+
+/**
+ * Creates the pipelines of a vkCreate*Pipelines call, and frees the jobs.
+ *
+ * Pipelines are independent of each other, so when there are several they
+ * are created on the device's compile queue, while a single pipeline gets
+ * its stages compiled there instead.  With a deferred operation, the
+ * pipelines are created by the threads joining it.  An externally
+ * synchronized cache keeps all of it on one thread.
+ */
+VkResult
+lvp_pipeline_jobs_run(struct lvp_pipeline_jobs *jobs, VkDeferredOperationKHR deferred_operation)
+{
+   VK_FROM_HANDLE(vk_deferred_operation, op, deferred_operation);
+   struct lvp_device *device = jobs->device;
+
+   if (!jobs->count) {
+      vk_free(&device->vk.alloc, jobs);
+      return VK_SUCCESS;
+   }
+
+   /* All pipelines of a call share the cache */
+   VK_FROM_HANDLE(vk_pipeline_cache, cache, jobs->jobs[0].cache);
+   const bool serial = lvp_cache_is_externally_synchronized(cache);
+
+   if (op) {
+      if (serial) {
+         return vk_deferred_operation_defer(op, 1, lvp_pipeline_jobs_execute_serial,
+                                            lvp_pipeline_jobs_finish, jobs);
+      }
+      return vk_deferred_operation_defer(op, jobs->count, lvp_pipeline_job_execute,
+                                         lvp_pipeline_jobs_finish, jobs);
+   }
+
+   struct util_queue *queue =
+      jobs->count > 1 && !serial ? lvp_device_compile_queue(device) : NULL;
+   if (!queue) {
+      lvp_pipeline_jobs_execute_serial(jobs, 0);
+      return lvp_pipeline_jobs_finish(jobs);
+   }
+
+   for (uint32_t i = 1; i < jobs->count; i++) {
+      util_queue_fence_init(&jobs->jobs[i].fence);
+      util_queue_add_job(queue, &jobs->jobs[i], &jobs->jobs[i].fence,
+                         lvp_pipeline_job_queue_execute, NULL, 0);
+   }
+
+   lvp_pipeline_job_execute(jobs, 0);
+
+   for (uint32_t i = 1; i < jobs->count; i++) {
+      util_queue_fence_wait(&jobs->jobs[i].fence);
+      util_queue_fence_destroy(&jobs->jobs[i].fence);
+   }
+
+   return lvp_pipeline_jobs_finish(jobs);
+}
+
+static VkResult
+lvp_graphics_pipeline_job(struct lvp_pipeline_job *job)
+{
+   return lvp_graphics_pipeline_create(job->device, job->cache, job->create_info,
+                                       job->flags, job->pipeline, false,
+                                       job->parallel_stages);
+}
+
 VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateGraphicsPipelines(
    VkDevice                                    _device,
    VkPipelineCache                             pipelineCache,
@@ -983,41 +1420,37 @@ VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateGraphicsPipelines(
    const VkAllocationCallbacks*                pAllocator,
    VkPipeline*                                 pPipelines)
 {
-   VkResult result = VK_SUCCESS;
-   unsigned i = 0;
-
-   for (; i < count; i++) {
-      VkResult r = VK_PIPELINE_COMPILE_REQUIRED;
-      VkPipelineCreateFlagBits2KHR flags = vk_graphics_pipeline_create_flags(&pCreateInfos[i]);
+   VK_FROM_HANDLE(lvp_device, device, _device);
 
-      if (!(flags & VK_PIPELINE_CREATE_2_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT_KHR))
-         r = lvp_graphics_pipeline_create(_device,
-                                          pipelineCache,
-                                          &pCreateInfos[i],
-                                          flags,
-                                          &pPipelines[i],
-                                          false);
-      if (r != VK_SUCCESS) {
-         result = r;
+   struct lvp_pipeline_jobs *jobs = lvp_pipeline_jobs_alloc(device, count);
+   if (!jobs) {
+      for (uint32_t i = 0; i < count; i++)
          pPipelines[i] = VK_NULL_HANDLE;
-         if (flags & VK_PIPELINE_CREATE_2_EARLY_RETURN_ON_FAILURE_BIT_KHR)
-            break;
-      }
+      return vk_error(device, VK_ERROR_OUT_OF_HOST_MEMORY);
    }
-   if (result != VK_SUCCESS) {
-      for (; i < count; i++)
-         pPipelines[i] = VK_NULL_HANDLE;
+
+   for (uint32_t i = 0; i < count; i++) {
+      jobs->jobs[i] = (struct lvp_pipeline_job) {
+         .create = lvp_graphics_pipeline_job,
+         .device = _device,
+         .cache = pipelineCache,
+         .create_info = &pCreateInfos[i],
+         .flags = vk_graphics_pipeline_create_flags(&pCreateInfos[i]),
+         .pipeline = &pPipelines[i],
+      };
    }
 
-   return result;
+   return lvp_pipeline_jobs_run(jobs, VK_NULL_HANDLE);
 }
 
 static VkResult
 lvp_compute_pipeline_init(struct lvp_pipeline *pipeline,
                           struct lvp_device *device,
-                          struct lvp_pipeline_cache *cache,
+                          struct vk_pipeline_cache *cache,
                           const VkComputePipelineCreateInfo *pCreateInfo,
-                          VkPipelineCreateFlagBits2KHR flags)
+                          VkPipelineCreateFlagBits2KHR flags,
+                          const VkPipelineCreationFeedbackCreateInfo *feedback,
+                          bool *cache_hit)
 {
    pipeline->flags = flags;
    pipeline->layout = lvp_pipeline_layout_from_handle(pCreateInfo->layout);
@@ -1026,7 +1459,8 @@ lvp_compute_pipeline_init(struct lvp_pipeline *pipeline,
 
    pipeline->type = LVP_PIPELINE_COMPUTE;
 
-   VkResult result = lvp_shader_compile_to_ir(pipeline, pCreateInfo->pNext, &pCreateInfo->stage);
+   VkResult result = lvp_shader_compile_to_ir(pipeline, cache, pCreateInfo->pNext, &pCreateInfo->stage,
+                                              lvp_stage_feedback(feedback, 0), cache_hit);
    if (result != VK_SUCCESS)
       return result;
 
@@ -1047,12 +1481,15 @@ lvp_compute_pipeline_create(
    VkPipeline *pPipeline)
 {
    VK_FROM_HANDLE(lvp_device, device, _device);
-   VK_FROM_HANDLE(lvp_pipeline_cache, cache, _cache);
+   VK_FROM_HANDLE(vk_pipeline_cache, cache, _cache);
    struct lvp_pipeline *pipeline;
    VkResult result;
 
    assert(pCreateInfo->sType == VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO);
 
+   if (cache == NULL)
+      cache = device->vk.mem_cache;
+
    pipeline = vk_zalloc(&device->vk.alloc, sizeof(*pipeline), 8,
                          VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
    if (pipeline == NULL)
@@ -1061,24 +1498,31 @@ lvp_compute_pipeline_create(
    vk_object_base_init(&device->vk, &pipeline->base,
                        VK_OBJECT_TYPE_PIPELINE);
    uint64_t t0 = os_time_get_nano();
-   result = lvp_compute_pipeline_init(pipeline, device, cache, pCreateInfo, flags);
+   const VkPipelineCreationFeedbackCreateInfo *feedback = (void*)vk_find_struct_const(pCreateInfo->pNext, PIPELINE_CREATION_FEEDBACK_CREATE_INFO);
+   if (feedback)
+      memset(feedback->pPipelineStageCreationFeedbacks, 0, sizeof(VkPipelineCreationFeedback) * feedback->pipelineStageCreationFeedbackCount);
+
+   bool cache_hit;
+   result = lvp_compute_pipeline_init(pipeline, device, cache, pCreateInfo, flags, feedback, &cache_hit);
    if (result != VK_SUCCESS) {
       vk_free(&device->vk.alloc, pipeline);
       return result;
    }
 
-   const VkPipelineCreationFeedbackCreateInfo *feedback = (void*)vk_find_struct_const(pCreateInfo->pNext, PIPELINE_CREATION_FEEDBACK_CREATE_INFO);
-   if (feedback) {
-      feedback->pPipelineCreationFeedback->duration = os_time_get_nano() - t0;
-      feedback->pPipelineCreationFeedback->flags = VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT;
-      memset(feedback->pPipelineStageCreationFeedbacks, 0, sizeof(VkPipelineCreationFeedback) * feedback->pipelineStageCreationFeedbackCount);
-   }
+   lvp_pipeline_feedback(device, cache, feedback, cache_hit, t0);
 
    *pPipeline = lvp_pipeline_to_handle(pipeline);
 
    return VK_SUCCESS;
 }
 
+static VkResult
+lvp_compute_pipeline_job(struct lvp_pipeline_job *job)
+{
+   return lvp_compute_pipeline_create(job->device, job->cache, job->create_info,
+                                      job->flags, job->pipeline);
+}
+
 VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateComputePipelines(
    VkDevice                                    _device,
    VkPipelineCache                             pipelineCache,
@@ -1087,33 +1531,27 @@ VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateComputePipelines(
    const VkAllocationCallbacks*                pAllocator,
    VkPipeline*                                 pPipelines)
 {
-   VkResult result = VK_SUCCESS;
-   unsigned i = 0;
-
-   for (; i < count; i++) {
-      VkResult r = VK_PIPELINE_COMPILE_REQUIRED;
-      VkPipelineCreateFlagBits2KHR flags = vk_compute_pipeline_create_flags(&pCreateInfos[i]);
+   VK_FROM_HANDLE(lvp_device, device, _device);
 
-      if (!(flags & VK_PIPELINE_CREATE_2_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT_KHR))
-         r = lvp_compute_pipeline_create(_device,
-                                         pipelineCache,
-                                         &pCreateInfos[i],
-                                         flags,
-                                         &pPipelines[i]);
-      if (r != VK_SUCCESS) {
-         result = r;
-         pPipelines[i] = VK_NULL_HANDLE;
-         if (flags & VK_PIPELINE_CREATE_2_EARLY_RETURN_ON_FAILURE_BIT_KHR)
-            break;
-      }
-   }
-   if (result != VK_SUCCESS) {
-      for (; i < count; i++)
+   struct lvp_pipeline_jobs *jobs = lvp_pipeline_jobs_alloc(device, count);
+   if (!jobs) {
+      for (uint32_t i = 0; i < count; i++)
          pPipelines[i] = VK_NULL_HANDLE;
+      return vk_error(device, VK_ERROR_OUT_OF_HOST_MEMORY);
    }
 
+   for (uint32_t i = 0; i < count; i++) {
+      jobs->jobs[i] = (struct lvp_pipeline_job) {
+         .create = lvp_compute_pipeline_job,
+         .device = _device,
+         .cache = pipelineCache,
+         .create_info = &pCreateInfos[i],
+         .flags = vk_compute_pipeline_create_flags(&pCreateInfos[i]),
+         .pipeline = &pPipelines[i],
+      };
+   }
 
-   return result;
+   return lvp_pipeline_jobs_run(jobs, VK_NULL_HANDLE);
 }
 
 VKAPI_ATTR void VKAPI_CALL lvp_DestroyShaderEXT(
@@ -96,7 +96,7 @@ typedef uint32_t xcb_window_t;
 extern "C" {
 #endif
 
-#define LVP_NUM_QUEUES 1
+#define LVP_NUM_QUEUES 4
 #define MAX_SETS 8
 #define MAX_DESCRIPTORS 1000000 /* Required by vkd3d-proton */
 #define MAX_PUSH_CONSTANTS_SIZE 256
@@ -111,6 +111,11 @@ extern "C" {
 #define LVP_MAX_TLAS_DEPTH 24
 #define LVP_MAX_BLAS_DEPTH 29
 
+/* Imported host pointers are used as resource backing in place, so they
+ * have to be page aligned like the memory llvmpipe allocates itself.
+ */
+#define LVP_HOST_POINTER_ALIGNMENT 4096
+
 #ifdef _WIN32
 #define lvp_printflike(a, b)
 #else
@@ -182,15 +187,39 @@ void lvp_finish_wsi(struct lvp_physical_device *physical_device);
 bool lvp_physical_device_extension_supported(struct lvp_physical_device *dev,
                                               const char *name);
 
+struct lvp_queue_cso {
+   mesa_shader_stage stage;
+   void *cso;
+};
+
 struct lvp_queue {
    struct vk_queue vk;
    struct pipe_context *ctx;
    struct cso_context *cso;
    struct u_upload_mgr *uploader;
    struct pipe_fence_handle *last_fence;
+   void *noop_fs;
    void *state;
-   struct util_dynarray pipeline_destroys;
    simple_mtx_t lock;
+
+   /* Pipelines destroyed while command buffers may still reference them,
+    * only used on queue 0.  They are freed after a submit, see
+    * destroy_pipelines().
+    */
+   struct util_dynarray pipeline_destroys;
+   simple_mtx_t pipeline_destroys_lock;
+
+   /* Shader CSOs this queue's context created for shaders which have since
+    * been destroyed; they can only be deleted on this queue's thread.
+    */
+   struct util_dynarray cso_destroys;
+   simple_mtx_t cso_destroys_lock;
+
+   /* Queries this queue's context created which were reset or destroyed
+    * from another thread, deleted on this queue's thread like the CSOs.
+    */
+   struct util_dynarray query_destroys;
+   simple_mtx_t query_destroys_lock;
 };
 
 static inline struct lvp_device *
@@ -199,17 +228,17 @@ lvp_queue_device(const struct lvp_queue *queue)
    return (struct lvp_device *)queue->vk.base.device;
 }
 
-struct lvp_pipeline_cache {
-   struct vk_object_base base;
-   VkAllocationCallbacks alloc;
-};
-
 struct lvp_device {
    struct vk_device vk;
 
+   /* Queue 0's context also owns the device-level state (shader CSOs,
+    * texture handles, queries), which device->queue.lock protects.  The
+    * other queues have contexts of their own and run concurrently with it.
+    */
    struct lvp_queue queue;
+   struct lvp_queue extra_queues[LVP_NUM_QUEUES - 1];
+   uint32_t queue_count;
    struct pipe_screen *pscreen;
-   void *noop_fs;
    simple_mtx_t bda_lock;
    struct hash_table bda;
    struct pipe_resource *zero_buffer; /* for zeroed bda */
@@ -223,6 +252,12 @@ struct lvp_device {
 
    uint32_t group_handle_alloc;
 
+   /* Worker threads for creating pipelines and compiling their stages,
+    * started by the first compile which can use them.
+    */
+   simple_mtx_t compile_queue_lock;
+   struct util_queue compile_queue;
+
    struct vk_meta_device meta;
    radix_sort_vk_t *radix_sort;
    simple_mtx_t radix_sort_lock;
@@ -379,6 +414,27 @@ struct lvp_descriptor_set {
    void *map;
 };
 
+/* One run of a compiled descriptor update template: count descriptors of
+ * the same type which are contiguous both in the set and, src_stride apart,
+ * in the user data.  For inline uniform blocks, dst and count are in bytes
+ * and the run is a single memcpy.
+ */
+struct lvp_descriptor_update_op {
+   VkDescriptorType type;
+   bool immutable_samplers;
+   uint32_t count;
+   uint32_t dst;        /* lp_descriptor index, or byte offset in the map */
+   uint32_t dst_stride; /* lp_descriptors per array element */
+   size_t src;
+   size_t src_stride;
+};
+
+/* vk_descriptor_update_template::driver_data */
+struct lvp_descriptor_update_program {
+   uint32_t op_count;
+   struct lvp_descriptor_update_op ops[0];
+};
+
 struct lvp_descriptor_pool {
    struct vk_object_base base;
    VkDescriptorPoolCreateFlags flags;
@@ -445,6 +501,9 @@ struct lvp_shader {
    struct lvp_pipeline_nir *tess_ccw;
    void *shader_cso;
    void *tess_ccw_cso;
+   /* CSOs of the other queues, created when they first bind the shader */
+   void *queue_cso[LVP_NUM_QUEUES - 1];
+   void *queue_tess_ccw_cso[LVP_NUM_QUEUES - 1];
    struct pipe_stream_output_info stream_output;
    struct blob blob; //preserved for GetShaderBinaryDataEXT
    uint32_t push_constant_size;
@@ -571,6 +630,37 @@ struct lvp_exec_graph_internal_data {
 void
 lvp_pipeline_shaders_compile(struct lvp_pipeline *pipeline, bool locked);
 
+struct lvp_pipeline_job;
+
+typedef VkResult (*lvp_pipeline_create_func)(struct lvp_pipeline_job *job);
+
+/* Creates one pipeline of a vkCreate*Pipelines call. */
+struct lvp_pipeline_job {
+   struct util_queue_fence fence;
+   lvp_pipeline_create_func create;
+   VkDevice device;
+   VkPipelineCache cache;
+   const void *create_info;
+   const VkAllocationCallbacks *alloc;
+   VkPipelineCreateFlagBits2KHR flags;
+   VkPipeline *pipeline;
+   VkResult result;
+   /* Set when the pipeline's stages may be compiled on the worker threads */
+   bool parallel_stages;
+};
+
+struct lvp_pipeline_jobs {
+   struct lvp_device *device;
+   uint32_t count;
+   struct lvp_pipeline_job jobs[];
+};
+
+struct lvp_pipeline_jobs *
+lvp_pipeline_jobs_alloc(struct lvp_device *device, uint32_t count);
+
+VkResult
+lvp_pipeline_jobs_run(struct lvp_pipeline_jobs *jobs, VkDeferredOperationKHR deferred_operation);
+
 struct lvp_event {
    struct vk_object_base base;
    volatile uint64_t event_storage;
@@ -606,12 +696,22 @@ struct lvp_query_pool {
    struct vk_query_pool vk;
    enum pipe_query_type base_type;
    void *data; /* Used by queries that are not implemented by pipe_query */
+   /* Queue whose context each of queries[] was created on, every queue has
+    * its own context and only that queue's thread may destroy the query.
+    */
+   struct lvp_queue **query_queue;
    struct pipe_query *queries[0];
 };
 
+void
+lvp_query_pool_destroy_query(struct lvp_query_pool *pool, uint32_t idx,
+                             struct lvp_queue *queue);
+
 struct lvp_cmd_buffer {
    struct vk_command_buffer vk;
    uint8_t push_constants[MAX_PUSH_CONSTANTS_SIZE];
+   /* Recorded without ONE_TIME_SUBMIT, worth optimizing at EndCommandBuffer */
+   bool reusable;
 };
 
 static inline struct lvp_device *
@@ -693,8 +793,6 @@ VK_DEFINE_NONDISP_HANDLE_CASTS(lvp_event, base, VkEvent, VK_OBJECT_TYPE_EVENT)
 VK_DEFINE_NONDISP_HANDLE_CASTS(lvp_image, vk.base, VkImage, VK_OBJECT_TYPE_IMAGE)
 VK_DEFINE_NONDISP_HANDLE_CASTS(lvp_image_view, vk.base, VkImageView,
                                VK_OBJECT_TYPE_IMAGE_VIEW);
-VK_DEFINE_NONDISP_HANDLE_CASTS(lvp_pipeline_cache, base, VkPipelineCache,
-                               VK_OBJECT_TYPE_PIPELINE_CACHE)
 VK_DEFINE_NONDISP_HANDLE_CASTS(lvp_pipeline, base, VkPipeline,
                                VK_OBJECT_TYPE_PIPELINE)
 VK_DEFINE_NONDISP_HANDLE_CASTS(lvp_shader, base, VkShaderEXT,
@@ -801,6 +899,12 @@ lvp_shader_optimize(nir_shader *nir);
 void *
 lvp_shader_compile(struct lvp_device *device, struct lvp_shader *shader, nir_shader *nir, bool locked);
 
+void *
+lvp_shader_get_cso(struct lvp_queue *queue, struct lvp_shader *shader, bool tess_ccw);
+
+void
+lvp_shader_cso_delete(struct pipe_context *ctx, mesa_shader_stage stage, void *cso);
+
 enum vk_cmd_type
 lvp_nv_dgc_token_to_cmd_type(const VkIndirectCommandsLayoutTokenNV *token);
 
@@ -24,6 +24,32 @@
 #include "lvp_private.h"
 #include "pipe/p_context.h"
 
+/**
+ * Drops query idx of the pool.  queue is the queue the caller executes on,
+ * or NULL for the host.  A query is only destroyed right away on the queue
+ * whose context owns it, otherwise that context may be busy on its own
+ * thread and the query is handed back to be destroyed after the owning
+ * queue's next submit.
+ */
+void
+lvp_query_pool_destroy_query(struct lvp_query_pool *pool, uint32_t idx,
+                             struct lvp_queue *queue)
+{
+   struct pipe_query *query = pool->queries[idx];
+   if (!query)
+      return;
+
+   struct lvp_queue *owner = pool->query_queue[idx];
+   if (owner == queue) {
+      owner->ctx->destroy_query(owner->ctx, query);
+   } else {
+      simple_mtx_lock(&owner->query_destroys_lock);
+      util_dynarray_append(&owner->query_destroys, query);
+      simple_mtx_unlock(&owner->query_destroys_lock);
+   }
+   pool->queries[idx] = NULL;
+}
+
 VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateQueryPool(
     VkDevice                                    _device,
     const VkQueryPoolCreateInfo*                pCreateInfo,
@@ -71,17 +97,22 @@ VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateQueryPool(
       return VK_ERROR_FEATURE_NOT_PRESENT;
    }
 
+   size_t queue_size = pipeq < PIPE_QUERY_TYPES ?
+      pCreateInfo->queryCount * sizeof(struct lvp_queue *) : 0;
    struct lvp_query_pool *pool = vk_query_pool_create(&device->vk,
                                                       pCreateInfo,
                                                       pAllocator,
                                                       sizeof(*pool)
-                                                      + pCreateInfo->queryCount * query_size);
+                                                      + pCreateInfo->queryCount * query_size
+                                                      + queue_size);
 
    if (!pool)
       return vk_error(device, VK_ERROR_OUT_OF_HOST_MEMORY);
 
    pool->base_type = pipeq;
    pool->data = &pool->queries;
+   if (queue_size)
+      pool->query_queue = (struct lvp_queue **)&pool->queries[pCreateInfo->queryCount];
 
    *pQueryPool = lvp_query_pool_to_handle(pool);
    return VK_SUCCESS;
@@ -100,8 +131,7 @@ VKAPI_ATTR void VKAPI_CALL lvp_DestroyQueryPool(
 
    if (pool->base_type < PIPE_QUERY_TYPES) {
       for (unsigned i = 0; i < pool->vk.query_count; i++)
-         if (pool->queries[i])
-            device->queue.ctx->destroy_query(device->queue.ctx, pool->queries[i]);
+         lvp_query_pool_destroy_query(pool, i, NULL);
    }
    vk_query_pool_destroy(&device->vk, pAllocator, &pool->vk);
 }
@@ -145,10 +175,10 @@ VKAPI_ATTR VkResult VKAPI_CALL lvp_GetQueryPoolResults(
       }
 
       if (pool->queries[i]) {
-         ready = device->queue.ctx->get_query_result(device->queue.ctx,
-                                                     pool->queries[i],
-                                                     (flags & VK_QUERY_RESULT_WAIT_BIT),
-                                                     &result);
+         struct pipe_context *ctx = pool->query_queue[i]->ctx;
+         ready = ctx->get_query_result(ctx, pool->queries[i],
+                                       (flags & VK_QUERY_RESULT_WAIT_BIT),
+                                       &result);
       } else {
          result.u64 = 0;
       }
@@ -221,18 +251,11 @@ VKAPI_ATTR void VKAPI_CALL lvp_ResetQueryPool(
    uint32_t                                    firstQuery,
    uint32_t                                    queryCount)
 {
-   VK_FROM_HANDLE(lvp_device, device, _device);
    VK_FROM_HANDLE(lvp_query_pool, pool, queryPool);
 
    if (pool->base_type >= PIPE_QUERY_TYPES)
       return;
 
-   for (uint32_t i = 0; i < queryCount; i++) {
-      uint32_t idx = i + firstQuery;
-
-      if (pool->queries[idx]) {
-         device->queue.ctx->destroy_query(device->queue.ctx, pool->queries[idx]);
-         pool->queries[idx] = NULL;
-      }
-   }
+   for (uint32_t i = 0; i < queryCount; i++)
+      lvp_query_pool_destroy_query(pool, i + firstQuery, NULL);
 }
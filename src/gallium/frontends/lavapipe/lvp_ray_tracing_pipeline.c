@@ -1179,9 +1179,16 @@ fail:
    return result;
 }
 
+static VkResult
+lvp_ray_tracing_pipeline_job(struct lvp_pipeline_job *job)
+{
+   return lvp_create_ray_tracing_pipeline(job->device, job->alloc, job->create_info,
+                                          job->pipeline);
+}
+
 VKAPI_ATTR VkResult VKAPI_CALL
 lvp_CreateRayTracingPipelinesKHR(
-   VkDevice device,
+   VkDevice _device,
    VkDeferredOperationKHR deferredOperation,
    VkPipelineCache pipelineCache,
    uint32_t createInfoCount,
@@ -1189,30 +1196,30 @@ lvp_CreateRayTracingPipelinesKHR(
    const VkAllocationCallbacks *pAllocator,
    VkPipeline *pPipelines)
 {
-   VkResult result = VK_SUCCESS;
-
-   uint32_t i = 0;
-   for (; i < createInfoCount; i++) {
-      VkResult tmp_result = lvp_create_ray_tracing_pipeline(
-         device, pAllocator, pCreateInfos + i, pPipelines + i);
+   VK_FROM_HANDLE(lvp_device, device, _device);
 
-      if (tmp_result != VK_SUCCESS) {
-         result = tmp_result;
+   struct lvp_pipeline_jobs *jobs = lvp_pipeline_jobs_alloc(device, createInfoCount);
+   if (!jobs) {
+      for (uint32_t i = 0; i < createInfoCount; i++)
          pPipelines[i] = VK_NULL_HANDLE;
-
-         if (vk_rt_pipeline_create_flags(&pCreateInfos[i]) &
-             VK_PIPELINE_CREATE_2_EARLY_RETURN_ON_FAILURE_BIT_KHR)
-            break;
-      }
+      return vk_error(device, VK_ERROR_OUT_OF_HOST_MEMORY);
    }
 
-   for (; i < createInfoCount; i++)
-      pPipelines[i] = VK_NULL_HANDLE;
+   for (uint32_t i = 0; i < createInfoCount; i++) {
+      jobs->jobs[i] = (struct lvp_pipeline_job) {
+         .create = lvp_ray_tracing_pipeline_job,
+         .device = _device,
+         .cache = pipelineCache,
+         .create_info = &pCreateInfos[i],
+         .alloc = pAllocator,
+         .flags = vk_rt_pipeline_create_flags(&pCreateInfos[i]),
+         .pipeline = &pPipelines[i],
+      };
+   }
 
-   return result;
+   return lvp_pipeline_jobs_run(jobs, deferredOperation);
 }
 
-
 VKAPI_ATTR VkResult VKAPI_CALL
 lvp_GetRayTracingShaderGroupHandlesKHR(
     VkDevice _device,
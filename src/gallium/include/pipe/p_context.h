@@ -449,6 +449,13 @@ struct pipe_context {
    void (*set_min_samples)(struct pipe_context *,
                            unsigned min_samples);
 
+   /**
+    * Hint which state the frontend changes between draws, as a mask of
+    * PIPE_DYNAMIC_x flags.  The driver may then read that state at draw
+    * time rather than compile it into its shaders.  Optional.
+    */
+   void (*set_dynamic_state)(struct pipe_context *, unsigned flags);
+
    /* Called to set user clip plane state.  Unused on GL drivers with
     * !caps->clip_planes.
     */
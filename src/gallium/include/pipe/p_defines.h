@@ -450,6 +450,11 @@ enum pipe_flush_flags
 #define PIPE_TEXTURE_BARRIER_SAMPLER      (1 << 0)
 #define PIPE_TEXTURE_BARRIER_FRAMEBUFFER  (1 << 1)
 
+/**
+ * Flags for pipe_context::set_dynamic_state.
+ */
+#define PIPE_DYNAMIC_STENCIL_MASKS        (1 << 0) /* valuemask, writemask */
+
 /**
  * Resource binding flags -- gallium frontends must specify in advance all
  * the ways a resource might be used.
@@ -0,0 +1,422 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Checks which commands vkEndCommandBuffer drops from reusable lavapipe
+ * command buffers.  Each case records a sequence of commands and lists the
+ * ones expected to be left, in recording order: state which is set to the
+ * value it already has must go, while state set again after a barrier,
+ * event or transfer must stay, and nothing may be reordered.  Command
+ * buffers are only recorded, never submitted.
+ *
+ * Then reports the CPU time of submitting a command buffer which keeps
+ * setting the same state, recorded for one-time submission and so left
+ * alone, and recorded reusable.  Lavapipe executes on the CPU, so the
+ * time from vkQueueSubmit to the queue going idle is CPU time.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vulkan/vulkan_core.h>
+
+#include "vk_command_buffer.h"
+
+#include "util/macros.h"
+#include "util/os_time.h"
+
+#define MAX_OPS 16
+
+#define SUBMIT_BLOCKS 4096
+#define SUBMIT_RUNS 32
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL
+vk_icdGetInstanceProcAddr(VkInstance instance, const char *pName);
+
+static PFN_vkGetDeviceProcAddr get_device_proc_addr;
+
+#define CHECK(expr) do {                                             \
+      VkResult _result = (expr);                                     \
+      if (_result != VK_SUCCESS) {                                   \
+         fprintf(stderr, "%s failed: %d\n", #expr, _result);          \
+         exit(1);                                                    \
+      }                                                              \
+   } while (0)
+
+#define GET_DEVICE_PROC(device, name) \
+   ((PFN_vk##name)get_device_proc_addr(device, "vk" #name))
+
+enum op {
+   OP_END = 0,
+   OP_VIEWPORT_A,
+   OP_VIEWPORT_B,
+   OP_SCISSOR,
+   OP_LINE_WIDTH,
+   OP_DRAW,
+   OP_BARRIER,
+   OP_FILL,
+   OP_SET_EVENT,
+   OP_WAIT_EVENT,
+};
+
+struct op_case {
+   const char *name;
+   bool one_time_submit;
+   enum op ops[MAX_OPS];
+   /* Whether ops[i] is expected to survive vkEndCommandBuffer */
+   bool kept[MAX_OPS];
+};
+
+static const struct op_case cases[] = {
+   {
+      "equal viewports around draws",
+      false,
+      { OP_VIEWPORT_A, OP_DRAW, OP_VIEWPORT_A, OP_DRAW, OP_VIEWPORT_B, OP_DRAW,
+        OP_VIEWPORT_A, OP_DRAW },
+      { true, true, false, true, true, true, true, true },
+   },
+   {
+      "other state in between",
+      false,
+      { OP_LINE_WIDTH, OP_VIEWPORT_A, OP_LINE_WIDTH, OP_SCISSOR, OP_SCISSOR,
+        OP_VIEWPORT_A, OP_DRAW },
+      { true, true, false, true, false, false, true },
+   },
+   {
+      "pipeline barrier",
+      false,
+      { OP_VIEWPORT_A, OP_DRAW, OP_BARRIER, OP_VIEWPORT_A, OP_DRAW,
+        OP_BARRIER, OP_BARRIER },
+      { true, true, true, true, true, true, true },
+   },
+   {
+      "transfer",
+      false,
+      { OP_LINE_WIDTH, OP_DRAW, OP_FILL, OP_LINE_WIDTH, OP_DRAW },
+      { true, true, true, true, true },
+   },
+   {
+      "events",
+      false,
+      { OP_SCISSOR, OP_SET_EVENT, OP_SCISSOR, OP_WAIT_EVENT, OP_SCISSOR,
+        OP_DRAW, OP_SCISSOR },
+      { true, true, true, true, true, true, false },
+   },
+   {
+      "one-time submit",
+      true,
+      { OP_VIEWPORT_A, OP_DRAW, OP_VIEWPORT_A, OP_DRAW },
+      { true, true, true, true },
+   },
+};
+
+struct test_objects {
+   VkDevice device;
+   VkQueue queue;
+   VkCommandPool cmd_pool;
+   VkBuffer buffer;
+   VkDeviceMemory memory;
+   VkEvent event;
+};
+
+static enum vk_cmd_type
+op_cmd_type(enum op op)
+{
+   switch (op) {
+   case OP_VIEWPORT_A:
+   case OP_VIEWPORT_B:
+      return VK_CMD_SET_VIEWPORT;
+   case OP_SCISSOR:
+      return VK_CMD_SET_SCISSOR;
+   case OP_LINE_WIDTH:
+      return VK_CMD_SET_LINE_WIDTH;
+   case OP_DRAW:
+      return VK_CMD_DRAW;
+   case OP_BARRIER:
+      return VK_CMD_PIPELINE_BARRIER2;
+   case OP_FILL:
+      return VK_CMD_FILL_BUFFER;
+   case OP_SET_EVENT:
+      return VK_CMD_SET_EVENT2;
+   case OP_WAIT_EVENT:
+      return VK_CMD_WAIT_EVENTS2;
+   default:
+      UNREACHABLE("bad op");
+   }
+}
+
+static void
+record_op(const struct test_objects *objs, VkCommandBuffer cmd, enum op op)
+{
+   VkDevice device = objs->device;
+   const VkViewport viewports[2] = {
+      { 0, 0, 64, 64, 0, 1 },
+      { 0, 0, 32, 32, 0, 1 },
+   };
+   const VkRect2D scissor = { { 0, 0 }, { 16, 16 } };
+   const VkMemoryBarrier2 barrier = {
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+      .srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+      .srcAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT,
+      .dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+      .dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT,
+   };
+   const VkDependencyInfo dependency = {
+      .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+      .memoryBarrierCount = 1,
+      .pMemoryBarriers = &barrier,
+   };
+
+   switch (op) {
+   case OP_VIEWPORT_A:
+   case OP_VIEWPORT_B:
+      GET_DEVICE_PROC(device, CmdSetViewport)(cmd, 0, 1,
+                                              &viewports[op - OP_VIEWPORT_A]);
+      break;
+   case OP_SCISSOR:
+      GET_DEVICE_PROC(device, CmdSetScissor)(cmd, 0, 1, &scissor);
+      break;
+   case OP_LINE_WIDTH:
+      GET_DEVICE_PROC(device, CmdSetLineWidth)(cmd, 1.0f);
+      break;
+   case OP_DRAW:
+      GET_DEVICE_PROC(device, CmdDraw)(cmd, 3, 1, 0, 0);
+      break;
+   case OP_BARRIER:
+      GET_DEVICE_PROC(device, CmdPipelineBarrier2)(cmd, &dependency);
+      break;
+   case OP_FILL:
+      GET_DEVICE_PROC(device, CmdFillBuffer)(cmd, objs->buffer, 0,
+                                             VK_WHOLE_SIZE, 0);
+      break;
+   case OP_SET_EVENT:
+      GET_DEVICE_PROC(device, CmdSetEvent2)(cmd, objs->event, &dependency);
+      break;
+   case OP_WAIT_EVENT:
+      GET_DEVICE_PROC(device, CmdWaitEvents2)(cmd, 1, &objs->event,
+                                              &dependency);
+      break;
+   default:
+      UNREACHABLE("bad op");
+   }
+}
+
+static bool
+run_case(const struct test_objects *objs, const struct op_case *c)
+{
+   VkDevice device = objs->device;
+
+   const VkCommandBufferAllocateInfo cmd_info = {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+      .commandPool = objs->cmd_pool,
+      .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+      .commandBufferCount = 1,
+   };
+   VkCommandBuffer cmd;
+   CHECK(GET_DEVICE_PROC(device, AllocateCommandBuffers)(device, &cmd_info, &cmd));
+
+   const VkCommandBufferBeginInfo begin_info = {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+      .flags = c->one_time_submit ?
+               VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT : 0,
+   };
+   CHECK(GET_DEVICE_PROC(device, BeginCommandBuffer)(cmd, &begin_info));
+   for (unsigned i = 0; i < MAX_OPS && c->ops[i] != OP_END; i++)
+      record_op(objs, cmd, c->ops[i]);
+   CHECK(GET_DEVICE_PROC(device, EndCommandBuffer)(cmd));
+
+   /* The recorded commands must be the kept ops, in the same order */
+   VK_FROM_HANDLE(vk_command_buffer, cmd_buffer, cmd);
+   bool success = true;
+   unsigned i = 0;
+   list_for_each_entry(struct vk_cmd_queue_entry, entry,
+                       &cmd_buffer->cmd_queue.cmds, cmd_link) {
+      while (i < MAX_OPS && c->ops[i] != OP_END && !c->kept[i])
+         i++;
+
+      if (i == MAX_OPS || c->ops[i] == OP_END) {
+         fprintf(stderr, "%s: unexpected %s at the end\n", c->name,
+                 vk_cmd_queue_type_names[entry->type]);
+         success = false;
+         break;
+      }
+
+      if (entry->type != op_cmd_type(c->ops[i])) {
+         fprintf(stderr, "%s: op %u: expected %s, got %s\n", c->name, i,
+                 vk_cmd_queue_type_names[op_cmd_type(c->ops[i])],
+                 vk_cmd_queue_type_names[entry->type]);
+         success = false;
+         break;
+      }
+      i++;
+   }
+
+   if (success) {
+      while (i < MAX_OPS && c->ops[i] != OP_END && !c->kept[i])
+         i++;
+      if (i < MAX_OPS && c->ops[i] != OP_END) {
+         fprintf(stderr, "%s: op %u was dropped\n", c->name, i);
+         success = false;
+      }
+   }
+
+   GET_DEVICE_PROC(device, FreeCommandBuffers)(device, objs->cmd_pool, 1, &cmd);
+
+   printf("%-32s %s\n", c->name, success ? "ok" : "FAILED");
+   return success;
+}
+
+static VkCommandBuffer
+record_redundant_state(const struct test_objects *objs, bool one_time_submit)
+{
+   VkDevice device = objs->device;
+
+   const VkCommandBufferAllocateInfo cmd_info = {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+      .commandPool = objs->cmd_pool,
+      .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+      .commandBufferCount = 1,
+   };
+   VkCommandBuffer cmd;
+   CHECK(GET_DEVICE_PROC(device, AllocateCommandBuffers)(device, &cmd_info, &cmd));
+
+   const VkCommandBufferBeginInfo begin_info = {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+      .flags = one_time_submit ?
+               VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT : 0,
+   };
+   CHECK(GET_DEVICE_PROC(device, BeginCommandBuffer)(cmd, &begin_info));
+   for (unsigned i = 0; i < SUBMIT_BLOCKS; i++) {
+      record_op(objs, cmd, OP_VIEWPORT_A);
+      record_op(objs, cmd, OP_SCISSOR);
+      record_op(objs, cmd, OP_LINE_WIDTH);
+   }
+   CHECK(GET_DEVICE_PROC(device, EndCommandBuffer)(cmd));
+
+   return cmd;
+}
+
+/**
+ * Returns the best time of SUBMIT_RUNS submissions in microseconds.  A
+ * one-time command buffer is recorded again before each submission, which
+ * isn't timed.
+ */
+static double
+measure_submit(const struct test_objects *objs, bool one_time_submit)
+{
+   VkDevice device = objs->device;
+   VkCommandBuffer cmd = VK_NULL_HANDLE;
+   int64_t best = INT64_MAX;
+
+   for (unsigned i = 0; i < SUBMIT_RUNS; i++) {
+      if (one_time_submit || i == 0)
+         cmd = record_redundant_state(objs, one_time_submit);
+
+      const VkSubmitInfo submit_info = {
+         .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+         .commandBufferCount = 1,
+         .pCommandBuffers = &cmd,
+      };
+      int64_t start = os_time_get_nano();
+      CHECK(GET_DEVICE_PROC(device, QueueSubmit)(objs->queue, 1, &submit_info,
+                                                 VK_NULL_HANDLE));
+      CHECK(GET_DEVICE_PROC(device, QueueWaitIdle)(objs->queue));
+      best = MIN2(best, os_time_get_nano() - start);
+
+      if (one_time_submit || i == SUBMIT_RUNS - 1)
+         GET_DEVICE_PROC(device, FreeCommandBuffers)(device, objs->cmd_pool,
+                                                     1, &cmd);
+   }
+
+   return best / 1e3;
+}
+
+int
+main(int argc, char **argv)
+{
+   PFN_vkCreateInstance create_instance =
+      (PFN_vkCreateInstance)vk_icdGetInstanceProcAddr(NULL, "vkCreateInstance");
+
+   const VkApplicationInfo app = {
+      .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+      .apiVersion = VK_API_VERSION_1_3,
+   };
+   const VkInstanceCreateInfo instance_info = {
+      .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+      .pApplicationInfo = &app,
+   };
+   VkInstance instance;
+   CHECK(create_instance(&instance_info, NULL, &instance));
+
+#define GET_INSTANCE_PROC(name) \
+   ((PFN_vk##name)vk_icdGetInstanceProcAddr(instance, "vk" #name))
+
+   uint32_t pdev_count = 1;
+   VkPhysicalDevice pdev;
+   CHECK(GET_INSTANCE_PROC(EnumeratePhysicalDevices)(instance, &pdev_count, &pdev));
+
+   const float priority = 1.0f;
+   const VkDeviceQueueCreateInfo queue_info = {
+      .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+      .queueCount = 1,
+      .pQueuePriorities = &priority,
+   };
+   const VkDeviceCreateInfo device_info = {
+      .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+      .queueCreateInfoCount = 1,
+      .pQueueCreateInfos = &queue_info,
+   };
+   struct test_objects objs;
+   CHECK(GET_INSTANCE_PROC(CreateDevice)(pdev, &device_info, NULL, &objs.device));
+   VkDevice device = objs.device;
+
+   get_device_proc_addr = GET_INSTANCE_PROC(GetDeviceProcAddr);
+   GET_DEVICE_PROC(device, GetDeviceQueue)(device, 0, 0, &objs.queue);
+
+   const VkCommandPoolCreateInfo pool_info = {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+   };
+   CHECK(GET_DEVICE_PROC(device, CreateCommandPool)(device, &pool_info, NULL,
+                                                    &objs.cmd_pool));
+
+   const VkBufferCreateInfo buffer_info = {
+      .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+      .size = 4096,
+      .usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+   };
+   CHECK(GET_DEVICE_PROC(device, CreateBuffer)(device, &buffer_info, NULL,
+                                               &objs.buffer));
+   const VkMemoryAllocateInfo memory_info = {
+      .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+      .allocationSize = buffer_info.size,
+   };
+   CHECK(GET_DEVICE_PROC(device, AllocateMemory)(device, &memory_info, NULL,
+                                                 &objs.memory));
+   CHECK(GET_DEVICE_PROC(device, BindBufferMemory)(device, objs.buffer,
+                                                   objs.memory, 0));
+
+   const VkEventCreateInfo event_info = {
+      .sType = VK_STRUCTURE_TYPE_EVENT_CREATE_INFO,
+   };
+   CHECK(GET_DEVICE_PROC(device, CreateEvent)(device, &event_info, NULL,
+                                              &objs.event));
+
+   bool success = true;
+   for (unsigned i = 0; i < ARRAY_SIZE(cases); i++)
+      success &= run_case(&objs, &cases[i]);
+
+   printf("%u redundant state blocks per submit:\n", SUBMIT_BLOCKS);
+   printf("   one-time submit %10.2f us\n", measure_submit(&objs, true));
+   printf("   reusable        %10.2f us\n", measure_submit(&objs, false));
+
+   GET_DEVICE_PROC(device, DestroyEvent)(device, objs.event, NULL);
+   GET_DEVICE_PROC(device, DestroyBuffer)(device, objs.buffer, NULL);
+   GET_DEVICE_PROC(device, FreeMemory)(device, objs.memory, NULL);
+   GET_DEVICE_PROC(device, DestroyCommandPool)(device, objs.cmd_pool, NULL);
+   GET_INSTANCE_PROC(DestroyDevice)(device, NULL);
+   GET_INSTANCE_PROC(DestroyInstance)(instance, NULL);
+
+   return success ? 0 : 1;
+}
@@ -0,0 +1,277 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Measures descriptor update throughput on lavapipe.  A set of uniform
+ * buffers, storage buffers and samplers is updated over and over with
+ * vkUpdateDescriptorSets, with an update template that has one entry per
+ * binding, and with one that has an entry per descriptor.  The last one
+ * should run as fast as the per-binding template, since contiguous entries
+ * are merged when the template is created.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vulkan/vulkan_core.h>
+
+#include "util/macros.h"
+#include "util/os_time.h"
+
+#define NUM_DESCRIPTORS 64
+#define NUM_ITERATIONS 20000
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL
+vk_icdGetInstanceProcAddr(VkInstance instance, const char *pName);
+
+static PFN_vkGetDeviceProcAddr get_device_proc_addr;
+static PFN_vkUpdateDescriptorSets update_descriptor_sets;
+static PFN_vkUpdateDescriptorSetWithTemplate update_with_template;
+
+#define CHECK(expr) do {                                             \
+      VkResult _result = (expr);                                     \
+      if (_result != VK_SUCCESS) {                                   \
+         fprintf(stderr, "%s failed: %d\n", #expr, _result);          \
+         exit(1);                                                    \
+      }                                                              \
+   } while (0)
+
+#define GET_DEVICE_PROC(device, name) \
+   ((PFN_vk##name)get_device_proc_addr(device, "vk" #name))
+
+/* The data the templates read, laid out the way an engine would */
+struct update_data {
+   VkDescriptorBufferInfo ubos[NUM_DESCRIPTORS];
+   VkDescriptorBufferInfo ssbos[NUM_DESCRIPTORS];
+   VkDescriptorImageInfo samplers[NUM_DESCRIPTORS];
+};
+
+static const VkDescriptorType binding_types[] = {
+   VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+   VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+   VK_DESCRIPTOR_TYPE_SAMPLER,
+};
+
+static const size_t binding_offsets[] = {
+   offsetof(struct update_data, ubos),
+   offsetof(struct update_data, ssbos),
+   offsetof(struct update_data, samplers),
+};
+
+static const size_t binding_strides[] = {
+   sizeof(VkDescriptorBufferInfo),
+   sizeof(VkDescriptorBufferInfo),
+   sizeof(VkDescriptorImageInfo),
+};
+
+static VkDescriptorUpdateTemplate
+create_template(VkDevice device, VkDescriptorSetLayout layout, bool per_descriptor)
+{
+   VkDescriptorUpdateTemplateEntry entries[ARRAY_SIZE(binding_types) * NUM_DESCRIPTORS];
+   uint32_t entry_count = 0;
+
+   for (uint32_t b = 0; b < ARRAY_SIZE(binding_types); b++) {
+      const uint32_t count = per_descriptor ? 1 : NUM_DESCRIPTORS;
+
+      for (uint32_t i = 0; i < NUM_DESCRIPTORS; i += count) {
+         entries[entry_count++] = (VkDescriptorUpdateTemplateEntry) {
+            .dstBinding = b,
+            .dstArrayElement = i,
+            .descriptorCount = count,
+            .descriptorType = binding_types[b],
+            .offset = binding_offsets[b] + i * binding_strides[b],
+            .stride = binding_strides[b],
+         };
+      }
+   }
+
+   const VkDescriptorUpdateTemplateCreateInfo info = {
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO,
+      .descriptorUpdateEntryCount = entry_count,
+      .pDescriptorUpdateEntries = entries,
+      .templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET,
+      .descriptorSetLayout = layout,
+   };
+
+   VkDescriptorUpdateTemplate templ;
+   CHECK(GET_DEVICE_PROC(device, CreateDescriptorUpdateTemplate)(device, &info, NULL, &templ));
+   return templ;
+}
+
+static void
+report(const char *name, int64_t start, int64_t end)
+{
+   const double descriptors =
+      (double)NUM_ITERATIONS * NUM_DESCRIPTORS * ARRAY_SIZE(binding_types);
+   const double ns = (double)MAX2(end - start, 1);
+
+   printf("%-26s %8.2f ns/descriptor  %8.2f M descriptors/s\n",
+          name, ns / descriptors, descriptors * 1e3 / ns);
+}
+
+int
+main(int argc, char **argv)
+{
+   PFN_vkCreateInstance create_instance =
+      (PFN_vkCreateInstance)vk_icdGetInstanceProcAddr(NULL, "vkCreateInstance");
+
+   const VkApplicationInfo app = {
+      .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+      .apiVersion = VK_API_VERSION_1_3,
+   };
+   const VkInstanceCreateInfo instance_info = {
+      .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+      .pApplicationInfo = &app,
+   };
+   VkInstance instance;
+   CHECK(create_instance(&instance_info, NULL, &instance));
+
+#define GET_INSTANCE_PROC(name) \
+   ((PFN_vk##name)vk_icdGetInstanceProcAddr(instance, "vk" #name))
+
+   uint32_t pdev_count = 1;
+   VkPhysicalDevice pdev;
+   CHECK(GET_INSTANCE_PROC(EnumeratePhysicalDevices)(instance, &pdev_count, &pdev));
+
+   const float priority = 1.0f;
+   const VkDeviceQueueCreateInfo queue_info = {
+      .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+      .queueCount = 1,
+      .pQueuePriorities = &priority,
+   };
+   const VkDeviceCreateInfo device_info = {
+      .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+      .queueCreateInfoCount = 1,
+      .pQueueCreateInfos = &queue_info,
+   };
+   VkDevice device;
+   CHECK(GET_INSTANCE_PROC(CreateDevice)(pdev, &device_info, NULL, &device));
+
+   get_device_proc_addr = GET_INSTANCE_PROC(GetDeviceProcAddr);
+   update_descriptor_sets = GET_DEVICE_PROC(device, UpdateDescriptorSets);
+   update_with_template = GET_DEVICE_PROC(device, UpdateDescriptorSetWithTemplate);
+
+   /* Resources */
+   const VkBufferCreateInfo buffer_info = {
+      .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+      .size = 4096,
+      .usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+   };
+   VkBuffer buffer;
+   CHECK(GET_DEVICE_PROC(device, CreateBuffer)(device, &buffer_info, NULL, &buffer));
+
+   const VkMemoryAllocateInfo memory_info = {
+      .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+      .allocationSize = buffer_info.size,
+   };
+   VkDeviceMemory memory;
+   CHECK(GET_DEVICE_PROC(device, AllocateMemory)(device, &memory_info, NULL, &memory));
+   CHECK(GET_DEVICE_PROC(device, BindBufferMemory)(device, buffer, memory, 0));
+
+   const VkSamplerCreateInfo sampler_info = {
+      .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+      .magFilter = VK_FILTER_LINEAR,
+      .minFilter = VK_FILTER_LINEAR,
+   };
+   VkSampler sampler;
+   CHECK(GET_DEVICE_PROC(device, CreateSampler)(device, &sampler_info, NULL, &sampler));
+
+   /* Set */
+   VkDescriptorSetLayoutBinding bindings[ARRAY_SIZE(binding_types)];
+   VkDescriptorPoolSize pool_sizes[ARRAY_SIZE(binding_types)];
+   for (uint32_t b = 0; b < ARRAY_SIZE(binding_types); b++) {
+      bindings[b] = (VkDescriptorSetLayoutBinding) {
+         .binding = b,
+         .descriptorType = binding_types[b],
+         .descriptorCount = NUM_DESCRIPTORS,
+         .stageFlags = VK_SHADER_STAGE_ALL,
+      };
+      pool_sizes[b] = (VkDescriptorPoolSize) {
+         .type = binding_types[b],
+         .descriptorCount = NUM_DESCRIPTORS,
+      };
+   }
+
+   const VkDescriptorSetLayoutCreateInfo layout_info = {
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+      .bindingCount = ARRAY_SIZE(bindings),
+      .pBindings = bindings,
+   };
+   VkDescriptorSetLayout layout;
+   CHECK(GET_DEVICE_PROC(device, CreateDescriptorSetLayout)(device, &layout_info, NULL, &layout));
+
+   const VkDescriptorPoolCreateInfo pool_info = {
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+      .maxSets = 1,
+      .poolSizeCount = ARRAY_SIZE(pool_sizes),
+      .pPoolSizes = pool_sizes,
+   };
+   VkDescriptorPool pool;
+   CHECK(GET_DEVICE_PROC(device, CreateDescriptorPool)(device, &pool_info, NULL, &pool));
+
+   const VkDescriptorSetAllocateInfo set_info = {
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+      .descriptorPool = pool,
+      .descriptorSetCount = 1,
+      .pSetLayouts = &layout,
+   };
+   VkDescriptorSet set;
+   CHECK(GET_DEVICE_PROC(device, AllocateDescriptorSets)(device, &set_info, &set));
+
+   /* Update data */
+   static struct update_data data;
+   for (uint32_t i = 0; i < NUM_DESCRIPTORS; i++) {
+      data.ubos[i] = (VkDescriptorBufferInfo) { buffer, i * 64, 64 };
+      data.ssbos[i] = (VkDescriptorBufferInfo) { buffer, 0, VK_WHOLE_SIZE };
+      data.samplers[i] = (VkDescriptorImageInfo) { .sampler = sampler };
+   }
+
+   VkWriteDescriptorSet writes[ARRAY_SIZE(binding_types)];
+   for (uint32_t b = 0; b < ARRAY_SIZE(binding_types); b++) {
+      writes[b] = (VkWriteDescriptorSet) {
+         .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+         .dstSet = set,
+         .dstBinding = b,
+         .descriptorCount = NUM_DESCRIPTORS,
+         .descriptorType = binding_types[b],
+      };
+   }
+   writes[0].pBufferInfo = data.ubos;
+   writes[1].pBufferInfo = data.ssbos;
+   writes[2].pImageInfo = data.samplers;
+
+   VkDescriptorUpdateTemplate per_binding = create_template(device, layout, false);
+   VkDescriptorUpdateTemplate per_descriptor = create_template(device, layout, true);
+
+   int64_t start = os_time_get_nano();
+   for (unsigned i = 0; i < NUM_ITERATIONS; i++)
+      update_descriptor_sets(device, ARRAY_SIZE(writes), writes, 0, NULL);
+   int64_t end = os_time_get_nano();
+   report("vkUpdateDescriptorSets", start, end);
+
+   start = os_time_get_nano();
+   for (unsigned i = 0; i < NUM_ITERATIONS; i++)
+      update_with_template(device, set, per_binding, &data);
+   end = os_time_get_nano();
+   report("template, per binding", start, end);
+
+   start = os_time_get_nano();
+   for (unsigned i = 0; i < NUM_ITERATIONS; i++)
+      update_with_template(device, set, per_descriptor, &data);
+   end = os_time_get_nano();
+   report("template, per descriptor", start, end);
+
+   GET_DEVICE_PROC(device, DestroyDescriptorUpdateTemplate)(device, per_descriptor, NULL);
+   GET_DEVICE_PROC(device, DestroyDescriptorUpdateTemplate)(device, per_binding, NULL);
+   GET_DEVICE_PROC(device, DestroyDescriptorPool)(device, pool, NULL);
+   GET_DEVICE_PROC(device, DestroyDescriptorSetLayout)(device, layout, NULL);
+   GET_DEVICE_PROC(device, DestroySampler)(device, sampler, NULL);
+   GET_DEVICE_PROC(device, FreeMemory)(device, memory, NULL);
+   GET_DEVICE_PROC(device, DestroyBuffer)(device, buffer, NULL);
+   GET_DEVICE_PROC(device, DestroyDevice)(device, NULL);
+   GET_INSTANCE_PROC(DestroyInstance)(instance, NULL);
+
+   return 0;
+}
@@ -0,0 +1,456 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Checks that descriptor update templates write the same descriptors as
+ * the equivalent vkUpdateDescriptorSets.  Each case is a list of template
+ * entries; the writes are derived from the same entries and the same data,
+ * one per entry.  Both are applied to freshly allocated sets, whose memory
+ * must then be equal.
+ *
+ * The entries are chosen so that template_entry_continues() merges some of
+ * them when the template is created, and lvp_descriptor_update_program_compile()
+ * merges some of the rest into one op: entries continuing across bindings,
+ * inline uniform blocks and arrays read with a stride.  The resulting entry
+ * and op counts are checked too, so a case can't silently stop covering the
+ * merging it is meant to.
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lvp_private.h"
+#include "vk_descriptor_update_template.h"
+
+#include "util/macros.h"
+
+#define NUM_ELEMENTS 16
+#define NUM_SETS_PER_CASE 3
+#define MAX_ENTRIES 16
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL
+vk_icdGetInstanceProcAddr(VkInstance instance, const char *pName);
+
+static PFN_vkGetDeviceProcAddr get_device_proc_addr;
+
+#define CHECK(expr) do {                                             \
+      VkResult _result = (expr);                                     \
+      if (_result != VK_SUCCESS) {                                   \
+         fprintf(stderr, "%s failed: %d\n", #expr, _result);          \
+         exit(1);                                                    \
+      }                                                              \
+   } while (0)
+
+#define GET_DEVICE_PROC(device, name) \
+   ((PFN_vk##name)get_device_proc_addr(device, "vk" #name))
+
+/* One element of the strided arrays, with a descriptor of every kind */
+struct element {
+   VkDescriptorBufferInfo buffer;
+   VkDescriptorImageInfo image;
+   VkBufferView texel_buffer;
+};
+
+struct update_data {
+   struct element elements[NUM_ELEMENTS];
+   VkDescriptorBufferInfo buffers[NUM_ELEMENTS];
+   uint8_t inline_data[64];
+};
+
+#define ELEMENT(i, member) \
+   (offsetof(struct update_data, elements) + (i) * sizeof(struct element) + \
+    offsetof(struct element, member))
+#define ELEMENT_STRIDE sizeof(struct element)
+
+#define BUFFER(i) \
+   (offsetof(struct update_data, buffers) + (i) * sizeof(VkDescriptorBufferInfo))
+#define BUFFER_STRIDE sizeof(VkDescriptorBufferInfo)
+
+#define INLINE_DATA(i) (offsetof(struct update_data, inline_data) + (i))
+
+/* Bindings 0 and 1, as well as 6 and 7, can be updated as one */
+static const VkDescriptorSetLayoutBinding bindings[] = {
+   { 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 4, VK_SHADER_STAGE_ALL, NULL },
+   { 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 4, VK_SHADER_STAGE_ALL, NULL },
+   { 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 8, VK_SHADER_STAGE_ALL, NULL },
+   { 3, VK_DESCRIPTOR_TYPE_SAMPLER, 4, VK_SHADER_STAGE_ALL, NULL },
+   { 4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4, VK_SHADER_STAGE_ALL, NULL },
+   { 5, VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 4, VK_SHADER_STAGE_ALL, NULL },
+   { 6, VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK, 16, VK_SHADER_STAGE_ALL, NULL },
+   { 7, VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK, 32, VK_SHADER_STAGE_ALL, NULL },
+};
+
+struct update_case {
+   const char *name;
+   VkDescriptorUpdateTemplateEntry entries[MAX_ENTRIES];
+   uint32_t entry_count;
+   /* After template_entry_continues() */
+   uint32_t merged_entries;
+   /* After lvp_descriptor_update_program_compile() */
+   uint32_t ops;
+};
+
+static const struct update_case cases[] = {
+   {
+      "across bindings",
+      {
+         /* Binding 0 elements 1-3 and binding 1 elements 0-1 */
+         { 0, 1, 5, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, BUFFER(0), BUFFER_STRIDE },
+         /* Continues the previous one in a different binding */
+         { 1, 2, 2, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, BUFFER(5), BUFFER_STRIDE },
+         /* One entry per descriptor */
+         { 2, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, BUFFER(8), BUFFER_STRIDE },
+         { 2, 1, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, BUFFER(9), BUFFER_STRIDE },
+         { 2, 2, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, BUFFER(10), BUFFER_STRIDE },
+         { 2, 3, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, BUFFER(11), BUFFER_STRIDE },
+         { 2, 4, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, BUFFER(12), BUFFER_STRIDE },
+         { 2, 5, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, BUFFER(13), BUFFER_STRIDE },
+         { 2, 6, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, BUFFER(14), BUFFER_STRIDE },
+         { 2, 7, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, BUFFER(15), BUFFER_STRIDE },
+      },
+      10, 3, 2,
+   },
+   {
+      "inline uniform blocks",
+      {
+         { 6, 0, 4, VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK, INLINE_DATA(0), 0 },
+         { 6, 4, 8, VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK, INLINE_DATA(4), 0 },
+         /* Bytes 12-15 of binding 6 and 0-7 of binding 7 */
+         { 6, 12, 12, VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK, INLINE_DATA(12), 0 },
+         /* Continues the previous one in a different binding */
+         { 7, 8, 8, VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK, INLINE_DATA(24), 0 },
+         /* Leaves a gap in both */
+         { 7, 20, 4, VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK, INLINE_DATA(40), 0 },
+      },
+      5, 3, 2,
+   },
+   {
+      "strided arrays",
+      {
+         { 2, 0, 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, ELEMENT(0, buffer), ELEMENT_STRIDE },
+         { 2, 4, 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, ELEMENT(4, buffer), ELEMENT_STRIDE },
+         { 3, 0, 2, VK_DESCRIPTOR_TYPE_SAMPLER, ELEMENT(0, image), ELEMENT_STRIDE },
+         { 3, 2, 2, VK_DESCRIPTOR_TYPE_SAMPLER, ELEMENT(2, image), ELEMENT_STRIDE },
+         /* Contiguous in the set but not in the data */
+         { 4, 0, 2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, ELEMENT(6, image), ELEMENT_STRIDE },
+         { 4, 2, 2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, ELEMENT(2, image), ELEMENT_STRIDE },
+         { 5, 1, 3, VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, ELEMENT(0, texel_buffer), ELEMENT_STRIDE },
+         /* Binding 0 elements 2-3 continued by binding 1 elements 0-2 */
+         { 0, 2, 2, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, ELEMENT(8, buffer), ELEMENT_STRIDE },
+         { 1, 0, 3, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, ELEMENT(10, buffer), ELEMENT_STRIDE },
+      },
+      9, 7, 6,
+   },
+};
+
+static VkDevice device;
+static VkDescriptorSetLayout layout;
+static VkDescriptorPool pool;
+
+/* Applies the entries as one VkWriteDescriptorSet each */
+static void
+write_entries(VkDescriptorSet set, const struct update_case *c, const uint8_t *data)
+{
+   VkWriteDescriptorSet writes[MAX_ENTRIES];
+   VkWriteDescriptorSetInlineUniformBlock inline_blocks[MAX_ENTRIES];
+   VkDescriptorBufferInfo buffer_infos[MAX_ENTRIES][NUM_ELEMENTS];
+   VkDescriptorImageInfo image_infos[MAX_ENTRIES][NUM_ELEMENTS];
+   VkBufferView texel_buffers[MAX_ENTRIES][NUM_ELEMENTS];
+
+   for (uint32_t i = 0; i < c->entry_count; i++) {
+      const VkDescriptorUpdateTemplateEntry *entry = &c->entries[i];
+      const uint8_t *src = data + entry->offset;
+
+      writes[i] = (VkWriteDescriptorSet) {
+         .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+         .dstSet = set,
+         .dstBinding = entry->dstBinding,
+         .dstArrayElement = entry->dstArrayElement,
+         .descriptorCount = entry->descriptorCount,
+         .descriptorType = entry->descriptorType,
+         .pBufferInfo = buffer_infos[i],
+         .pImageInfo = image_infos[i],
+         .pTexelBufferView = texel_buffers[i],
+      };
+
+      if (entry->descriptorType == VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK) {
+         inline_blocks[i] = (VkWriteDescriptorSetInlineUniformBlock) {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_INLINE_UNIFORM_BLOCK,
+            .dataSize = entry->descriptorCount,
+            .pData = src,
+         };
+         writes[i].pNext = &inline_blocks[i];
+         continue;
+      }
+
+      assert(entry->descriptorCount <= NUM_ELEMENTS);
+      for (uint32_t j = 0; j < entry->descriptorCount; j++, src += entry->stride) {
+         switch (entry->descriptorType) {
+         case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+         case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+            memcpy(&buffer_infos[i][j], src, sizeof(buffer_infos[i][j]));
+            break;
+         case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+            memcpy(&texel_buffers[i][j], src, sizeof(texel_buffers[i][j]));
+            break;
+         default:
+            memcpy(&image_infos[i][j], src, sizeof(image_infos[i][j]));
+            break;
+         }
+      }
+   }
+
+   GET_DEVICE_PROC(device, UpdateDescriptorSets)(device, c->entry_count, writes, 0, NULL);
+}
+
+static bool
+run_case(const struct update_case *c, const struct update_data *data)
+{
+   const VkDescriptorUpdateTemplateCreateInfo templ_info = {
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO,
+      .descriptorUpdateEntryCount = c->entry_count,
+      .pDescriptorUpdateEntries = c->entries,
+      .templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET,
+      .descriptorSetLayout = layout,
+   };
+   VkDescriptorUpdateTemplate templ_handle;
+   CHECK(GET_DEVICE_PROC(device, CreateDescriptorUpdateTemplate)(device, &templ_info,
+                                                                 NULL, &templ_handle));
+
+   const VkDescriptorSetLayout layouts[NUM_SETS_PER_CASE] = { layout, layout, layout };
+   const VkDescriptorSetAllocateInfo set_info = {
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+      .descriptorPool = pool,
+      .descriptorSetCount = NUM_SETS_PER_CASE,
+      .pSetLayouts = layouts,
+   };
+   VkDescriptorSet sets[NUM_SETS_PER_CASE];
+   CHECK(GET_DEVICE_PROC(device, AllocateDescriptorSets)(device, &set_info, sets));
+
+   /* sets[2] is left as allocated */
+   write_entries(sets[0], c, (const uint8_t *)data);
+   GET_DEVICE_PROC(device, UpdateDescriptorSetWithTemplate)(device, sets[1], templ_handle,
+                                                            data);
+
+   VK_FROM_HANDLE(vk_descriptor_update_template, templ, templ_handle);
+   const struct lvp_descriptor_update_program *program = templ->driver_data;
+   VK_FROM_HANDLE(lvp_descriptor_set, written, sets[0]);
+   VK_FROM_HANDLE(lvp_descriptor_set, templated, sets[1]);
+   VK_FROM_HANDLE(lvp_descriptor_set, untouched, sets[2]);
+   const size_t size = written->bo->width0;
+   bool success = true;
+
+   if (templ->entry_count != c->merged_entries || program->op_count != c->ops) {
+      fprintf(stderr, "%s: %u entries and %u ops, expected %u and %u\n", c->name,
+              templ->entry_count, program->op_count, c->merged_entries, c->ops);
+      success = false;
+   }
+
+   if (memcmp(written->map, untouched->map, size) == 0) {
+      fprintf(stderr, "%s: vkUpdateDescriptorSets wrote nothing\n", c->name);
+      success = false;
+   }
+
+   for (size_t i = 0; i < size; i++) {
+      const uint8_t *a = written->map, *b = templated->map;
+      if (a[i] != b[i]) {
+         fprintf(stderr, "%s: byte %zu of the set differs: 0x%02x, 0x%02x with the template\n",
+                 c->name, i, a[i], b[i]);
+         success = false;
+         break;
+      }
+   }
+
+   printf("%-24s %s\n", c->name, success ? "ok" : "FAILED");
+
+   CHECK(GET_DEVICE_PROC(device, ResetDescriptorPool)(device, pool, 0));
+   GET_DEVICE_PROC(device, DestroyDescriptorUpdateTemplate)(device, templ_handle, NULL);
+
+   return success;
+}
+
+int
+main(int argc, char **argv)
+{
+   PFN_vkCreateInstance create_instance =
+      (PFN_vkCreateInstance)vk_icdGetInstanceProcAddr(NULL, "vkCreateInstance");
+
+   const VkApplicationInfo app = {
+      .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+      .apiVersion = VK_API_VERSION_1_3,
+   };
+   const VkInstanceCreateInfo instance_info = {
+      .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+      .pApplicationInfo = &app,
+   };
+   VkInstance instance;
+   CHECK(create_instance(&instance_info, NULL, &instance));
+
+#define GET_INSTANCE_PROC(name) \
+   ((PFN_vk##name)vk_icdGetInstanceProcAddr(instance, "vk" #name))
+
+   uint32_t pdev_count = 1;
+   VkPhysicalDevice pdev;
+   CHECK(GET_INSTANCE_PROC(EnumeratePhysicalDevices)(instance, &pdev_count, &pdev));
+
+   const float priority = 1.0f;
+   const VkDeviceQueueCreateInfo queue_info = {
+      .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+      .queueCount = 1,
+      .pQueuePriorities = &priority,
+   };
+   const VkPhysicalDeviceVulkan13Features features13 = {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+      .inlineUniformBlock = VK_TRUE,
+   };
+   const VkDeviceCreateInfo device_info = {
+      .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+      .pNext = &features13,
+      .queueCreateInfoCount = 1,
+      .pQueueCreateInfos = &queue_info,
+   };
+   CHECK(GET_INSTANCE_PROC(CreateDevice)(pdev, &device_info, NULL, &device));
+
+   get_device_proc_addr = GET_INSTANCE_PROC(GetDeviceProcAddr);
+
+   /* Resources */
+   const VkBufferCreateInfo buffer_info = {
+      .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+      .size = 4096,
+      .usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+               VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT,
+   };
+   VkBuffer buffer;
+   CHECK(GET_DEVICE_PROC(device, CreateBuffer)(device, &buffer_info, NULL, &buffer));
+
+   const VkImageCreateInfo image_info = {
+      .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+      .imageType = VK_IMAGE_TYPE_2D,
+      .format = VK_FORMAT_R8G8B8A8_UNORM,
+      .extent = { 4, 4, 1 },
+      .mipLevels = 1,
+      .arrayLayers = 2,
+      .samples = VK_SAMPLE_COUNT_1_BIT,
+      .tiling = VK_IMAGE_TILING_OPTIMAL,
+      .usage = VK_IMAGE_USAGE_SAMPLED_BIT,
+   };
+   VkImage image;
+   CHECK(GET_DEVICE_PROC(device, CreateImage)(device, &image_info, NULL, &image));
+
+   VkMemoryRequirements image_reqs;
+   GET_DEVICE_PROC(device, GetImageMemoryRequirements)(device, image, &image_reqs);
+
+   const VkDeviceSize image_offset = align64(buffer_info.size, image_reqs.alignment);
+   const VkMemoryAllocateInfo memory_info = {
+      .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+      .allocationSize = image_offset + image_reqs.size,
+   };
+   VkDeviceMemory memory;
+   CHECK(GET_DEVICE_PROC(device, AllocateMemory)(device, &memory_info, NULL, &memory));
+   CHECK(GET_DEVICE_PROC(device, BindBufferMemory)(device, buffer, memory, 0));
+   CHECK(GET_DEVICE_PROC(device, BindImageMemory)(device, image, memory, image_offset));
+
+   /* Two of each, so that descriptors written in the wrong order differ */
+   VkSampler samplers[2];
+   VkImageView image_views[2];
+   for (uint32_t i = 0; i < 2; i++) {
+      const VkSamplerCreateInfo sampler_info = {
+         .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+         .magFilter = i ? VK_FILTER_LINEAR : VK_FILTER_NEAREST,
+         .minFilter = i ? VK_FILTER_LINEAR : VK_FILTER_NEAREST,
+      };
+      CHECK(GET_DEVICE_PROC(device, CreateSampler)(device, &sampler_info, NULL, &samplers[i]));
+
+      const VkImageViewCreateInfo view_info = {
+         .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+         .image = image,
+         .viewType = VK_IMAGE_VIEW_TYPE_2D,
+         .format = VK_FORMAT_R8G8B8A8_UNORM,
+         .subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, i, 1 },
+      };
+      CHECK(GET_DEVICE_PROC(device, CreateImageView)(device, &view_info, NULL, &image_views[i]));
+   }
+
+   VkBufferView texel_buffers[4];
+   for (uint32_t i = 0; i < ARRAY_SIZE(texel_buffers); i++) {
+      const VkBufferViewCreateInfo view_info = {
+         .sType = VK_STRUCTURE_TYPE_BUFFER_VIEW_CREATE_INFO,
+         .buffer = buffer,
+         .format = VK_FORMAT_R8G8B8A8_UNORM,
+         .offset = i * 256,
+         .range = 256,
+      };
+      CHECK(GET_DEVICE_PROC(device, CreateBufferView)(device, &view_info, NULL,
+                                                      &texel_buffers[i]));
+   }
+
+   /* Set layout and pool */
+   const VkDescriptorSetLayoutCreateInfo layout_info = {
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+      .bindingCount = ARRAY_SIZE(bindings),
+      .pBindings = bindings,
+   };
+   CHECK(GET_DEVICE_PROC(device, CreateDescriptorSetLayout)(device, &layout_info, NULL, &layout));
+
+   VkDescriptorPoolSize pool_sizes[ARRAY_SIZE(bindings)];
+   uint32_t inline_block_count = 0;
+   for (uint32_t b = 0; b < ARRAY_SIZE(bindings); b++) {
+      pool_sizes[b] = (VkDescriptorPoolSize) {
+         .type = bindings[b].descriptorType,
+         .descriptorCount = bindings[b].descriptorCount * NUM_SETS_PER_CASE,
+      };
+      if (bindings[b].descriptorType == VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK)
+         inline_block_count += NUM_SETS_PER_CASE;
+   }
+
+   const VkDescriptorPoolInlineUniformBlockCreateInfo pool_inline_info = {
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_INLINE_UNIFORM_BLOCK_CREATE_INFO,
+      .maxInlineUniformBlockBindings = inline_block_count,
+   };
+   const VkDescriptorPoolCreateInfo pool_info = {
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+      .pNext = &pool_inline_info,
+      .maxSets = NUM_SETS_PER_CASE,
+      .poolSizeCount = ARRAY_SIZE(pool_sizes),
+      .pPoolSizes = pool_sizes,
+   };
+   CHECK(GET_DEVICE_PROC(device, CreateDescriptorPool)(device, &pool_info, NULL, &pool));
+
+   /* Update data, different for every element */
+   static struct update_data data;
+   for (uint32_t i = 0; i < NUM_ELEMENTS; i++) {
+      data.elements[i] = (struct element) {
+         .buffer = { buffer, i * 64, 64 },
+         .image = { samplers[i % 2], image_views[(i / 2) % 2],
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+         .texel_buffer = texel_buffers[i % ARRAY_SIZE(texel_buffers)],
+      };
+      data.buffers[i] = (VkDescriptorBufferInfo) { buffer, 2048 + i * 64, 32 + i };
+   }
+   for (uint32_t i = 0; i < ARRAY_SIZE(data.inline_data); i++)
+      data.inline_data[i] = i * 7 + 1;
+
+   bool success = true;
+   for (uint32_t i = 0; i < ARRAY_SIZE(cases); i++)
+      success &= run_case(&cases[i], &data);
+
+   GET_DEVICE_PROC(device, DestroyDescriptorPool)(device, pool, NULL);
+   GET_DEVICE_PROC(device, DestroyDescriptorSetLayout)(device, layout, NULL);
+   for (uint32_t i = 0; i < ARRAY_SIZE(texel_buffers); i++)
+      GET_DEVICE_PROC(device, DestroyBufferView)(device, texel_buffers[i], NULL);
+   for (uint32_t i = 0; i < 2; i++) {
+      GET_DEVICE_PROC(device, DestroyImageView)(device, image_views[i], NULL);
+      GET_DEVICE_PROC(device, DestroySampler)(device, samplers[i], NULL);
+   }
+   GET_DEVICE_PROC(device, DestroyImage)(device, image, NULL);
+   GET_DEVICE_PROC(device, DestroyBuffer)(device, buffer, NULL);
+   GET_DEVICE_PROC(device, FreeMemory)(device, memory, NULL);
+   GET_DEVICE_PROC(device, DestroyDevice)(device, NULL);
+   GET_INSTANCE_PROC(DestroyInstance)(instance, NULL);
+
+   return success ? 0 : 1;
+}
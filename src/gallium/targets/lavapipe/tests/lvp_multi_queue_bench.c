@@ -0,0 +1,234 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Measures submit throughput across lavapipe queues.  Every thread owns a
+ * queue, a command buffer that fills a buffer of its own and writes a
+ * timestamp into a query pool shared by all threads, and submits it over
+ * and over.  Fill bandwidth is reported for 1 up to all queues; the
+ * rasterizer threads are shared by the screen, so this shows how much the
+ * per-queue contexts overlap rather than a linear speedup.  The timestamps
+ * are read back on the host at the end, from queries created on different
+ * queues.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vulkan/vulkan_core.h>
+
+#include "c11/threads.h"
+#include "util/macros.h"
+#include "util/os_time.h"
+
+#define BUFFER_SIZE (16 * 1024 * 1024)
+#define NUM_SUBMITS 64
+#define MAX_QUEUES 16
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL
+vk_icdGetInstanceProcAddr(VkInstance instance, const char *pName);
+
+static PFN_vkGetDeviceProcAddr get_device_proc_addr;
+
+#define CHECK(expr) do {                                             \
+      VkResult _result = (expr);                                     \
+      if (_result != VK_SUCCESS) {                                   \
+         fprintf(stderr, "%s failed: %d\n", #expr, _result);          \
+         exit(1);                                                    \
+      }                                                              \
+   } while (0)
+
+#define GET_DEVICE_PROC(device, name) \
+   ((PFN_vk##name)get_device_proc_addr(device, "vk" #name))
+
+struct queue_data {
+   VkDevice device;
+   VkQueue queue;
+   VkCommandPool cmd_pool;
+   VkCommandBuffer cmd;
+   VkBuffer buffer;
+   VkDeviceMemory memory;
+};
+
+static void
+init_queue(struct queue_data *q, VkDevice device, uint32_t index,
+           VkQueryPool query_pool)
+{
+   q->device = device;
+   GET_DEVICE_PROC(device, GetDeviceQueue)(device, 0, index, &q->queue);
+
+   const VkBufferCreateInfo buffer_info = {
+      .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+      .size = BUFFER_SIZE,
+      .usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+   };
+   CHECK(GET_DEVICE_PROC(device, CreateBuffer)(device, &buffer_info, NULL, &q->buffer));
+
+   const VkMemoryAllocateInfo memory_info = {
+      .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+      .allocationSize = BUFFER_SIZE,
+   };
+   CHECK(GET_DEVICE_PROC(device, AllocateMemory)(device, &memory_info, NULL, &q->memory));
+   CHECK(GET_DEVICE_PROC(device, BindBufferMemory)(device, q->buffer, q->memory, 0));
+
+   const VkCommandPoolCreateInfo pool_info = {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+   };
+   CHECK(GET_DEVICE_PROC(device, CreateCommandPool)(device, &pool_info, NULL, &q->cmd_pool));
+
+   const VkCommandBufferAllocateInfo cmd_info = {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+      .commandPool = q->cmd_pool,
+      .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+      .commandBufferCount = 1,
+   };
+   CHECK(GET_DEVICE_PROC(device, AllocateCommandBuffers)(device, &cmd_info, &q->cmd));
+
+   const VkCommandBufferBeginInfo begin_info = {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+   };
+   CHECK(GET_DEVICE_PROC(device, BeginCommandBuffer)(q->cmd, &begin_info));
+   GET_DEVICE_PROC(device, CmdResetQueryPool)(q->cmd, query_pool, index, 1);
+   GET_DEVICE_PROC(device, CmdFillBuffer)(q->cmd, q->buffer, 0, VK_WHOLE_SIZE, index);
+   GET_DEVICE_PROC(device, CmdWriteTimestamp)(q->cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                              query_pool, index);
+   CHECK(GET_DEVICE_PROC(device, EndCommandBuffer)(q->cmd));
+}
+
+static void
+finish_queue(struct queue_data *q)
+{
+   GET_DEVICE_PROC(q->device, DestroyCommandPool)(q->device, q->cmd_pool, NULL);
+   GET_DEVICE_PROC(q->device, FreeMemory)(q->device, q->memory, NULL);
+   GET_DEVICE_PROC(q->device, DestroyBuffer)(q->device, q->buffer, NULL);
+}
+
+static int
+submit_thread(void *_data)
+{
+   struct queue_data *q = _data;
+   PFN_vkQueueSubmit queue_submit = GET_DEVICE_PROC(q->device, QueueSubmit);
+
+   const VkSubmitInfo submit = {
+      .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+      .commandBufferCount = 1,
+      .pCommandBuffers = &q->cmd,
+   };
+   for (unsigned i = 0; i < NUM_SUBMITS; i++) {
+      CHECK(queue_submit(q->queue, 1, &submit, VK_NULL_HANDLE));
+      CHECK(GET_DEVICE_PROC(q->device, QueueWaitIdle)(q->queue));
+   }
+
+   return 0;
+}
+
+static void
+run_queues(struct queue_data *queues, unsigned num_queues)
+{
+   thrd_t threads[MAX_QUEUES];
+
+   int64_t start = os_time_get_nano();
+   for (unsigned t = 0; t < num_queues; t++)
+      thrd_create(&threads[t], submit_thread, &queues[t]);
+   for (unsigned t = 0; t < num_queues; t++)
+      thrd_join(threads[t], NULL);
+   int64_t end = os_time_get_nano();
+
+   const double bytes = (double)BUFFER_SIZE * NUM_SUBMITS * num_queues;
+   const double ns = (double)MAX2(end - start, 1);
+
+   printf("%2u queues: %8.2f GB/s filled  %8.2f us/submit\n",
+          num_queues, bytes / ns, ns * 1e-3 / (NUM_SUBMITS * num_queues));
+}
+
+int
+main(int argc, char **argv)
+{
+   PFN_vkCreateInstance create_instance =
+      (PFN_vkCreateInstance)vk_icdGetInstanceProcAddr(NULL, "vkCreateInstance");
+
+   const VkApplicationInfo app = {
+      .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+      .apiVersion = VK_API_VERSION_1_3,
+   };
+   const VkInstanceCreateInfo instance_info = {
+      .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+      .pApplicationInfo = &app,
+   };
+   VkInstance instance;
+   CHECK(create_instance(&instance_info, NULL, &instance));
+
+#define GET_INSTANCE_PROC(name) \
+   ((PFN_vk##name)vk_icdGetInstanceProcAddr(instance, "vk" #name))
+
+   uint32_t pdev_count = 1;
+   VkPhysicalDevice pdev;
+   CHECK(GET_INSTANCE_PROC(EnumeratePhysicalDevices)(instance, &pdev_count, &pdev));
+
+   uint32_t family_count = 1;
+   VkQueueFamilyProperties family;
+   GET_INSTANCE_PROC(GetPhysicalDeviceQueueFamilyProperties)(pdev, &family_count, &family);
+   const unsigned max_queues = MIN2(family.queueCount, MAX_QUEUES);
+
+   float priorities[MAX_QUEUES];
+   for (unsigned i = 0; i < max_queues; i++)
+      priorities[i] = 1.0f;
+
+   const VkDeviceQueueCreateInfo queue_info = {
+      .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+      .queueCount = max_queues,
+      .pQueuePriorities = priorities,
+   };
+   const VkDeviceCreateInfo device_info = {
+      .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+      .queueCreateInfoCount = 1,
+      .pQueueCreateInfos = &queue_info,
+   };
+   VkDevice device;
+   CHECK(GET_INSTANCE_PROC(CreateDevice)(pdev, &device_info, NULL, &device));
+
+   get_device_proc_addr = GET_INSTANCE_PROC(GetDeviceProcAddr);
+
+   const VkQueryPoolCreateInfo query_info = {
+      .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+      .queryType = VK_QUERY_TYPE_TIMESTAMP,
+      .queryCount = max_queues,
+   };
+   VkQueryPool query_pool;
+   CHECK(GET_DEVICE_PROC(device, CreateQueryPool)(device, &query_info, NULL, &query_pool));
+
+   struct queue_data queues[MAX_QUEUES];
+   for (unsigned i = 0; i < max_queues; i++)
+      init_queue(&queues[i], device, i, query_pool);
+
+   /* 1, 2, 4, ... queues, always finishing with max_queues */
+   for (unsigned n = 1;; n = MIN2(n * 2, max_queues)) {
+      run_queues(queues, n);
+      if (n == max_queues)
+         break;
+   }
+
+   uint64_t timestamps[MAX_QUEUES];
+   CHECK(GET_DEVICE_PROC(device, GetQueryPoolResults)(device, query_pool, 0, max_queues,
+                                                      sizeof(timestamps), timestamps,
+                                                      sizeof(uint64_t),
+                                                      VK_QUERY_RESULT_64_BIT |
+                                                      VK_QUERY_RESULT_WAIT_BIT));
+
+   bool success = true;
+   for (unsigned i = 0; i < max_queues; i++) {
+      if (timestamps[i] == 0) {
+         fprintf(stderr, "no timestamp written by queue %u\n", i);
+         success = false;
+      }
+      finish_queue(&queues[i]);
+   }
+
+   GET_DEVICE_PROC(device, DestroyQueryPool)(device, query_pool, NULL);
+   GET_DEVICE_PROC(device, DestroyDevice)(device, NULL);
+   GET_INSTANCE_PROC(DestroyInstance)(instance, NULL);
+
+   return success ? 0 : 1;
+}
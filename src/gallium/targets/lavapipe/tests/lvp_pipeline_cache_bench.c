@@ -0,0 +1,228 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Multi-threaded lookup stress for the common pipeline cache on a lavapipe
+ * device.  Half of the keys are added up front; each thread then looks up
+ * random keys and adds the ones it misses, the way concurrent pipeline
+ * creation does.  Lookup throughput and the cache statistics are reported
+ * for 1, 2, 4, ... threads, and every object returned is checked against
+ * the key it was looked up with.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vulkan/vulkan_core.h>
+
+#include "vk_device.h"
+#include "vk_pipeline_cache.h"
+
+#include "c11/threads.h"
+#include "util/macros.h"
+#include "util/os_time.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_math.h"
+
+#define NUM_KEYS 4096
+#define NUM_LOOKUPS 200000
+#define MAX_THREADS 64
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL
+vk_icdGetInstanceProcAddr(VkInstance instance, const char *pName);
+
+#define CHECK(expr) do {                                             \
+      VkResult _result = (expr);                                     \
+      if (_result != VK_SUCCESS) {                                   \
+         fprintf(stderr, "%s failed: %d\n", #expr, _result);          \
+         exit(1);                                                    \
+      }                                                              \
+   } while (0)
+
+struct cache_key {
+   uint32_t index;
+   uint32_t pad[7];
+};
+
+struct thread_data {
+   struct vk_pipeline_cache *cache;
+   uint32_t seed;
+   unsigned failures;
+};
+
+static void
+make_key(struct cache_key *key, uint32_t index)
+{
+   memset(key, 0, sizeof(*key));
+   key->index = index;
+}
+
+static bool
+add_key(struct vk_pipeline_cache *cache, uint32_t index)
+{
+   struct cache_key key;
+   make_key(&key, index);
+
+   struct vk_raw_data_cache_object *data =
+      vk_raw_data_cache_object_create(cache->base.device, &key, sizeof(key),
+                                      &index, sizeof(index));
+   if (data == NULL)
+      return false;
+
+   struct vk_pipeline_cache_object *object =
+      vk_pipeline_cache_add_object(cache, &data->base);
+   vk_pipeline_cache_object_unref(cache->base.device, object);
+   return true;
+}
+
+static int
+lookup_thread(void *_data)
+{
+   struct thread_data *data = _data;
+   struct vk_pipeline_cache *cache = data->cache;
+   uint32_t seed = data->seed;
+
+   for (unsigned i = 0; i < NUM_LOOKUPS; i++) {
+      /* xorshift32 */
+      seed ^= seed << 13;
+      seed ^= seed >> 17;
+      seed ^= seed << 5;
+
+      struct cache_key key;
+      make_key(&key, seed % NUM_KEYS);
+
+      struct vk_pipeline_cache_object *object =
+         vk_pipeline_cache_lookup_object(cache, &key, sizeof(key),
+                                         &vk_raw_data_cache_object_ops,
+                                         NULL);
+      if (object == NULL) {
+         if (!add_key(cache, key.index))
+            data->failures++;
+         continue;
+      }
+
+      struct vk_raw_data_cache_object *raw =
+         container_of(object, struct vk_raw_data_cache_object, base);
+      if (raw->data_size != sizeof(uint32_t) ||
+          *(const uint32_t *)raw->data != key.index)
+         data->failures++;
+
+      vk_pipeline_cache_object_unref(cache->base.device, object);
+   }
+
+   return 0;
+}
+
+static bool
+run_threads(struct vk_device *device, unsigned num_threads)
+{
+   const struct vk_pipeline_cache_create_info info = {
+      .force_enable = true,
+      .skip_disk_cache = true,
+   };
+   struct vk_pipeline_cache *cache =
+      vk_pipeline_cache_create(device, &info, NULL);
+   if (cache == NULL)
+      return false;
+
+   for (uint32_t i = 0; i < NUM_KEYS; i += 2) {
+      if (!add_key(cache, i)) {
+         vk_pipeline_cache_destroy(cache, NULL);
+         return false;
+      }
+   }
+
+   struct thread_data data[MAX_THREADS];
+   thrd_t threads[MAX_THREADS];
+
+   int64_t start = os_time_get_nano();
+   for (unsigned t = 0; t < num_threads; t++) {
+      data[t] = (struct thread_data) {
+         .cache = cache,
+         .seed = 0x9e3779b9 * (t + 1),
+      };
+      thrd_create(&threads[t], lookup_thread, &data[t]);
+   }
+
+   unsigned failures = 0;
+   for (unsigned t = 0; t < num_threads; t++) {
+      thrd_join(threads[t], NULL);
+      failures += data[t].failures;
+   }
+   int64_t end = os_time_get_nano();
+
+   struct vk_pipeline_cache_stats stats;
+   vk_pipeline_cache_get_stats(cache, &stats);
+
+   double total = (double)NUM_LOOKUPS * num_threads;
+   printf("%2u threads: %8.2f M lookups/s  %5.1f%% hits  %8" PRIu64
+          " inserts  %5.2f%% contended\n",
+          num_threads, total * 1e3 / MAX2(end - start, 1),
+          100.0 * stats.hits / MAX2(stats.lookups, 1), stats.inserts,
+          100.0 * stats.contended / MAX2(stats.lookups + stats.inserts, 1));
+
+   vk_pipeline_cache_destroy(cache, NULL);
+
+   if (failures)
+      fprintf(stderr, "%u lookups returned a wrong or no object\n", failures);
+   return failures == 0;
+}
+
+int
+main(int argc, char **argv)
+{
+   PFN_vkCreateInstance create_instance =
+      (PFN_vkCreateInstance)vk_icdGetInstanceProcAddr(NULL, "vkCreateInstance");
+
+   const VkApplicationInfo app = {
+      .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+      .apiVersion = VK_API_VERSION_1_3,
+   };
+   const VkInstanceCreateInfo instance_info = {
+      .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+      .pApplicationInfo = &app,
+   };
+   VkInstance instance;
+   CHECK(create_instance(&instance_info, NULL, &instance));
+
+#define GET_INSTANCE_PROC(name) \
+   ((PFN_vk##name)vk_icdGetInstanceProcAddr(instance, "vk" #name))
+
+   uint32_t pdev_count = 1;
+   VkPhysicalDevice pdev;
+   CHECK(GET_INSTANCE_PROC(EnumeratePhysicalDevices)(instance, &pdev_count, &pdev));
+
+   const float priority = 1.0f;
+   const VkDeviceQueueCreateInfo queue_info = {
+      .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+      .queueCount = 1,
+      .pQueuePriorities = &priority,
+   };
+   const VkDeviceCreateInfo device_info = {
+      .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+      .queueCreateInfoCount = 1,
+      .pQueueCreateInfos = &queue_info,
+   };
+   VkDevice _device;
+   CHECK(GET_INSTANCE_PROC(CreateDevice)(pdev, &device_info, NULL, &_device));
+   VK_FROM_HANDLE(vk_device, device, _device);
+
+   unsigned max_threads =
+      CLAMP(util_get_cpu_caps()->nr_cpus, 1, MAX_THREADS);
+   bool success = true;
+
+   /* 1, 2, 4, ... threads, always finishing with max_threads */
+   for (unsigned n = 1;; n = MIN2(n * 2, max_threads)) {
+      success &= run_threads(device, n);
+      if (n == max_threads)
+         break;
+   }
+
+   GET_INSTANCE_PROC(DestroyDevice)(_device, NULL);
+   GET_INSTANCE_PROC(DestroyInstance)(instance, NULL);
+
+   return success ? 0 : 1;
+}
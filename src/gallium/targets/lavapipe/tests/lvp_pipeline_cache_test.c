@@ -0,0 +1,232 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Round trip of lavapipe pipeline cache contents through the API, and the
+ * pipeline creation time it saves.  A compute pipeline is created with an
+ * empty cache (cold), again with that cache (warm), with a cache created
+ * from its vkGetPipelineCacheData blob (warm startup) and with a cache the
+ * blob was merged into.  All but the first must be reported as application
+ * cache hits, and a blob with a foreign UUID must be ignored.  The best
+ * creation time of each case is printed.
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vulkan/vulkan_core.h>
+
+#include "util/macros.h"
+#include "util/os_time.h"
+
+#define NUM_RUNS 16
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL
+vk_icdGetInstanceProcAddr(VkInstance instance, const char *pName);
+
+#define CHECK(expr) do {                                             \
+      VkResult _result = (expr);                                     \
+      if (_result != VK_SUCCESS) {                                   \
+         fprintf(stderr, "%s failed: %d\n", #expr, _result);          \
+         exit(1);                                                    \
+      }                                                              \
+   } while (0)
+
+/* void main() {} with a 1x1x1 workgroup */
+static const uint32_t spirv[] = {
+   0x07230203, 0x00010000, 0x00000000, 5, 0,
+   (2 << 16) | 17, 1,                         /* OpCapability Shader */
+   (3 << 16) | 14, 0, 1,                      /* OpMemoryModel Logical GLSL450 */
+   (5 << 16) | 15, 5, 1, 0x6e69616d, 0,       /* OpEntryPoint GLCompute %1 "main" */
+   (6 << 16) | 16, 1, 17, 1, 1, 1,            /* OpExecutionMode %1 LocalSize 1 1 1 */
+   (2 << 16) | 19, 2,                         /* %2 = OpTypeVoid */
+   (3 << 16) | 33, 3, 2,                      /* %3 = OpTypeFunction %2 */
+   (5 << 16) | 54, 2, 1, 0, 3,                /* %1 = OpFunction %2 None %3 */
+   (2 << 16) | 248, 4,                        /* %4 = OpLabel */
+   (1 << 16) | 253,                           /* OpReturn */
+   (1 << 16) | 56,                            /* OpFunctionEnd */
+};
+
+static VkInstance instance;
+static VkDevice device;
+static VkPipelineLayout layout;
+
+#define GET_PROC(name) \
+   ((PFN_vk##name)vk_icdGetInstanceProcAddr(instance, "vk" #name))
+
+static VkPipelineCache
+create_cache(const void *data, size_t size)
+{
+   const VkPipelineCacheCreateInfo info = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+      .initialDataSize = size,
+      .pInitialData = data,
+   };
+   VkPipelineCache cache;
+   CHECK(GET_PROC(CreatePipelineCache)(device, &info, NULL, &cache));
+   return cache;
+}
+
+/*
+ * Creates and destroys the pipeline, returning whether it was found in the
+ * cache and how long creation took.
+ */
+static bool
+create_pipeline(VkPipelineCache cache, double *ms)
+{
+   const VkShaderModuleCreateInfo module_info = {
+      .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+      .codeSize = sizeof(spirv),
+      .pCode = spirv,
+   };
+   VkPipelineCreationFeedback pipeline_feedback = { 0 };
+   VkPipelineCreationFeedback stage_feedback = { 0 };
+   const VkPipelineCreationFeedbackCreateInfo feedback_info = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO,
+      .pPipelineCreationFeedback = &pipeline_feedback,
+      .pipelineStageCreationFeedbackCount = 1,
+      .pPipelineStageCreationFeedbacks = &stage_feedback,
+   };
+   const VkComputePipelineCreateInfo info = {
+      .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+      .pNext = &feedback_info,
+      .stage = {
+         .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+         .pNext = &module_info,
+         .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+         .pName = "main",
+      },
+      .layout = layout,
+   };
+   VkPipeline pipeline;
+
+   int64_t start = os_time_get_nano();
+   CHECK(GET_PROC(CreateComputePipelines)(device, cache, 1, &info, NULL,
+                                          &pipeline));
+   *ms = (os_time_get_nano() - start) * 1e-6;
+
+   GET_PROC(DestroyPipeline)(device, pipeline, NULL);
+
+   return pipeline_feedback.flags &
+          VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT;
+}
+
+static void *
+get_cache_data(VkPipelineCache cache, size_t *size)
+{
+   CHECK(GET_PROC(GetPipelineCacheData)(device, cache, size, NULL));
+   void *data = malloc(*size);
+   if (data == NULL)
+      exit(1);
+   CHECK(GET_PROC(GetPipelineCacheData)(device, cache, size, data));
+   return data;
+}
+
+static bool
+report(const char *name, bool hit, bool expect_hit, double ms)
+{
+   const bool success = hit == expect_hit;
+   printf("%s: %-14s %-4s %8.3f ms\n", success ? "PASS" : "FAIL", name,
+          hit ? "hit" : "miss", ms);
+   return success;
+}
+
+int
+main(int argc, char **argv)
+{
+   /* Only the application caches are under test */
+   setenv("MESA_SHADER_CACHE_DISABLE", "true", 1);
+
+   PFN_vkCreateInstance create_instance =
+      (PFN_vkCreateInstance)vk_icdGetInstanceProcAddr(NULL, "vkCreateInstance");
+
+   const VkApplicationInfo app = {
+      .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+      .apiVersion = VK_API_VERSION_1_3,
+   };
+   const VkInstanceCreateInfo instance_info = {
+      .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+      .pApplicationInfo = &app,
+   };
+   CHECK(create_instance(&instance_info, NULL, &instance));
+
+   uint32_t pdev_count = 1;
+   VkPhysicalDevice pdev;
+   CHECK(GET_PROC(EnumeratePhysicalDevices)(instance, &pdev_count, &pdev));
+
+   const float priority = 1.0f;
+   const VkDeviceQueueCreateInfo queue_info = {
+      .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+      .queueCount = 1,
+      .pQueuePriorities = &priority,
+   };
+   const VkDeviceCreateInfo device_info = {
+      .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+      .queueCreateInfoCount = 1,
+      .pQueueCreateInfos = &queue_info,
+   };
+   CHECK(GET_PROC(CreateDevice)(pdev, &device_info, NULL, &device));
+
+   const VkPipelineLayoutCreateInfo layout_info = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+   };
+   CHECK(GET_PROC(CreatePipelineLayout)(device, &layout_info, NULL, &layout));
+
+   double cold_ms = 1e9, warm_ms = 1e9, loaded_ms = 1e9, merged_ms = 1e9;
+   double foreign_ms = 1e9, ms;
+   bool cold_hit = false, warm_hit = true, loaded_hit = true;
+   bool merged_hit = true, foreign_hit = false;
+
+   for (unsigned i = 0; i < NUM_RUNS; i++) {
+      VkPipelineCache cache = create_cache(NULL, 0);
+      cold_hit |= create_pipeline(cache, &ms);
+      cold_ms = MIN2(cold_ms, ms);
+      warm_hit &= create_pipeline(cache, &ms);
+      warm_ms = MIN2(warm_ms, ms);
+
+      size_t size;
+      uint8_t *data = get_cache_data(cache, &size);
+      GET_PROC(DestroyPipelineCache)(device, cache, NULL);
+
+      /* What an application does on its next start */
+      VkPipelineCache loaded = create_cache(data, size);
+      loaded_hit &= create_pipeline(loaded, &ms);
+      loaded_ms = MIN2(loaded_ms, ms);
+
+      VkPipelineCache merged = create_cache(NULL, 0);
+      CHECK(GET_PROC(MergePipelineCaches)(device, merged, 1, &loaded));
+      merged_hit &= create_pipeline(merged, &ms);
+      merged_ms = MIN2(merged_ms, ms);
+
+      GET_PROC(DestroyPipelineCache)(device, merged, NULL);
+      GET_PROC(DestroyPipelineCache)(device, loaded, NULL);
+
+      /* Data from another build must be dropped */
+      if (size >= sizeof(VkPipelineCacheHeaderVersionOne)) {
+         data[offsetof(VkPipelineCacheHeaderVersionOne, pipelineCacheUUID)] ^= 0xff;
+         VkPipelineCache foreign = create_cache(data, size);
+         foreign_hit |= create_pipeline(foreign, &ms);
+         foreign_ms = MIN2(foreign_ms, ms);
+         GET_PROC(DestroyPipelineCache)(device, foreign, NULL);
+      }
+
+      free(data);
+   }
+
+   bool success = true;
+   success &= report("cold", cold_hit, false, cold_ms);
+   success &= report("warm", warm_hit, true, warm_ms);
+   success &= report("loaded", loaded_hit, true, loaded_ms);
+   success &= report("merged", merged_hit, true, merged_ms);
+   success &= report("foreign_uuid", foreign_hit, false, foreign_ms);
+
+   GET_PROC(DestroyPipelineLayout)(device, layout, NULL);
+   GET_PROC(DestroyDevice)(device, NULL);
+   GET_PROC(DestroyInstance)(instance, NULL);
+
+   return success ? 0 : 1;
+}
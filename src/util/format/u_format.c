@@ -34,6 +34,7 @@
 
 #include "c11/threads.h"
 #include "util/detect_arch.h"
+#include "util/detect_cc.h"
 #include "util/format/u_format.h"
 #include "util/format/u_format_s3tc.h"
 #include "util/u_math.h"
@@ -1136,6 +1137,7 @@ util_format_rgb_to_bgr(enum pipe_format format)
 }
 
 static const struct util_format_unpack_description *util_format_unpack_table[PIPE_FORMAT_COUNT];
+static const struct util_format_pack_description *util_format_pack_table[PIPE_FORMAT_COUNT];
 
 static void
 util_format_unpack_table_init(void)
@@ -1149,6 +1151,16 @@ util_format_unpack_table_init(void)
       }
 #endif
 
+#if DETECT_ARCH_X86_64 && DETECT_CC_GCC && !defined(NO_FORMAT_ASM)
+      const struct util_format_unpack_description *unpack = util_format_unpack_description_avx512(format);
+      if (!unpack)
+         unpack = util_format_unpack_description_avx2(format);
+      if (unpack) {
+         util_format_unpack_table[format] = unpack;
+         continue;
+      }
+#endif
+
       util_format_unpack_table[format] = util_format_unpack_description_generic(format);
    }
 }
@@ -1162,6 +1174,33 @@ util_format_unpack_description(enum pipe_format format)
    return util_format_unpack_table[format];
 }
 
+static void
+util_format_pack_table_init(void)
+{
+   for (enum pipe_format format = PIPE_FORMAT_NONE; format < PIPE_FORMAT_COUNT; format++) {
+#if DETECT_ARCH_X86_64 && DETECT_CC_GCC && !defined(NO_FORMAT_ASM)
+      const struct util_format_pack_description *pack = util_format_pack_description_avx512(format);
+      if (!pack)
+         pack = util_format_pack_description_avx2(format);
+      if (pack) {
+         util_format_pack_table[format] = pack;
+         continue;
+      }
+#endif
+
+      util_format_pack_table[format] = util_format_pack_description_generic(format);
+   }
+}
+
+const struct util_format_pack_description *
+util_format_pack_description(enum pipe_format format)
+{
+   static once_flag flag = ONCE_FLAG_INIT;
+   call_once(&flag, util_format_pack_table_init);
+
+   return util_format_pack_table[format];
+}
+
 enum pipe_format
 util_format_rgbx_to_rgba(enum pipe_format format)
 {
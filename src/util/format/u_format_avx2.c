@@ -0,0 +1,141 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "util/detect_arch.h"
+#include "util/detect_cc.h"
+#include "util/format/u_format.h"
+
+/* The float16 kernels must match _mesa_half_to_float() and
+ * _mesa_float_to_float16_rtz(), which only use F16C on x86-64 GCC/clang.
+ */
+#if DETECT_ARCH_X86_64 && DETECT_CC_GCC && !defined(NO_FORMAT_ASM)
+
+#include <immintrin.h>
+#include "u_format_pack.h"
+#include "util/u_cpu_detect.h"
+
+typedef __m256 vecf;
+typedef __m256i veci;
+
+#define VEC_PIXELS 2
+#define VEC_BYTES 32
+#define VEC_SUPPORTED(caps) ((caps)->has_avx2 && (caps)->has_f16c)
+#define TAG(x) x##_avx2
+
+#define vec_setzero_ps() _mm256_setzero_ps()
+#define vec_setzero_si() _mm256_setzero_si256()
+#define vec_set1_ps(x) _mm256_set1_ps(x)
+#define vec_set1_epi32(x) _mm256_set1_epi32(x)
+#define vec_setr4_ps(a, b, c, d) _mm256_setr_ps(a, b, c, d, a, b, c, d)
+#define vec_setr4_epi32(a, b, c, d) _mm256_setr_epi32(a, b, c, d, a, b, c, d)
+#define vec_bcast128(x) _mm256_broadcastsi128_si256(x)
+#define vec_loadu_ps(p) _mm256_loadu_ps(p)
+#define vec_storeu_ps(p, v) _mm256_storeu_ps(p, v)
+#define vec_loadu_si(p) _mm256_loadu_si256((const __m256i *)(p))
+#define vec_storeu_si(p, v) _mm256_storeu_si256((__m256i *)(p), v)
+
+#define vec_add_ps(a, b) _mm256_add_ps(a, b)
+#define vec_mul_ps(a, b) _mm256_mul_ps(a, b)
+#define vec_min_ps(a, b) _mm256_min_ps(a, b)
+#define vec_max_ps(a, b) _mm256_max_ps(a, b)
+#define vec_cvtepi32_ps(a) _mm256_cvtepi32_ps(a)
+#define vec_cvtps_epi32(a) _mm256_cvtps_epi32(a)
+#define vec_castps_si(a) _mm256_castps_si256(a)
+#define vec_castsi_ps(a) _mm256_castsi256_ps(a)
+#define vec_and_si(a, b) _mm256_and_si256(a, b)
+#define vec_or_si(a, b) _mm256_or_si256(a, b)
+#define vec_add_epi32(a, b) _mm256_add_epi32(a, b)
+#define vec_sub_epi32(a, b) _mm256_sub_epi32(a, b)
+#define vec_mullo_epi32(a, b) _mm256_mullo_epi32(a, b)
+#define vec_srli_epi32(a, n) _mm256_srli_epi32(a, n)
+#define vec_slli_epi32(a, n) _mm256_slli_epi32(a, n)
+#define vec_srlv_epi32(a, n) _mm256_srlv_epi32(a, n)
+#define vec_sllv_epi32(a, n) _mm256_sllv_epi32(a, n)
+#define vec_shuffle_epi32(a, imm) _mm256_shuffle_epi32(a, imm)
+#define vec_shuffle_epi8(a, ctrl) _mm256_shuffle_epi8(a, ctrl)
+#define vec_permute_ps(a, imm) _mm256_permute_ps(a, imm)
+#define vec_blend_alpha_ps(rgb, a) _mm256_blend_ps(rgb, a, 0x88)
+#define vec_blend_alpha_epi32(rgb, a) _mm256_blend_epi32(rgb, a, 0x88)
+#define vec_gather_ps(base, idx) _mm256_i32gather_ps(base, idx, 4)
+#define vec_gather_epi32(base, idx) _mm256_i32gather_epi32((const int *)(base), idx, 4)
+
+/** f > g ? a : b, per lane */
+static inline veci
+vec_sel_gt_epi32(vecf f, vecf g, veci a, veci b)
+{
+   return _mm256_blendv_epi8(b, a, _mm256_castps_si256(_mm256_cmp_ps(f, g, _CMP_GT_OQ)));
+}
+
+/** f >= g ? a : b, per lane */
+static inline veci
+vec_sel_ge_epi32(vecf f, vecf g, veci a, veci b)
+{
+   return _mm256_blendv_epi8(b, a, _mm256_castps_si256(_mm256_cmp_ps(f, g, _CMP_GE_OQ)));
+}
+
+static inline veci
+vec_load_u8(const uint8_t *src)
+{
+   return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)src));
+}
+
+static inline veci
+vec_load_u16(const uint8_t *src)
+{
+   return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)src));
+}
+
+static inline vecf
+vec_load_f16(const uint8_t *src)
+{
+   return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)src));
+}
+
+/** Load two 32-bit pixels, each repeated across its four lanes */
+static inline veci
+vec_load_u32_bcast4(const uint8_t *src)
+{
+   return _mm256_permutevar8x32_epi32(
+      _mm256_castsi128_si256(_mm_loadl_epi64((const __m128i *)src)),
+      _mm256_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1));
+}
+
+/** Store the low byte of every lane */
+static inline void
+vec_store_u8(uint8_t *dst, veci v)
+{
+   const veci ctrl = _mm256_broadcastsi128_si256(
+      _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+
+   v = _mm256_shuffle_epi8(v, ctrl);
+   v = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0));
+   _mm_storel_epi64((__m128i *)dst, _mm256_castsi256_si128(v));
+}
+
+/** Store the low 16 bits of every lane (lanes hold values <= 0xffff) */
+static inline void
+vec_store_u16(uint8_t *dst, veci v)
+{
+   v = _mm256_permute4x64_epi64(_mm256_packus_epi32(v, v), _MM_SHUFFLE(3, 1, 2, 0));
+   _mm_storeu_si128((__m128i *)dst, _mm256_castsi256_si128(v));
+}
+
+static inline void
+vec_store_f16_rtz(uint8_t *dst, vecf v)
+{
+   _mm_storeu_si128((__m128i *)dst, _mm256_cvtps_ph(v, _MM_FROUND_TO_ZERO));
+}
+
+/** Store lane 0 of every group of four lanes */
+static inline void
+vec_store_u32_lane0(uint8_t *dst, veci v)
+{
+   v = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0));
+   _mm_storel_epi64((__m128i *)dst, _mm256_castsi256_si128(v));
+}
+
+#include "u_format_x86_tmp.h"
+
+#endif /* DETECT_ARCH_X86_64 && DETECT_CC_GCC && !NO_FORMAT_ASM */
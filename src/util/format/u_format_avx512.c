@@ -0,0 +1,133 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "util/detect_arch.h"
+#include "util/detect_cc.h"
+#include "util/format/u_format.h"
+
+/* See u_format_avx2.c for why this is x86-64 GCC/clang only. */
+#if DETECT_ARCH_X86_64 && DETECT_CC_GCC && !defined(NO_FORMAT_ASM)
+
+#include <immintrin.h>
+#include "u_format_pack.h"
+#include "util/u_cpu_detect.h"
+
+typedef __m512 vecf;
+typedef __m512i veci;
+
+#define VEC_PIXELS 4
+#define VEC_BYTES 64
+#define VEC_SUPPORTED(caps) \
+   ((caps)->has_avx512f && (caps)->has_avx512bw && (caps)->has_f16c)
+#define TAG(x) x##_avx512
+
+#define vec_setzero_ps() _mm512_setzero_ps()
+#define vec_setzero_si() _mm512_setzero_si512()
+#define vec_set1_ps(x) _mm512_set1_ps(x)
+#define vec_set1_epi32(x) _mm512_set1_epi32(x)
+#define vec_setr4_ps(a, b, c, d) _mm512_setr4_ps(a, b, c, d)
+#define vec_setr4_epi32(a, b, c, d) _mm512_setr4_epi32(a, b, c, d)
+#define vec_bcast128(x) _mm512_broadcast_i32x4(x)
+#define vec_loadu_ps(p) _mm512_loadu_ps(p)
+#define vec_storeu_ps(p, v) _mm512_storeu_ps(p, v)
+#define vec_loadu_si(p) _mm512_loadu_si512(p)
+#define vec_storeu_si(p, v) _mm512_storeu_si512(p, v)
+
+#define vec_add_ps(a, b) _mm512_add_ps(a, b)
+#define vec_mul_ps(a, b) _mm512_mul_ps(a, b)
+#define vec_min_ps(a, b) _mm512_min_ps(a, b)
+#define vec_max_ps(a, b) _mm512_max_ps(a, b)
+#define vec_cvtepi32_ps(a) _mm512_cvtepi32_ps(a)
+#define vec_cvtps_epi32(a) _mm512_cvtps_epi32(a)
+#define vec_castps_si(a) _mm512_castps_si512(a)
+#define vec_castsi_ps(a) _mm512_castsi512_ps(a)
+#define vec_and_si(a, b) _mm512_and_si512(a, b)
+#define vec_or_si(a, b) _mm512_or_si512(a, b)
+#define vec_add_epi32(a, b) _mm512_add_epi32(a, b)
+#define vec_sub_epi32(a, b) _mm512_sub_epi32(a, b)
+#define vec_mullo_epi32(a, b) _mm512_mullo_epi32(a, b)
+#define vec_srli_epi32(a, n) _mm512_srli_epi32(a, n)
+#define vec_slli_epi32(a, n) _mm512_slli_epi32(a, n)
+#define vec_srlv_epi32(a, n) _mm512_srlv_epi32(a, n)
+#define vec_sllv_epi32(a, n) _mm512_sllv_epi32(a, n)
+#define vec_shuffle_epi32(a, imm) _mm512_shuffle_epi32(a, (_MM_PERM_ENUM)(imm))
+#define vec_shuffle_epi8(a, ctrl) _mm512_shuffle_epi8(a, ctrl)
+#define vec_permute_ps(a, imm) _mm512_permute_ps(a, imm)
+#define vec_blend_alpha_ps(rgb, a) _mm512_mask_blend_ps(0x8888, rgb, a)
+#define vec_blend_alpha_epi32(rgb, a) _mm512_mask_blend_epi32(0x8888, rgb, a)
+#define vec_gather_ps(base, idx) _mm512_i32gather_ps(idx, base, 4)
+#define vec_gather_epi32(base, idx) _mm512_i32gather_epi32(idx, base, 4)
+
+/** f > g ? a : b, per lane */
+static inline veci
+vec_sel_gt_epi32(vecf f, vecf g, veci a, veci b)
+{
+   return _mm512_mask_blend_epi32(_mm512_cmp_ps_mask(f, g, _CMP_GT_OQ), b, a);
+}
+
+/** f >= g ? a : b, per lane */
+static inline veci
+vec_sel_ge_epi32(vecf f, vecf g, veci a, veci b)
+{
+   return _mm512_mask_blend_epi32(_mm512_cmp_ps_mask(f, g, _CMP_GE_OQ), b, a);
+}
+
+static inline veci
+vec_load_u8(const uint8_t *src)
+{
+   return _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i *)src));
+}
+
+static inline veci
+vec_load_u16(const uint8_t *src)
+{
+   return _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i *)src));
+}
+
+static inline vecf
+vec_load_f16(const uint8_t *src)
+{
+   return _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i *)src));
+}
+
+/** Load four 32-bit pixels, each repeated across its four lanes */
+static inline veci
+vec_load_u32_bcast4(const uint8_t *src)
+{
+   return _mm512_permutexvar_epi32(
+      _mm512_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3),
+      _mm512_castsi128_si512(_mm_loadu_si128((const __m128i *)src)));
+}
+
+/** Store the low byte of every lane */
+static inline void
+vec_store_u8(uint8_t *dst, veci v)
+{
+   _mm_storeu_si128((__m128i *)dst, _mm512_cvtepi32_epi8(v));
+}
+
+/** Store the low 16 bits of every lane */
+static inline void
+vec_store_u16(uint8_t *dst, veci v)
+{
+   _mm256_storeu_si256((__m256i *)dst, _mm512_cvtepi32_epi16(v));
+}
+
+static inline void
+vec_store_f16_rtz(uint8_t *dst, vecf v)
+{
+   _mm256_storeu_si256((__m256i *)dst, _mm512_cvtps_ph(v, _MM_FROUND_TO_ZERO));
+}
+
+/** Store lane 0 of every group of four lanes */
+static inline void
+vec_store_u32_lane0(uint8_t *dst, veci v)
+{
+   _mm512_mask_compressstoreu_epi32(dst, 0x1111, v);
+}
+
+#include "u_format_x86_tmp.h"
+
+#endif /* DETECT_ARCH_X86_64 && DETECT_CC_GCC && !NO_FORMAT_ASM */
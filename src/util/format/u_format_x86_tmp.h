@@ -0,0 +1,417 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * x86 SIMD pack/unpack kernels, included by u_format_avx2.c and
+ * u_format_avx512.c after defining the vec_* operations for their vector
+ * width.  A vector holds VEC_PIXELS RGBA pixels, one channel per 32-bit
+ * lane, or VEC_BYTES bytes.
+ *
+ * The results must be bit for bit identical to the generated code in
+ * u_format_table.c, so every conversion mirrors the scalar helper it
+ * replaces (ubyte_to_float(), float_to_ubyte(), util_iround(CLAMP()), the
+ * sRGB tables and F16C rounding).  Leftover pixels at the end of a row go
+ * through the generated functions.
+ */
+
+#include "util/format_srgb.h"
+
+
+/** Swap the R and B channels of every pixel */
+#define SWAP_RB _MM_SHUFFLE(3, 0, 1, 2)
+
+
+static inline veci
+TAG(float_to_ubyte)(vecf f)
+{
+   const veci t = vec_castps_si(vec_add_ps(vec_mul_ps(f, vec_set1_ps(255.0f / 256.0f)),
+                                           vec_set1_ps(32768.0f)));
+   veci ub = vec_and_si(t, vec_set1_epi32(0xff));
+
+   ub = vec_sel_ge_epi32(f, vec_set1_ps(1.0f), vec_set1_epi32(255), ub);
+   return vec_sel_gt_epi32(f, vec_setzero_ps(), ub, vec_setzero_si());
+}
+
+
+/** util_iround(CLAMP(f, 0.0f, 1.0f) * scale), NaN maps to 0 */
+static inline veci
+TAG(float_to_unorm)(vecf f, vecf scale)
+{
+   f = vec_min_ps(vec_max_ps(f, vec_setzero_ps()), vec_set1_ps(1.0f));
+   return vec_cvtps_epi32(vec_mul_ps(f, scale));
+}
+
+
+/** util_format_linear_float_to_srgb_8unorm() */
+static inline veci
+TAG(float_to_srgb_8unorm)(vecf x)
+{
+   const veci minval = vec_set1_epi32((127 - 13) << 23);
+
+   x = vec_max_ps(x, vec_castsi_ps(minval));
+   x = vec_min_ps(x, vec_castsi_ps(vec_set1_epi32(0x3f7fffff)));
+
+   const veci f = vec_castps_si(x);
+   const veci tab =
+      vec_gather_epi32(util_format_linear_to_srgb_helper_table,
+                       vec_srli_epi32(vec_sub_epi32(f, minval), 20));
+   const veci bias = vec_slli_epi32(vec_srli_epi32(tab, 16), 9);
+   const veci scale = vec_and_si(tab, vec_set1_epi32(0xffff));
+   const veci t = vec_and_si(vec_srli_epi32(f, 12), vec_set1_epi32(0xff));
+
+   return vec_srli_epi32(vec_add_epi32(bias, vec_mullo_epi32(scale, t)), 16);
+}
+
+
+/*
+ * Row helpers.  They return the number of pixels converted, which is a
+ * multiple of VEC_PIXELS.
+ */
+
+static inline unsigned
+TAG(unpack_8unorm_float)(float *dst, const uint8_t *src, unsigned width,
+                         bool swap)
+{
+   const vecf scale = vec_set1_ps(1.0f / 255.0f);
+   unsigned x;
+
+   for (x = 0; x + VEC_PIXELS <= width; x += VEC_PIXELS) {
+      vecf f = vec_mul_ps(vec_cvtepi32_ps(vec_load_u8(src + x * 4)), scale);
+      if (swap)
+         f = vec_permute_ps(f, SWAP_RB);
+      vec_storeu_ps(dst + x * 4, f);
+   }
+   return x;
+}
+
+
+static inline unsigned
+TAG(unpack_srgb8_float)(float *dst, const uint8_t *src, unsigned width,
+                        bool swap)
+{
+   const vecf scale = vec_set1_ps(1.0f / 255.0f);
+   unsigned x;
+
+   for (x = 0; x + VEC_PIXELS <= width; x += VEC_PIXELS) {
+      veci ub = vec_load_u8(src + x * 4);
+      if (swap)
+         ub = vec_shuffle_epi32(ub, SWAP_RB);
+      const vecf rgb =
+         vec_gather_ps(util_format_srgb_8unorm_to_linear_float_table, ub);
+      const vecf a = vec_mul_ps(vec_cvtepi32_ps(ub), scale);
+      vec_storeu_ps(dst + x * 4, vec_blend_alpha_ps(rgb, a));
+   }
+   return x;
+}
+
+
+static inline unsigned
+TAG(unpack_16unorm_float)(float *dst, const uint8_t *src, unsigned width)
+{
+   const vecf scale = vec_set1_ps(1.0f / 0xffff);
+   unsigned x;
+
+   for (x = 0; x + VEC_PIXELS <= width; x += VEC_PIXELS) {
+      vec_storeu_ps(dst + x * 4,
+                    vec_mul_ps(vec_cvtepi32_ps(vec_load_u16(src + x * 8)),
+                               scale));
+   }
+   return x;
+}
+
+
+static inline unsigned
+TAG(unpack_16float_float)(float *dst, const uint8_t *src, unsigned width)
+{
+   unsigned x;
+
+   for (x = 0; x + VEC_PIXELS <= width; x += VEC_PIXELS)
+      vec_storeu_ps(dst + x * 4, vec_load_f16(src + x * 8));
+   return x;
+}
+
+
+static inline unsigned
+TAG(unpack_10_10_10_2_float)(float *dst, const uint8_t *src, unsigned width,
+                             bool swap)
+{
+   const veci shift = vec_setr4_epi32(0, 10, 20, 30);
+   const veci mask = vec_setr4_epi32(0x3ff, 0x3ff, 0x3ff, 0x3);
+   const vecf scale = vec_setr4_ps(1.0f / 0x3ff, 1.0f / 0x3ff,
+                                   1.0f / 0x3ff, 1.0f / 0x3);
+   unsigned x;
+
+   for (x = 0; x + VEC_PIXELS <= width; x += VEC_PIXELS) {
+      const veci v = vec_and_si(vec_srlv_epi32(vec_load_u32_bcast4(src + x * 4),
+                                               shift), mask);
+      vecf f = vec_mul_ps(vec_cvtepi32_ps(v), scale);
+      if (swap)
+         f = vec_permute_ps(f, SWAP_RB);
+      vec_storeu_ps(dst + x * 4, f);
+   }
+   return x;
+}
+
+
+/** Swap bytes 0 and 2 of every 32-bit pixel, for both pack and unpack */
+static inline unsigned
+TAG(swap_rb_8unorm)(uint8_t *dst, const uint8_t *src, unsigned width)
+{
+   const veci ctrl = vec_bcast128(_mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7,
+                                                10, 9, 8, 11, 14, 13, 12, 15));
+   const unsigned pixels = VEC_BYTES / 4;
+   unsigned x;
+
+   for (x = 0; x + pixels <= width; x += pixels)
+      vec_storeu_si(dst + x * 4, vec_shuffle_epi8(vec_loadu_si(src + x * 4), ctrl));
+   return x;
+}
+
+
+static inline unsigned
+TAG(pack_float_8unorm)(uint8_t *dst, const float *src, unsigned width,
+                       bool swap)
+{
+   unsigned x;
+
+   for (x = 0; x + VEC_PIXELS <= width; x += VEC_PIXELS) {
+      vecf f = vec_loadu_ps(src + x * 4);
+      if (swap)
+         f = vec_permute_ps(f, SWAP_RB);
+      vec_store_u8(dst + x * 4, TAG(float_to_ubyte)(f));
+   }
+   return x;
+}
+
+
+static inline unsigned
+TAG(pack_float_srgb8)(uint8_t *dst, const float *src, unsigned width,
+                      bool swap)
+{
+   unsigned x;
+
+   for (x = 0; x + VEC_PIXELS <= width; x += VEC_PIXELS) {
+      vecf f = vec_loadu_ps(src + x * 4);
+      if (swap)
+         f = vec_permute_ps(f, SWAP_RB);
+      vec_store_u8(dst + x * 4,
+                   vec_blend_alpha_epi32(TAG(float_to_srgb_8unorm)(f),
+                                         TAG(float_to_ubyte)(f)));
+   }
+   return x;
+}
+
+
+static inline unsigned
+TAG(pack_float_16unorm)(uint8_t *dst, const float *src, unsigned width)
+{
+   const vecf scale = vec_set1_ps(0xffff);
+   unsigned x;
+
+   for (x = 0; x + VEC_PIXELS <= width; x += VEC_PIXELS) {
+      vec_store_u16(dst + x * 8,
+                    TAG(float_to_unorm)(vec_loadu_ps(src + x * 4), scale));
+   }
+   return x;
+}
+
+
+static inline unsigned
+TAG(pack_float_16float)(uint8_t *dst, const float *src, unsigned width)
+{
+   unsigned x;
+
+   for (x = 0; x + VEC_PIXELS <= width; x += VEC_PIXELS)
+      vec_store_f16_rtz(dst + x * 8, vec_loadu_ps(src + x * 4));
+   return x;
+}
+
+
+static inline unsigned
+TAG(pack_float_10_10_10_2)(uint8_t *dst, const float *src, unsigned width,
+                           bool swap)
+{
+   const veci shift = vec_setr4_epi32(0, 10, 20, 30);
+   const vecf scale = vec_setr4_ps(0x3ff, 0x3ff, 0x3ff, 0x3);
+   unsigned x;
+
+   for (x = 0; x + VEC_PIXELS <= width; x += VEC_PIXELS) {
+      vecf f = vec_loadu_ps(src + x * 4);
+      if (swap)
+         f = vec_permute_ps(f, SWAP_RB);
+      veci v = vec_sllv_epi32(TAG(float_to_unorm)(f, scale), shift);
+      v = vec_or_si(v, vec_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+      v = vec_or_si(v, vec_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+      vec_store_u32_lane0(dst + x * 4, v);
+   }
+   return x;
+}
+
+
+/*
+ * The format functions.  Pixels left over by the row helpers are handed
+ * to the generated code.
+ */
+
+#define UNPACK_FLOAT_FUNC(name, bpp, helper)                                 \
+static void                                                                  \
+TAG(util_format_##name##_unpack_rgba_float)(void *restrict dst_row,          \
+                                            const uint8_t *restrict src,     \
+                                            unsigned width)                  \
+{                                                                            \
+   float *dst = dst_row;                                                     \
+   const unsigned x = helper;                                                \
+   if (x < width)                                                            \
+      util_format_##name##_unpack_rgba_float(dst + x * 4, src + x * (bpp),   \
+                                             width - x);                     \
+}
+
+#define PACK_FLOAT_FUNC(name, bpp, helper)                                   \
+static void                                                                  \
+TAG(util_format_##name##_pack_rgba_float)(uint8_t *restrict dst_row,         \
+                                          unsigned dst_stride,               \
+                                          const float *restrict src_row,     \
+                                          unsigned src_stride,               \
+                                          unsigned width, unsigned height)   \
+{                                                                            \
+   for (unsigned y = 0; y < height; y++) {                                   \
+      uint8_t *dst = dst_row;                                                \
+      const float *src = src_row;                                            \
+      const unsigned x = helper;                                             \
+      if (x < width)                                                         \
+         util_format_##name##_pack_rgba_float(dst + x * (bpp), 0,            \
+                                              src + x * 4, 0,                \
+                                              width - x, 1);                 \
+      dst_row += dst_stride;                                                 \
+      src_row += src_stride / sizeof(*src_row);                              \
+   }                                                                         \
+}
+
+UNPACK_FLOAT_FUNC(r8g8b8a8_unorm, 4, TAG(unpack_8unorm_float)(dst, src, width, false))
+UNPACK_FLOAT_FUNC(b8g8r8a8_unorm, 4, TAG(unpack_8unorm_float)(dst, src, width, true))
+UNPACK_FLOAT_FUNC(r8g8b8a8_srgb, 4, TAG(unpack_srgb8_float)(dst, src, width, false))
+UNPACK_FLOAT_FUNC(b8g8r8a8_srgb, 4, TAG(unpack_srgb8_float)(dst, src, width, true))
+UNPACK_FLOAT_FUNC(r16g16b16a16_unorm, 8, TAG(unpack_16unorm_float)(dst, src, width))
+UNPACK_FLOAT_FUNC(r16g16b16a16_float, 8, TAG(unpack_16float_float)(dst, src, width))
+UNPACK_FLOAT_FUNC(r10g10b10a2_unorm, 4, TAG(unpack_10_10_10_2_float)(dst, src, width, false))
+UNPACK_FLOAT_FUNC(b10g10r10a2_unorm, 4, TAG(unpack_10_10_10_2_float)(dst, src, width, true))
+
+PACK_FLOAT_FUNC(r8g8b8a8_unorm, 4, TAG(pack_float_8unorm)(dst, src, width, false))
+PACK_FLOAT_FUNC(b8g8r8a8_unorm, 4, TAG(pack_float_8unorm)(dst, src, width, true))
+PACK_FLOAT_FUNC(r8g8b8a8_srgb, 4, TAG(pack_float_srgb8)(dst, src, width, false))
+PACK_FLOAT_FUNC(b8g8r8a8_srgb, 4, TAG(pack_float_srgb8)(dst, src, width, true))
+PACK_FLOAT_FUNC(r16g16b16a16_unorm, 8, TAG(pack_float_16unorm)(dst, src, width))
+PACK_FLOAT_FUNC(r16g16b16a16_float, 8, TAG(pack_float_16float)(dst, src, width))
+PACK_FLOAT_FUNC(r10g10b10a2_unorm, 4, TAG(pack_float_10_10_10_2)(dst, src, width, false))
+PACK_FLOAT_FUNC(b10g10r10a2_unorm, 4, TAG(pack_float_10_10_10_2)(dst, src, width, true))
+
+#undef UNPACK_FLOAT_FUNC
+#undef PACK_FLOAT_FUNC
+
+
+static void
+TAG(util_format_b8g8r8a8_unorm_unpack_rgba_8unorm)(uint8_t *restrict dst,
+                                                   const uint8_t *restrict src,
+                                                   unsigned width)
+{
+   const unsigned x = TAG(swap_rb_8unorm)(dst, src, width);
+   if (x < width)
+      util_format_b8g8r8a8_unorm_unpack_rgba_8unorm(dst + x * 4, src + x * 4,
+                                                    width - x);
+}
+
+
+static void
+TAG(util_format_b8g8r8a8_unorm_pack_rgba_8unorm)(uint8_t *restrict dst_row,
+                                                 unsigned dst_stride,
+                                                 const uint8_t *restrict src_row,
+                                                 unsigned src_stride,
+                                                 unsigned width,
+                                                 unsigned height)
+{
+   for (unsigned y = 0; y < height; y++) {
+      const unsigned x = TAG(swap_rb_8unorm)(dst_row, src_row, width);
+      if (x < width)
+         util_format_b8g8r8a8_unorm_pack_rgba_8unorm(dst_row + x * 4, 0,
+                                                     src_row + x * 4, 0,
+                                                     width - x, 1);
+      dst_row += dst_stride;
+      src_row += src_stride;
+   }
+}
+
+
+/*
+ * Like the NEON tables, the entries list every function the generic
+ * description has for these formats, accelerated or not.
+ */
+#define UNPACK_DESC(FORMAT, name, unpack_8unorm)                             \
+   [PIPE_FORMAT_##FORMAT] = {                                                \
+      .unpack_rgba_8unorm = &unpack_8unorm,                                  \
+      .unpack_rgba = &TAG(util_format_##name##_unpack_rgba_float),           \
+   }
+
+#define PACK_DESC(FORMAT, name, pack_8unorm)                                 \
+   [PIPE_FORMAT_##FORMAT] = {                                                \
+      .pack_rgba_8unorm = &pack_8unorm,                                      \
+      .pack_rgba_float = &TAG(util_format_##name##_pack_rgba_float),         \
+   }
+
+static const struct util_format_unpack_description TAG(util_format_unpack_descriptions)[] = {
+   UNPACK_DESC(R8G8B8A8_UNORM, r8g8b8a8_unorm, util_format_r8g8b8a8_unorm_unpack_rgba_8unorm),
+   UNPACK_DESC(B8G8R8A8_UNORM, b8g8r8a8_unorm, TAG(util_format_b8g8r8a8_unorm_unpack_rgba_8unorm)),
+   UNPACK_DESC(R8G8B8A8_SRGB, r8g8b8a8_srgb, util_format_r8g8b8a8_srgb_unpack_rgba_8unorm),
+   UNPACK_DESC(B8G8R8A8_SRGB, b8g8r8a8_srgb, util_format_b8g8r8a8_srgb_unpack_rgba_8unorm),
+   UNPACK_DESC(R16G16B16A16_UNORM, r16g16b16a16_unorm, util_format_r16g16b16a16_unorm_unpack_rgba_8unorm),
+   UNPACK_DESC(R16G16B16A16_FLOAT, r16g16b16a16_float, util_format_r16g16b16a16_float_unpack_rgba_8unorm),
+   UNPACK_DESC(R10G10B10A2_UNORM, r10g10b10a2_unorm, util_format_r10g10b10a2_unorm_unpack_rgba_8unorm),
+   UNPACK_DESC(B10G10R10A2_UNORM, b10g10r10a2_unorm, util_format_b10g10r10a2_unorm_unpack_rgba_8unorm),
+};
+
+static const struct util_format_pack_description TAG(util_format_pack_descriptions)[] = {
+   PACK_DESC(R8G8B8A8_UNORM, r8g8b8a8_unorm, util_format_r8g8b8a8_unorm_pack_rgba_8unorm),
+   PACK_DESC(B8G8R8A8_UNORM, b8g8r8a8_unorm, TAG(util_format_b8g8r8a8_unorm_pack_rgba_8unorm)),
+   PACK_DESC(R8G8B8A8_SRGB, r8g8b8a8_srgb, util_format_r8g8b8a8_srgb_pack_rgba_8unorm),
+   PACK_DESC(B8G8R8A8_SRGB, b8g8r8a8_srgb, util_format_b8g8r8a8_srgb_pack_rgba_8unorm),
+   PACK_DESC(R16G16B16A16_UNORM, r16g16b16a16_unorm, util_format_r16g16b16a16_unorm_pack_rgba_8unorm),
+   PACK_DESC(R16G16B16A16_FLOAT, r16g16b16a16_float, util_format_r16g16b16a16_float_pack_rgba_8unorm),
+   PACK_DESC(R10G10B10A2_UNORM, r10g10b10a2_unorm, util_format_r10g10b10a2_unorm_pack_rgba_8unorm),
+   PACK_DESC(B10G10R10A2_UNORM, b10g10r10a2_unorm, util_format_b10g10r10a2_unorm_pack_rgba_8unorm),
+};
+
+#undef UNPACK_DESC
+#undef PACK_DESC
+
+
+const struct util_format_unpack_description *
+TAG(util_format_unpack_description)(enum pipe_format format)
+{
+   if (!VEC_SUPPORTED(util_get_cpu_caps()))
+      return NULL;
+
+   if (format >= ARRAY_SIZE(TAG(util_format_unpack_descriptions)))
+      return NULL;
+
+   if (!TAG(util_format_unpack_descriptions)[format].unpack_rgba)
+      return NULL;
+
+   return &TAG(util_format_unpack_descriptions)[format];
+}
+
+
+const struct util_format_pack_description *
+TAG(util_format_pack_description)(enum pipe_format format)
+{
+   if (!VEC_SUPPORTED(util_get_cpu_caps()))
+      return NULL;
+
+   if (format >= ARRAY_SIZE(TAG(util_format_pack_descriptions)))
+      return NULL;
+
+   if (!TAG(util_format_pack_descriptions)[format].pack_rgba_float)
+      return NULL;
+
+   return &TAG(util_format_pack_descriptions)[format];
+}
@@ -984,6 +984,40 @@ gc_sweep_end(gc_ctx *ctx)
    ctx->rubbish = NULL;
 }
 
+void
+gc_adopt(gc_ctx *new_ctx, gc_ctx *old_ctx)
+{
+   assert(!new_ctx->rubbish && !old_ctx->rubbish);
+
+   /* Live objects are the ones of the current generation, which has to be
+    * new_ctx's from now on.
+    */
+   const bool flip_gen = new_ctx->current_gen != old_ctx->current_gen;
+
+   for (unsigned i = 0; i < NUM_FREELIST_BUCKETS; i++) {
+      unsigned obj_size = gc_bucket_obj_size(i);
+      list_for_each_entry(gc_slab, slab, &old_ctx->slabs[i].slabs, link) {
+         slab->ctx = new_ctx;
+         if (!flip_gen)
+            continue;
+
+         for (char *ptr = (char*)(slab + 1); ptr != slab->next_available; ptr += obj_size)
+            ((gc_block_header *)ptr)->flags ^= CURRENT_GENERATION;
+      }
+
+      /* This leaves new_ctx's free slabs unsorted, which only makes
+       * allocating from them a little less compact.
+       */
+      list_splicetail(&old_ctx->slabs[i].slabs, &new_ctx->slabs[i].slabs);
+      list_inithead(&old_ctx->slabs[i].slabs);
+      list_splicetail(&old_ctx->slabs[i].free_slabs, &new_ctx->slabs[i].free_slabs);
+      list_inithead(&old_ctx->slabs[i].free_slabs);
+   }
+
+   /* The slabs and the large allocations */
+   ralloc_adopt(new_ctx, old_ctx);
+}
+
 /***************************************************************************
  * Linear allocator for short-lived allocations.
  ***************************************************************************
@@ -122,6 +122,21 @@ simple_mtx_lock(simple_mtx_t *mtx)
    HG(ANNOTATE_RWLOCK_ACQUIRED(mtx, 1));
 }
 
+/* Returns true if the lock was acquired without waiting. */
+static inline bool
+simple_mtx_trylock(simple_mtx_t *mtx)
+{
+   int64_t c = p_atomic_cmpxchg(&mtx->val, 0, 1);
+
+   assert(c != _SIMPLE_MTX_INVALID_VALUE);
+
+   if (c != 0)
+      return false;
+
+   HG(ANNOTATE_RWLOCK_ACQUIRED(mtx, 1));
+   return true;
+}
+
 static inline void
 simple_mtx_unlock(simple_mtx_t *mtx)
 {
@@ -176,6 +191,13 @@ simple_mtx_lock(simple_mtx_t *mtx)
    mtx_lock(&mtx->mtx);
 }
 
+static inline bool
+simple_mtx_trylock(simple_mtx_t *mtx)
+{
+   _simple_mtx_init_with_once(mtx);
+   return mtx_trylock(&mtx->mtx) == thrd_success;
+}
+
 static inline void
 simple_mtx_unlock(simple_mtx_t *mtx)
 {
@@ -29,8 +29,12 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <float.h>
+#include <string.h>
 
+#include "util/detect_arch.h"
+#include "util/detect_cc.h"
 #include "util/half_float.h"
+#include "util/os_time.h"
 #include "util/u_math.h"
 #include "util/format/u_format.h"
 #include "util/format/u_format_tests.h"
@@ -865,11 +869,280 @@ test_all(void)
 }
 
 
+/*
+ * The CPU-specific pack/unpack paths (NEON, AVX2, AVX-512) must give bit for
+ * bit the same results as the generated code.  Compare them on random
+ * pixels, including NaN, infinities, denormals and out of range values,
+ * over every width up to a few vectors so the leftover pixels are covered
+ * too, and print the throughput of both.
+ */
+
+#define SIMD_TEST_MAX_WIDTH 67
+#define SIMD_BENCH_PIXELS (256 * 1024)
+#define SIMD_BENCH_ITERATIONS 8
+
+static uint32_t
+simd_test_rand(uint32_t *state)
+{
+   /* xorshift32 */
+   *state ^= *state << 13;
+   *state ^= *state >> 17;
+   *state ^= *state << 5;
+   return *state;
+}
+
+static void
+simd_test_fill_float(float *dst, unsigned count, uint32_t *state)
+{
+   static const uint32_t special[] = {
+      0x7fc00000, /* NaN */
+      0xffc00000, /* -NaN */
+      0x7f800000, /* +inf */
+      0xff800000, /* -inf */
+      0x80000000, /* -0.0 */
+      0x00000001, /* smallest denormal */
+      0x807fffff, /* largest negative denormal */
+      0x3f7fffff, /* largest float below 1.0 */
+      0x3f800001, /* smallest float above 1.0 */
+      0x477fe000, /* 65504.0 */
+      0x477ff000, /* just above the largest float16 */
+   };
+
+   for (unsigned i = 0; i < count; i++) {
+      const uint32_t r = simd_test_rand(state);
+
+      if (r % 8 == 0) {
+         memcpy(&dst[i], &special[(r >> 8) % ARRAY_SIZE(special)], sizeof(float));
+      } else if (r % 8 == 1) {
+         /* Any bit pattern */
+         uint32_t bits = simd_test_rand(state);
+         memcpy(&dst[i], &bits, sizeof(float));
+      } else {
+         /* Mostly in range, some out of range */
+         dst[i] = (float)(r >> 8) / (float)(1 << 24) * 1.5f - 0.25f;
+      }
+   }
+}
+
+static void
+simd_test_fill_bytes(uint8_t *dst, unsigned count, uint32_t *state)
+{
+   for (unsigned i = 0; i < count; i++)
+      dst[i] = simd_test_rand(state);
+}
+
+static void
+simd_test_report(const struct util_format_description *format_desc,
+                 const char *func, uint64_t bytes,
+                 int64_t generic_ns, int64_t simd_ns)
+{
+   printf("   util_format_%s_%s: generic %.2f GB/s, simd %.2f GB/s\n",
+          format_desc->short_name, func,
+          (double)bytes / MAX2(generic_ns, 1),
+          (double)bytes / MAX2(simd_ns, 1));
+   fflush(stdout);
+}
+
+static bool
+test_simd_unpack(const struct util_format_description *format_desc,
+                 const struct util_format_unpack_description *simd,
+                 const struct util_format_unpack_description *generic)
+{
+   const unsigned bpp = format_desc->block.bits / 8;
+   bool success = true;
+   uint32_t state = 0x12345678;
+
+   uint8_t *src = malloc(SIMD_BENCH_PIXELS * bpp);
+   float *dst_simd = malloc(SIMD_BENCH_PIXELS * 4 * sizeof(float));
+   float *dst_generic = malloc(SIMD_BENCH_PIXELS * 4 * sizeof(float));
+   simd_test_fill_bytes(src, SIMD_BENCH_PIXELS * bpp, &state);
+
+   for (unsigned width = 1; width <= SIMD_TEST_MAX_WIDTH; width++) {
+      if (simd->unpack_rgba != generic->unpack_rgba) {
+         memset(dst_simd, 0xcd, (width + 1) * 4 * sizeof(float));
+         memset(dst_generic, 0xcd, (width + 1) * 4 * sizeof(float));
+         simd->unpack_rgba(dst_simd, src, width);
+         generic->unpack_rgba(dst_generic, src, width);
+         if (memcmp(dst_simd, dst_generic, (width + 1) * 4 * sizeof(float))) {
+            printf("FAILED: util_format_%s_unpack_rgba differs from the generic code at width %u\n",
+                   format_desc->short_name, width);
+            success = false;
+            break;
+         }
+      }
+
+      if (simd->unpack_rgba_8unorm != generic->unpack_rgba_8unorm) {
+         uint8_t *ub_simd = (uint8_t *)dst_simd, *ub_generic = (uint8_t *)dst_generic;
+         memset(ub_simd, 0xcd, (width + 1) * 4);
+         memset(ub_generic, 0xcd, (width + 1) * 4);
+         simd->unpack_rgba_8unorm(ub_simd, src, width);
+         generic->unpack_rgba_8unorm(ub_generic, src, width);
+         if (memcmp(ub_simd, ub_generic, (width + 1) * 4)) {
+            printf("FAILED: util_format_%s_unpack_rgba_8unorm differs from the generic code at width %u\n",
+                   format_desc->short_name, width);
+            success = false;
+            break;
+         }
+      }
+   }
+
+   if (success && simd->unpack_rgba != generic->unpack_rgba) {
+      int64_t start = os_time_get_nano();
+      for (unsigned i = 0; i < SIMD_BENCH_ITERATIONS; i++)
+         generic->unpack_rgba(dst_generic, src, SIMD_BENCH_PIXELS);
+      const int64_t generic_ns = os_time_get_nano() - start;
+
+      start = os_time_get_nano();
+      for (unsigned i = 0; i < SIMD_BENCH_ITERATIONS; i++)
+         simd->unpack_rgba(dst_simd, src, SIMD_BENCH_PIXELS);
+      const int64_t simd_ns = os_time_get_nano() - start;
+
+      simd_test_report(format_desc, "unpack_rgba",
+                       (uint64_t)SIMD_BENCH_ITERATIONS * SIMD_BENCH_PIXELS * bpp,
+                       generic_ns, simd_ns);
+   }
+
+   free(src);
+   free(dst_simd);
+   free(dst_generic);
+   return success;
+}
+
+static bool
+test_simd_pack(const struct util_format_description *format_desc,
+               const struct util_format_pack_description *simd,
+               const struct util_format_pack_description *generic)
+{
+   const unsigned bpp = format_desc->block.bits / 8;
+   bool success = true;
+   uint32_t state = 0x87654321;
+
+   float *src = malloc(SIMD_BENCH_PIXELS * 4 * sizeof(float));
+   uint8_t *dst_simd = malloc(SIMD_BENCH_PIXELS * bpp);
+   uint8_t *dst_generic = malloc(SIMD_BENCH_PIXELS * bpp);
+   simd_test_fill_float(src, SIMD_BENCH_PIXELS * 4, &state);
+
+   for (unsigned width = 1; width <= SIMD_TEST_MAX_WIDTH; width++) {
+      /* Two rows, to cover the strides */
+      const unsigned dst_stride = (width + 1) * bpp;
+      const unsigned src_stride = (width + 3) * 4 * sizeof(float);
+
+      if (simd->pack_rgba_float != generic->pack_rgba_float) {
+         memset(dst_simd, 0xcd, 2 * dst_stride);
+         memset(dst_generic, 0xcd, 2 * dst_stride);
+         simd->pack_rgba_float(dst_simd, dst_stride, src, src_stride, width, 2);
+         generic->pack_rgba_float(dst_generic, dst_stride, src, src_stride, width, 2);
+         if (memcmp(dst_simd, dst_generic, 2 * dst_stride)) {
+            printf("FAILED: util_format_%s_pack_rgba_float differs from the generic code at width %u\n",
+                   format_desc->short_name, width);
+            success = false;
+            break;
+         }
+      }
+
+      if (simd->pack_rgba_8unorm != generic->pack_rgba_8unorm) {
+         const uint8_t *ub_src = (const uint8_t *)src;
+         memset(dst_simd, 0xcd, 2 * dst_stride);
+         memset(dst_generic, 0xcd, 2 * dst_stride);
+         simd->pack_rgba_8unorm(dst_simd, dst_stride, ub_src, (width + 3) * 4, width, 2);
+         generic->pack_rgba_8unorm(dst_generic, dst_stride, ub_src, (width + 3) * 4, width, 2);
+         if (memcmp(dst_simd, dst_generic, 2 * dst_stride)) {
+            printf("FAILED: util_format_%s_pack_rgba_8unorm differs from the generic code at width %u\n",
+                   format_desc->short_name, width);
+            success = false;
+            break;
+         }
+      }
+   }
+
+   if (success && simd->pack_rgba_float != generic->pack_rgba_float) {
+      const unsigned src_stride = SIMD_BENCH_PIXELS * 4 * sizeof(float);
+      int64_t start = os_time_get_nano();
+      for (unsigned i = 0; i < SIMD_BENCH_ITERATIONS; i++)
+         generic->pack_rgba_float(dst_generic, 0, src, src_stride, SIMD_BENCH_PIXELS, 1);
+      const int64_t generic_ns = os_time_get_nano() - start;
+
+      start = os_time_get_nano();
+      for (unsigned i = 0; i < SIMD_BENCH_ITERATIONS; i++)
+         simd->pack_rgba_float(dst_simd, 0, src, src_stride, SIMD_BENCH_PIXELS, 1);
+      const int64_t simd_ns = os_time_get_nano() - start;
+
+      simd_test_report(format_desc, "pack_rgba_float",
+                       (uint64_t)SIMD_BENCH_ITERATIONS * SIMD_BENCH_PIXELS * bpp,
+                       generic_ns, simd_ns);
+   }
+
+   free(src);
+   free(dst_simd);
+   free(dst_generic);
+   return success;
+}
+
+struct simd_isa {
+   const char *name;
+   const struct util_format_unpack_description *(*unpack)(enum pipe_format format);
+   const struct util_format_pack_description *(*pack)(enum pipe_format format);
+};
+
+/* Each table returns NULL for formats it doesn't cover and, when the CPU
+ * lacks the ISA, for every format.  Testing them one by one also covers
+ * the kernels that runtime selection shadows, e.g. AVX2 on AVX-512 hosts.
+ */
+static const struct simd_isa simd_isas[] = {
+#if (DETECT_ARCH_AARCH64 || DETECT_ARCH_ARM) && !defined(NO_FORMAT_ASM) && !defined(__SOFTFP__)
+   { "neon", util_format_unpack_description_neon, NULL },
+#endif
+#if DETECT_ARCH_X86_64 && DETECT_CC_GCC && !defined(NO_FORMAT_ASM)
+   { "avx2", util_format_unpack_description_avx2, util_format_pack_description_avx2 },
+   { "avx512", util_format_unpack_description_avx512, util_format_pack_description_avx512 },
+#endif
+};
+
+static bool
+test_all_simd(void)
+{
+   bool success = true;
+
+   for (unsigned i = 0; i < ARRAY_SIZE(simd_isas); i++) {
+      const struct simd_isa *isa = &simd_isas[i];
+
+      for (enum pipe_format format = 1; format < PIPE_FORMAT_COUNT; ++format) {
+         const struct util_format_description *format_desc = util_format_description(format);
+         if (!format_desc)
+            continue;
+
+         const struct util_format_unpack_description *unpack = isa->unpack(format);
+         if (unpack) {
+            printf("Testing %s util_format_%s_unpack_rgba against the generic code ...\n",
+                   isa->name, format_desc->short_name);
+            fflush(stdout);
+            if (!test_simd_unpack(format_desc, unpack,
+                                  util_format_unpack_description_generic(format)))
+               success = false;
+         }
+
+         const struct util_format_pack_description *pack =
+            isa->pack ? isa->pack(format) : NULL;
+         if (pack) {
+            printf("Testing %s util_format_%s_pack_rgba against the generic code ...\n",
+                   isa->name, format_desc->short_name);
+            fflush(stdout);
+            if (!test_simd_pack(format_desc, pack,
+                                util_format_pack_description_generic(format)))
+               success = false;
+         }
+      }
+   }
+
+   return success;
+}
+
 int main(int argc, char **argv)
 {
    bool success;
 
    success = test_all();
+   success = test_all_simd() && success;
 
    return success ? 0 : 1;
 }
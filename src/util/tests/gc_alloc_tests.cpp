@@ -46,3 +46,53 @@ TEST(gc_alloc, align)
       }
    }
 }
+
+TEST(gc_alloc, adopt)
+{
+   gc_ctx *ctx = gc_context(NULL);
+   gc_ctx *other = gc_context(NULL);
+
+   /* Puts the contexts in different generations */
+   gc_sweep_start(ctx);
+   gc_sweep_end(ctx);
+
+   uint32_t *small[64], *large[4];
+   for (unsigned i = 0; i < 64; i++) {
+      small[i] = (uint32_t *)gc_alloc_size(other, 64, 4);
+      *small[i] = i;
+   }
+   for (unsigned i = 0; i < 4; i++) {
+      large[i] = (uint32_t *)gc_alloc_size(other, 4096, 4);
+      *large[i] = i;
+   }
+
+   gc_adopt(ctx, other);
+   ralloc_free(other);
+
+   for (unsigned i = 0; i < 64; i++)
+      EXPECT_EQ(gc_get_context(small[i]), ctx);
+   for (unsigned i = 0; i < 4; i++)
+      EXPECT_EQ(gc_get_context(large[i]), ctx);
+
+   /* Only the even ones survive a sweep */
+   gc_sweep_start(ctx);
+   for (unsigned i = 0; i < 64; i += 2)
+      gc_mark_live(ctx, small[i]);
+   for (unsigned i = 0; i < 4; i += 2)
+      gc_mark_live(ctx, large[i]);
+   gc_sweep_end(ctx);
+
+   for (unsigned i = 0; i < 64; i += 2)
+      EXPECT_EQ(*small[i], i);
+   for (unsigned i = 0; i < 4; i += 2)
+      EXPECT_EQ(*large[i], i);
+
+   /* Newer allocations reuse the freed objects */
+   uint32_t *reused = (uint32_t *)gc_alloc_size(ctx, 64, 4);
+   bool found = false;
+   for (unsigned i = 1; i < 64; i += 2)
+      found |= reused == small[i];
+   EXPECT_TRUE(found);
+
+   ralloc_free(ctx);
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright © 2026 The Mesa Authors
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Records and replays a draw-heavy vk_cmd_queue several times and reports
+ * the per-command cost of both, along with how many allocations reached the
+ * parent allocator.  Once the first recording has sized the arena, resets
+ * must not allocate or free anything, and trimming must free all but one
+ * chunk.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "vk_alloc.h"
+#include "vk_cmd_queue.h"
+#include "vk_dispatch_table.h"
+
+#include "util/os_memory.h"
+#include "util/os_time.h"
+
+#define NUM_DRAWS 100000
+#define NUM_ITERATIONS 5
+
+static unsigned parent_allocs;
+static unsigned parent_frees;
+
+static VKAPI_ATTR void * VKAPI_CALL
+counting_alloc(void *pUserData, size_t size, size_t align,
+               VkSystemAllocationScope allocationScope)
+{
+   parent_allocs++;
+   return os_malloc_aligned(size, align);
+}
+
+static VKAPI_ATTR void * VKAPI_CALL
+counting_realloc(void *pUserData, void *pOriginal, size_t size, size_t align,
+                 VkSystemAllocationScope allocationScope)
+{
+   abort();
+}
+
+static VKAPI_ATTR void VKAPI_CALL
+counting_free(void *pUserData, void *pMemory)
+{
+   if (pMemory)
+      parent_frees++;
+   os_free_aligned(pMemory);
+}
+
+static uint64_t replay_vertices;
+static uint64_t replay_offsets;
+static float replay_width;
+
+static VKAPI_ATTR void VKAPI_CALL
+replay_CmdDraw(VkCommandBuffer commandBuffer, uint32_t vertexCount,
+               uint32_t instanceCount, uint32_t firstVertex,
+               uint32_t firstInstance)
+{
+   replay_vertices += vertexCount;
+}
+
+static VKAPI_ATTR void VKAPI_CALL
+replay_CmdSetViewport(VkCommandBuffer commandBuffer, uint32_t firstViewport,
+                      uint32_t viewportCount, const VkViewport *pViewports)
+{
+   replay_width += pViewports[0].width;
+}
+
+static VKAPI_ATTR void VKAPI_CALL
+replay_CmdBindVertexBuffers(VkCommandBuffer commandBuffer,
+                            uint32_t firstBinding, uint32_t bindingCount,
+                            const VkBuffer *pBuffers,
+                            const VkDeviceSize *pOffsets)
+{
+   for (uint32_t i = 0; i < bindingCount; i++)
+      replay_offsets += pOffsets[i];
+}
+
+static bool
+record(struct vk_cmd_queue *queue)
+{
+   const VkBuffer buffers[2] = { VK_NULL_HANDLE, VK_NULL_HANDLE };
+
+   for (unsigned i = 0; i < NUM_DRAWS; i++) {
+      if (i % 8 == 0) {
+         const VkViewport viewport = { .width = 1.0f, .height = 1.0f };
+         if (vk_enqueue_cmd_set_viewport(queue, 0, 1, &viewport) != VK_SUCCESS)
+            return false;
+
+         const VkDeviceSize offsets[2] = { 1, 2 };
+         if (vk_enqueue_cmd_bind_vertex_buffers(queue, 0, 2, buffers,
+                                                offsets) != VK_SUCCESS)
+            return false;
+      }
+      if (vk_enqueue_cmd_draw(queue, 3, 1, i, 0) != VK_SUCCESS)
+         return false;
+   }
+
+   return true;
+}
+
+int
+main(int argc, char **argv)
+{
+   VkAllocationCallbacks alloc = {
+      .pfnAllocation = counting_alloc,
+      .pfnReallocation = counting_realloc,
+      .pfnFree = counting_free,
+   };
+   struct vk_device_dispatch_table disp = {
+      .CmdDraw = replay_CmdDraw,
+      .CmdSetViewport = replay_CmdSetViewport,
+      .CmdBindVertexBuffers = replay_CmdBindVertexBuffers,
+   };
+   const unsigned num_state = (NUM_DRAWS + 7) / 8;
+   const unsigned num_cmds = NUM_DRAWS + 2 * num_state;
+   bool pass = true;
+
+   struct vk_cmd_queue queue;
+   vk_cmd_queue_init(&queue, &alloc);
+
+   for (unsigned iter = 0; iter < NUM_ITERATIONS; iter++) {
+      const unsigned allocs_before = parent_allocs;
+      const unsigned frees_before = parent_frees;
+
+      int64_t t0 = os_time_get_nano();
+      if (!record(&queue)) {
+         fprintf(stderr, "recording failed\n");
+         return 1;
+      }
+      int64_t t1 = os_time_get_nano();
+
+      replay_vertices = 0;
+      replay_offsets = 0;
+      replay_width = 0.0f;
+      vk_cmd_queue_execute(&queue, VK_NULL_HANDLE, &disp);
+      int64_t t2 = os_time_get_nano();
+
+      vk_cmd_queue_reset(&queue);
+      int64_t t3 = os_time_get_nano();
+
+      const unsigned allocs = parent_allocs - allocs_before;
+      const unsigned frees = parent_frees - frees_before;
+
+      printf("iteration %u: record %.1f ns/cmd, replay %.1f ns/cmd, "
+             "reset %.3f ms, %u allocations, %u frees\n",
+             iter, (double)(t1 - t0) / num_cmds, (double)(t2 - t1) / num_cmds,
+             (double)(t3 - t2) / 1e6, allocs, frees);
+
+      if (replay_vertices != 3ull * NUM_DRAWS ||
+          replay_offsets != 3ull * num_state ||
+          replay_width != (float)num_state) {
+         fprintf(stderr, "iteration %u: replay doesn't match the recording\n",
+                 iter);
+         pass = false;
+      }
+
+      if (iter > 0 && (allocs != 0 || frees != 0)) {
+         fprintf(stderr, "iteration %u: re-recording after a reset went "
+                 "through the parent allocator\n", iter);
+         pass = false;
+      }
+   }
+
+   /* Resets releasing resources only keep the first chunk */
+   if (!record(&queue)) {
+      fprintf(stderr, "recording failed\n");
+      return 1;
+   }
+   vk_cmd_queue_trim(&queue);
+   if (parent_allocs - parent_frees != 1) {
+      fprintf(stderr, "%u chunks left after trimming\n",
+              parent_allocs - parent_frees);
+      pass = false;
+   }
+
+   vk_cmd_queue_finish(&queue);
+
+   if (parent_allocs != parent_frees) {
+      fprintf(stderr, "%u allocations but %u frees\n",
+              parent_allocs, parent_frees);
+      pass = false;
+   }
+
+   return pass ? 0 : 1;
+}
@@ -118,6 +118,7 @@ vk_command_buffer_recycle(struct vk_command_buffer *cmd_buffer)
     */
    cmd_buffer->ops->reset(cmd_buffer,
       VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT);
+   vk_cmd_queue_trim(&cmd_buffer->cmd_queue);
 
    vk_object_base_recycle(&cmd_buffer->base);
 }
@@ -131,6 +132,10 @@ vk_common_ResetCommandBuffer(VkCommandBuffer commandBuffer,
    if (cmd_buffer->state != MESA_VK_COMMAND_BUFFER_STATE_INITIAL)
       cmd_buffer->ops->reset(cmd_buffer, flags);
 
+   /* The pool maps VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT to this too */
+   if (flags & VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT)
+      vk_cmd_queue_trim(&cmd_buffer->cmd_queue);
+
    return VK_SUCCESS;
 }
 
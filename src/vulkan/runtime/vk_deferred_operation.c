@@ -43,6 +43,15 @@ vk_common_CreateDeferredOperationKHR(VkDevice _device,
    vk_object_base_init(device, &op->base,
                        VK_OBJECT_TYPE_DEFERRED_OPERATION_KHR);
 
+   mtx_init(&op->mutex, mtx_plain);
+   op->task = NULL;
+   op->finish = NULL;
+   op->data = NULL;
+   op->task_count = 0;
+   op->next_task = 0;
+   op->done_count = 0;
+   op->result = VK_SUCCESS;
+
    *pDeferredOperation = vk_deferred_operation_to_handle(op);
 
    return VK_SUCCESS;
@@ -59,27 +68,83 @@ vk_common_DestroyDeferredOperationKHR(VkDevice _device,
    if (op == NULL)
       return;
 
+   assert(op->done_count == op->task_count);
+
+   mtx_destroy(&op->mutex);
    vk_object_base_finish(&op->base);
    vk_free2(&device->alloc, pAllocator, op);
 }
 
+VkResult
+vk_deferred_operation_defer(struct vk_deferred_operation *op,
+                            uint32_t task_count,
+                            vk_deferred_operation_task_cb task,
+                            vk_deferred_operation_finish_cb finish,
+                            void *data)
+{
+   assert(task_count > 0);
+
+   mtx_lock(&op->mutex);
+   assert(op->done_count == op->task_count);
+   op->task = task;
+   op->finish = finish;
+   op->data = data;
+   op->task_count = task_count;
+   op->next_task = 0;
+   op->done_count = 0;
+   op->result = VK_NOT_READY;
+   mtx_unlock(&op->mutex);
+
+   return VK_OPERATION_DEFERRED_KHR;
+}
+
 VKAPI_ATTR uint32_t VKAPI_CALL
 vk_common_GetDeferredOperationMaxConcurrencyKHR(UNUSED VkDevice device,
-                                                UNUSED VkDeferredOperationKHR operation)
+                                                VkDeferredOperationKHR operation)
 {
-   return 1;
+   VK_FROM_HANDLE(vk_deferred_operation, op, operation);
+
+   /* Tasks no thread has picked up yet, zero once all of them have been */
+   mtx_lock(&op->mutex);
+   const uint32_t remaining = op->task_count - op->next_task;
+   mtx_unlock(&op->mutex);
+
+   return remaining;
 }
 
 VKAPI_ATTR VkResult VKAPI_CALL
 vk_common_GetDeferredOperationResultKHR(UNUSED VkDevice device,
-                                        UNUSED VkDeferredOperationKHR operation)
+                                        VkDeferredOperationKHR operation)
 {
-   return VK_SUCCESS;
+   VK_FROM_HANDLE(vk_deferred_operation, op, operation);
+
+   mtx_lock(&op->mutex);
+   const VkResult result = op->result;
+   mtx_unlock(&op->mutex);
+
+   return result;
 }
 
 VKAPI_ATTR VkResult VKAPI_CALL
 vk_common_DeferredOperationJoinKHR(UNUSED VkDevice device,
-                                   UNUSED VkDeferredOperationKHR operation)
+                                   VkDeferredOperationKHR operation)
 {
-   return VK_SUCCESS;
+   VK_FROM_HANDLE(vk_deferred_operation, op, operation);
+
+   mtx_lock(&op->mutex);
+   while (op->next_task < op->task_count) {
+      const uint32_t index = op->next_task++;
+      mtx_unlock(&op->mutex);
+
+      op->task(op->data, index);
+
+      mtx_lock(&op->mutex);
+      if (++op->done_count == op->task_count)
+         op->result = op->finish ? op->finish(op->data) : VK_SUCCESS;
+   }
+   const bool complete = op->done_count == op->task_count;
+   mtx_unlock(&op->mutex);
+
+   /* Other threads are still running the remaining tasks. */
+   return complete ? VK_SUCCESS : VK_THREAD_DONE_KHR;
 }
@@ -32,14 +32,51 @@
 extern "C" {
 #endif
 
+/** Runs task index of a deferred operation on a joining thread */
+typedef void (*vk_deferred_operation_task_cb)(void *data, uint32_t index);
+
+/** Called once all tasks of a deferred operation ran, returns its result */
+typedef VkResult (*vk_deferred_operation_finish_cb)(void *data);
+
 struct vk_deferred_operation {
    struct vk_object_base base;
+
+   mtx_t mutex;
+
+   /* Work deferred by vk_deferred_operation_defer(), executed by the
+    * threads which join the operation.
+    */
+   vk_deferred_operation_task_cb task;
+   vk_deferred_operation_finish_cb finish;
+   void *data;
+
+   uint32_t task_count;
+   uint32_t next_task;
+   uint32_t done_count;
+
+   VkResult result;
 };
 
 VK_DEFINE_NONDISP_HANDLE_CASTS(vk_deferred_operation, base,
                                VkDeferredOperationKHR,
                                VK_OBJECT_TYPE_DEFERRED_OPERATION_KHR)
 
+/**
+ * Hands task_count independent tasks to a deferred operation.  Threads
+ * joining the operation pick them up one by one; once the last one is done,
+ * finish is called (on the thread which ran it) and its return value becomes
+ * the result of the operation.
+ *
+ * Returns VK_OPERATION_DEFERRED_KHR, for the driver to return from the
+ * deferred command.
+ */
+VkResult
+vk_deferred_operation_defer(struct vk_deferred_operation *op,
+                            uint32_t task_count,
+                            vk_deferred_operation_task_cb task,
+                            vk_deferred_operation_finish_cb finish,
+                            void *data);
+
 #ifdef __cplusplus
 }
 #endif
@@ -29,13 +29,33 @@
 #include "vk_device.h"
 #include "vk_log.h"
 
-VKAPI_ATTR VkResult VKAPI_CALL
-vk_common_CreateDescriptorUpdateTemplate(VkDevice _device,
-   const VkDescriptorUpdateTemplateCreateInfo *pCreateInfo,
-   const VkAllocationCallbacks *pAllocator,
-   VkDescriptorUpdateTemplate *pDescriptorUpdateTemplate)
+#include "util/u_math.h"
+
+static bool
+template_entry_continues(const struct vk_descriptor_template_entry *prev,
+                         const VkDescriptorUpdateTemplateEntry *entry)
+{
+   if (prev->type != entry->descriptorType ||
+       prev->binding != entry->dstBinding ||
+       prev->array_element + prev->array_count != entry->dstArrayElement)
+      return false;
+
+   /* For inline uniform blocks the array element and count are in bytes
+    * and the stride is ignored.
+    */
+   if (entry->descriptorType == VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK)
+      return prev->offset + prev->array_count == entry->offset;
+
+   return prev->stride == entry->stride &&
+          prev->offset + prev->array_count * prev->stride == entry->offset;
+}
+
+VkResult
+vk_descriptor_update_template_create(struct vk_device *device,
+                                     const VkDescriptorUpdateTemplateCreateInfo *pCreateInfo,
+                                     size_t driver_data_size,
+                                     struct vk_descriptor_update_template **template_out)
 {
-   VK_FROM_HANDLE(vk_device, device, _device);
    struct vk_descriptor_update_template *template;
 
    uint32_t entry_count = 0;
@@ -45,6 +65,9 @@ vk_common_CreateDescriptorUpdateTemplate(VkDevice _device,
    }
 
    size_t size = sizeof(*template) + entry_count * sizeof(template->entries[0]);
+   size_t driver_data_offset = align_uintptr(size, 8);
+   if (driver_data_size > 0)
+      size = driver_data_offset + driver_data_size;
 
    /* Because we're reference counting and lifetimes may not be what the
     * client expects, these have to be allocated off the device and not as
@@ -61,12 +84,13 @@ vk_common_CreateDescriptorUpdateTemplate(VkDevice _device,
    template->type = pCreateInfo->templateType;
    template->bind_point = pCreateInfo->pipelineBindPoint;
    template->ref_cnt = 1;
+   if (driver_data_size > 0)
+      template->driver_data = (char *)template + driver_data_offset;
 
    if (template->type == VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET)
       template->set = pCreateInfo->set;
 
    uint32_t entry_idx = 0;
-   template->entry_count = entry_count;
    for (uint32_t i = 0; i < pCreateInfo->descriptorUpdateEntryCount; i++) {
       const VkDescriptorUpdateTemplateEntry *pEntry =
          &pCreateInfo->pDescriptorUpdateEntries[i];
@@ -74,6 +98,12 @@ vk_common_CreateDescriptorUpdateTemplate(VkDevice _device,
       if (pEntry->descriptorCount == 0)
          continue;
 
+      if (entry_idx > 0 &&
+          template_entry_continues(&template->entries[entry_idx - 1], pEntry)) {
+         template->entries[entry_idx - 1].array_count += pEntry->descriptorCount;
+         continue;
+      }
+
       template->entries[entry_idx++] = (struct vk_descriptor_template_entry) {
          .type = pEntry->descriptorType,
          .binding = pEntry->dstBinding,
@@ -83,7 +113,27 @@ vk_common_CreateDescriptorUpdateTemplate(VkDevice _device,
          .stride = pEntry->stride,
       };
    }
-   assert(entry_idx == entry_count);
+   assert(entry_idx <= entry_count);
+   template->entry_count = entry_idx;
+
+   *template_out = template;
+
+   return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL
+vk_common_CreateDescriptorUpdateTemplate(VkDevice _device,
+   const VkDescriptorUpdateTemplateCreateInfo *pCreateInfo,
+   const VkAllocationCallbacks *pAllocator,
+   VkDescriptorUpdateTemplate *pDescriptorUpdateTemplate)
+{
+   VK_FROM_HANDLE(vk_device, device, _device);
+   struct vk_descriptor_update_template *template;
+
+   VkResult result =
+      vk_descriptor_update_template_create(device, pCreateInfo, 0, &template);
+   if (result != VK_SUCCESS)
+      return result;
 
    *pDescriptorUpdateTemplate =
       vk_descriptor_update_template_to_handle(template);
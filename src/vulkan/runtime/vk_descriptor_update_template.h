@@ -84,6 +84,14 @@ struct vk_descriptor_update_template {
     */
    uint32_t ref_cnt;
 
+   /** Driver-private data, allocated and freed along with the template
+    *
+    * Drivers that compile templates into their own form when they are
+    * created keep the result here, see vk_descriptor_update_template_create.
+    * NULL if the driver asked for no data.
+    */
+   void *driver_data;
+
    /** Entries of the template */
    struct vk_descriptor_template_entry entries[0];
 };
@@ -105,6 +113,20 @@ vk_descriptor_update_template_unref(struct vk_device *device,
       vk_object_free(device, NULL, templ);
 }
 
+/** Creates a template with driver_data_size bytes of driver_data
+ *
+ * This is what vk_common_CreateDescriptorUpdateTemplate does, with room
+ * for drivers to compile the template at creation time.  Entries with a
+ * descriptorCount of zero are dropped, and entries which continue the
+ * previous one in both the destination binding and the user data are
+ * merged into a single entry.
+ */
+VkResult
+vk_descriptor_update_template_create(struct vk_device *device,
+                                     const VkDescriptorUpdateTemplateCreateInfo *pCreateInfo,
+                                     size_t driver_data_size,
+                                     struct vk_descriptor_update_template **template_out);
+
 VK_DEFINE_NONDISP_HANDLE_CASTS(vk_descriptor_update_template, base,
                                VkDescriptorUpdateTemplate,
                                VK_OBJECT_TYPE_DESCRIPTOR_UPDATE_TEMPLATE)
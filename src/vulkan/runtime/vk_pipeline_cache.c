@@ -35,7 +35,10 @@
 #include "util/u_debug.h"
 #include "util/disk_cache.h"
 #include "util/hash_table.h"
+#include "util/log.h"
+#include "util/os_time.h"
 #include "util/set.h"
+#include "util/u_memory.h"
 
 #define vk_pipeline_cache_log(cache, ...)                                      \
    if (cache->base.client_visible)                                             \
@@ -143,35 +146,68 @@ object_key_hash(const void *void_object)
    return _mesa_hash_data(object->key_data, object->key_size);
 }
 
+/* Pipeline creation from many threads looks up the cache for every shader
+ * and pipeline, so a single table lock serializes all of them even when
+ * every lookup hits.  The table is split into shards selected by the top
+ * bits of the key hash (the set itself uses the low bits), each shard
+ * holding its own lock on its own cache line.
+ */
+#define VK_PIPELINE_CACHE_SHARD_BITS 4
+#define VK_PIPELINE_CACHE_SHARD_COUNT (1 << VK_PIPELINE_CACHE_SHARD_BITS)
+
+struct vk_pipeline_cache_shard {
+   EXCLUSIVE_CACHELINE(struct {
+      simple_mtx_t lock;
+
+      struct set *objects;
+
+      /* Protected by lock */
+      struct vk_pipeline_cache_stats stats;
+   });
+};
+
+static inline struct vk_pipeline_cache_shard *
+vk_pipeline_cache_get_shard(struct vk_pipeline_cache *cache, uint32_t hash)
+{
+   return &cache->shards[hash >> (32 - VK_PIPELINE_CACHE_SHARD_BITS)];
+}
+
 static void
-vk_pipeline_cache_lock(struct vk_pipeline_cache *cache)
+vk_pipeline_cache_lock_shard(struct vk_pipeline_cache *cache,
+                             struct vk_pipeline_cache_shard *shard)
 {
+   if (cache->flags & VK_PIPELINE_CACHE_CREATE_EXTERNALLY_SYNCHRONIZED_BIT)
+      return;
 
-   if (!(cache->flags & VK_PIPELINE_CACHE_CREATE_EXTERNALLY_SYNCHRONIZED_BIT))
-      simple_mtx_lock(&cache->lock);
+   if (!simple_mtx_trylock(&shard->lock)) {
+      simple_mtx_lock(&shard->lock);
+      shard->stats.contended++;
+   }
 }
 
 static void
-vk_pipeline_cache_unlock(struct vk_pipeline_cache *cache)
+vk_pipeline_cache_unlock_shard(struct vk_pipeline_cache *cache,
+                               struct vk_pipeline_cache_shard *shard)
 {
    if (!(cache->flags & VK_PIPELINE_CACHE_CREATE_EXTERNALLY_SYNCHRONIZED_BIT))
-      simple_mtx_unlock(&cache->lock);
+      simple_mtx_unlock(&shard->lock);
 }
 
-/* cache->lock must be held when calling */
+/* shard->lock must be held when calling */
 static void
 vk_pipeline_cache_remove_object(struct vk_pipeline_cache *cache,
+                                struct vk_pipeline_cache_shard *shard,
                                 uint32_t hash,
                                 struct vk_pipeline_cache_object *object)
 {
    struct set_entry *entry =
-      _mesa_set_search_pre_hashed(cache->object_cache, hash, object);
+      _mesa_set_search_pre_hashed(shard->objects, hash, object);
    if (entry && entry->key == (const void *)object) {
       /* Drop the reference owned by the cache */
       if (!cache->weak_ref)
          vk_pipeline_cache_object_unref(cache->base.device, object);
 
-      _mesa_set_remove(cache->object_cache, entry);
+      _mesa_set_remove(shard->objects, entry);
    }
 }
 
@@ -194,13 +230,15 @@ vk_pipeline_cache_object_unref(struct vk_device *device, struct vk_pipeline_cach
       if (p_atomic_dec_zero(&object->ref_cnt))
          object->ops->destroy(device, object);
    } else {
-      vk_pipeline_cache_lock(weak_owner);
+      uint32_t hash = object_key_hash(object);
+      struct vk_pipeline_cache_shard *shard =
+         vk_pipeline_cache_get_shard(weak_owner, hash);
+
+      vk_pipeline_cache_lock_shard(weak_owner, shard);
       bool destroy = p_atomic_dec_zero(&object->ref_cnt);
-      if (destroy) {
-         uint32_t hash = object_key_hash(object);
-         vk_pipeline_cache_remove_object(weak_owner, hash, object);
-      }
-      vk_pipeline_cache_unlock(weak_owner);
+      if (destroy)
+         vk_pipeline_cache_remove_object(weak_owner, shard, hash, object);
+      vk_pipeline_cache_unlock_shard(weak_owner, shard);
       if (destroy)
          object->ops->destroy(device, object);
    }
@@ -293,15 +331,17 @@ vk_pipeline_cache_insert_object(struct vk_pipeline_cache *cache,
 {
    assert(object->ops != NULL);
 
-   if (cache->object_cache == NULL)
+   if (cache->shards == NULL)
       return object;
 
    uint32_t hash = object_key_hash(object);
+   struct vk_pipeline_cache_shard *shard =
+      vk_pipeline_cache_get_shard(cache, hash);
 
-   vk_pipeline_cache_lock(cache);
+   vk_pipeline_cache_lock_shard(cache, shard);
    bool found = false;
    struct set_entry *entry = _mesa_set_search_or_add_pre_hashed(
-       cache->object_cache, hash, object, &found);
+       shard->objects, hash, object, &found);
 
    struct vk_pipeline_cache_object *result = NULL;
    /* add reference to either the found or inserted object */
@@ -323,8 +363,9 @@ vk_pipeline_cache_insert_object(struct vk_pipeline_cache *cache,
          vk_pipeline_cache_object_ref(result);
       else
          vk_pipeline_cache_object_weak_ref(cache, result);
+      shard->stats.inserts++;
    }
-   vk_pipeline_cache_unlock(cache);
+   vk_pipeline_cache_unlock_shard(cache, shard);
 
    if (found) {
       vk_pipeline_cache_object_unref(cache->base.device, object);
@@ -352,21 +393,29 @@ vk_pipeline_cache_lookup_object(struct vk_pipeline_cache *cache,
 
    struct vk_pipeline_cache_object *object = NULL;
 
-   if (cache != NULL && cache->object_cache != NULL) {
-      vk_pipeline_cache_lock(cache);
+   if (cache != NULL && cache->shards != NULL) {
+      struct vk_pipeline_cache_shard *shard =
+         vk_pipeline_cache_get_shard(cache, hash);
+      int64_t start = cache->collect_stats ? os_time_get_nano() : 0;
+
+      vk_pipeline_cache_lock_shard(cache, shard);
       struct set_entry *entry =
-         _mesa_set_search_pre_hashed(cache->object_cache, hash, &key);
+         _mesa_set_search_pre_hashed(shard->objects, hash, &key);
       if (entry) {
          object = vk_pipeline_cache_object_ref((void *)entry->key);
          if (cache_hit != NULL)
             *cache_hit = true;
+         shard->stats.hits++;
       }
-      vk_pipeline_cache_unlock(cache);
+      shard->stats.lookups++;
+      if (cache->collect_stats)
+         shard->stats.lookup_ns += os_time_get_nano() - start;
+      vk_pipeline_cache_unlock_shard(cache, shard);
    }
 
    if (object == NULL) {
       struct disk_cache *disk_cache = get_disk_cache(cache);
-      if (!cache->skip_disk_cache && disk_cache && cache->object_cache) {
+      if (!cache->skip_disk_cache && disk_cache && cache->shards) {
          cache_key cache_key;
          disk_cache_compute_key(disk_cache, key_data, key_size, cache_key);
 
@@ -406,9 +455,11 @@ vk_pipeline_cache_lookup_object(struct vk_pipeline_cache *cache,
          vk_pipeline_cache_log(cache,
                                "Deserializing pipeline cache object failed");
 
-         vk_pipeline_cache_lock(cache);
-         vk_pipeline_cache_remove_object(cache, hash, object);
-         vk_pipeline_cache_unlock(cache);
+         struct vk_pipeline_cache_shard *shard =
+            vk_pipeline_cache_get_shard(cache, hash);
+         vk_pipeline_cache_lock_shard(cache, shard);
+         vk_pipeline_cache_remove_object(cache, shard, hash, object);
+         vk_pipeline_cache_unlock_shard(cache, shard);
          vk_pipeline_cache_object_unref(cache->base.device, object);
          return NULL;
       }
@@ -651,15 +702,32 @@ vk_pipeline_cache_create(struct vk_device *device,
    };
    memcpy(cache->header.uuid, pdevice_props.pipelineCacheUUID, VK_UUID_SIZE);
 
-   simple_mtx_init(&cache->lock, mtx_plain);
-
    if (info->force_enable ||
        debug_get_bool_option("VK_ENABLE_PIPELINE_CACHE", true)) {
-      cache->object_cache = _mesa_set_create(NULL, object_key_hash,
-                                             object_keys_equal);
+      cache->shards = vk_zalloc2(&device->alloc, pAllocator,
+                                 VK_PIPELINE_CACHE_SHARD_COUNT *
+                                 sizeof(*cache->shards), CACHE_LINE_SIZE,
+                                 VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+      if (cache->shards == NULL) {
+         vk_object_free(device, pAllocator, cache);
+         return NULL;
+      }
+
+      for (unsigned i = 0; i < VK_PIPELINE_CACHE_SHARD_COUNT; i++) {
+         simple_mtx_init(&cache->shards[i].lock, mtx_plain);
+         cache->shards[i].objects = _mesa_set_create(NULL, object_key_hash,
+                                                     object_keys_equal);
+         if (cache->shards[i].objects == NULL) {
+            vk_pipeline_cache_destroy(cache, pAllocator);
+            return NULL;
+         }
+      }
+
+      cache->collect_stats =
+         debug_get_bool_option("MESA_VK_PIPELINE_CACHE_STATS", false);
    }
 
-   if (cache->object_cache && pCreateInfo->initialDataSize > 0) {
+   if (cache->shards && pCreateInfo->initialDataSize > 0) {
       vk_pipeline_cache_load(cache, pCreateInfo->pInitialData,
                              pCreateInfo->initialDataSize);
    }
@@ -671,20 +739,61 @@ void
 vk_pipeline_cache_destroy(struct vk_pipeline_cache *cache,
                           const VkAllocationCallbacks *pAllocator)
 {
-   if (cache->object_cache) {
-      if (!cache->weak_ref) {
-         set_foreach(cache->object_cache, entry) {
-            vk_pipeline_cache_object_unref(cache->base.device, (void *)entry->key);
+   if (cache->shards) {
+      if (cache->collect_stats) {
+         struct vk_pipeline_cache_stats stats;
+         vk_pipeline_cache_get_stats(cache, &stats);
+         mesa_logi("pipeline cache %p: %" PRIu64 " lookups, %" PRIu64
+                   " hits, %" PRIu64 " inserts, %" PRIu64 " contended, "
+                   "%.1f ns/lookup", cache, stats.lookups, stats.hits,
+                   stats.inserts, stats.contended,
+                   (double)stats.lookup_ns / MAX2(stats.lookups, 1));
+      }
+
+      for (unsigned i = 0; i < VK_PIPELINE_CACHE_SHARD_COUNT; i++) {
+         struct vk_pipeline_cache_shard *shard = &cache->shards[i];
+
+         /* Partially created caches stop at the first missing set */
+         if (shard->objects == NULL)
+            break;
+
+         if (!cache->weak_ref) {
+            set_foreach(shard->objects, entry) {
+               vk_pipeline_cache_object_unref(cache->base.device, (void *)entry->key);
+            }
+         } else {
+            assert(shard->objects->entries == 0);
          }
-      } else {
-         assert(cache->object_cache->entries == 0);
+         _mesa_set_destroy(shard->objects, NULL);
+         simple_mtx_destroy(&shard->lock);
       }
-      _mesa_set_destroy(cache->object_cache, NULL);
+      vk_free2(&cache->base.device->alloc, pAllocator, cache->shards);
    }
-   simple_mtx_destroy(&cache->lock);
    vk_object_free(cache->base.device, pAllocator, cache);
 }
 
+void
+vk_pipeline_cache_get_stats(struct vk_pipeline_cache *cache,
+                            struct vk_pipeline_cache_stats *stats)
+{
+   memset(stats, 0, sizeof(*stats));
+
+   if (cache->shards == NULL)
+      return;
+
+   for (unsigned i = 0; i < VK_PIPELINE_CACHE_SHARD_COUNT; i++) {
+      struct vk_pipeline_cache_shard *shard = &cache->shards[i];
+
+      vk_pipeline_cache_lock_shard(cache, shard);
+      stats->lookups += shard->stats.lookups;
+      stats->hits += shard->stats.hits;
+      stats->inserts += shard->stats.inserts;
+      stats->contended += shard->stats.contended;
+      stats->lookup_ns += shard->stats.lookup_ns;
+      vk_pipeline_cache_unlock_shard(cache, shard);
+   }
+}
+
 VKAPI_ATTR VkResult VKAPI_CALL
 vk_common_CreatePipelineCache(VkDevice _device,
                               const VkPipelineCacheCreateInfo *pCreateInfo,
@@ -747,54 +856,58 @@ vk_common_GetPipelineCacheData(VkDevice _device,
       return VK_INCOMPLETE;
    }
 
-   vk_pipeline_cache_lock(cache);
-
    VkResult result = VK_SUCCESS;
-   if (cache->object_cache != NULL) {
-      set_foreach(cache->object_cache, entry) {
-         struct vk_pipeline_cache_object *object = (void *)entry->key;
+   if (cache->shards != NULL) {
+      for (unsigned i = 0; i < VK_PIPELINE_CACHE_SHARD_COUNT &&
+                           result == VK_SUCCESS; i++) {
+         struct vk_pipeline_cache_shard *shard = &cache->shards[i];
 
-         if (object->ops->serialize == NULL)
-            continue;
+         vk_pipeline_cache_lock_shard(cache, shard);
+         set_foreach(shard->objects, entry) {
+            struct vk_pipeline_cache_object *object = (void *)entry->key;
 
-         size_t blob_size_save = blob.size;
+            if (object->ops->serialize == NULL)
+               continue;
 
-         int32_t type = find_type_for_ops(device->physical, object->ops);
-         blob_write_uint32(&blob, type);
-         blob_write_uint32(&blob, object->key_size);
-         intptr_t data_size_resv = blob_reserve_uint32(&blob);
-         blob_write_bytes(&blob, object->key_data, object->key_size);
+            size_t blob_size_save = blob.size;
 
-         if (!blob_align(&blob, VK_PIPELINE_CACHE_BLOB_ALIGN)) {
-            result = VK_INCOMPLETE;
-            break;
-         }
+            int32_t type = find_type_for_ops(device->physical, object->ops);
+            blob_write_uint32(&blob, type);
+            blob_write_uint32(&blob, object->key_size);
+            intptr_t data_size_resv = blob_reserve_uint32(&blob);
+            blob_write_bytes(&blob, object->key_data, object->key_size);
 
-         uint32_t data_size;
-         if (!vk_pipeline_cache_object_serialize(cache, object,
-                                                 &blob, &data_size)) {
-            blob.size = blob_size_save;
-            if (blob.out_of_memory) {
+            if (!blob_align(&blob, VK_PIPELINE_CACHE_BLOB_ALIGN)) {
                result = VK_INCOMPLETE;
                break;
             }
 
-            /* Failed for some other reason; keep going */
-            continue;
-         }
+            uint32_t data_size;
+            if (!vk_pipeline_cache_object_serialize(cache, object,
+                                                    &blob, &data_size)) {
+               blob.size = blob_size_save;
+               if (blob.out_of_memory) {
+                  result = VK_INCOMPLETE;
+                  break;
+               }
+
+               /* Failed for some other reason; keep going */
+               continue;
+            }
+
+            /* vk_pipeline_cache_object_serialize should have failed */
+            assert(!blob.out_of_memory);
 
-         /* vk_pipeline_cache_object_serialize should have failed */
-         assert(!blob.out_of_memory);
+            assert(data_size_resv >= 0);
+            blob_overwrite_uint32(&blob, data_size_resv, data_size);
 
-         assert(data_size_resv >= 0);
-         blob_overwrite_uint32(&blob, data_size_resv, data_size);
+            count++;
+         }
 
-         count++;
+         vk_pipeline_cache_unlock_shard(cache, shard);
       }
    }
 
-   vk_pipeline_cache_unlock(cache);
-
    blob_overwrite_uint32(&blob, count_offset, count);
 
    *pDataSize = blob.size;
@@ -815,53 +928,59 @@ vk_common_MergePipelineCaches(VkDevice _device,
    assert(dst->base.device == device);
    assert(!dst->weak_ref);
 
-   if (!dst->object_cache)
+   if (!dst->shards)
       return VK_SUCCESS;
 
-   vk_pipeline_cache_lock(dst);
-
    for (uint32_t i = 0; i < srcCacheCount; i++) {
       VK_FROM_HANDLE(vk_pipeline_cache, src, pSrcCaches[i]);
       assert(src->base.device == device);
 
-      if (!src->object_cache)
+      if (!src->shards)
          continue;
 
       assert(src != dst);
       if (src == dst)
          continue;
 
-      vk_pipeline_cache_lock(src);
-
-      set_foreach(src->object_cache, src_entry) {
-         struct vk_pipeline_cache_object *src_object = (void *)src_entry->key;
-
-         bool found_in_dst = false;
-         struct set_entry *dst_entry =
-            _mesa_set_search_or_add_pre_hashed(dst->object_cache,
-                                               src_entry->hash,
-                                               src_object, &found_in_dst);
-         if (found_in_dst) {
-            struct vk_pipeline_cache_object *dst_object = (void *)dst_entry->key;
-            if (dst_object->ops == &vk_raw_data_cache_object_ops &&
-                src_object->ops != &vk_raw_data_cache_object_ops) {
-               /* Even though dst has the object, it only has the blob version
-                * which isn't as useful.  Replace it with the real object.
-                */
-               vk_pipeline_cache_object_unref(device, dst_object);
-               dst_entry->key = vk_pipeline_cache_object_ref(src_object);
+      /* Both caches pick shards with the same hash bits */
+      for (unsigned j = 0; j < VK_PIPELINE_CACHE_SHARD_COUNT; j++) {
+         struct vk_pipeline_cache_shard *dst_shard = &dst->shards[j];
+         struct vk_pipeline_cache_shard *src_shard = &src->shards[j];
+
+         vk_pipeline_cache_lock_shard(dst, dst_shard);
+         vk_pipeline_cache_lock_shard(src, src_shard);
+
+         set_foreach(src_shard->objects, src_entry) {
+            struct vk_pipeline_cache_object *src_object = (void *)src_entry->key;
+
+            bool found_in_dst = false;
+            struct set_entry *dst_entry =
+               _mesa_set_search_or_add_pre_hashed(dst_shard->objects,
+                                                  src_entry->hash,
+                                                  src_object, &found_in_dst);
+            if (found_in_dst) {
+               struct vk_pipeline_cache_object *dst_object = (void *)dst_entry->key;
+               if (dst_object->ops == &vk_raw_data_cache_object_ops &&
+                   src_object->ops != &vk_raw_data_cache_object_ops) {
+                  /* Even though dst has the object, it only has the blob
+                   * version which isn't as useful.  Replace it with the real
+                   * object.
+                   */
+                  vk_pipeline_cache_object_unref(device, dst_object);
+                  dst_entry->key = vk_pipeline_cache_object_ref(src_object);
+               }
+            } else {
+               /* We inserted src_object in dst so it needs a reference */
+               assert(dst_entry->key == (const void *)src_object);
+               vk_pipeline_cache_object_ref(src_object);
+               dst_shard->stats.inserts++;
             }
-         } else {
-            /* We inserted src_object in dst so it needs a reference */
-            assert(dst_entry->key == (const void *)src_object);
-            vk_pipeline_cache_object_ref(src_object);
          }
-      }
 
-      vk_pipeline_cache_unlock(src);
+         vk_pipeline_cache_unlock_shard(src, src_shard);
+         vk_pipeline_cache_unlock_shard(dst, dst_shard);
+      }
    }
 
-   vk_pipeline_cache_unlock(dst);
-
    return VK_SUCCESS;
 }
@@ -147,6 +147,29 @@ void
 vk_pipeline_cache_object_unref(struct vk_device *device,
                                struct vk_pipeline_cache_object *object);
 
+/** Lookup statistics of a vk_pipeline_cache */
+struct vk_pipeline_cache_stats {
+   /** Number of in-memory lookups */
+   uint64_t lookups;
+
+   /** Number of in-memory lookups that found the object */
+   uint64_t hits;
+
+   /** Number of objects inserted into the table */
+   uint64_t inserts;
+
+   /** Number of lookups and inserts which had to wait for a shard lock */
+   uint64_t contended;
+
+   /** Total time spent in in-memory lookups, in nanoseconds
+    *
+    * Only collected with MESA_VK_PIPELINE_CACHE_STATS set.
+    */
+   uint64_t lookup_ns;
+};
+
+struct vk_pipeline_cache_shard;
+
 /** A generic implementation of VkPipelineCache */
 struct vk_pipeline_cache {
    struct vk_object_base base;
@@ -159,10 +182,14 @@ struct vk_pipeline_cache {
 
    struct vk_pipeline_cache_header header;
 
-   /** Protects object_cache */
-   simple_mtx_t lock;
+   /** Whether lookups are timed, see MESA_VK_PIPELINE_CACHE_STATS */
+   bool collect_stats;
 
-   struct set *object_cache;
+   /** The object table, split into VK_PIPELINE_CACHE_SHARD_COUNT shards
+    * selected by key hash, each with its own lock.  NULL if the cache is
+    * disabled.
+    */
+   struct vk_pipeline_cache_shard *shards;
 };
 
 VK_DEFINE_NONDISP_HANDLE_CASTS(vk_pipeline_cache, base, VkPipelineCache,
@@ -212,6 +239,11 @@ void
 vk_pipeline_cache_destroy(struct vk_pipeline_cache *cache,
                           const VkAllocationCallbacks *pAllocator);
 
+/** Returns the lookup statistics of the cache, summed over all shards */
+void
+vk_pipeline_cache_get_stats(struct vk_pipeline_cache *cache,
+                            struct vk_pipeline_cache_stats *stats);
+
 /** Attempts to look up an object in the cache by key
  *
  * If an object is found in the cache matching the given key, *cache_hit is
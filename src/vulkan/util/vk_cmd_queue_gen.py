@@ -76,7 +76,10 @@ TEMPLATE_H = Template(COPYRIGHT + """\
 
 #pragma once
 
+#include <string.h>
+
 #include "util/list.h"
+#include "util/macros.h"
 
 #define VK_PROTOTYPES
 #include <vulkan/vulkan_core.h>
@@ -91,10 +94,26 @@ extern "C" {
 #endif
 
 struct vk_device_dispatch_table;
+struct vk_cmd_queue_chunk;
 
 struct vk_cmd_queue {
+   /* Points at arena_alloc.  Anything allocated through it lives until the
+    * queue is reset and vk_free() on it is a no-op.
+    */
    const VkAllocationCallbacks *alloc;
    struct list_head cmds;
+
+   /* Commands and everything they point to are bump-allocated, in recording
+    * order, out of a list of chunks allocated from parent_alloc.  Resetting
+    * the queue rewinds to the first chunk without freeing any of them,
+    * trimming it also frees all chunks but the first.
+    */
+   const VkAllocationCallbacks *parent_alloc;
+   VkAllocationCallbacks arena_alloc;
+   struct list_head chunks;
+   struct vk_cmd_queue_chunk *chunk;
+   uint8_t *cursor;
+   uint8_t *end;
 };
 
 enum vk_cmd_type {
@@ -182,29 +201,43 @@ struct vk_cmd_queue_entry {
 
 % endfor
 
-void vk_free_queue(struct vk_cmd_queue *queue);
+void *vk_cmd_queue_alloc_slow(struct vk_cmd_queue *queue,
+                              size_t size, size_t align);
 
-static inline void
-vk_cmd_queue_init(struct vk_cmd_queue *queue, VkAllocationCallbacks *alloc)
+static inline void *
+vk_cmd_queue_alloc(struct vk_cmd_queue *queue, size_t size, size_t align)
 {
-   queue->alloc = alloc;
-   list_inithead(&queue->cmds);
-}
+   uintptr_t ptr = ALIGN_POT((uintptr_t)queue->cursor, align);
+   if (unlikely(queue->cursor == NULL || ptr + size > (uintptr_t)queue->end))
+      return vk_cmd_queue_alloc_slow(queue, size, align);
 
-static inline void
-vk_cmd_queue_reset(struct vk_cmd_queue *queue)
-{
-   vk_free_queue(queue);
-   list_inithead(&queue->cmds);
+   queue->cursor = (uint8_t *)ptr + size;
+   return (void *)ptr;
 }
 
-static inline void
-vk_cmd_queue_finish(struct vk_cmd_queue *queue)
+static inline void *
+vk_cmd_queue_zalloc(struct vk_cmd_queue *queue, size_t size)
 {
-   vk_free_queue(queue);
-   list_inithead(&queue->cmds);
+   void *ptr = vk_cmd_queue_alloc(queue, size, 8);
+   if (likely(ptr != NULL))
+      memset(ptr, 0, size);
+   return ptr;
 }
 
+void vk_free_queue(struct vk_cmd_queue *queue);
+
+void vk_cmd_queue_init(struct vk_cmd_queue *queue, VkAllocationCallbacks *alloc);
+
+/* Drops all commands but keeps the memory for the next recording. */
+void vk_cmd_queue_reset(struct vk_cmd_queue *queue);
+
+/* Drops all commands and frees all of the memory but the first chunk, for
+ * resets that release resources.
+ */
+void vk_cmd_queue_trim(struct vk_cmd_queue *queue);
+
+void vk_cmd_queue_finish(struct vk_cmd_queue *queue);
+
 void vk_cmd_queue_execute(struct vk_cmd_queue *queue,
                           VkCommandBuffer commandBuffer,
                           const struct vk_device_dispatch_table *disp);
@@ -259,73 +292,182 @@ size_t vk_cmd_queue_type_sizes[] = {
 };
 
 % for c in commands:
+% if c.name not in manual_commands and c.name not in no_enqueue_commands:
 % if c.guard is not None:
 #ifdef ${c.guard}
 % endif
-static void
-vk_free_${to_underscore(c.name)}(struct vk_cmd_queue *queue,
-${' ' * len('vk_free_' + to_underscore(c.name) + '(')}\\
-struct vk_cmd_queue_entry *cmd)
-{
-% for p in c.params[1:]:
-% if p.len:
-   vk_free(queue->alloc, (${remove_suffix(p.decl.replace("const", ""), p.name)})cmd->u.${to_struct_field_name(c.name)}.${to_field_name(p.name)});
-% elif '*' in p.decl:
-${get_struct_free(c, p, types)}
-% endif
-% endfor
-}
-
-% if c.name not in manual_commands and c.name not in no_enqueue_commands:
 VkResult vk_enqueue_${to_underscore(c.name)}(struct vk_cmd_queue *queue
 % for p in c.params[1:]:
 , ${p.decl}
 % endfor
 )
 {
-   struct vk_cmd_queue_entry *cmd = vk_zalloc(queue->alloc, vk_cmd_queue_type_sizes[${to_enum_name(c.name)}], 8,
-                                              VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+   struct vk_cmd_queue_entry *cmd =
+      vk_cmd_queue_zalloc(queue, vk_cmd_queue_type_sizes[${to_enum_name(c.name)}]);
    if (!cmd) return VK_ERROR_OUT_OF_HOST_MEMORY;
 
    cmd->type = ${to_enum_name(c.name)};
 ${get_params_copy(c, types)}}
-% endif
 % if c.guard is not None:
 #endif // ${c.guard}
 % endif
 
+% endif
 % endfor
 
+struct vk_cmd_queue_chunk {
+   struct list_head link;
+   size_t size;
+   alignas(16) uint8_t data[];
+};
+
+#define VK_CMD_QUEUE_MIN_CHUNK_SIZE (16 * 1024)
+#define VK_CMD_QUEUE_MAX_CHUNK_SIZE (1024 * 1024)
+
+static void
+vk_cmd_queue_set_chunk(struct vk_cmd_queue *queue,
+                       struct vk_cmd_queue_chunk *chunk)
+{
+   queue->chunk = chunk;
+   queue->cursor = chunk->data;
+   queue->end = chunk->data + chunk->size;
+}
+
+void *
+vk_cmd_queue_alloc_slow(struct vk_cmd_queue *queue, size_t size, size_t align)
+{
+   const size_t needed = size + align;
+
+   /* Chunks left over from before the last reset come first. */
+   struct list_head *next =
+      queue->chunk ? queue->chunk->link.next : queue->chunks.next;
+   if (next != &queue->chunks) {
+      struct vk_cmd_queue_chunk *chunk =
+         list_entry(next, struct vk_cmd_queue_chunk, link);
+      if (chunk->size >= needed) {
+         vk_cmd_queue_set_chunk(queue, chunk);
+         return vk_cmd_queue_alloc(queue, size, align);
+      }
+   }
+
+   /* Grow geometrically so long command buffers end up in a few big chunks
+    * while short ones stay small.
+    */
+   size_t chunk_size = queue->chunk ? queue->chunk->size * 2 : 0;
+   chunk_size = CLAMP(chunk_size, VK_CMD_QUEUE_MIN_CHUNK_SIZE,
+                      VK_CMD_QUEUE_MAX_CHUNK_SIZE);
+   chunk_size = MAX2(chunk_size, needed);
+
+   struct vk_cmd_queue_chunk *chunk =
+      vk_alloc(queue->parent_alloc, sizeof(*chunk) + chunk_size, 16,
+               VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+   if (chunk == NULL)
+      return NULL;
+
+   chunk->size = chunk_size;
+   /* Insert it in front of any chunk that was too small so that one still
+    * gets reused after the next reset.
+    */
+   list_addtail(&chunk->link, next);
+   vk_cmd_queue_set_chunk(queue, chunk);
+
+   return vk_cmd_queue_alloc(queue, size, align);
+}
+
+static VKAPI_ATTR void * VKAPI_CALL
+vk_cmd_queue_arena_alloc(void *pUserData, size_t size, size_t align,
+                         VkSystemAllocationScope allocationScope)
+{
+   return vk_cmd_queue_alloc(pUserData, size, align);
+}
+
+static VKAPI_ATTR void * VKAPI_CALL
+vk_cmd_queue_arena_realloc(void *pUserData, void *pOriginal, size_t size,
+                           size_t align, VkSystemAllocationScope allocationScope)
+{
+   /* The arena doesn't track allocation sizes, so there's nothing to copy
+    * from.  Nothing recorded into a command queue gets reallocated.
+    */
+   assert(pOriginal == NULL);
+   return vk_cmd_queue_alloc(pUserData, size, align);
+}
+
+static VKAPI_ATTR void VKAPI_CALL
+vk_cmd_queue_arena_free(void *pUserData, void *pMemory)
+{
+}
+
+void
+vk_cmd_queue_init(struct vk_cmd_queue *queue, VkAllocationCallbacks *alloc)
+{
+   queue->parent_alloc = alloc;
+   queue->arena_alloc = (VkAllocationCallbacks) {
+      .pUserData = queue,
+      .pfnAllocation = vk_cmd_queue_arena_alloc,
+      .pfnReallocation = vk_cmd_queue_arena_realloc,
+      .pfnFree = vk_cmd_queue_arena_free,
+   };
+   queue->alloc = &queue->arena_alloc;
+   list_inithead(&queue->cmds);
+   list_inithead(&queue->chunks);
+   queue->chunk = NULL;
+   queue->cursor = NULL;
+   queue->end = NULL;
+}
+
 void
 vk_free_queue(struct vk_cmd_queue *queue)
 {
-   struct vk_cmd_queue_entry *tmp, *cmd;
-   LIST_FOR_EACH_ENTRY_SAFE(cmd, tmp, &queue->cmds, cmd_link) {
-      if (cmd->driver_free_cb) {
+   /* The commands themselves live in the arena, only driver hooks need to
+    * run.
+    */
+   list_for_each_entry(struct vk_cmd_queue_entry, cmd, &queue->cmds, cmd_link) {
+      if (cmd->driver_free_cb)
          cmd->driver_free_cb(queue, cmd);
-         vk_free(queue->alloc, cmd);
-         continue;
-      }
-      switch(cmd->type) {
-% for c in commands:
-% if c.guard is not None:
-#ifdef ${c.guard}
-% endif
-      case ${to_enum_name(c.name)}:
-         vk_free_${to_underscore(c.name)}(queue, cmd);
-         break;
-% if c.guard is not None:
-#endif // ${c.guard}
-% endif
-% endfor
-      case VK_CMD_TYPE_COUNT:
-         break;
+   }
+   list_inithead(&queue->cmds);
+}
+
+void
+vk_cmd_queue_reset(struct vk_cmd_queue *queue)
+{
+   vk_free_queue(queue);
+
+   queue->chunk = NULL;
+   queue->cursor = NULL;
+   queue->end = NULL;
+}
+
+void
+vk_cmd_queue_trim(struct vk_cmd_queue *queue)
+{
+   vk_cmd_queue_reset(queue);
+
+   if (list_is_empty(&queue->chunks))
+      return;
+
+   struct vk_cmd_queue_chunk *first =
+      list_first_entry(&queue->chunks, struct vk_cmd_queue_chunk, link);
+   list_for_each_entry_safe(struct vk_cmd_queue_chunk, chunk,
+                            &queue->chunks, link) {
+      if (chunk != first) {
+         list_del(&chunk->link);
+         vk_free(queue->parent_alloc, chunk);
       }
-      vk_free(queue->alloc, cmd->driver_data);
-      vk_free(queue->alloc, cmd);
    }
 }
 
+void
+vk_cmd_queue_finish(struct vk_cmd_queue *queue)
+{
+   vk_cmd_queue_reset(queue);
+
+   list_for_each_entry_safe(struct vk_cmd_queue_chunk, chunk,
+                            &queue->chunks, link)
+      vk_free(queue->parent_alloc, chunk);
+   list_inithead(&queue->chunks);
+}
+
 void
 vk_cmd_queue_execute(struct vk_cmd_queue *queue,
                      VkCommandBuffer commandBuffer,
@@ -460,7 +602,7 @@ def get_array_copy(builder, command, param, field_name):
     else:
         field_size = "sizeof(*%s)" % field_name
 
-    builder.add("%s = vk_zalloc(queue->alloc, %s * (%s), 8, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);\n   if (%s == NULL) goto err;" % (
+    builder.add("%s = vk_cmd_queue_zalloc(queue, %s * (%s));\n   if (%s == NULL) goto err;" % (
         field_name, field_size, param.len, field_name
     ))
     builder.add("memcpy((void*)%s, %s, %s * (%s));" % (field_name, param.name, field_size, param.len))
@@ -474,7 +616,7 @@ def get_array_member_copy(builder, struct, src_name, member):
 
     builder.add("if (%s->%s) {" % (src_name, member.name))
     builder.level += 1
-    builder.add("%s = vk_zalloc(queue->alloc, %s, 8, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);" % (field_name, field_size))
+    builder.add("%s = vk_cmd_queue_zalloc(queue, %s);" % (field_name, field_size))
     builder.add("if (%s == NULL) goto err;" % (field_name))
     builder.add("memcpy((void*)%s, %s->%s, %s);" % (field_name, src_name, member.name, field_size))
     builder.level -= 1
@@ -508,36 +650,6 @@ def get_pnext_member_copy(builder, struct, src_type, member, types):
     builder.level -= 1
     builder.add("}")
 
-def get_pnext_member_free(builder, struct_type, types, field_name):
-    if not types[struct_type].extended_by:
-        return
-
-    local_pnext = builder.get_variable_name("pnext")
-
-    builder.add("const VkBaseInStructure *%s = %s;" % (local_pnext, field_name))
-    builder.add("if (%s) {" % (local_pnext))
-    builder.level += 1
-    builder.add("switch ((int32_t)%s->sType) {" % (local_pnext))
-
-    for type in types[struct_type].extended_by:
-        if type.guard is not None:
-            builder.code += "#ifdef %s\n" % (type.guard)
-
-        builder.add("case %s: {" % (type.enum))
-        builder.level += 1
-        get_struct_free(builder, "((%s *)%s)" % (type.name, local_pnext), False, type.name, types)
-        builder.add("vk_free(queue->alloc, (void*)%s);" % (local_pnext))
-        builder.add("break;")
-        builder.level -= 1
-        builder.add("}")
-
-        if type.guard is not None:
-            builder.code += "#endif\n"
-
-    builder.add("}")
-    builder.level -= 1
-    builder.add("}")
-
 def get_struct_copy(builder, dst, src_name, src_type, types, parent_name=None, len=None):
     tmp_dst_name = builder.get_variable_name("tmp_dst")
     tmp_src_name = builder.get_variable_name("tmp_src")
@@ -553,7 +665,7 @@ def get_struct_copy(builder, dst, src_name, src_type, types, parent_name=None, l
     if len and len != "struct-ptr":
         size = "%s * %s->%s" % (size, parent_name, len)
 
-    builder.add("%s = vk_zalloc(queue->alloc, %s, 8, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);" % (dst, size))
+    builder.add("%s = vk_cmd_queue_zalloc(queue, %s);" % (dst, size))
     builder.add("if (%s == NULL) goto err;" % (dst))
     builder.add("%s *%s = (void *)%s;" % (src_type, tmp_dst_name, dst))
     builder.add("%s *%s = (void *)%s;" % (src_type, tmp_src_name, src_name))
@@ -593,64 +705,6 @@ def get_struct_copy(builder, dst, src_name, src_type, types, parent_name=None, l
     builder.level -= 1
     builder.add("}")
 
-def get_command_struct_free(command, param, types):
-    field_name = "cmd->u.%s.%s" % (to_struct_field_name(command.name), to_field_name(param.name))
-    builder = CodeBuilder(1)
-    get_struct_free(builder, field_name, True, param.type, types)
-    builder.add("vk_free(queue->alloc, (void*)%s);" % (field_name))
-    return builder.code
-
-def get_struct_free(builder, field_name, nullable, struct_type, types, parent_name=None, len=None):
-    if struct_type not in types:
-        return
-
-    members = types[struct_type].members
-
-    if members and nullable:
-        builder.add("if (%s) {" % (field_name))
-        builder.level += 1
-
-    struct_array_copy = len and len != "struct-ptr" and struct_type != "void"
-    if struct_array_copy:
-        array_index = builder.get_variable_name("i")
-        builder.add("for (uint32_t %s = 0; %s < %s->%s; %s++) {" % (array_index, array_index, parent_name, len, array_index))
-        builder.level += 1
-        element_name = builder.get_variable_name("element")
-        builder.add("%s *%s = %s + %s; (void)%s;" % (struct_type, element_name, field_name, array_index, element_name))
-        field_name = element_name
-
-    for member in members:
-        member_name = "%s->%s" % (field_name, member.name)
-        if member.len and member.len != 'null-terminated':
-            local_member_name = builder.get_variable_name(member.name)
-            builder.add("%s *%s = (void *)(%s);" % (member.type, local_member_name, member_name))
-
-            guard = member.len != "struct-ptr"
-            if guard:
-                builder.add("if (%s->%s) {" % (field_name, member.len))
-                builder.level += 1
-
-            get_struct_free(builder, local_member_name, not guard, member.type, types, field_name, member.len)
-
-            if guard:
-                builder.level -= 1
-                builder.add("}")
-
-            builder.add("vk_free(queue->alloc, %s);" % (local_member_name))
-        elif member.len and member.len == 'null-terminated':
-            builder.add("vk_free(queue->alloc, (void*)%s);" % (member_name))
-
-        elif member.name == 'pNext':
-            get_pnext_member_free(builder, struct_type, types, member_name)
-
-    if struct_array_copy:
-        builder.level -= 1
-        builder.add("}")
-
-    if members and nullable:
-        builder.level -= 1
-        builder.add("}")
-
 def get_param_copy(builder, command, param, types):
     dst = "cmd->u.%s.%s" % (to_struct_field_name(command.name), to_field_name(param.name))
 
@@ -692,8 +746,6 @@ def get_params_copy(command, types):
 
     if any_needs_error_handling:
         builder.code += "\nerr:\n"
-        builder.add("if (cmd)")
-        builder.add("   vk_free_%s(queue, cmd);" % (to_underscore(command.name)))
         builder.add("return VK_ERROR_OUT_OF_HOST_MEMORY;")
 
     return builder.code
@@ -836,7 +888,6 @@ def main():
         'to_enum_name': to_enum_name,
         'to_struct_name': to_struct_name,
         'get_params_copy': get_params_copy,
-        'get_struct_free': get_command_struct_free,
         'types': types,
         'manual_commands': MANUAL_COMMANDS,
         'no_enqueue_commands': NO_ENQUEUE_COMMANDS,